@@ -355,7 +355,8 @@ static int write_persistence_file(const char *path,
             || anjay_persistence_string(ctx, (char **) (intptr_t) &uri)
             || anjay_persistence_string(ctx, &download_file)
             || anjay_persistence_bool(ctx, &filename_administratively_set)
-            || store_etag(ctx, etag)) {
+            || store_etag(ctx, etag)
+            || anjay_persistence_context_flush(ctx)) {
         demo_log(ERROR, "Could not write firmware state persistence file");
         retval = -1;
     }
@@ -569,7 +570,7 @@ static persistence_file_data_t read_persistence_file(const char *path) {
         result8 = (int8_t) ANJAY_FW_UPDATE_INITIAL_SUCCESS;
     }
     if (!stream
-            || !(ctx = anjay_persistence_restore_context_new(stream))
+            || !(ctx = anjay_persistence_buffered_restore_context_new(stream))
             || anjay_persistence_bytes(ctx, (uint8_t *) &result8, 1)
             || !is_valid_result(result8)
             || anjay_persistence_string(ctx, &data.uri)
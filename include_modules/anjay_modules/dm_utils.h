@@ -216,6 +216,19 @@ int _anjay_dm_instance_remove(anjay_t *anjay,
                               const anjay_dm_object_def_t *const *obj_ptr,
                               anjay_iid_t iid,
                               const anjay_dm_module_t *current_module);
+
+/**
+ * Checks whether all Instances of @p obj_ptr may be removed using
+ * @ref _anjay_dm_instance_remove_all , i.e. the Object implements the
+ * <c>instance_remove_all</c> handler and no installed module overrides
+ * <c>instance_remove</c> without overriding it as well.
+ */
+bool _anjay_dm_instance_remove_all_usable(
+        anjay_t *anjay, const anjay_dm_object_def_t *const *obj_ptr);
+
+int _anjay_dm_instance_remove_all(anjay_t *anjay,
+                                  const anjay_dm_object_def_t *const *obj_ptr,
+                                  const anjay_dm_module_t *current_module);
 int _anjay_dm_instance_read_default_attrs(anjay_t *anjay,
                                           const anjay_dm_object_def_t *const *obj_ptr,
                                           anjay_iid_t iid,
@@ -249,12 +262,49 @@ int _anjay_dm_resource_operations(anjay_t *anjay,
                                   anjay_dm_resource_op_mask_t *out,
                                   const anjay_dm_module_t *current_module);
 
+/**
+ * Checks whether presence and operations of all Resources of @p obj_ptr
+ * Instances may be queried using @ref _anjay_dm_instance_resources , i.e. the
+ * Object implements the <c>instance_resources</c> handler and no installed
+ * module overrides the per-Resource queries without overriding it as well.
+ */
+bool _anjay_dm_instance_resources_usable(
+        anjay_t *anjay, const anjay_dm_object_def_t *const *obj_ptr);
+
+/**
+ * Fills @p out (of <c>(*obj_ptr)->supported_rids.count</c> elements) as
+ * described in @ref anjay_dm_instance_resources_t . If the
+ * <c>resource_operations</c> handler is not implemented, all operations are
+ * reported as supported for each PRESENT Resource.
+ */
+int _anjay_dm_instance_resources(anjay_t *anjay,
+                                 const anjay_dm_object_def_t *const *obj_ptr,
+                                 anjay_iid_t iid,
+                                 anjay_dm_resource_op_mask_t *out,
+                                 const anjay_dm_module_t *current_module);
+
 int _anjay_dm_resource_read(anjay_t *anjay,
                             const anjay_dm_object_def_t *const *obj_ptr,
                             anjay_iid_t iid,
                             anjay_rid_t rid,
                             anjay_output_ctx_t *ctx,
                             const anjay_dm_module_t *current_module);
+
+/**
+ * Checks whether all Resources of @p obj_ptr Instances may be read using
+ * @ref _anjay_dm_instance_read , i.e. the Object implements the
+ * <c>instance_read</c> handler and no installed module overrides
+ * <c>resource_read</c> without overriding it as well.
+ */
+bool _anjay_dm_instance_read_usable(
+        anjay_t *anjay, const anjay_dm_object_def_t *const *obj_ptr);
+
+int _anjay_dm_instance_read(anjay_t *anjay,
+                            const anjay_dm_object_def_t *const *obj_ptr,
+                            anjay_iid_t iid,
+                            anjay_output_ctx_t *ctx,
+                            const anjay_dm_module_t *current_module);
+
 int _anjay_dm_resource_write(anjay_t *anjay,
                              const anjay_dm_object_def_t *const *obj_ptr,
                              anjay_iid_t iid,
@@ -364,6 +414,31 @@ bool _anjay_dm_resource_attributes_empty(
 
 bool _anjay_dm_attributes_full(const anjay_dm_internal_attrs_t *attrs);
 
+#ifdef WITH_DISCOVER
+/**
+ * Drops cached Discover responses generated for server @p ssid (or for all
+ * servers if it is ANJAY_SSID_ANY) that may include data at @p path - i.e.
+ * ones generated for @p path itself, any of its parents or any of its
+ * children. A path without OID matches all cached responses.
+ *
+ * Changes signalled through the notify queue and Write-Attributes requests are
+ * handled by the core. Modules that change the data model or attributes in
+ * some other way need to call this function explicitly.
+ */
+void _anjay_discover_cache_invalidate(anjay_t *anjay,
+                                      anjay_ssid_t ssid,
+                                      const anjay_uri_path_t *path);
+#else // WITH_DISCOVER
+static inline void
+_anjay_discover_cache_invalidate(anjay_t *anjay,
+                                 anjay_ssid_t ssid,
+                                 const anjay_uri_path_t *path) {
+    (void) anjay;
+    (void) ssid;
+    (void) path;
+}
+#endif // WITH_DISCOVER
+
 #define ANJAY_DM_OID_SECURITY 0
 #define ANJAY_DM_OID_SERVER 1
 #define ANJAY_DM_OID_ACCESS_CONTROL 2
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_INCLUDE_ANJAY_MODULES_DTLS_SESSION_H
+#define ANJAY_INCLUDE_ANJAY_MODULES_DTLS_SESSION_H
+
+#include <config.h>
+
+#include <avsystem/commons/list.h>
+
+#include <anjay/core.h>
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+typedef struct {
+    anjay_ssid_t ssid;
+    /**
+     * Digest of the Security mode and credentials the session has been
+     * established with. The session is dropped if they change.
+     */
+    uint32_t credentials_digest;
+    /**
+     * Session state in a format internal to avs_net; all zeros if no session
+     * has been established.
+     */
+    uint8_t buffer[ANJAY_DTLS_SESSION_BUFFER_SIZE];
+} anjay_dtls_session_t;
+
+/**
+ * @returns List of DTLS session state buffers of all the servers the client
+ *          connected to, sorted by SSID.
+ */
+AVS_LIST(const anjay_dtls_session_t) _anjay_dtls_sessions(anjay_t *anjay);
+
+/**
+ * Sets the DTLS session state of the server @p ssid, e.g. after restarting the
+ * client. The state is filled in place, as sockets may already refer to it.
+ *
+ * @param data Session state of ANJAY_DTLS_SESSION_BUFFER_SIZE bytes.
+ *
+ * @returns 0 on success, a negative value if out of memory.
+ */
+int _anjay_dtls_session_restore(anjay_t *anjay,
+                                anjay_ssid_t ssid,
+                                uint32_t credentials_digest,
+                                const uint8_t *data);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_INCLUDE_ANJAY_MODULES_DTLS_SESSION_H */
@@ -75,6 +75,16 @@ int _anjay_notify_queue_instance_set_unknown_change(
         anjay_notify_queue_t *out_queue,
         anjay_oid_t oid);
 
+/**
+ * Adds a notification that all Instances of the Object specified by
+ * <c>oid</c> have been removed at once. Any resource changes and known added
+ * Instances previously queued for that Object are discarded, as they refer to
+ * Instances that no longer exist. The removed Instance IDs are not recorded
+ * individually.
+ */
+int _anjay_notify_queue_all_instances_removed(anjay_notify_queue_t *out_queue,
+                                              anjay_oid_t oid);
+
 /**
  * Adds a notification about the change of value of the data model resource
  * specified by <c>oid</c>, <c>iid</c> and <c>rid</c>.
@@ -31,6 +31,22 @@ typedef struct anjay_sched_struct anjay_sched_t;
 anjay_sched_t *_anjay_sched_get(anjay_t *anjay);
 
 ssize_t _anjay_sched_run(anjay_sched_t *sched);
+
+/**
+ * Executes due jobs like @ref _anjay_sched_run, but stops after executing
+ * @p max_tasks jobs (unless it is 0), or once @p deadline passes (unless it is
+ * invalid). At least one due job is always executed.
+ *
+ * @returns Number of executed jobs.
+ */
+ssize_t _anjay_sched_run_bounded(anjay_sched_t *sched,
+                                 size_t max_tasks,
+                                 avs_time_monotonic_t deadline);
+
+/**
+ * @returns Whether there are jobs that are due for execution right now.
+ */
+bool _anjay_sched_has_due_tasks(anjay_sched_t *sched);
 void _anjay_sched_delete(anjay_sched_t **sched_ptr);
 
 /**
@@ -87,6 +87,60 @@ void anjay_smsdrv_cleanup(anjay_smsdrv_t **smsdrv_ptr);
         /* .max_retransmit = */ 0          \
     }
 
+/**
+ * Default time for which resolved server and download hostnames are cached,
+ * unless the resolver specifies otherwise.
+ */
+#define ANJAY_DNS_CACHE_DEFAULT_TTL_S 300
+
+/**
+ * Resolves a hostname used to connect to a LwM2M Server or a download URI.
+ *
+ * @param arg          Opaque argument, as passed in
+ *                     @ref anjay_configuration_t::resolve_handler_arg .
+ * @param host         Hostname to resolve.
+ * @param port         Port the address will be used with.
+ * @param family       Address family preferred by the socket configuration.
+ * @param out_address  Buffer for the resolved numeric address.
+ * @param address_size Size of the @p out_address buffer.
+ * @param inout_ttl    Time for which the result may be cached. Initially set
+ *                     to @ref ANJAY_DNS_CACHE_DEFAULT_TTL_S seconds; may be
+ *                     changed by the resolver, e.g. to the TTL of the DNS
+ *                     record. Zero disables caching of the result.
+ *
+ * @returns 0 on success, a negative value in case of error.
+ */
+typedef int anjay_resolve_handler_t(void *arg,
+                                    const char *host,
+                                    const char *port,
+                                    avs_net_af_t family,
+                                    char *out_address,
+                                    size_t address_size,
+                                    avs_time_duration_t *inout_ttl);
+
+/**
+ * Reads the current monotonic time, replacing @ref avs_time_monotonic_now for
+ * all timing decisions made by the library.
+ *
+ * @param arg Opaque argument, as passed in
+ *            @ref anjay_configuration_t::clock_arg .
+ *
+ * @returns Current monotonic time. Subsequent calls MUST NOT return decreasing
+ *          values.
+ */
+typedef avs_time_monotonic_t anjay_monotonic_clock_t(void *arg);
+
+/**
+ * Reads the current real (wall) time, replacing @ref avs_time_real_now for
+ * all purposes within the library.
+ *
+ * @param arg Opaque argument, as passed in
+ *            @ref anjay_configuration_t::clock_arg .
+ *
+ * @returns Current real time.
+ */
+typedef avs_time_real_t anjay_real_clock_t(void *arg);
+
 typedef struct anjay_configuration {
     /** Endpoint name as presented to the LwM2M server. Must be non-NULL, or
      * otherwise @ref anjay_new() will fail. */
@@ -124,6 +178,46 @@ typedef struct anjay_configuration {
      */
     size_t msg_cache_size;
 
+    /**
+     * Number of bytes reserved for caching payloads of large Read responses.
+     * If not 0, a successful response to a GET request (e.g. Read) that does
+     * not fit in a single message is generated in full only once and stored
+     * under a generated ETag. Blocks of it are then served from the cache,
+     * in any order, including Block2 requests retransmitted with a new message
+     * ID, until EXCHANGE_LIFETIME passes. The data model is not queried again
+     * in that case.
+     *
+     * Responses larger than this limit are sent block-wise without caching,
+     * just like when this field is 0.
+     *
+     * NOTE: Setting this field to a non-zero value causes @ref anjay_new to
+     * fail if Anjay is compiled without WITH_BLOCK_SEND.
+     */
+    size_t block_response_cache_size;
+
+    /**
+     * Number of bytes reserved for caching Discover responses. If not 0,
+     * the payload generated for a Discover request is stored per server and
+     * path, and reused for subsequent Discover requests on the same path,
+     * without querying the data model again.
+     *
+     * Cached responses are dropped whenever a change that may affect them is
+     * signalled with @ref anjay_notify_changed or
+     * @ref anjay_notify_instances_changed, performed by a LwM2M server
+     * (including Write-Attributes), or made through the Attribute Storage
+     * module. When the limit is reached, least recently used responses are
+     * dropped first.
+     *
+     * NOTE: If some Objects implement attribute handlers by themselves and
+     * change the attributes in any other way than through Write-Attributes,
+     * @ref anjay_notify_instances_changed needs to be called afterwards, or
+     * Discover may report stale attributes.
+     *
+     * NOTE: Setting this field to a non-zero value causes @ref anjay_new to
+     * fail if Anjay is compiled without WITH_DISCOVER.
+     */
+    size_t discover_cache_size;
+
     /** Socket configuration to use when creating UDP sockets.
      *
      * Note that:
@@ -160,6 +254,27 @@ typedef struct anjay_configuration {
      * messages by default. */
     bool confirmable_notifications;
 
+    /** Maximum number of Confirmable notifications that may await
+     * acknowledgement at the same time, counted separately for each server
+     * connection (NSTART, as per RFC 7252, section 4.7). Subsequent
+     * notifications are queued until one of the outstanding ones is finished.
+     *
+     * If 0, the default value of 1 mandated by RFC 7252 is used. Larger values
+     * shall only be used if the servers are known to handle them. */
+    uint16_t nstart;
+
+    /** If set to true, connections to servers in queue mode are not closed
+     * after MAX_TRANSMIT_WAIT of inactivity. Instead, their sockets are only
+     * excluded from @ref anjay_get_sockets, keeping the bound port, resolved
+     * address and DTLS context, so that the next message is sent right away,
+     * without re-binding, reconnecting or DTLS handshake.
+     *
+     * NOTE: This assumes that the client's address as seen by the server
+     * (e.g. NAT binding) survives the idle period. If it does not, messages
+     * are lost until the server is reconnected, e.g. by
+     * @ref anjay_schedule_reconnect(). */
+    bool queue_mode_park_sockets;
+
     /** Specifies the cellular modem driver to use, enabling the SMS transport
      * if not NULL.
      *
@@ -197,6 +312,57 @@ typedef struct anjay_configuration {
      * call e.g. @ref anjay_schedule_reconnect() method.
      */
     const uint32_t *max_icmp_failures;
+
+    /** Resolver used to translate hostnames of LwM2M Servers and CoAP
+     * download URIs into addresses. Results are cached, so that reconnecting
+     * does not block on DNS queries until the cached entry expires; expired
+     * entries are resolved again when they are next needed, unless
+     * @ref anjay_configuration_t::refresh_dns_cache_in_background is set.
+     *
+     * If NULL, the system resolver is used, and results are cached for
+     * @ref ANJAY_DNS_CACHE_DEFAULT_TTL_S seconds.
+     *
+     * NOTE: Hostnames of servers using certificate-based DTLS are always
+     * passed to the socket as-is, as they are needed to verify the server
+     * certificate. */
+    anjay_resolve_handler_t *resolve_handler;
+
+    /** Opaque argument passed to @ref anjay_configuration_t::resolve_handler .
+     */
+    void *resolve_handler_arg;
+
+    /** If set, cache entries that are still in use are resolved again from
+     * within @ref anjay_sched_run as soon as they expire, so that the address
+     * is up to date when it is needed.
+     *
+     * NOTE: The resolver is called synchronously, so this shall only be
+     * enabled if @ref anjay_configuration_t::resolve_handler does not block,
+     * e.g. if it answers from an application-level cache. The system resolver
+     * may block the whole client for the duration of a DNS query. */
+    bool refresh_dns_cache_in_background;
+
+    /** Source of monotonic time used for all scheduling and timing decisions
+     * made by the library, e.g. Registration Updates, retransmissions,
+     * backoff, notification periods and cache expiration. Together with
+     * @ref anjay_configuration_t::real_clock , it allows running the library
+     * in virtual time, e.g. to simulate days of operation of many clients in
+     * seconds.
+     *
+     * If NULL, @ref avs_time_monotonic_now is used.
+     *
+     * NOTE: Socket timeouts, e.g. while waiting for a response in
+     * @ref anjay_serve, are always measured in system time. */
+    anjay_monotonic_clock_t *monotonic_clock;
+
+    /** Source of real time used for notification timestamps and periods of
+     * confirmable notifications.
+     *
+     * If NULL, @ref avs_time_real_now is used. */
+    anjay_real_clock_t *real_clock;
+
+    /** Opaque argument passed to @ref anjay_configuration_t::monotonic_clock
+     * and @ref anjay_configuration_t::real_clock . */
+    void *clock_arg;
 } anjay_configuration_t;
 
 /**
@@ -377,6 +543,87 @@ int anjay_sched_calculate_wait_time_ms(anjay_t *anjay, int limit_ms);
  */
 int anjay_sched_run(anjay_t *anjay);
 
+/**
+ * Runs scheduled events like @ref anjay_sched_run, but returns early once the
+ * given budget is exhausted, so that latency-sensitive applications may
+ * interleave their own work with that of the library.
+ *
+ * Jobs are never interrupted, so the time budget may be exceeded by the run
+ * time of the last executed job. At least one due job is always executed.
+ *
+ * @param anjay       Anjay object to operate on.
+ * @param max_tasks   Maximum number of jobs to execute, or 0 for no limit.
+ * @param time_budget Maximum time to spend executing jobs, or
+ *                    @c AVS_TIME_DURATION_INVALID for no limit.
+ *
+ * @returns 0 if all due jobs have been executed, 1 if there still are some -
+ *          in that case this function shall be called again as soon as
+ *          possible, or a negative value in case of error.
+ */
+int anjay_sched_run_bounded(anjay_t *anjay,
+                            size_t max_tasks,
+                            avs_time_duration_t time_budget);
+
+/** Execution statistics of a single kind of scheduler jobs. */
+typedef struct {
+    /**
+     * Address of the job callback. It may be translated into a function name
+     * using debug symbols of the library.
+     */
+    uintptr_t callback;
+    /** Number of times the job has been executed. */
+    uint64_t count;
+    /** Total time spent executing the job. */
+    avs_time_duration_t total_run_time;
+    /** Longest single execution of the job. */
+    avs_time_duration_t max_run_time;
+    /** Longest delay between the time the job was scheduled for and the time
+     * it was actually executed. */
+    avs_time_duration_t max_lateness;
+} anjay_sched_job_stats_t;
+
+/**
+ * Returns execution statistics of all jobs executed by the scheduler so far,
+ * one entry per job callback.
+ *
+ * @param anjay Anjay object to operate on.
+ *
+ * @returns A list of statistics, owned by @p anjay. It is valid until the next
+ *          call to @ref anjay_sched_run or any other function that may execute
+ *          scheduler jobs, such as @ref anjay_serve .
+ */
+AVS_LIST(const anjay_sched_job_stats_t) anjay_sched_job_stats(anjay_t *anjay);
+
+/**
+ * Called after a scheduler job has run longer than the budget configured using
+ * @ref anjay_sched_set_watchdog .
+ *
+ * @param arg      Opaque argument passed to @ref anjay_sched_set_watchdog .
+ * @param job      Statistics of the job, already including this execution.
+ * @param run_time Time the job has just run for.
+ */
+typedef void anjay_sched_overrun_handler_t(void *arg,
+                                           const anjay_sched_job_stats_t *job,
+                                           avs_time_duration_t run_time);
+
+/**
+ * Configures a handler to be called whenever a single scheduler job runs for
+ * longer than @p budget. Jobs cannot be interrupted, so the handler is called
+ * only after the job finishes.
+ *
+ * @param anjay   Anjay object to operate on.
+ * @param budget  Maximum expected run time of a single job.
+ * @param handler Handler to call, or NULL to disable the watchdog.
+ * @param arg     Opaque argument to pass to @p handler.
+ *
+ * @returns 0 on success, a negative value if @p budget is not a valid,
+ *          non-negative duration.
+ */
+int anjay_sched_set_watchdog(anjay_t *anjay,
+                             avs_time_duration_t budget,
+                             anjay_sched_overrun_handler_t *handler,
+                             void *arg);
+
 /**
  * Schedules sending an Update message to the server identified by given
  * Short Server ID.
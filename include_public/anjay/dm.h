@@ -246,6 +246,33 @@ typedef int anjay_dm_instance_remove_t(anjay_t *anjay,
                                        const anjay_dm_object_def_t *const *obj_ptr,
                                        anjay_iid_t iid);
 
+/**
+ * An optional handler that removes all Instances of an Object at once. It is
+ * used instead of calling @ref anjay_dm_instance_remove_t for each Instance
+ * when the whole Object is cleared, e.g. by a Bootstrap Delete request, which
+ * allows the implementation to drop its whole storage in linear time.
+ *
+ * The per-Instance @ref anjay_dm_instance_remove_t handler still needs to be
+ * implemented, as it is used for operations on single Instances.
+ *
+ * NOTE: This handler is never called for the Security Object, as the
+ * Bootstrap-Server Account Instance must survive Bootstrap Delete requests.
+ *
+ * @param anjay   Anjay object to operate on.
+ * @param obj_ptr Object definition pointer, as passed to
+ *                @ref anjay_register_object .
+ *
+ * @returns This handler should return:
+ * - 0 on success,
+ * - a negative value in case of error. If it returns one of ANJAY_ERR_
+ *   constants, the response message will have an appropriate CoAP response
+ *   code. Otherwise, the device will respond with an unspecified (but valid)
+ *   error code.
+ */
+typedef int
+anjay_dm_instance_remove_all_t(anjay_t *anjay,
+                               const anjay_dm_object_def_t *const *obj_ptr);
+
 /**
  * A handler that creates an Object Instance.
  *
@@ -391,6 +418,52 @@ anjay_dm_resource_operations_t(anjay_t *anjay,
                                anjay_rid_t rid,
                                anjay_dm_resource_op_mask_t *out);
 
+/**
+ * Flag set in the array filled by @ref anjay_dm_instance_resources_t for each
+ * Resource that is PRESENT. It is never a valid result of
+ * @ref anjay_dm_resource_operations_t.
+ */
+#define ANJAY_DM_RESOURCE_PRESENT ((anjay_dm_resource_op_mask_t) (1 << 15))
+
+/**
+ * An optional handler that reports presence and supported operations of all
+ * SUPPORTED Resources (see @ref anjay_dm_supported_rids_t) of an Object
+ * Instance at once. Operations that traverse whole Instances (Read and
+ * Discover on an Object or Object Instance) use it instead of calling
+ * @ref anjay_dm_resource_present_t and @ref anjay_dm_resource_operations_t
+ * for each Resource separately.
+ *
+ * The per-Resource handlers still need to be implemented, as they are used
+ * for operations on single Resources. Both ways of querying MUST report
+ * consistent results.
+ *
+ * @param anjay   Anjay object to operate on.
+ * @param obj_ptr Object definition pointer, as passed to
+ *                @ref anjay_register_object .
+ * @param iid     Checked Instance ID.
+ * @param out     Array of <c>(*obj_ptr)->supported_rids.count</c> elements,
+ *                initially zeroed. For each Resource that is PRESENT, the
+ *                element with the same index as the Resource ID in
+ *                <c>supported_rids.rids</c> shall be set to
+ *                @ref ANJAY_DM_RESOURCE_PRESENT combined with the same
+ *                @ref anjay_dm_resource_op_bit_t flags that
+ *                @ref anjay_dm_resource_operations_t would return. If
+ *                <c>resource_operations</c> is not implemented, the operation
+ *                flags are ignored and all operations are assumed supported.
+ *
+ * @returns This handler should return:
+ * - 0 on success,
+ * - a negative value in case of error. If it returns one of ANJAY_ERR_
+ *   constants, the response message will have an appropriate CoAP response
+ *   code. Otherwise, the device will respond with an unspecified (but valid)
+ *   error code.
+ */
+typedef int
+anjay_dm_instance_resources_t(anjay_t *anjay,
+                              const anjay_dm_object_def_t *const *obj_ptr,
+                              anjay_iid_t iid,
+                              anjay_dm_resource_op_mask_t *out);
+
 /**
  * A handler that reads the Resource value, called only if the Resource is
  * PRESENT (see @ref anjay_dm_resource_present_t).
@@ -422,6 +495,36 @@ typedef int anjay_dm_resource_read_t(anjay_t *anjay,
                                      anjay_rid_t rid,
                                      anjay_output_ctx_t *ctx);
 
+/**
+ * An optional handler that reads all readable Resources of an Object Instance
+ * in a single call. If implemented, it is used instead of calling
+ * @ref anjay_dm_resource_present_t , @ref anjay_dm_resource_operations_t and
+ * @ref anjay_dm_resource_read_t for each Resource when a whole Instance is
+ * read, either by a Read request or when evaluating an Observe relation, which
+ * allows taking a single consistent snapshot of the Instance.
+ *
+ * For each Resource that is PRESENT and readable, the handler shall call
+ * @ref anjay_ret_resource_id , followed by exactly one of the anjay_ret_*
+ * functions returning its value. Resources SHOULD be returned in order of
+ * ascending Resource IDs. @ref anjay_dm_resource_read_t still needs to be
+ * implemented, as it is used for reading single Resources.
+ *
+ * @param anjay   Anjay object to operate on.
+ * @param obj_ptr Object definition pointer, as passed to
+ *                @ref anjay_register_object .
+ * @param iid     Object Instance ID.
+ * @param ctx     Output context to write the Resource IDs and values to.
+ *
+ * @returns This handler should return:
+ * - 0 on success,
+ * - a negative value in case of error. If it returns one of ANJAY_ERR_
+ *   constants, it will be used as a hint for the CoAP response code to use.
+ */
+typedef int anjay_dm_instance_read_t(anjay_t *anjay,
+                                     const anjay_dm_object_def_t *const *obj_ptr,
+                                     anjay_iid_t iid,
+                                     anjay_output_ctx_t *ctx);
+
 /**
  * A handler that writes the Resource value.
  *
@@ -556,6 +659,7 @@ typedef int anjay_dm_resource_write_attrs_t(anjay_t *anjay,
  * then it will not be possible to perform operations listed below):
  *  - @ref anjay_dm_instance_create_t
  *  - @ref anjay_dm_instance_remove_t
+ *  - @ref anjay_dm_instance_remove_all_t
  *  - @ref anjay_dm_instance_reset_t
  *  - @ref anjay_dm_resource_write_t
  *  - @ref anjay_dm_transaction_commit_t
@@ -670,6 +774,8 @@ typedef struct {
     anjay_dm_instance_create_t *instance_create;
     /** Delete an Object Instance, @ref anjay_dm_instance_remove_t */
     anjay_dm_instance_remove_t *instance_remove;
+    /** Delete all Instances of an Object at once, @ref anjay_dm_instance_remove_all_t */
+    anjay_dm_instance_remove_all_t *instance_remove_all;
 
     /** Get default Object Instance attributes, @ref anjay_dm_instance_read_default_attrs_t */
     anjay_dm_instance_read_default_attrs_t *instance_read_default_attrs;
@@ -680,9 +786,13 @@ typedef struct {
     anjay_dm_resource_present_t *resource_present;
     /** Returns a mask of supported operations on a given Resource, @ref anjay_dm_resource_operations_t */
     anjay_dm_resource_operations_t *resource_operations;
+    /** Check presence and operations of all Resources in given Object Instance at once, @ref anjay_dm_instance_resources_t */
+    anjay_dm_instance_resources_t *instance_resources;
 
     /** Get Resource value, @ref anjay_dm_resource_read_t */
     anjay_dm_resource_read_t *resource_read;
+    /** Get values of all Resources in given Object Instance at once, @ref anjay_dm_instance_read_t */
+    anjay_dm_instance_read_t *instance_read;
     /** Set Resource value, @ref anjay_dm_resource_write_t */
     anjay_dm_resource_write_t *resource_write;
     /** Perform Execute action on a Resource, @ref anjay_dm_resource_execute_t */
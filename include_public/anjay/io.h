@@ -226,6 +226,18 @@ anjay_output_ctx_t *anjay_ret_array_start(anjay_output_ctx_t *ctx);
  */
 int anjay_ret_array_index(anjay_output_ctx_t *array_ctx, anjay_riid_t index);
 
+/**
+ * Assigns a Resource ID to the next value returned using one of the
+ * anjay_ret_* functions. May only be used from within the
+ * @ref anjay_dm_instance_read_t handler.
+ *
+ * @param ctx Output context passed to the handler.
+ * @param rid Resource ID to assign.
+ *
+ * @returns 0 on success, a negative value in case of error.
+ */
+int anjay_ret_resource_id(anjay_output_ctx_t *ctx, anjay_rid_t rid);
+
 /**
  * Finished an array of values returned from the data model and cleans up
  * the @p array_ctx .
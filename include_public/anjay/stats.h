@@ -16,6 +16,8 @@
 #ifndef ANJAY_INCLUDE_ANJAY_STATS_H
 #define ANJAY_INCLUDE_ANJAY_STATS_H
 
+#include <anjay/core.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -51,6 +53,88 @@ uint64_t anjay_get_num_incoming_retransmissions(anjay_t *anjay);
  */
 uint64_t anjay_get_num_outgoing_retransmissions(anjay_t *anjay);
 
+/**
+ * @returns the number of DTLS handshakes performed by the client that
+ *          established a new session.
+ *
+ * NOTE: When WITH_NET_STATS is disabled this function always return 0.
+ */
+uint64_t anjay_get_num_dtls_full_handshakes(anjay_t *anjay);
+
+/**
+ * @returns the number of DTLS handshakes performed by the client that resumed
+ *          a previous session, including ones restored using
+ *          @ref anjay_security_object_restore_dtls_sessions .
+ *
+ * NOTE: When WITH_NET_STATS is disabled this function always return 0.
+ */
+uint64_t anjay_get_num_dtls_resumed_handshakes(anjay_t *anjay);
+
+/** Number of buckets in @ref anjay_latency_histogram_t . */
+#define ANJAY_LATENCY_HISTOGRAM_BUCKETS 12
+
+/** Upper bound of the first bucket in @ref anjay_latency_histogram_t . */
+#define ANJAY_LATENCY_HISTOGRAM_FIRST_BUCKET_MS 16
+
+/**
+ * Histogram of round-trip times of a specific kind of exchanges, measured from
+ * sending the request (including any retransmissions) until receiving the
+ * response.
+ *
+ * <c>buckets[0]</c> counts exchanges that took less than
+ * @ref ANJAY_LATENCY_HISTOGRAM_FIRST_BUCKET_MS milliseconds. Upper bound of
+ * each subsequent bucket is twice as large as that of the previous one, except
+ * for the last bucket, which counts all the exchanges that took longer.
+ *
+ * Exchanges that did not receive any response are not counted.
+ */
+typedef struct {
+    uint64_t buckets[ANJAY_LATENCY_HISTOGRAM_BUCKETS];
+} anjay_latency_histogram_t;
+
+/**
+ * Statistics of communication with a single LwM2M Server. Traffic that is not
+ * related to any server (e.g. firmware downloads) is not included.
+ */
+typedef struct {
+    /** Number of bytes sent to the server, including retransmissions. */
+    uint64_t tx_bytes;
+    /** Number of bytes received from the server. */
+    uint64_t rx_bytes;
+    /** Number of CoAP messages received from the server. */
+    uint64_t num_incoming_messages;
+    /** Number of duplicate requests received from the server, answered using
+     * the response cache (see @ref anjay_configuration_t::msg_cache_size )
+     * without handling them again. */
+    uint64_t num_incoming_retransmissions;
+    /** Number of messages retransmitted to the server. */
+    uint64_t num_outgoing_retransmissions;
+    /** Round-trip times of Register requests. */
+    anjay_latency_histogram_t register_latency;
+    /** Round-trip times of Update requests. */
+    anjay_latency_histogram_t update_latency;
+    /** Round-trip times of Confirmable Notify messages. */
+    anjay_latency_histogram_t notify_latency;
+} anjay_server_stats_t;
+
+/**
+ * Retrieves statistics of communication with the server @p ssid, collected
+ * since @ref anjay_new . They are kept when the server is disabled or deleted.
+ *
+ * @param anjay     Anjay object to operate on.
+ * @param ssid      Short Server ID of the server to query, or
+ *                  @ref ANJAY_SSID_BOOTSTRAP for the Bootstrap Server.
+ * @param out_stats Structure to fill with the statistics.
+ *
+ * @returns 0 on success, or a negative value if no communication with the
+ *          server @p ssid has taken place.
+ *
+ * NOTE: When WITH_NET_STATS is disabled this function always fails.
+ */
+int anjay_get_server_stats(anjay_t *anjay,
+                           anjay_ssid_t ssid,
+                           anjay_server_stats_t *out_stats);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_INCLUDE_ANJAY_TRACE_H
+#define ANJAY_INCLUDE_ANJAY_TRACE_H
+
+#include <avsystem/commons/stream.h>
+#include <avsystem/commons/time.h>
+
+#include <anjay/core.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    /** Beginning of a traced operation. */
+    ANJAY_TRACE_BEGIN,
+    /** End of the traced operation most recently begun. */
+    ANJAY_TRACE_END
+} anjay_trace_phase_t;
+
+/**
+ * A single trace point. Begin and end events are always properly nested.
+ */
+typedef struct {
+    anjay_trace_phase_t phase;
+    /**
+     * Component that emitted the event: "coap" for CoAP message handling,
+     * "dm" for data model handler calls, "observe" for notification triggers,
+     * "sched" for scheduler jobs and "net" for sending ("send") and receiving
+     * ("recv") CoAP messages on LwM2M server connections. Transfers made by
+     * the downloader are not traced.
+     */
+    const char *category;
+    /**
+     * Name of the traced operation, e.g. name of the data model handler. Both
+     * @ref anjay_trace_event_t::category and this string are static.
+     */
+    const char *name;
+    /**
+     * Additional information about the operation: Object ID for data model
+     * handlers, address of the job callback for scheduler jobs, 0 otherwise.
+     */
+    uintptr_t detail;
+    /** Time at which the event occurred. */
+    avs_time_monotonic_t timestamp;
+} anjay_trace_event_t;
+
+/**
+ * Called synchronously for every trace point. It shall not call any Anjay
+ * functions, and it shall return as quickly as possible, as it is called on
+ * hot paths of the library.
+ */
+typedef void anjay_trace_handler_t(void *arg, const anjay_trace_event_t *event);
+
+/**
+ * Sets a function to be called on every trace point reached by the library.
+ *
+ * @param anjay   Anjay object to operate on.
+ * @param handler Trace handler, or NULL to disable tracing.
+ * @param arg     Opaque argument passed to @p handler.
+ *
+ * @returns 0 on success, a negative value if tracing is not supported.
+ *
+ * NOTE: When WITH_TRACE is disabled, trace points are not compiled in at all
+ * and this function always fails.
+ */
+int anjay_set_trace_handler(anjay_t *anjay,
+                            anjay_trace_handler_t *handler,
+                            void *arg);
+
+/**
+ * Trace handler that writes events to an <c>avs_stream_abstract_t *</c>,
+ * passed as @p stream, in the Trace Event Format used by Chrome's
+ * <c>about:tracing</c> and Perfetto.
+ *
+ * Each event is written as a single line, terminated with a comma. The
+ * application shall write the opening <c>[</c> character before the first
+ * event - the closing bracket is optional in that format.
+ *
+ * Write errors are ignored.
+ */
+void anjay_trace_chrome_json(void *stream, const anjay_trace_event_t *event);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+#endif /* ANJAY_INCLUDE_ANJAY_TRACE_H */
@@ -20,6 +20,7 @@
 #include <avsystem/commons/stream.h>
 
 #include <anjay/dm.h>
+#include <anjay/persistence.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -62,6 +63,37 @@ int anjay_access_control_persist(anjay_t *anjay,
 int anjay_access_control_restore(anjay_t *anjay,
                                  avs_stream_abstract_t *in_stream);
 
+/**
+ * Appends changes made to Access Control Object Instances since the last call
+ * to @ref anjay_access_control_persist_journal or
+ * @ref anjay_access_control_restore_journal to the @p out_stream. If the
+ * @p journal contains no checkpoint, all Instances are written.
+ *
+ * See @ref anjay_persistence_journal_new for details on the journal format and
+ * @ref anjay_persistence_journal_needs_compaction for compacting it.
+ *
+ * @param anjay         ANJAY object with the Access Control module installed
+ * @param journal       journal tracking the Access Control Object
+ * @param out_stream    stream to append to
+ * @return 0 in case of success, negative value in case of an error
+ */
+int anjay_access_control_persist_journal(anjay_t *anjay,
+                                         anjay_persistence_journal_t *journal,
+                                         avs_stream_abstract_t *out_stream);
+
+/**
+ * Tries to restore Access Control Object Instances from a journal stream
+ * written with @ref anjay_access_control_persist_journal.
+ *
+ * @param anjay         ANJAY object with the Access Control module installed
+ * @param journal       journal that will track the Access Control Object
+ * @param in_stream     stream used for reading Access Control Object Instances
+ * @return 0 in case of success, negative value in case of an error
+ */
+int anjay_access_control_restore_journal(anjay_t *anjay,
+                                         anjay_persistence_journal_t *journal,
+                                         avs_stream_abstract_t *in_stream);
+
 /**
  * Assign permissions for Instance /OID/IID to a particular server.
  *
@@ -47,9 +47,9 @@ static int handle_acl(anjay_persistence_context_t *ctx,
     return retval;
 }
 
-static int persist_instance(anjay_persistence_context_t *ctx,
-                            void *element_,
-                            void *user_data) {
+static int handle_instance(anjay_persistence_context_t *ctx,
+                           void *element_,
+                           void *user_data) {
     (void) user_data;
     access_control_instance_t *element = (access_control_instance_t *) element_;
     anjay_iid_t target_iid = (anjay_iid_t) element->target.iid;
@@ -62,6 +62,9 @@ static int persist_instance(anjay_persistence_context_t *ctx,
                 || (retval = anjay_persistence_u16(ctx, &target_iid))
                 || (retval = anjay_persistence_u16(ctx, &element->owner))
                 || (retval = handle_acl(ctx, element)));
+    if (!retval) {
+        element->target.iid = target_iid;
+    }
     return retval;
 }
 
@@ -170,10 +173,10 @@ int anjay_access_control_persist(anjay_t *anjay,
         ac_log(ERROR, "Out of memory");
         return -1;
     }
-    retval = anjay_persistence_list(ctx,
-                                    (AVS_LIST(void) *) &ac->current.instances,
-                                    sizeof(*ac->current.instances),
-                                    persist_instance, NULL);
+    (void) ((retval = anjay_persistence_list(
+                     ctx, (AVS_LIST(void) *) &ac->current.instances,
+                     sizeof(*ac->current.instances), handle_instance, NULL))
+            || (retval = anjay_persistence_context_flush(ctx)));
     anjay_persistence_context_delete(ctx);
     return retval;
 }
@@ -200,6 +203,66 @@ int anjay_access_control_restore(anjay_t *anjay, avs_stream_abstract_t *in) {
     return restore(anjay, ac, in);
 }
 
+static const char JOURNAL_MAGIC[] = { 'A', 'C', 'O', 'J' };
+
+static int cleanup_instance(void *element) {
+    AVS_LIST_CLEAR(&((access_control_instance_t *) element)->acl);
+    return 0;
+}
+
+static const anjay_persistence_journal_list_def_t JOURNAL_DEF = {
+    .magic = JOURNAL_MAGIC,
+    .magic_size = sizeof(JOURNAL_MAGIC),
+    .element_size = sizeof(access_control_instance_t),
+    .handler = handle_instance,
+    .cleanup = cleanup_instance
+};
+
+int anjay_access_control_persist_journal(anjay_t *anjay,
+                                         anjay_persistence_journal_t *journal,
+                                         avs_stream_abstract_t *out) {
+    AVS_STATIC_ASSERT(offsetof(access_control_instance_t, iid) == 0,
+                      journal_id_offset);
+    access_control_t *ac = _anjay_access_control_get(anjay);
+    if (!ac) {
+        ac_log(ERROR, "Access Control not installed in this Anjay object");
+        return -1;
+    }
+    return anjay_persistence_journal_store_list(
+            journal, out, &JOURNAL_DEF,
+            (AVS_LIST(void) *) &ac->current.instances, NULL);
+}
+
+int anjay_access_control_restore_journal(anjay_t *anjay,
+                                         anjay_persistence_journal_t *journal,
+                                         avs_stream_abstract_t *in) {
+    access_control_t *ac = _anjay_access_control_get(anjay);
+    if (!ac) {
+        ac_log(ERROR, "Access Control not installed in this Anjay object");
+        return -1;
+    }
+
+    access_control_state_t state = { NULL };
+    int retval = anjay_persistence_journal_restore_list(
+            journal, in, &JOURNAL_DEF, (AVS_LIST(void) *) &state.instances,
+            NULL);
+    if (retval) {
+        return retval;
+    }
+    AVS_LIST(access_control_instance_t) *instance_ptr;
+    AVS_LIST(access_control_instance_t) instance_helper;
+    AVS_LIST_DELETABLE_FOREACH_PTR(instance_ptr, instance_helper,
+                                   &state.instances) {
+        if (!is_object_registered(anjay, (*instance_ptr)->target.oid)) {
+            cleanup_instance(*instance_ptr);
+            AVS_LIST_DELETE(instance_ptr);
+        }
+    }
+    _anjay_access_control_clear_state(&ac->current);
+    ac->current = state;
+    return 0;
+}
+
 #ifdef ANJAY_TEST
 #include "test/persistence.c"
 #endif // ANJAY_TEST
@@ -20,6 +20,7 @@
 #include <avsystem/commons/stream.h>
 
 #include <anjay/core.h>
+#include <anjay/persistence.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -60,16 +61,61 @@ int anjay_attr_storage_install(anjay_t *anjay);
 
 /**
  * Checks whether the attribute storage has been modified since last call to
- * @ref anjay_attr_storage_persist or @ref anjay_attr_storage_restore.
+ * @ref anjay_attr_storage_persist, @ref anjay_attr_storage_restore,
+ * @ref anjay_attr_storage_persist_journal or
+ * @ref anjay_attr_storage_restore_journal.
  */
 bool anjay_attr_storage_is_modified(anjay_t *anjay);
 
 int anjay_attr_storage_persist(anjay_t *anjay,
                                avs_stream_abstract_t *out_stream);
 
+/**
+ * Restores the attribute storage from a stream written with
+ * @ref anjay_attr_storage_persist. The storage is cleared on failure.
+ *
+ * The stream is read ahead in chunks, so it shall contain nothing but the
+ * persisted attribute storage; an empty stream restores an empty storage.
+ */
 int anjay_attr_storage_restore(anjay_t *anjay,
                                avs_stream_abstract_t *in_stream);
 
+/**
+ * Appends attributes that changed since the last call to
+ * @ref anjay_attr_storage_persist_journal or
+ * @ref anjay_attr_storage_restore_journal to @p out_stream. Changes are
+ * tracked per Object, i.e. all attributes set within an Object are written if
+ * any of them changed. If the @p journal contains no checkpoint, the whole
+ * attribute storage is written.
+ *
+ * See @ref anjay_persistence_journal_new for details on the journal format and
+ * @ref anjay_persistence_journal_needs_compaction for compacting it.
+ *
+ * @param anjay      ANJAY object with the Attribute Storage installed.
+ * @param journal    Journal tracking the attribute storage.
+ * @param out_stream Stream to append to.
+ *
+ * @returns 0 on success, or a negative value in case of error.
+ */
+int anjay_attr_storage_persist_journal(anjay_t *anjay,
+                                       anjay_persistence_journal_t *journal,
+                                       avs_stream_abstract_t *out_stream);
+
+/**
+ * Restores the attribute storage from a journal stream written with
+ * @ref anjay_attr_storage_persist_journal. As with
+ * @ref anjay_attr_storage_restore, the storage is cleared on failure.
+ *
+ * @param anjay     ANJAY object with the Attribute Storage installed.
+ * @param journal   Journal that will track the attribute storage.
+ * @param in_stream Stream to read from.
+ *
+ * @returns 0 on success, or a negative value in case of error.
+ */
+int anjay_attr_storage_restore_journal(anjay_t *anjay,
+                                       anjay_persistence_journal_t *journal,
+                                       avs_stream_abstract_t *in_stream);
+
 /**
  * Sets Object level attributes for the specified @p ssid.
  *
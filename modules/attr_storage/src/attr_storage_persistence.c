@@ -369,7 +369,9 @@ int _anjay_attr_storage_persist_inner(anjay_attr_storage_t *attr_storage,
         fas_log(ERROR, "Out of memory");
         return -1;
     }
-    retval = HANDLE_LIST(object, ctx, &attr_storage->objects, (void *) 2);
+    (void) ((retval = HANDLE_LIST(object, ctx, &attr_storage->objects,
+                                  (void *) 2))
+            || (retval = anjay_persistence_context_flush(ctx)));
     anjay_persistence_context_delete(ctx);
     return retval;
 }
@@ -400,8 +402,10 @@ int _anjay_attr_storage_restore_inner(anjay_t *anjay,
         return -1;
     }
 
+    // the attribute storage data is expected to fill the whole stream
+    // (see stream_at_end() above), so reading ahead of it is safe
     anjay_persistence_context_t *ctx =
-            anjay_persistence_restore_context_new(in);
+            anjay_persistence_buffered_restore_context_new(in);
     if (!ctx) {
         fas_log(ERROR, "Out of memory");
         retval = -1;
@@ -442,6 +446,86 @@ int anjay_attr_storage_restore(anjay_t *anjay, avs_stream_abstract_t *in) {
     }
     int retval = _anjay_attr_storage_restore_inner(anjay, fas, in);
     fas->modified_since_persist = (retval != 0);
+    // the storage is either replaced or cleared at this point
+    _anjay_discover_cache_invalidate(anjay, ANJAY_SSID_ANY,
+                                     &(const anjay_uri_path_t) {
+                                         .has_oid = false
+                                     });
+    return retval;
+}
+
+static const char JOURNAL_MAGIC[] = { 'F', 'A', 'S', 'J' };
+
+static int cleanup_object(void *object_) {
+    fas_object_entry_t *object = (fas_object_entry_t *) object_;
+    AVS_LIST_CLEAR(&object->default_attrs);
+    AVS_LIST_CLEAR(&object->instances) {
+        AVS_LIST_CLEAR(&object->instances->default_attrs);
+        AVS_LIST_CLEAR(&object->instances->resources) {
+            AVS_LIST_CLEAR(&object->instances->resources->attrs);
+        }
+    }
+    return 0;
+}
+
+/**
+ * Journal records hold whole Object entries, i.e. a change of any attribute
+ * causes all attributes within the same Object to be written again.
+ */
+static const anjay_persistence_journal_list_def_t JOURNAL_DEF = {
+    .magic = JOURNAL_MAGIC,
+    .magic_size = sizeof(JOURNAL_MAGIC),
+    .element_size = sizeof(fas_object_entry_t),
+    .handler = handle_object,
+    .cleanup = cleanup_object
+};
+
+int anjay_attr_storage_persist_journal(anjay_t *anjay,
+                                       anjay_persistence_journal_t *journal,
+                                       avs_stream_abstract_t *out) {
+    AVS_STATIC_ASSERT(offsetof(fas_object_entry_t, oid) == 0,
+                      journal_id_offset);
+    anjay_attr_storage_t *fas = _anjay_attr_storage_get(anjay);
+    if (!fas) {
+        fas_log(ERROR,
+                "Attribute Storage is not installed on this Anjay object");
+        return -1;
+    }
+    int retval = anjay_persistence_journal_store_list(
+            journal, out, &JOURNAL_DEF, (AVS_LIST(void) *) &fas->objects,
+            (void *) 2);
+    if (!retval) {
+        fas->modified_since_persist = false;
+    }
+    return retval;
+}
+
+int anjay_attr_storage_restore_journal(anjay_t *anjay,
+                                       anjay_persistence_journal_t *journal,
+                                       avs_stream_abstract_t *in) {
+    anjay_attr_storage_t *fas = _anjay_attr_storage_get(anjay);
+    if (!fas) {
+        fas_log(ERROR,
+                "Attribute Storage is not installed on this Anjay object");
+        return -1;
+    }
+    _anjay_attr_storage_clear(fas);
+    int retval;
+    (void) ((retval = anjay_persistence_journal_restore_list(
+                     journal, in, &JOURNAL_DEF,
+                     (AVS_LIST(void) *) &fas->objects, (void *) 2))
+            || (retval = (is_attr_storage_sane(fas) ? 0 : -1))
+            || (retval = clear_nonexistent_entries(anjay, fas)));
+    if (retval) {
+        _anjay_attr_storage_clear(fas);
+        anjay_persistence_journal_reset(journal);
+    }
+    fas->modified_since_persist = (retval != 0);
+    // the storage is either replaced or cleared at this point
+    _anjay_discover_cache_invalidate(anjay, ANJAY_SSID_ANY,
+                                     &(const anjay_uri_path_t) {
+                                         .has_oid = false
+                                     });
     return retval;
 }
 
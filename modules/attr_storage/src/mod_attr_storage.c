@@ -37,9 +37,11 @@ static anjay_dm_object_write_default_attrs_t object_write_default_attrs;
 static anjay_dm_instance_it_t instance_it;
 static anjay_dm_instance_present_t instance_present;
 static anjay_dm_instance_remove_t instance_remove;
+static anjay_dm_instance_remove_all_t instance_remove_all;
 static anjay_dm_instance_read_default_attrs_t instance_read_default_attrs;
 static anjay_dm_instance_write_default_attrs_t instance_write_default_attrs;
 static anjay_dm_resource_present_t resource_present;
+static anjay_dm_instance_resources_t instance_resources;
 static anjay_dm_resource_read_attrs_t resource_read_attrs;
 static anjay_dm_resource_write_attrs_t resource_write_attrs;
 static anjay_dm_transaction_begin_t transaction_begin;
@@ -62,9 +64,11 @@ const anjay_dm_module_t _anjay_attr_storage_MODULE = {
         .instance_it = instance_it,
         .instance_present = instance_present,
         .instance_remove = instance_remove,
+        .instance_remove_all = instance_remove_all,
         .instance_read_default_attrs = instance_read_default_attrs,
         .instance_write_default_attrs = instance_write_default_attrs,
         .resource_present = resource_present,
+        .instance_resources = instance_resources,
         .resource_read_attrs = resource_read_attrs,
         .resource_write_attrs = resource_write_attrs,
         .transaction_begin = transaction_begin,
@@ -814,6 +818,30 @@ static int instance_remove(anjay_t *anjay,
     return result;
 }
 
+static int instance_remove_all(anjay_t *anjay,
+                               const anjay_dm_object_def_t *const *obj_ptr) {
+    int result = _anjay_dm_instance_remove_all(anjay, obj_ptr,
+                                               &_anjay_attr_storage_MODULE);
+    if (result == 0) {
+        anjay_attr_storage_t *fas = get_fas(anjay);
+        AVS_LIST(fas_object_entry_t) *object_ptr = find_object(fas,
+                                                               (*obj_ptr)->oid);
+        if (object_ptr) {
+            while ((*object_ptr)->instances) {
+                remove_instance_entry(fas, &(*object_ptr)->instances);
+            }
+            remove_object_if_empty(object_ptr);
+        }
+        if (is_ssid_reference_object((*obj_ptr)->oid)) {
+            // no instance refers to any server any more
+            AVS_LIST(anjay_ssid_t) no_ssids = NULL;
+            remove_servers(fas, remove_attrs_for_servers_not_on_list,
+                           &no_ssids);
+        }
+    }
+    return result;
+}
+
 static int resource_present(anjay_t *anjay,
                             const anjay_dm_object_def_t *const *obj_ptr,
                             anjay_iid_t iid,
@@ -833,6 +861,43 @@ static int resource_present(anjay_t *anjay,
     return result;
 }
 
+static int instance_resources(anjay_t *anjay,
+                              const anjay_dm_object_def_t *const *obj_ptr,
+                              anjay_iid_t iid,
+                              anjay_dm_resource_op_mask_t *out) {
+    int result = _anjay_dm_instance_resources(anjay, obj_ptr, iid, out,
+                                              &_anjay_attr_storage_MODULE);
+    if (result) {
+        return result;
+    }
+    anjay_attr_storage_t *fas = get_fas(anjay);
+    AVS_LIST(fas_object_entry_t) *object_ptr = find_object(fas,
+                                                           (*obj_ptr)->oid);
+    AVS_LIST(fas_instance_entry_t) *instance_ptr =
+            object_ptr ? find_instance(*object_ptr, iid) : NULL;
+    if (!instance_ptr) {
+        return 0;
+    }
+    // both lists are sorted by Resource ID
+    const anjay_dm_supported_rids_t *rids = &(*obj_ptr)->supported_rids;
+    size_t i = 0;
+    AVS_LIST(fas_resource_entry_t) *resource_ptr = &(*instance_ptr)->resources;
+    while (*resource_ptr) {
+        while (i < rids->count && rids->rids[i] < (*resource_ptr)->rid) {
+            ++i;
+        }
+        if (i < rids->count && rids->rids[i] == (*resource_ptr)->rid
+                && !(out[i] & ANJAY_DM_RESOURCE_PRESENT)) {
+            remove_resource_entry(fas, resource_ptr);
+        } else {
+            resource_ptr = AVS_LIST_NEXT_PTR(resource_ptr);
+        }
+    }
+    remove_instance_if_empty(instance_ptr);
+    remove_object_if_empty(object_ptr);
+    return 0;
+}
+
 static void saved_state_reset(anjay_attr_storage_t *fas) {
     avs_stream_reset(fas->saved_state.persist_data);
     avs_stream_membuf_fit(fas->saved_state.persist_data);
@@ -39,6 +39,14 @@ typedef int anjay_persistence_cleanup_collection_element_t(void *element);
 /**
  * Creates context where each underlying operation writes passed value to the
  * stream.
+ *
+ * Values are encoded into an internal buffer, which is written to the stream
+ * in chunks of a few hundred bytes. Use @ref anjay_persistence_context_flush
+ * to write out any pending data before using the stream directly, and to check
+ * whether all data has been stored successfully. Pending data is also written
+ * out by @ref anjay_persistence_context_delete, but errors are not reported
+ * then.
+ *
  * @param stream    stream to operate on
  * @return          NULL on error during context construction, valid pointer
  *                  otherwise
@@ -56,6 +64,24 @@ anjay_persistence_store_context_new(avs_stream_abstract_t *stream);
 anjay_persistence_context_t *
 anjay_persistence_restore_context_new(avs_stream_abstract_t *stream);
 
+/**
+ * Creates context that behaves like one created with
+ * @ref anjay_persistence_restore_context_new, but reads the stream ahead in
+ * chunks of a few hundred bytes instead of issuing a separate read for each
+ * value.
+ *
+ * WARNING: Data past the end of the restored structure may be consumed from
+ * the stream and discarded along with the context. Use it only if nothing
+ * else is going to be read from the stream afterwards, and do not use other
+ * contexts on the same stream at the same time.
+ *
+ * @param stream    stream to operate on
+ * @return          NULL on error during context construction, valid pointer
+ *                  otherwise
+ */
+anjay_persistence_context_t *
+anjay_persistence_buffered_restore_context_new(avs_stream_abstract_t *stream);
+
 /**
  * Creates context where each underlying operation skips value.
  * @param stream    stream to operate on
@@ -65,6 +91,16 @@ anjay_persistence_restore_context_new(avs_stream_abstract_t *stream);
 anjay_persistence_context_t *
 anjay_persistence_ignore_context_new(avs_stream_abstract_t *stream);
 
+/**
+ * Writes any data buffered by a context created with
+ * @ref anjay_persistence_store_context_new to the underlying stream. Does
+ * nothing for other kinds of contexts.
+ *
+ * @param ctx       context to flush
+ * @return 0 in case of success, negative value in case of failure
+ */
+int anjay_persistence_context_flush(anjay_persistence_context_t *ctx);
+
 /**
  * Deletes @p ctx and frees memory associated with it.
  * Note: stream used to initialize context is not closed.
@@ -231,6 +267,162 @@ int anjay_persistence_tree(
         void *handler_user_ptr,
         anjay_persistence_cleanup_collection_element_t *cleanup);
 
+struct anjay_persistence_journal_struct;
+typedef struct anjay_persistence_journal_struct anjay_persistence_journal_t;
+
+/**
+ * Description of a list that can be persisted with
+ * @ref anjay_persistence_journal_store_list and restored with
+ * @ref anjay_persistence_journal_restore_list.
+ *
+ * Each element of such list MUST begin with a <c>uint16_t</c> identifier (e.g.
+ * an Object ID or an Instance ID), and the list MUST be sorted by that
+ * identifier in strictly ascending order.
+ */
+typedef struct {
+    /** Header written at the beginning of each journal section. */
+    const void *magic;
+    size_t magic_size;
+    /** Size of a single list element. */
+    size_t element_size;
+    /**
+     * Function called to persist or restore a single element. It is required
+     * to produce the same data each time it is called to persist an unchanged
+     * element.
+     */
+    anjay_persistence_handler_collection_element_t *handler;
+    /**
+     * Function called to free resources owned by an element before it is
+     * removed from the list. May be NULL.
+     */
+    anjay_persistence_cleanup_collection_element_t *cleanup;
+} anjay_persistence_journal_list_def_t;
+
+/**
+ * Creates a journal that allows persisting a list incrementally.
+ *
+ * A journal stream is a sequence of sections. The first section is a
+ * checkpoint, i.e. a copy of the whole list. Each subsequent call to
+ * @ref anjay_persistence_journal_store_list appends a section that contains
+ * only the elements that were added, changed or removed since the previous
+ * call. The stream is thus meant to be opened in append mode, e.g. with
+ * <c>fopen(..., "ab")</c>.
+ *
+ * The journal object remembers digests of the persisted elements. It needs to
+ * be primed with @ref anjay_persistence_journal_restore_list before appending
+ * to a stream that already contains data. A single journal object shall be
+ * used with a single stream and a single list only.
+ *
+ * @return NULL in case of an out-of-memory condition, valid pointer otherwise
+ */
+anjay_persistence_journal_t *anjay_persistence_journal_new(void);
+
+/**
+ * Deletes @p journal and frees memory associated with it.
+ *
+ * @param journal   journal to delete
+ */
+void anjay_persistence_journal_delete(anjay_persistence_journal_t *journal);
+
+/**
+ * Makes the next call to @ref anjay_persistence_journal_store_list write a
+ * checkpoint instead of a delta section. This is intended for compacting the
+ * journal: after calling this function, the application shall truncate the
+ * journal stream (or start a new one) before persisting.
+ *
+ * @param journal   journal to reset
+ */
+void anjay_persistence_journal_reset(anjay_persistence_journal_t *journal);
+
+/**
+ * Checks whether the journal stream shall be compacted, i.e. whether the
+ * application should call @ref anjay_persistence_journal_reset and truncate the
+ * journal stream before persisting next time.
+ *
+ * This is the case if the delta sections written since the last checkpoint
+ * take more space than a new checkpoint would, or if the journal does not
+ * contain a valid checkpoint at all.
+ *
+ * @param journal   journal to examine
+ * @return true if the journal shall be compacted, false otherwise
+ */
+bool anjay_persistence_journal_needs_compaction(
+        const anjay_persistence_journal_t *journal);
+
+/**
+ * Returns the size of the valid part of the stream last read by
+ * @ref anjay_persistence_journal_restore_list, i.e. the offset right after the
+ * last complete section. If an incomplete section has been discarded, the
+ * application may truncate the journal stream to this size instead of
+ * starting a new one; @ref anjay_persistence_journal_reset still needs to be
+ * called before persisting.
+ *
+ * @param journal   journal to examine
+ * @return number of bytes, or 0 if the journal has been reset since
+ */
+size_t anjay_persistence_journal_valid_size(
+        const anjay_persistence_journal_t *journal);
+
+/**
+ * Appends a journal section describing the current state of a list to
+ * @p out_stream.
+ *
+ * If the @p journal contains no checkpoint (i.e. it is freshly created or
+ * @ref anjay_persistence_journal_reset has been called), the section is a
+ * checkpoint containing the whole list. Otherwise, it contains only the
+ * elements that changed since the last call; if nothing changed, nothing is
+ * written.
+ *
+ * If this function fails, the contents of @p out_stream are unspecified and
+ * the next call will write a checkpoint, which shall be written to a new
+ * stream.
+ *
+ * @param journal          journal that tracks the list
+ * @param out_stream       stream to append the data to
+ * @param def              description of the list
+ * @param list_ptr         pointer to the list containing the data
+ * @param handler_user_ptr opaque pointer passed to each call to
+ *                         <c>def->handler</c>
+ * @return 0 in case of success, negative value in case of failure
+ */
+int anjay_persistence_journal_store_list(
+        anjay_persistence_journal_t *journal,
+        avs_stream_abstract_t *out_stream,
+        const anjay_persistence_journal_list_def_t *def,
+        AVS_LIST(void) *list_ptr,
+        void *handler_user_ptr);
+
+/**
+ * Reads the whole journal stream and rebuilds the list by replaying all its
+ * sections, starting with the last checkpoint. @p journal is updated to track
+ * the restored list, so that subsequent calls to
+ * @ref anjay_persistence_journal_store_list can append to the same stream.
+ *
+ * A section that cannot be read completely (e.g. because of a power loss while
+ * it was being appended), or whose records do not match their declared sizes,
+ * is discarded together with anything that follows it.
+ * @ref anjay_persistence_journal_needs_compaction will then return true, and
+ * @ref anjay_persistence_journal_store_list will fail until the journal is
+ * compacted, as anything appended would follow the discarded bytes.
+ *
+ * An empty stream is restored as an empty list.
+ *
+ * @param journal          journal that will track the list
+ * @param in_stream        stream to read from
+ * @param def              description of the list
+ * @param list_ptr         pointer to an empty list, that will be filled with
+ *                         the restored elements; it is left empty on failure
+ * @param handler_user_ptr opaque pointer passed to each call to
+ *                         <c>def->handler</c>
+ * @return 0 in case of success, negative value in case of failure
+ */
+int anjay_persistence_journal_restore_list(
+        anjay_persistence_journal_t *journal,
+        avs_stream_abstract_t *in_stream,
+        const anjay_persistence_journal_list_def_t *def,
+        AVS_LIST(void) *list_ptr,
+        void *handler_user_ptr);
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,8 +16,10 @@
 
 #include <config.h>
 
+#include <assert.h>
 #include <inttypes.h>
 #include <stdio.h>
+#include <string.h>
 
 #include <avsystem/commons/utils.h>
 
@@ -74,31 +76,121 @@ struct anjay_persistence_context_struct {
     persistence_handler_list_t *handle_list;
     persistence_handler_tree_t *handle_tree;
     avs_stream_abstract_t *stream;
+    // block buffer; unused if buffer_capacity is 0
+    size_t buffer_capacity;
+    // store: number of bytes not yet written to the stream;
+    // restore: number of bytes read from the stream
+    size_t buffer_size;
+    // restore: number of buffered bytes already consumed
+    size_t buffer_offset;
+    uint8_t buffer[];
 };
 
+/**
+ * Size of the block buffer used by store contexts and buffered restore
+ * contexts. Encoded values are collected there, so that the underlying stream
+ * is accessed in chunks of this size rather than once per value.
+ */
+#define PERSISTENCE_BUFFER_SIZE 512
+
+static int flush_buffer(anjay_persistence_context_t *ctx) {
+    if (!ctx->buffer_size) {
+        return 0;
+    }
+    int retval = avs_stream_write(ctx->stream, ctx->buffer, ctx->buffer_size);
+    ctx->buffer_size = 0;
+    return retval;
+}
+
+static int write_data(anjay_persistence_context_t *ctx,
+                      const void *data,
+                      size_t size) {
+    if (ctx->buffer_size + size > ctx->buffer_capacity) {
+        int retval = flush_buffer(ctx);
+        if (retval) {
+            return retval;
+        }
+        if (size >= ctx->buffer_capacity) {
+            return avs_stream_write(ctx->stream, data, size);
+        }
+    }
+    memcpy(ctx->buffer + ctx->buffer_size, data, size);
+    ctx->buffer_size += size;
+    return 0;
+}
+
+static int fill_buffer(anjay_persistence_context_t *ctx, size_t min_size) {
+    assert(ctx->buffer_offset == ctx->buffer_size);
+    assert(min_size <= ctx->buffer_capacity);
+    ctx->buffer_offset = 0;
+    ctx->buffer_size = 0;
+    while (ctx->buffer_size < min_size) {
+        size_t bytes_read;
+        char message_finished = 0;
+        int retval = avs_stream_read(ctx->stream, &bytes_read,
+                                     &message_finished,
+                                     ctx->buffer + ctx->buffer_size,
+                                     ctx->buffer_capacity - ctx->buffer_size);
+        if (retval) {
+            return retval;
+        }
+        ctx->buffer_size += bytes_read;
+        if (message_finished && ctx->buffer_size < min_size) {
+            persistence_log(ERROR, "Unexpected end of stream");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int read_data(anjay_persistence_context_t *ctx,
+                     void *data,
+                     size_t size) {
+    if (!ctx->buffer_capacity) {
+        return avs_stream_read_reliably(ctx->stream, data, size);
+    }
+    size_t buffered = ctx->buffer_size - ctx->buffer_offset;
+    if (buffered < size) {
+        memcpy(data, ctx->buffer + ctx->buffer_offset, buffered);
+        ctx->buffer_offset = ctx->buffer_size;
+        data = (uint8_t *) data + buffered;
+        size -= buffered;
+        if (size >= ctx->buffer_capacity) {
+            return avs_stream_read_reliably(ctx->stream, data, size);
+        }
+        int retval = fill_buffer(ctx, size);
+        if (retval) {
+            return retval;
+        }
+    }
+    memcpy(data, ctx->buffer + ctx->buffer_offset, size);
+    ctx->buffer_offset += size;
+    return 0;
+}
+
 //// PERSIST ///////////////////////////////////////////////////////////////////
 
 static int persist_bool(anjay_persistence_context_t *ctx, bool *value) {
     AVS_STATIC_ASSERT(sizeof(*value) == 1, bool_is_1byte);
-    return avs_stream_write(ctx->stream, value, 1);
+    return write_data(ctx, value, 1);
 }
 
 static int persist_bytes(anjay_persistence_context_t *ctx,
                          uint8_t *buffer,
                          size_t buffer_size) {
-    return avs_stream_write(ctx->stream, buffer, buffer_size);
+    return write_data(ctx, buffer, buffer_size);
 }
 
 static int persist_u16(anjay_persistence_context_t *ctx, uint16_t *value) {
     AVS_STATIC_ASSERT(sizeof(*value) == 2, u16_is_2bytes);
     uint16_t tmp = avs_convert_be16(*value);
-    return avs_stream_write(ctx->stream, &tmp, 2);
+    return write_data(ctx, &tmp, 2);
 }
 
 static int persist_u32(anjay_persistence_context_t *ctx, uint32_t *value) {
     AVS_STATIC_ASSERT(sizeof(*value) == 4, u32_is_4bytes);
     uint32_t tmp = avs_convert_be32(*value);
-    return avs_stream_write(ctx->stream, &tmp, 4);
+    return write_data(ctx, &tmp, 4);
 }
 
 static int persist_time(anjay_persistence_context_t *ctx, time_t *value) {
@@ -112,7 +204,7 @@ static int persist_double(anjay_persistence_context_t *ctx, double *value) {
     uint64_t value_be = _anjay_htond(*value);
     AVS_STATIC_ASSERT(sizeof(*value) == sizeof(value_be), double_is_64);
     AVS_STATIC_ASSERT(sizeof(value_be) == 8, u64_is_8bytes);
-    return avs_stream_write(ctx->stream, &value_be, 8);
+    return write_data(ctx, &value_be, 8);
 }
 
 static int persist_sized_buffer(anjay_persistence_context_t *ctx,
@@ -200,19 +292,19 @@ static int persist_tree(anjay_persistence_context_t *ctx,
 
 static int restore_bool(anjay_persistence_context_t *ctx, bool *out) {
     AVS_STATIC_ASSERT(sizeof(*out) == 1, bool_is_1byte);
-    return avs_stream_read_reliably(ctx->stream, out, 1);
+    return read_data(ctx, out, 1);
 }
 
 static int restore_bytes(anjay_persistence_context_t *ctx,
                          uint8_t *buffer,
                          size_t buffer_size) {
-    return avs_stream_read_reliably(ctx->stream, buffer, buffer_size);
+    return read_data(ctx, buffer, buffer_size);
 }
 
 static int restore_u16(anjay_persistence_context_t *ctx, uint16_t *out) {
     AVS_STATIC_ASSERT(sizeof(*out) == 2, u16_is_2bytes);
     uint16_t tmp;
-    int retval = avs_stream_read_reliably(ctx->stream, &tmp, 2);
+    int retval = read_data(ctx, &tmp, 2);
     if (!retval && out) {
         *out = avs_convert_be16(tmp);
     }
@@ -222,7 +314,7 @@ static int restore_u16(anjay_persistence_context_t *ctx, uint16_t *out) {
 static int restore_u32(anjay_persistence_context_t *ctx, uint32_t *out) {
     AVS_STATIC_ASSERT(sizeof(*out) == 4, u32_is_4bytes);
     uint32_t tmp;
-    int retval = avs_stream_read_reliably(ctx->stream, &tmp, 4);
+    int retval = read_data(ctx, &tmp, 4);
     if (!retval) {
         *out = avs_convert_be32(tmp);
     }
@@ -243,7 +335,7 @@ static int restore_double(anjay_persistence_context_t *ctx, double *out) {
     uint64_t tmp;
     AVS_STATIC_ASSERT(sizeof(*out) == sizeof(tmp), double_is_64);
     AVS_STATIC_ASSERT(sizeof(tmp) == 8, u64_is_8bytes);
-    int retval = avs_stream_read_reliably(ctx->stream, &tmp, 8);
+    int retval = read_data(ctx, &tmp, 8);
     if (!retval) {
         *out = _anjay_ntohd(tmp);
     }
@@ -368,7 +460,7 @@ static int ignore_bool(anjay_persistence_context_t *ctx, bool *out) {
     (void) out;
     bool tmp;
     AVS_STATIC_ASSERT(sizeof(*out) == 1, bool_is_1byte);
-    return avs_stream_read_reliably(ctx->stream, &tmp, 1);
+    return read_data(ctx, &tmp, 1);
 }
 
 #define PERSISTENCE_IGNORE_BYTES_BUFSIZE 512
@@ -381,8 +473,7 @@ static int ignore_bytes(anjay_persistence_context_t *ctx,
     while (buffer_size > 0) {
         size_t chunk_to_ignore =
                 buffer_size < sizeof(buf) ? buffer_size : sizeof(buf);
-        int retval =
-                avs_stream_read_reliably(ctx->stream, buf, chunk_to_ignore);
+        int retval = read_data(ctx, buf, chunk_to_ignore);
         if (retval) {
             return retval;
         }
@@ -395,14 +486,14 @@ static int ignore_u16(anjay_persistence_context_t *ctx, uint16_t *out) {
     (void) out;
     uint16_t tmp;
     AVS_STATIC_ASSERT(sizeof(*out) == 2, u16_is_2bytes);
-    return avs_stream_read_reliably(ctx->stream, &tmp, 2);
+    return read_data(ctx, &tmp, 2);
 }
 
 static int ignore_u32(anjay_persistence_context_t *ctx, uint32_t *out) {
     (void) out;
     uint32_t tmp;
     AVS_STATIC_ASSERT(sizeof(*out) == 4, u32_is_4bytes);
-    return avs_stream_read_reliably(ctx->stream, &tmp, 4);
+    return read_data(ctx, &tmp, 4);
 }
 
 static int ignore_double(anjay_persistence_context_t *ctx, double *out) {
@@ -410,7 +501,7 @@ static int ignore_double(anjay_persistence_context_t *ctx, double *out) {
     uint64_t tmp;
     AVS_STATIC_ASSERT(sizeof(*out) == sizeof(tmp), double_is_64);
     AVS_STATIC_ASSERT(sizeof(tmp) == 8, u64_is_8bytes);
-    return avs_stream_read_reliably(ctx->stream, &tmp, 8);
+    return read_data(ctx, &tmp, 8);
 }
 
 static int ignore_time(anjay_persistence_context_t *ctx, time_t *out) {
@@ -482,46 +573,64 @@ static int ignore_tree(anjay_persistence_context_t *ctx,
             Stream \
         }
 
-anjay_persistence_context_t *
-anjay_persistence_store_context_new(avs_stream_abstract_t *stream) {
-    if (!stream) {
+static anjay_persistence_context_t *
+create_context(const anjay_persistence_context_t *init,
+               size_t buffer_capacity) {
+    if (!init->stream) {
         return NULL;
     }
     anjay_persistence_context_t *ctx = (anjay_persistence_context_t *)
-            calloc(1, sizeof(anjay_persistence_context_t));
+            calloc(1, sizeof(anjay_persistence_context_t) + buffer_capacity);
     if (ctx) {
-        *ctx = (anjay_persistence_context_t) INIT_STORE_CONTEXT(stream);
+        *ctx = *init;
+        ctx->buffer_capacity = buffer_capacity;
     }
     return ctx;
 }
 
+static bool is_store_context(anjay_persistence_context_t *ctx) {
+    return ctx->handle_bytes == persist_bytes;
+}
+
+anjay_persistence_context_t *
+anjay_persistence_store_context_new(avs_stream_abstract_t *stream) {
+    return create_context(&(const anjay_persistence_context_t)
+                                  INIT_STORE_CONTEXT(stream),
+                          PERSISTENCE_BUFFER_SIZE);
+}
+
 anjay_persistence_context_t *
 anjay_persistence_restore_context_new(avs_stream_abstract_t *stream) {
-    if (!stream) {
-        return NULL;
-    }
-    anjay_persistence_context_t *ctx = (anjay_persistence_context_t *)
-            calloc(1, sizeof(anjay_persistence_context_t));
-    if (ctx) {
-        *ctx = (anjay_persistence_context_t) INIT_RESTORE_CONTEXT(stream);
-    }
-    return ctx;
+    return create_context(&(const anjay_persistence_context_t)
+                                  INIT_RESTORE_CONTEXT(stream),
+                          0);
+}
+
+anjay_persistence_context_t *
+anjay_persistence_buffered_restore_context_new(avs_stream_abstract_t *stream) {
+    return create_context(&(const anjay_persistence_context_t)
+                                  INIT_RESTORE_CONTEXT(stream),
+                          PERSISTENCE_BUFFER_SIZE);
 }
 
 anjay_persistence_context_t *
 anjay_persistence_ignore_context_new(avs_stream_abstract_t *stream) {
-    if (!stream) {
-        return NULL;
-    }
-    anjay_persistence_context_t *ctx = (anjay_persistence_context_t *)
-            calloc(1, sizeof(anjay_persistence_context_t));
-    if (ctx) {
-        *ctx = (anjay_persistence_context_t) INIT_IGNORE_CONTEXT(stream);
+    return create_context(&(const anjay_persistence_context_t)
+                                  INIT_IGNORE_CONTEXT(stream),
+                          0);
+}
+
+int anjay_persistence_context_flush(anjay_persistence_context_t *ctx) {
+    if (!ctx) {
+        return -1;
     }
-    return ctx;
+    return is_store_context(ctx) ? flush_buffer(ctx) : 0;
 }
 
 void anjay_persistence_context_delete(anjay_persistence_context_t *ctx) {
+    if (ctx && is_store_context(ctx) && flush_buffer(ctx)) {
+        persistence_log(ERROR, "Could not flush persisted data");
+    }
     free(ctx);
 }
 
@@ -0,0 +1,664 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <avsystem/commons/stream_v_table.h>
+
+#include <anjay/persistence.h>
+
+VISIBILITY_SOURCE_BEGIN
+
+#define persistence_log(...) _anjay_log(anjay_persistence, __VA_ARGS__)
+
+/**
+ * Journal stream format:
+ *
+ * section := magic[def->magic_size] type:u8 count:u32 record[count]
+ * record  := op:u8 id:u16 (size:u32 element[size])?
+ *
+ * element is present for RECORD_PUT only. A checkpoint section always begins
+ * from an empty list.
+ */
+typedef enum {
+    SECTION_CHECKPOINT = 'C',
+    SECTION_DELTA = 'D'
+} journal_section_type_t;
+
+typedef enum {
+    RECORD_REMOVE = 'R',
+    RECORD_PUT = 'P'
+} journal_record_op_t;
+
+#define SECTION_HEADER_SIZE(Def) ((Def)->magic_size + 1 + 4)
+#define RECORD_HEADER_SIZE (1 + 2)
+#define PUT_RECORD_SIZE(DataSize) (RECORD_HEADER_SIZE + 4 + (DataSize))
+
+typedef struct {
+    uint16_t id;
+    uint32_t size;
+    uint64_t digest;
+} journal_record_t;
+
+struct anjay_persistence_journal_struct {
+    // digests of elements as of the last section stored or restored, sorted
+    // by ID
+    AVS_LIST(journal_record_t) records;
+    bool has_checkpoint;
+    // size of a checkpoint section that would contain all of the records
+    size_t checkpoint_size;
+    // total size of delta sections since the last checkpoint
+    size_t deltas_size;
+    // size of the complete sections read by the last restore
+    size_t valid_size;
+    // set if the last restore discarded an incomplete section; anything
+    // appended to the stream would then follow the discarded bytes
+    bool tail_discarded;
+};
+
+static uint16_t element_id(const void *element) {
+    return *(const uint16_t *) element;
+}
+
+//// DIGEST STREAM /////////////////////////////////////////////////////////////
+
+/* 64-bit FNV-1a */
+#define DIGEST_OFFSET_BASIS UINT64_C(0xcbf29ce484222325)
+#define DIGEST_PRIME UINT64_C(0x100000001b3)
+
+typedef struct {
+    const avs_stream_v_table_t * const vtable;
+    uint64_t digest;
+    size_t size;
+} digest_stream_t;
+
+static int unimplemented() {
+    return -1;
+}
+
+static int digest_stream_write_some(avs_stream_abstract_t *stream_,
+                                    const void *buffer,
+                                    size_t *inout_data_length) {
+    digest_stream_t *stream = (digest_stream_t *) stream_;
+    const uint8_t *bytes = (const uint8_t *) buffer;
+    for (size_t i = 0; i < *inout_data_length; ++i) {
+        stream->digest = (stream->digest ^ bytes[i]) * DIGEST_PRIME;
+    }
+    stream->size += *inout_data_length;
+    return 0;
+}
+
+static const avs_stream_v_table_t DIGEST_STREAM_VTABLE = {
+    digest_stream_write_some,
+    (avs_stream_finish_message_t) unimplemented,
+    (avs_stream_read_t) unimplemented,
+    (avs_stream_peek_t) unimplemented,
+    (avs_stream_reset_t) unimplemented,
+    (avs_stream_close_t) unimplemented,
+    (avs_stream_errno_t) unimplemented,
+    NULL
+};
+
+//// COUNTING STREAM ///////////////////////////////////////////////////////////
+
+/**
+ * Read-only stream that passes the data through from @c backend, counting the
+ * bytes read. Used to verify record sizes declared in the journal.
+ */
+typedef struct {
+    const avs_stream_v_table_t * const vtable;
+    avs_stream_abstract_t *backend;
+    size_t offset;
+} counting_stream_t;
+
+static int counting_stream_read(avs_stream_abstract_t *stream_,
+                                size_t *out_bytes_read,
+                                char *out_message_finished,
+                                void *buffer,
+                                size_t buffer_length) {
+    counting_stream_t *stream = (counting_stream_t *) stream_;
+    size_t bytes_read = 0;
+    int retval = avs_stream_read(stream->backend, &bytes_read,
+                                 out_message_finished, buffer, buffer_length);
+    stream->offset += bytes_read;
+    if (out_bytes_read) {
+        *out_bytes_read = bytes_read;
+    }
+    return retval;
+}
+
+static int counting_stream_peek(avs_stream_abstract_t *stream,
+                                size_t offset) {
+    return avs_stream_peek(((counting_stream_t *) stream)->backend, offset);
+}
+
+static const avs_stream_v_table_t COUNTING_STREAM_VTABLE = {
+    (avs_stream_write_some_t) unimplemented,
+    (avs_stream_finish_message_t) unimplemented,
+    counting_stream_read,
+    counting_stream_peek,
+    (avs_stream_reset_t) unimplemented,
+    (avs_stream_close_t) unimplemented,
+    (avs_stream_errno_t) unimplemented,
+    NULL
+};
+
+//// RECORDS ///////////////////////////////////////////////////////////////////
+
+static int compute_record(journal_record_t *out_record,
+                          const anjay_persistence_journal_list_def_t *def,
+                          void *element,
+                          void *handler_user_ptr) {
+    digest_stream_t stream = { &DIGEST_STREAM_VTABLE, DIGEST_OFFSET_BASIS, 0 };
+    anjay_persistence_context_t *ctx = anjay_persistence_store_context_new(
+            (avs_stream_abstract_t *) &stream);
+    if (!ctx) {
+        persistence_log(ERROR, "Out of memory");
+        return -1;
+    }
+    int retval;
+    (void) ((retval = def->handler(ctx, element, handler_user_ptr))
+            || (retval = anjay_persistence_context_flush(ctx)));
+    anjay_persistence_context_delete(ctx);
+    if (retval) {
+        return retval;
+    }
+    if (stream.size > UINT32_MAX) {
+        persistence_log(ERROR, "Element too big to persist");
+        return -1;
+    }
+    out_record->id = element_id(element);
+    out_record->size = (uint32_t) stream.size;
+    out_record->digest = stream.digest;
+    return 0;
+}
+
+static int collect_records(AVS_LIST(journal_record_t) *out_records,
+                           const anjay_persistence_journal_list_def_t *def,
+                           AVS_LIST(void) list,
+                           void *handler_user_ptr) {
+    assert(!*out_records);
+    AVS_LIST(journal_record_t) *tail = out_records;
+    int32_t last_id = -1;
+    AVS_LIST(void) element;
+    AVS_LIST_FOREACH(element, list) {
+        if (element_id(element) <= last_id) {
+            persistence_log(ERROR, "List is not sorted by ID");
+            return -1;
+        }
+        last_id = element_id(element);
+        if (!(*tail = AVS_LIST_NEW_ELEMENT(journal_record_t))) {
+            persistence_log(ERROR, "Out of memory");
+            return -1;
+        }
+        int retval = compute_record(*tail, def, element, handler_user_ptr);
+        if (retval) {
+            return retval;
+        }
+        tail = AVS_LIST_NEXT_PTR(tail);
+    }
+    return 0;
+}
+
+static size_t checkpoint_size(const anjay_persistence_journal_list_def_t *def,
+                              AVS_LIST(journal_record_t) records) {
+    size_t result = SECTION_HEADER_SIZE(def);
+    AVS_LIST(journal_record_t) record;
+    AVS_LIST_FOREACH(record, records) {
+        result += PUT_RECORD_SIZE(record->size);
+    }
+    return result;
+}
+
+//// STORE /////////////////////////////////////////////////////////////////////
+
+static int write_record(anjay_persistence_context_t *ctx,
+                        const anjay_persistence_journal_list_def_t *def,
+                        journal_record_op_t op_,
+                        const journal_record_t *record,
+                        void *element,
+                        void *handler_user_ptr) {
+    uint8_t op = (uint8_t) op_;
+    uint16_t id = record->id;
+    int retval;
+    (void) ((retval = anjay_persistence_bytes(ctx, &op, 1))
+            || (retval = anjay_persistence_u16(ctx, &id)));
+    if (!retval && op_ == RECORD_PUT) {
+        uint32_t size = record->size;
+        (void) ((retval = anjay_persistence_u32(ctx, &size))
+                || (retval = def->handler(ctx, element, handler_user_ptr)));
+    }
+    return retval;
+}
+
+/**
+ * Walks through the old and new records, both sorted by ID, and writes the
+ * differences to @p ctx. If @p ctx is NULL, the differences are only counted.
+ */
+static int write_changes(anjay_persistence_context_t *ctx,
+                         const anjay_persistence_journal_list_def_t *def,
+                         AVS_LIST(journal_record_t) old_records,
+                         AVS_LIST(journal_record_t) new_records,
+                         AVS_LIST(void) list,
+                         void *handler_user_ptr,
+                         uint32_t *out_count,
+                         size_t *out_size) {
+    *out_count = 0;
+    *out_size = 0;
+    int retval = 0;
+    while (!retval && (old_records || new_records)) {
+        if (new_records
+                && (!old_records || new_records->id <= old_records->id)) {
+            if (!old_records || new_records->id < old_records->id
+                    || new_records->size != old_records->size
+                    || new_records->digest != old_records->digest) {
+                ++*out_count;
+                *out_size += PUT_RECORD_SIZE(new_records->size);
+                if (ctx) {
+                    retval = write_record(ctx, def, RECORD_PUT, new_records,
+                                          list, handler_user_ptr);
+                }
+            }
+            if (old_records && new_records->id == old_records->id) {
+                old_records = AVS_LIST_NEXT(old_records);
+            }
+            new_records = AVS_LIST_NEXT(new_records);
+            list = AVS_LIST_NEXT(list);
+        } else {
+            ++*out_count;
+            *out_size += RECORD_HEADER_SIZE;
+            if (ctx) {
+                retval = write_record(ctx, def, RECORD_REMOVE, old_records,
+                                      NULL, handler_user_ptr);
+            }
+            old_records = AVS_LIST_NEXT(old_records);
+        }
+    }
+    return retval;
+}
+
+static int write_section(avs_stream_abstract_t *out_stream,
+                         const anjay_persistence_journal_list_def_t *def,
+                         journal_section_type_t type_,
+                         uint32_t count,
+                         AVS_LIST(journal_record_t) old_records,
+                         AVS_LIST(journal_record_t) new_records,
+                         AVS_LIST(void) list,
+                         void *handler_user_ptr) {
+    int retval = avs_stream_write(out_stream, def->magic, def->magic_size);
+    if (retval) {
+        return retval;
+    }
+    anjay_persistence_context_t *ctx =
+            anjay_persistence_store_context_new(out_stream);
+    if (!ctx) {
+        persistence_log(ERROR, "Out of memory");
+        return -1;
+    }
+    uint8_t type = (uint8_t) type_;
+    uint32_t written_count;
+    size_t written_size;
+    (void) ((retval = anjay_persistence_bytes(ctx, &type, 1))
+            || (retval = anjay_persistence_u32(ctx, &count))
+            || (retval = write_changes(ctx, def, old_records, new_records,
+                                       list, handler_user_ptr,
+                                       &written_count, &written_size))
+            || (retval = anjay_persistence_context_flush(ctx)));
+    anjay_persistence_context_delete(ctx);
+    assert(retval || written_count == count);
+    return retval;
+}
+
+int anjay_persistence_journal_store_list(
+        anjay_persistence_journal_t *journal,
+        avs_stream_abstract_t *out_stream,
+        const anjay_persistence_journal_list_def_t *def,
+        AVS_LIST(void) *list_ptr,
+        void *handler_user_ptr) {
+    if (!journal || !out_stream || !def || !list_ptr) {
+        return -1;
+    }
+    if (journal->tail_discarded) {
+        persistence_log(ERROR, "Journal stream ends with a discarded section; "
+                               "it needs to be truncated and the journal "
+                               "reset before storing");
+        return -1;
+    }
+    AVS_LIST(journal_record_t) records = NULL;
+    int retval = collect_records(&records, def, *list_ptr, handler_user_ptr);
+    if (retval) {
+        AVS_LIST_CLEAR(&records);
+        return retval;
+    }
+
+    const bool is_checkpoint = !journal->has_checkpoint;
+    AVS_LIST(journal_record_t) old_records =
+            is_checkpoint ? NULL : journal->records;
+    uint32_t count;
+    size_t size;
+    (void) write_changes(NULL, def, old_records, records, *list_ptr,
+                         handler_user_ptr, &count, &size);
+    if (count || is_checkpoint) {
+        if ((retval = write_section(out_stream, def,
+                                    is_checkpoint ? SECTION_CHECKPOINT
+                                                  : SECTION_DELTA,
+                                    count, old_records, records, *list_ptr,
+                                    handler_user_ptr))) {
+            AVS_LIST_CLEAR(&records);
+            anjay_persistence_journal_reset(journal);
+            return retval;
+        }
+    }
+
+    if (is_checkpoint) {
+        journal->has_checkpoint = true;
+        journal->deltas_size = 0;
+    } else if (count) {
+        journal->deltas_size += SECTION_HEADER_SIZE(def) + size;
+    }
+    AVS_LIST_CLEAR(&journal->records);
+    journal->records = records;
+    journal->checkpoint_size = checkpoint_size(def, records);
+    return 0;
+}
+
+//// RESTORE ///////////////////////////////////////////////////////////////////
+
+typedef struct {
+    journal_record_op_t op;
+    uint16_t id;
+    AVS_LIST(void) element;
+} journal_entry_t;
+
+static void delete_element(const anjay_persistence_journal_list_def_t *def,
+                           AVS_LIST(void) *element_ptr) {
+    if (def->cleanup) {
+        def->cleanup(*element_ptr);
+    }
+    AVS_LIST_DELETE(element_ptr);
+}
+
+static void clear_elements(const anjay_persistence_journal_list_def_t *def,
+                           AVS_LIST(void) *list_ptr) {
+    while (*list_ptr) {
+        delete_element(def, list_ptr);
+    }
+}
+
+static void clear_entries(const anjay_persistence_journal_list_def_t *def,
+                          AVS_LIST(journal_entry_t) *entries_ptr) {
+    AVS_LIST_CLEAR(entries_ptr) {
+        if ((*entries_ptr)->element) {
+            delete_element(def, &(*entries_ptr)->element);
+        }
+    }
+}
+
+static int stream_at_end(avs_stream_abstract_t *in) {
+    if (avs_stream_peek(in, 0) != EOF) {
+        return 0; // data ahead
+    }
+
+    size_t bytes_read;
+    char message_finished;
+    char value;
+    int result = avs_stream_read(in, &bytes_read, &message_finished,
+                                 &value, sizeof(value));
+    if (!result && !bytes_read && message_finished) {
+        return 1;
+    }
+    return result < 0 ? result : -1;
+}
+
+static int read_magic(avs_stream_abstract_t *in,
+                      const anjay_persistence_journal_list_def_t *def) {
+    const uint8_t *magic = (const uint8_t *) def->magic;
+    for (size_t i = 0; i < def->magic_size; ++i) {
+        uint8_t byte;
+        int retval = avs_stream_read_reliably(in, &byte, 1);
+        if (retval) {
+            return retval;
+        }
+        if (byte != magic[i]) {
+            persistence_log(ERROR, "Journal section magic mismatch");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int read_entry(journal_entry_t *entry,
+                      const counting_stream_t *in,
+                      anjay_persistence_context_t *ctx,
+                      const anjay_persistence_journal_list_def_t *def,
+                      void *handler_user_ptr,
+                      size_t *inout_size) {
+    uint8_t op;
+    int retval;
+    if ((retval = anjay_persistence_bytes(ctx, &op, 1))
+            || (retval = anjay_persistence_u16(ctx, &entry->id))) {
+        return retval;
+    }
+    entry->op = (journal_record_op_t) op;
+    if (op == RECORD_REMOVE) {
+        *inout_size += RECORD_HEADER_SIZE;
+        return 0;
+    } else if (op != RECORD_PUT) {
+        persistence_log(ERROR, "Invalid journal record type: %d", (int) op);
+        return -1;
+    }
+
+    uint32_t size;
+    if ((retval = anjay_persistence_u32(ctx, &size))) {
+        return retval;
+    }
+    if (!(entry->element = AVS_LIST_NEW_BUFFER(def->element_size))) {
+        persistence_log(ERROR, "Out of memory");
+        return -1;
+    }
+    const size_t element_offset = in->offset;
+    if ((retval = def->handler(ctx, entry->element, handler_user_ptr))) {
+        return retval;
+    }
+    if (in->offset - element_offset != size) {
+        persistence_log(ERROR, "Journal record size mismatch");
+        return -1;
+    }
+    if (element_id(entry->element) != entry->id) {
+        persistence_log(ERROR, "Journal record ID mismatch");
+        return -1;
+    }
+    *inout_size += PUT_RECORD_SIZE(size);
+    return 0;
+}
+
+static int read_section(counting_stream_t *in,
+                        anjay_persistence_context_t *ctx,
+                        const anjay_persistence_journal_list_def_t *def,
+                        void *handler_user_ptr,
+                        journal_section_type_t *out_type,
+                        AVS_LIST(journal_entry_t) *out_entries,
+                        size_t *out_size) {
+    uint8_t type;
+    uint32_t count;
+    int retval;
+    if ((retval = read_magic((avs_stream_abstract_t *) in, def))
+            || (retval = anjay_persistence_bytes(ctx, &type, 1))
+            || (retval = anjay_persistence_u32(ctx, &count))) {
+        return retval;
+    }
+    if (type != SECTION_CHECKPOINT && type != SECTION_DELTA) {
+        persistence_log(ERROR, "Invalid journal section type: %d", (int) type);
+        return -1;
+    }
+    *out_type = (journal_section_type_t) type;
+    *out_size = SECTION_HEADER_SIZE(def);
+
+    AVS_LIST(journal_entry_t) *tail = out_entries;
+    while (count--) {
+        if (!(*tail = AVS_LIST_NEW_ELEMENT(journal_entry_t))) {
+            persistence_log(ERROR, "Out of memory");
+            return -1;
+        }
+        if ((retval = read_entry(*tail, in, ctx, def, handler_user_ptr,
+                                 out_size))) {
+            return retval;
+        }
+        tail = AVS_LIST_NEXT_PTR(tail);
+    }
+    return 0;
+}
+
+static void apply_entries(const anjay_persistence_journal_list_def_t *def,
+                          AVS_LIST(void) *list_ptr,
+                          AVS_LIST(journal_entry_t) *entries_ptr) {
+    AVS_LIST_CLEAR(entries_ptr) {
+        journal_entry_t *entry = *entries_ptr;
+        AVS_LIST(void) *element_ptr = list_ptr;
+        while (*element_ptr && element_id(*element_ptr) < entry->id) {
+            element_ptr = AVS_LIST_NEXT_PTR(element_ptr);
+        }
+        if (*element_ptr && element_id(*element_ptr) == entry->id) {
+            delete_element(def, element_ptr);
+        }
+        if (entry->element) {
+            AVS_LIST_INSERT(element_ptr, entry->element);
+        }
+    }
+}
+
+static int replay_journal(anjay_persistence_journal_t *journal,
+                          counting_stream_t *in,
+                          anjay_persistence_context_t *ctx,
+                          const anjay_persistence_journal_list_def_t *def,
+                          AVS_LIST(void) *list_ptr,
+                          void *handler_user_ptr) {
+    while (true) {
+        int retval = stream_at_end((avs_stream_abstract_t *) in);
+        if (retval) {
+            return retval < 0 ? retval : 0;
+        }
+
+        journal_section_type_t type = SECTION_DELTA;
+        AVS_LIST(journal_entry_t) entries = NULL;
+        size_t size = 0;
+        retval = read_section(in, ctx, def, handler_user_ptr,
+                              &type, &entries, &size);
+        if (!retval && type == SECTION_DELTA && !journal->has_checkpoint) {
+            persistence_log(ERROR, "Journal does not begin with a checkpoint");
+            retval = -1;
+        }
+        if (retval) {
+            clear_entries(def, &entries);
+            if (!journal->has_checkpoint) {
+                return retval;
+            }
+            persistence_log(WARNING, "Discarding incomplete journal section "
+                                     "at offset %lu",
+                            (unsigned long) journal->valid_size);
+            journal->has_checkpoint = false;
+            journal->tail_discarded = true;
+            return 0;
+        }
+        journal->valid_size = in->offset;
+
+        if (type == SECTION_CHECKPOINT) {
+            clear_elements(def, list_ptr);
+            journal->has_checkpoint = true;
+            journal->deltas_size = 0;
+        } else {
+            journal->deltas_size += size;
+        }
+        apply_entries(def, list_ptr, &entries);
+    }
+}
+
+int anjay_persistence_journal_restore_list(
+        anjay_persistence_journal_t *journal,
+        avs_stream_abstract_t *in_stream,
+        const anjay_persistence_journal_list_def_t *def,
+        AVS_LIST(void) *list_ptr,
+        void *handler_user_ptr) {
+    if (!journal || !in_stream || !def || !list_ptr || *list_ptr) {
+        return -1;
+    }
+    anjay_persistence_journal_reset(journal);
+    counting_stream_t in = { &COUNTING_STREAM_VTABLE, in_stream, 0 };
+    anjay_persistence_context_t *ctx = anjay_persistence_restore_context_new(
+            (avs_stream_abstract_t *) &in);
+    if (!ctx) {
+        persistence_log(ERROR, "Out of memory");
+        return -1;
+    }
+    int retval;
+    (void) ((retval = replay_journal(journal, &in, ctx, def, list_ptr,
+                                     handler_user_ptr))
+            || (retval = collect_records(&journal->records, def, *list_ptr,
+                                         handler_user_ptr)));
+    anjay_persistence_context_delete(ctx);
+    if (retval) {
+        clear_elements(def, list_ptr);
+        anjay_persistence_journal_reset(journal);
+    } else {
+        journal->checkpoint_size = checkpoint_size(def, journal->records);
+    }
+    return retval;
+}
+
+//// JOURNAL OBJECT ////////////////////////////////////////////////////////////
+
+anjay_persistence_journal_t *anjay_persistence_journal_new(void) {
+    return (anjay_persistence_journal_t *)
+            calloc(1, sizeof(anjay_persistence_journal_t));
+}
+
+void anjay_persistence_journal_delete(anjay_persistence_journal_t *journal) {
+    if (journal) {
+        AVS_LIST_CLEAR(&journal->records);
+        free(journal);
+    }
+}
+
+void anjay_persistence_journal_reset(anjay_persistence_journal_t *journal) {
+    if (journal) {
+        AVS_LIST_CLEAR(&journal->records);
+        journal->has_checkpoint = false;
+        journal->checkpoint_size = 0;
+        journal->deltas_size = 0;
+        journal->valid_size = 0;
+        journal->tail_discarded = false;
+    }
+}
+
+size_t anjay_persistence_journal_valid_size(
+        const anjay_persistence_journal_t *journal) {
+    return journal ? journal->valid_size : 0;
+}
+
+bool anjay_persistence_journal_needs_compaction(
+        const anjay_persistence_journal_t *journal) {
+    return journal
+            && (!journal->has_checkpoint
+                    || journal->deltas_size > journal->checkpoint_size);
+}
+
+#ifdef ANJAY_TEST
+#include "test/persistence_journal.c"
+#endif
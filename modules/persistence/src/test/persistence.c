@@ -17,6 +17,8 @@
 #include <avsystem/commons/list.h>
 #include <avsystem/commons/stream.h>
 #include <avsystem/commons/stream/stream_membuf.h>
+#include <avsystem/commons/stream_v_table.h>
+#include <avsystem/commons/time.h>
 #include <avsystem/commons/unit/test.h>
 
 #include <anjay_test/utils.h>
@@ -86,6 +88,7 @@ AVS_UNIT_TEST(persistence, bytes_store_restore) {
     AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_u32(store_ctx, &buffer_size));
     AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_bytes(
             store_ctx, (uint8_t *) (intptr_t) BUFFER, buffer_size));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_context_flush(store_ctx));
 
     uint8_t result[128];
     uint32_t result_size;
@@ -108,6 +111,7 @@ AVS_UNIT_TEST(persistence, bytes_restore_too_much) {
     AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_u32(store_ctx, &buffer_size));
     AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_bytes(
             store_ctx, (uint8_t *) (intptr_t) BUFFER, buffer_size));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_context_flush(store_ctx));
 
     uint8_t result[128];
     uint32_t result_size;
@@ -130,6 +134,7 @@ AVS_UNIT_TEST(persistence, bytes_ignore) {
     AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_u32(store_ctx, &buffer_size));
     AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_bytes(
             store_ctx, (uint8_t *) (intptr_t) BUFFER, buffer_size));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_context_flush(store_ctx));
 
     AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_u32(ignore_ctx, NULL));
     AVS_UNIT_ASSERT_SUCCESS(
@@ -156,6 +161,7 @@ AVS_UNIT_TEST(persistence, bytes_ignore_multiphase) {
     AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_bytes(
             store_ctx, (uint8_t *) (intptr_t) buffer, buffer_size));
     AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_u32(store_ctx, &magic));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_context_flush(store_ctx));
 
     AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_u32(ignore_ctx, NULL));
     AVS_UNIT_ASSERT_SUCCESS(
@@ -178,8 +184,217 @@ AVS_UNIT_TEST(persistence, bytes_ignore_too_much) {
     AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_u32(store_ctx, &buffer_size));
     AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_bytes(
             store_ctx, (uint8_t *) (intptr_t) BUFFER, buffer_size));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_context_flush(store_ctx));
 
     AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_u32(ignore_ctx, NULL));
     AVS_UNIT_ASSERT_FAILED(
             anjay_persistence_bytes(ignore_ctx, NULL, buffer_size + 1));
 }
+
+typedef struct {
+    const avs_stream_v_table_t *vtable;
+    avs_stream_abstract_t *backend;
+    size_t writes;
+    size_t reads;
+} counting_stream_t;
+
+static int counting_write_some(avs_stream_abstract_t *stream_,
+                               const void *buffer,
+                               size_t *inout_data_length) {
+    counting_stream_t *stream = (counting_stream_t *) stream_;
+    ++stream->writes;
+    return avs_stream_write(stream->backend, buffer, *inout_data_length);
+}
+
+static int counting_read(avs_stream_abstract_t *stream_,
+                         size_t *out_bytes_read,
+                         char *out_message_finished,
+                         void *buffer,
+                         size_t buffer_length) {
+    counting_stream_t *stream = (counting_stream_t *) stream_;
+    ++stream->reads;
+    return avs_stream_read(stream->backend, out_bytes_read,
+                           out_message_finished, buffer, buffer_length);
+}
+
+static const avs_stream_v_table_t COUNTING_STREAM_VTABLE = {
+    .write_some = counting_write_some,
+    .read = counting_read
+};
+
+#define COUNTING_STREAM_INIT(Backend) \
+    { &COUNTING_STREAM_VTABLE, (Backend), 0, 0 }
+
+AVS_UNIT_TEST(persistence, store_and_buffered_restore_in_blocks) {
+    SCOPED_PERSISTENCE_TEST_ENV(env);
+    counting_stream_t stream = COUNTING_STREAM_INIT(env->stream);
+
+    // 4000 bytes in total
+    const uint32_t COUNT = 1000;
+    anjay_persistence_context_t *store_ctx =
+            anjay_persistence_store_context_new(
+                    (avs_stream_abstract_t *) &stream);
+    AVS_UNIT_ASSERT_NOT_NULL(store_ctx);
+    for (uint32_t i = 0; i < COUNT; ++i) {
+        uint32_t value = i;
+        AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_u32(store_ctx, &value));
+    }
+    AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_context_flush(store_ctx));
+    anjay_persistence_context_delete(store_ctx);
+    AVS_UNIT_ASSERT_EQUAL(stream.writes,
+                          (4 * COUNT + PERSISTENCE_BUFFER_SIZE - 1)
+                                  / PERSISTENCE_BUFFER_SIZE);
+
+    anjay_persistence_context_t *restore_ctx =
+            anjay_persistence_buffered_restore_context_new(
+                    (avs_stream_abstract_t *) &stream);
+    AVS_UNIT_ASSERT_NOT_NULL(restore_ctx);
+    for (uint32_t i = 0; i < COUNT; ++i) {
+        uint32_t value;
+        AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_u32(restore_ctx, &value));
+        AVS_UNIT_ASSERT_EQUAL(value, i);
+    }
+    // nothing more to read
+    uint32_t value;
+    AVS_UNIT_ASSERT_FAILED(anjay_persistence_u32(restore_ctx, &value));
+    anjay_persistence_context_delete(restore_ctx);
+    AVS_UNIT_ASSERT_TRUE(stream.reads
+                         <= (4 * COUNT + PERSISTENCE_BUFFER_SIZE - 1)
+                                            / PERSISTENCE_BUFFER_SIZE
+                                    + 1);
+}
+
+// layout similar to a Resource entry persisted by the Attribute Storage
+typedef struct {
+    uint16_t oid;
+    uint16_t iid;
+    uint16_t rid;
+    uint16_t ssid;
+    uint32_t min_period;
+    uint32_t max_period;
+    double greater_than;
+    double less_than;
+    double step;
+} bench_attr_entry_t;
+
+static int handle_bench_attr_entry(anjay_persistence_context_t *ctx,
+                                   void *entry_,
+                                   void *user_data) {
+    (void) user_data;
+    bench_attr_entry_t *entry = (bench_attr_entry_t *) entry_;
+    int retval;
+    (void) ((retval = anjay_persistence_u16(ctx, &entry->oid))
+            || (retval = anjay_persistence_u16(ctx, &entry->iid))
+            || (retval = anjay_persistence_u16(ctx, &entry->rid))
+            || (retval = anjay_persistence_u16(ctx, &entry->ssid))
+            || (retval = anjay_persistence_u32(ctx, &entry->min_period))
+            || (retval = anjay_persistence_u32(ctx, &entry->max_period))
+            || (retval = anjay_persistence_double(ctx, &entry->greater_than))
+            || (retval = anjay_persistence_double(ctx, &entry->less_than))
+            || (retval = anjay_persistence_double(ctx, &entry->step)));
+    return retval;
+}
+
+#define BENCH_ATTR_ENTRIES 10000
+
+static int64_t elapsed_us(avs_time_monotonic_t start) {
+    int64_t result = 0;
+    AVS_UNIT_ASSERT_SUCCESS(avs_time_duration_to_scalar(
+            &result, AVS_TIME_US,
+            avs_time_monotonic_diff(avs_time_monotonic_now(), start)));
+    return result;
+}
+
+static void bench_restore(counting_stream_t *stream,
+                          persistence_context_constructor_t *constructor,
+                          AVS_LIST(bench_attr_entry_t) expected) {
+    const size_t reads_before = stream->reads;
+    AVS_LIST(bench_attr_entry_t) restored = NULL;
+    avs_time_monotonic_t start = avs_time_monotonic_now();
+    anjay_persistence_context_t *ctx =
+            constructor((avs_stream_abstract_t *) stream);
+    AVS_UNIT_ASSERT_NOT_NULL(ctx);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_list(
+            ctx, (AVS_LIST(void) *) &restored, sizeof(bench_attr_entry_t),
+            handle_bench_attr_entry, NULL));
+    anjay_persistence_context_delete(ctx);
+    const int64_t restore_us = elapsed_us(start);
+    persistence_log(INFO,
+                    "restoring %d attribute entries: %" PRId64
+                    " us, %lu stream reads",
+                    BENCH_ATTR_ENTRIES, restore_us,
+                    (unsigned long) (stream->reads - reads_before));
+
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(restored), BENCH_ATTR_ENTRIES);
+    AVS_LIST(bench_attr_entry_t) restored_entry = restored;
+    AVS_LIST(bench_attr_entry_t) expected_entry;
+    AVS_LIST_FOREACH(expected_entry, expected) {
+        AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(restored_entry, expected_entry,
+                                          sizeof(bench_attr_entry_t));
+        restored_entry = AVS_LIST_NEXT(restored_entry);
+    }
+    AVS_LIST_CLEAR(&restored);
+}
+
+AVS_UNIT_TEST(persistence, benchmark_attr_entries) {
+    SCOPED_PERSISTENCE_TEST_ENV(env);
+    counting_stream_t stream = COUNTING_STREAM_INIT(env->stream);
+
+    AVS_LIST(bench_attr_entry_t) entries = NULL;
+    AVS_LIST(bench_attr_entry_t) *append_ptr = &entries;
+    for (uint16_t i = 0; i < BENCH_ATTR_ENTRIES; ++i) {
+        AVS_UNIT_ASSERT_NOT_NULL(
+                (*append_ptr = AVS_LIST_NEW_ELEMENT(bench_attr_entry_t)));
+        **append_ptr = (bench_attr_entry_t) {
+            .oid = (uint16_t) (i / 1000),
+            .iid = (uint16_t) (i / 10 % 100),
+            .rid = (uint16_t) (i % 10),
+            .ssid = 1,
+            .min_period = i,
+            .max_period = 2u * i,
+            .greater_than = i + 0.5,
+            .less_than = -0.5 - i,
+            .step = 1.0
+        };
+        append_ptr = AVS_LIST_NEXT_PTR(append_ptr);
+    }
+
+    // two identical copies: one for each kind of restore context
+    for (int copy = 0; copy < 2; ++copy) {
+        const size_t writes_before = stream.writes;
+        avs_time_monotonic_t start = avs_time_monotonic_now();
+        anjay_persistence_context_t *ctx = anjay_persistence_store_context_new(
+                (avs_stream_abstract_t *) &stream);
+        AVS_UNIT_ASSERT_NOT_NULL(ctx);
+        AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_list(
+                ctx, (AVS_LIST(void) *) &entries, sizeof(bench_attr_entry_t),
+                handle_bench_attr_entry, NULL));
+        AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_context_flush(ctx));
+        anjay_persistence_context_delete(ctx);
+        const int64_t persist_us = elapsed_us(start);
+        const size_t writes = stream.writes - writes_before;
+        persistence_log(INFO,
+                        "persisting %d attribute entries: %" PRId64
+                        " us, %lu stream writes",
+                        BENCH_ATTR_ENTRIES, persist_us,
+                        (unsigned long) writes);
+        // 4 bytes of list size + 40 bytes per entry; values are never split
+        // between blocks, so each block is filled with at least
+        // PERSISTENCE_BUFFER_SIZE - 8 bytes
+        const size_t max_writes = (4 + 40 * BENCH_ATTR_ENTRIES)
+                                          / (PERSISTENCE_BUFFER_SIZE - 8)
+                                  + 1;
+        AVS_UNIT_ASSERT_TRUE(writes <= max_writes);
+    }
+
+    const size_t reads_before = stream.reads;
+    bench_restore(&stream, anjay_persistence_restore_context_new, entries);
+    const size_t unbuffered_reads = stream.reads - reads_before;
+    bench_restore(&stream, anjay_persistence_buffered_restore_context_new,
+                  entries);
+    const size_t buffered_reads =
+            stream.reads - reads_before - unbuffered_reads;
+    AVS_UNIT_ASSERT_TRUE(10 * buffered_reads < unbuffered_reads);
+
+    AVS_LIST_CLEAR(&entries);
+}
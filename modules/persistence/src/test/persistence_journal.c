@@ -0,0 +1,404 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <avsystem/commons/list.h>
+#include <avsystem/commons/stream.h>
+#include <avsystem/commons/stream/stream_membuf.h>
+#include <avsystem/commons/unit/test.h>
+
+typedef struct {
+    uint16_t id;
+    uint32_t value;
+} test_element_t;
+
+static int handle_test_element(anjay_persistence_context_t *ctx,
+                               void *element_,
+                               void *user_data) {
+    (void) user_data;
+    test_element_t *element = (test_element_t *) element_;
+    int retval;
+    (void) ((retval = anjay_persistence_u16(ctx, &element->id))
+            || (retval = anjay_persistence_u32(ctx, &element->value)));
+    return retval;
+}
+
+static const char TEST_MAGIC[] = { 'T', 'S', 'T', '\0' };
+
+static const anjay_persistence_journal_list_def_t TEST_LIST_DEF = {
+    .magic = TEST_MAGIC,
+    .magic_size = sizeof(TEST_MAGIC),
+    .element_size = sizeof(test_element_t),
+    .handler = handle_test_element
+};
+
+// magic + type + count
+#define TEST_SECTION_SIZE (sizeof(TEST_MAGIC) + 5)
+// op + id + size + element
+#define TEST_PUT_SIZE (1 + 2 + 4 + 6)
+// op + id
+#define TEST_REMOVE_SIZE (1 + 2)
+
+static void set_element(AVS_LIST(test_element_t) *list_ptr,
+                        uint16_t id,
+                        uint32_t value) {
+    while (*list_ptr && (*list_ptr)->id < id) {
+        list_ptr = AVS_LIST_NEXT_PTR(list_ptr);
+    }
+    if (!*list_ptr || (*list_ptr)->id != id) {
+        AVS_LIST(test_element_t) element = AVS_LIST_NEW_ELEMENT(test_element_t);
+        AVS_UNIT_ASSERT_NOT_NULL(element);
+        element->id = id;
+        AVS_LIST_INSERT(list_ptr, element);
+    }
+    (*list_ptr)->value = value;
+}
+
+static void remove_element(AVS_LIST(test_element_t) *list_ptr, uint16_t id) {
+    while (*list_ptr && (*list_ptr)->id != id) {
+        list_ptr = AVS_LIST_NEXT_PTR(list_ptr);
+    }
+    AVS_UNIT_ASSERT_NOT_NULL(*list_ptr);
+    AVS_LIST_DELETE(list_ptr);
+}
+
+static void assert_lists_equal(AVS_LIST(test_element_t) actual,
+                               AVS_LIST(test_element_t) expected) {
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(actual), AVS_LIST_SIZE(expected));
+    while (actual) {
+        AVS_UNIT_ASSERT_EQUAL(actual->id, expected->id);
+        AVS_UNIT_ASSERT_EQUAL(actual->value, expected->value);
+        actual = AVS_LIST_NEXT(actual);
+        expected = AVS_LIST_NEXT(expected);
+    }
+}
+
+static void store(anjay_persistence_journal_t *journal,
+                  avs_stream_abstract_t *stream,
+                  AVS_LIST(test_element_t) *list_ptr) {
+    AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_journal_store_list(
+            journal, stream, &TEST_LIST_DEF, (AVS_LIST(void) *) list_ptr,
+            NULL));
+}
+
+static AVS_LIST(test_element_t) restore(anjay_persistence_journal_t *journal,
+                                        avs_stream_abstract_t *stream) {
+    AVS_LIST(test_element_t) result = NULL;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_persistence_journal_restore_list(
+            journal, stream, &TEST_LIST_DEF, (AVS_LIST(void) *) &result,
+            NULL));
+    return result;
+}
+
+/**
+ * Returns a new membuf stream with the contents of @p stream, except for the
+ * last @p bytes_to_skip_at_end bytes. Contents of @p stream are preserved.
+ */
+static avs_stream_abstract_t *duplicate_stream(avs_stream_abstract_t *stream,
+                                               size_t bytes_to_skip_at_end) {
+    char buffer[1024];
+    size_t size = 0;
+    char message_finished = 0;
+    while (!message_finished) {
+        size_t bytes_read;
+        AVS_UNIT_ASSERT_SUCCESS(avs_stream_read(stream, &bytes_read,
+                                                &message_finished,
+                                                buffer + size,
+                                                sizeof(buffer) - size));
+        size += bytes_read;
+        AVS_UNIT_ASSERT_TRUE(size < sizeof(buffer));
+    }
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_reset(stream));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, buffer, size));
+
+    avs_stream_abstract_t *result = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(result);
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_write(result, buffer, size - bytes_to_skip_at_end));
+    return result;
+}
+
+AVS_UNIT_TEST(persistence_journal, deltas) {
+    anjay_persistence_journal_t *journal = anjay_persistence_journal_new();
+    AVS_UNIT_ASSERT_NOT_NULL(journal);
+    avs_stream_abstract_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+
+    AVS_LIST(test_element_t) list = NULL;
+    for (uint16_t id = 1; id <= 10; ++id) {
+        set_element(&list, id, 100u * id);
+    }
+    AVS_UNIT_ASSERT_TRUE(anjay_persistence_journal_needs_compaction(journal));
+    store(journal, stream, &list);
+    AVS_UNIT_ASSERT_FALSE(anjay_persistence_journal_needs_compaction(journal));
+    AVS_UNIT_ASSERT_EQUAL(journal->checkpoint_size,
+                          TEST_SECTION_SIZE + 10 * TEST_PUT_SIZE);
+    AVS_UNIT_ASSERT_EQUAL(journal->deltas_size, 0);
+
+    // nothing changed, nothing is written
+    store(journal, stream, &list);
+    AVS_UNIT_ASSERT_EQUAL(journal->deltas_size, 0);
+
+    set_element(&list, 5, 42);
+    set_element(&list, 11, 1100);
+    remove_element(&list, 1);
+    store(journal, stream, &list);
+    AVS_UNIT_ASSERT_EQUAL(journal->deltas_size,
+                          TEST_SECTION_SIZE + 2 * TEST_PUT_SIZE
+                                  + TEST_REMOVE_SIZE);
+    AVS_UNIT_ASSERT_FALSE(anjay_persistence_journal_needs_compaction(journal));
+
+    anjay_persistence_journal_t *restored_journal =
+            anjay_persistence_journal_new();
+    AVS_UNIT_ASSERT_NOT_NULL(restored_journal);
+    AVS_LIST(test_element_t) restored = restore(restored_journal, stream);
+    assert_lists_equal(restored, list);
+    AVS_UNIT_ASSERT_TRUE(restored_journal->has_checkpoint);
+    AVS_UNIT_ASSERT_EQUAL(restored_journal->deltas_size, journal->deltas_size);
+    AVS_UNIT_ASSERT_EQUAL(restored_journal->checkpoint_size,
+                          journal->checkpoint_size);
+
+    AVS_LIST_CLEAR(&restored);
+    anjay_persistence_journal_delete(restored_journal);
+    anjay_persistence_journal_delete(journal);
+    AVS_LIST_CLEAR(&list);
+    avs_stream_cleanup(&stream);
+}
+
+AVS_UNIT_TEST(persistence_journal, append_after_restore) {
+    anjay_persistence_journal_t *journal = anjay_persistence_journal_new();
+    AVS_UNIT_ASSERT_NOT_NULL(journal);
+    avs_stream_abstract_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+
+    AVS_LIST(test_element_t) list = NULL;
+    set_element(&list, 1, 1);
+    set_element(&list, 2, 2);
+    store(journal, stream, &list);
+    anjay_persistence_journal_delete(journal);
+
+    // "reboot": restore the state and continue appending
+    journal = anjay_persistence_journal_new();
+    AVS_UNIT_ASSERT_NOT_NULL(journal);
+    avs_stream_abstract_t *copy = duplicate_stream(stream, 0);
+    AVS_LIST(test_element_t) restored = restore(journal, copy);
+    avs_stream_cleanup(&copy);
+    assert_lists_equal(restored, list);
+    set_element(&restored, 2, 22);
+    store(journal, stream, &restored);
+    AVS_UNIT_ASSERT_EQUAL(journal->deltas_size,
+                          TEST_SECTION_SIZE + TEST_PUT_SIZE);
+    anjay_persistence_journal_delete(journal);
+
+    journal = anjay_persistence_journal_new();
+    AVS_UNIT_ASSERT_NOT_NULL(journal);
+    AVS_LIST(test_element_t) restored_again = restore(journal, stream);
+    assert_lists_equal(restored_again, restored);
+
+    AVS_LIST_CLEAR(&restored_again);
+    AVS_LIST_CLEAR(&restored);
+    anjay_persistence_journal_delete(journal);
+    AVS_LIST_CLEAR(&list);
+    avs_stream_cleanup(&stream);
+}
+
+AVS_UNIT_TEST(persistence_journal, compaction) {
+    anjay_persistence_journal_t *journal = anjay_persistence_journal_new();
+    AVS_UNIT_ASSERT_NOT_NULL(journal);
+    avs_stream_abstract_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+
+    AVS_LIST(test_element_t) list = NULL;
+    set_element(&list, 1, 0);
+    set_element(&list, 2, 0);
+    store(journal, stream, &list);
+
+    uint32_t value = 0;
+    while (!anjay_persistence_journal_needs_compaction(journal)) {
+        set_element(&list, 1, ++value);
+        store(journal, stream, &list);
+    }
+    // checkpoint holds two elements and each delta holds one, so two deltas
+    // take more space than the checkpoint
+    AVS_UNIT_ASSERT_EQUAL(value, 2);
+
+    anjay_persistence_journal_reset(journal);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_reset(stream));
+    store(journal, stream, &list);
+    AVS_UNIT_ASSERT_FALSE(anjay_persistence_journal_needs_compaction(journal));
+
+    AVS_LIST(test_element_t) restored = restore(journal, stream);
+    assert_lists_equal(restored, list);
+    AVS_UNIT_ASSERT_EQUAL(journal->deltas_size, 0);
+
+    AVS_LIST_CLEAR(&restored);
+    anjay_persistence_journal_delete(journal);
+    AVS_LIST_CLEAR(&list);
+    avs_stream_cleanup(&stream);
+}
+
+AVS_UNIT_TEST(persistence_journal, incomplete_section) {
+    anjay_persistence_journal_t *journal = anjay_persistence_journal_new();
+    AVS_UNIT_ASSERT_NOT_NULL(journal);
+    avs_stream_abstract_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+
+    AVS_LIST(test_element_t) list = NULL;
+    set_element(&list, 1, 1);
+    store(journal, stream, &list);
+    AVS_LIST(test_element_t) expected = NULL;
+    set_element(&expected, 1, 1);
+
+    set_element(&list, 1, 2);
+    store(journal, stream, &list);
+    avs_stream_abstract_t *truncated = duplicate_stream(stream, 2);
+
+    AVS_LIST(test_element_t) restored = restore(journal, truncated);
+    assert_lists_equal(restored, expected);
+    AVS_UNIT_ASSERT_TRUE(anjay_persistence_journal_needs_compaction(journal));
+
+    AVS_LIST_CLEAR(&restored);
+    AVS_LIST_CLEAR(&expected);
+    anjay_persistence_journal_delete(journal);
+    AVS_LIST_CLEAR(&list);
+    avs_stream_cleanup(&truncated);
+    avs_stream_cleanup(&stream);
+}
+
+AVS_UNIT_TEST(persistence_journal, store_after_incomplete_section) {
+    anjay_persistence_journal_t *journal = anjay_persistence_journal_new();
+    AVS_UNIT_ASSERT_NOT_NULL(journal);
+    avs_stream_abstract_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+
+    AVS_LIST(test_element_t) list = NULL;
+    set_element(&list, 1, 1);
+    store(journal, stream, &list);
+    set_element(&list, 1, 2);
+    store(journal, stream, &list);
+    avs_stream_abstract_t *truncated = duplicate_stream(stream, 2);
+
+    avs_stream_abstract_t *copy = duplicate_stream(truncated, 0);
+    AVS_LIST(test_element_t) restored = restore(journal, copy);
+    avs_stream_cleanup(&copy);
+    AVS_UNIT_ASSERT_EQUAL(anjay_persistence_journal_valid_size(journal),
+                          TEST_SECTION_SIZE + TEST_PUT_SIZE);
+
+    // appending after the discarded bytes would make the data unreadable
+    set_element(&restored, 2, 3);
+    AVS_UNIT_ASSERT_FAILED(anjay_persistence_journal_store_list(
+            journal, truncated, &TEST_LIST_DEF, (AVS_LIST(void) *) &restored,
+            NULL));
+
+    // truncate the stream to its valid part and persist again
+    avs_stream_abstract_t *compacted = duplicate_stream(
+            truncated, TEST_SECTION_SIZE + TEST_PUT_SIZE - 2);
+    anjay_persistence_journal_reset(journal);
+    store(journal, compacted, &restored);
+
+    AVS_LIST(test_element_t) expected = NULL;
+    set_element(&expected, 1, 1);
+    set_element(&expected, 2, 3);
+    AVS_LIST_CLEAR(&restored);
+    restored = restore(journal, compacted);
+    assert_lists_equal(restored, expected);
+    AVS_UNIT_ASSERT_FALSE(anjay_persistence_journal_needs_compaction(journal));
+
+    AVS_LIST_CLEAR(&restored);
+    AVS_LIST_CLEAR(&expected);
+    anjay_persistence_journal_delete(journal);
+    AVS_LIST_CLEAR(&list);
+    avs_stream_cleanup(&compacted);
+    avs_stream_cleanup(&truncated);
+    avs_stream_cleanup(&stream);
+}
+
+AVS_UNIT_TEST(persistence_journal, record_size_mismatch) {
+    anjay_persistence_journal_t *journal = anjay_persistence_journal_new();
+    AVS_UNIT_ASSERT_NOT_NULL(journal);
+    avs_stream_abstract_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+
+    AVS_LIST(test_element_t) list = NULL;
+    set_element(&list, 1, 1);
+    store(journal, stream, &list);
+
+    // delta that puts element 2, declaring 7 bytes of data instead of 6
+    static const char DELTA[] = "TST\0" "D" "\0\0\0\1"
+                                "P" "\0\2" "\0\0\0\7" "\0\2" "\0\0\0\3";
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, DELTA,
+                                             sizeof(DELTA) - 1));
+
+    AVS_LIST(test_element_t) restored = restore(journal, stream);
+    assert_lists_equal(restored, list);
+    AVS_UNIT_ASSERT_TRUE(anjay_persistence_journal_needs_compaction(journal));
+    AVS_UNIT_ASSERT_EQUAL(anjay_persistence_journal_valid_size(journal),
+                          TEST_SECTION_SIZE + TEST_PUT_SIZE);
+
+    AVS_LIST_CLEAR(&restored);
+    anjay_persistence_journal_delete(journal);
+    AVS_LIST_CLEAR(&list);
+    avs_stream_cleanup(&stream);
+}
+
+AVS_UNIT_TEST(persistence_journal, restore_errors) {
+    anjay_persistence_journal_t *journal = anjay_persistence_journal_new();
+    AVS_UNIT_ASSERT_NOT_NULL(journal);
+    avs_stream_abstract_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+
+    // empty stream
+    AVS_LIST(test_element_t) restored = restore(journal, stream);
+    AVS_UNIT_ASSERT_NULL(restored);
+    AVS_UNIT_ASSERT_TRUE(anjay_persistence_journal_needs_compaction(journal));
+
+    // invalid magic
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, "XYZ\0D\0\0\0\0", 9));
+    AVS_UNIT_ASSERT_FAILED(anjay_persistence_journal_restore_list(
+            journal, stream, &TEST_LIST_DEF, (AVS_LIST(void) *) &restored,
+            NULL));
+    AVS_UNIT_ASSERT_NULL(restored);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_reset(stream));
+
+    // delta without a checkpoint
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, "TST\0D\0\0\0\0", 9));
+    AVS_UNIT_ASSERT_FAILED(anjay_persistence_journal_restore_list(
+            journal, stream, &TEST_LIST_DEF, (AVS_LIST(void) *) &restored,
+            NULL));
+    AVS_UNIT_ASSERT_NULL(restored);
+
+    anjay_persistence_journal_delete(journal);
+    avs_stream_cleanup(&stream);
+}
+
+AVS_UNIT_TEST(persistence_journal, unsorted_list) {
+    anjay_persistence_journal_t *journal = anjay_persistence_journal_new();
+    AVS_UNIT_ASSERT_NOT_NULL(journal);
+    avs_stream_abstract_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+
+    AVS_LIST(test_element_t) list = NULL;
+    set_element(&list, 2, 2);
+    AVS_LIST(test_element_t) element = AVS_LIST_NEW_ELEMENT(test_element_t);
+    AVS_UNIT_ASSERT_NOT_NULL(element);
+    element->id = 1;
+    AVS_LIST_APPEND(&list, element);
+    AVS_UNIT_ASSERT_FAILED(anjay_persistence_journal_store_list(
+            journal, stream, &TEST_LIST_DEF, (AVS_LIST(void) *) &list, NULL));
+
+    anjay_persistence_journal_delete(journal);
+    AVS_LIST_CLEAR(&list);
+    avs_stream_cleanup(&stream);
+}
@@ -18,6 +18,7 @@
 #define ANJAY_INCLUDE_ANJAY_SECURITY_H
 
 #include <anjay/dm.h>
+#include <anjay/persistence.h>
 
 #include <avsystem/commons/stream.h>
 
@@ -131,10 +132,87 @@ int anjay_security_object_persist(const anjay_dm_object_def_t *const *obj,
 int anjay_security_object_restore(const anjay_dm_object_def_t *const *obj,
                                   avs_stream_abstract_t *in_stream);
 
+/**
+ * Appends changes made to Security Object Instances since the last call to
+ * @ref anjay_security_object_persist_journal or
+ * @ref anjay_security_object_restore_journal to the @p out_stream. If the
+ * @p journal contains no checkpoint, all Instances are written.
+ *
+ * See @ref anjay_persistence_journal_new for details on the journal format and
+ * @ref anjay_persistence_journal_needs_compaction for compacting it.
+ *
+ * @param obj           Security Object.
+ * @param journal       Journal tracking the Security Object.
+ * @param out_stream    Stream to append to.
+ * @return 0 in case of success, negative value in case of an error.
+ */
+int anjay_security_object_persist_journal(
+        const anjay_dm_object_def_t *const *obj,
+        anjay_persistence_journal_t *journal,
+        avs_stream_abstract_t *out_stream);
+
+/**
+ * Attempts to restore Security Object Instances from a journal stream written
+ * with @ref anjay_security_object_persist_journal.
+ *
+ * Note: if restore fails, then Security Object will be left untouched, on
+ * success though all Instances stored within the Object will be purged.
+ *
+ * @param obj       Security Object.
+ * @param journal   Journal that will track the Security Object.
+ * @param in_stream Stream to read from.
+ * @return 0 in case of success, negative value in case of an error.
+ */
+int anjay_security_object_restore_journal(
+        const anjay_dm_object_def_t *const *obj,
+        anjay_persistence_journal_t *journal,
+        avs_stream_abstract_t *in_stream);
+
+/**
+ * Dumps DTLS session state of all LwM2M Servers into the @p out_stream, so
+ * that it can be restored with @ref anjay_security_object_restore_dtls_sessions
+ * after the client restarts, allowing reconnection using an abbreviated
+ * handshake. Each session is stored along with a digest of the Security
+ * Instance credentials it has been established with - if these change, the
+ * session is dropped rather than resumed.
+ *
+ * NOTE: The dumped data allows resuming the DTLS sessions, so it shall be
+ * stored as securely as the Security Object itself.
+ *
+ * NOTE: If avs_commons used to build the library does not support keeping
+ * DTLS session state outside of the socket, no session state is kept and
+ * this function only writes an empty list.
+ *
+ * @param anjay         Anjay object to operate on.
+ * @param out_stream    Stream to write to.
+ * @return 0 in case of success, negative value in case of an error.
+ */
+int anjay_security_object_persist_dtls_sessions(
+        anjay_t *anjay, avs_stream_abstract_t *out_stream);
+
+/**
+ * Restores DTLS session state dumped using
+ * @ref anjay_security_object_persist_dtls_sessions . It shall be called before
+ * the first call to @ref anjay_sched_run, so that the restored sessions are
+ * used when connecting to the servers.
+ *
+ * Session state dumped by a build with a different DTLS_SESSION_BUFFER_SIZE
+ * setting is ignored; full handshakes will be performed in that case.
+ *
+ * @param anjay     Anjay object to operate on.
+ * @param in_stream Stream to read from.
+ * @return 0 in case of success, negative value in case of an error. Sessions
+ *         restored before an error occurred are kept.
+ */
+int anjay_security_object_restore_dtls_sessions(
+        anjay_t *anjay, avs_stream_abstract_t *in_stream);
+
 /**
  * Checks whether the Security Object has been modified since last successful
- * call to @ref anjay_security_object_persist or @ref
- * anjay_security_object_restore.
+ * call to @ref anjay_security_object_persist,
+ * @ref anjay_security_object_restore,
+ * @ref anjay_security_object_persist_journal or
+ * @ref anjay_security_object_restore_journal.
  */
 bool anjay_security_object_is_modified(const anjay_dm_object_def_t *const *obj);
 
@@ -18,9 +18,12 @@
 
 #include <anjay/persistence.h>
 
+#include <stdlib.h>
 #include <string.h>
 #include <inttypes.h>
 
+#include <anjay_modules/dtls_session.h>
+
 #include "mod_security.h"
 #include "security_transaction.h"
 #include "security_utils.h"
@@ -123,9 +126,11 @@ int anjay_security_object_persist(const anjay_dm_object_def_t *const *obj,
         persistence_log(ERROR, "Out of memory");
         return -1;
     }
-    retval = anjay_persistence_list(ctx, (AVS_LIST(void) *) &repr->instances,
-                                    sizeof(sec_instance_t),
-                                    handle_instance, (void *) (intptr_t) 1);
+    (void) ((retval = anjay_persistence_list(
+                     ctx, (AVS_LIST(void) *) &repr->instances,
+                     sizeof(sec_instance_t), handle_instance,
+                     (void *) (intptr_t) 1))
+            || (retval = anjay_persistence_context_flush(ctx)));
     anjay_persistence_context_delete(ctx);
     if (!retval) {
         clear_modified(repr);
@@ -183,6 +188,182 @@ int anjay_security_object_restore(const anjay_dm_object_def_t *const *obj,
     return retval;
 }
 
+static const char JOURNAL_MAGIC[] = { 'S', 'E', 'C', 'J' };
+
+static int cleanup_instance(void *element) {
+    _anjay_sec_destroy_instance_fields((sec_instance_t *) element);
+    return 0;
+}
+
+static const anjay_persistence_journal_list_def_t JOURNAL_DEF = {
+    .magic = JOURNAL_MAGIC,
+    .magic_size = sizeof(JOURNAL_MAGIC),
+    .element_size = sizeof(sec_instance_t),
+    .handler = handle_instance,
+    .cleanup = cleanup_instance
+};
+
+int anjay_security_object_persist_journal(
+        const anjay_dm_object_def_t *const *obj,
+        anjay_persistence_journal_t *journal,
+        avs_stream_abstract_t *out_stream) {
+    AVS_STATIC_ASSERT(offsetof(sec_instance_t, iid) == 0, journal_id_offset);
+    sec_repr_t *repr = _anjay_sec_get(obj);
+    if (!repr) {
+        return -1;
+    }
+    int retval = anjay_persistence_journal_store_list(
+            journal, out_stream, &JOURNAL_DEF,
+            (AVS_LIST(void) *) &repr->instances, (void *) (intptr_t) 1);
+    if (!retval) {
+        clear_modified(repr);
+    }
+    return retval;
+}
+
+int anjay_security_object_restore_journal(
+        const anjay_dm_object_def_t *const *obj,
+        anjay_persistence_journal_t *journal,
+        avs_stream_abstract_t *in_stream) {
+    sec_repr_t *repr = _anjay_sec_get(obj);
+    if (!repr) {
+        return -1;
+    }
+    sec_repr_t backup = *repr;
+
+    repr->instances = NULL;
+    int retval = anjay_persistence_journal_restore_list(
+            journal, in_stream, &JOURNAL_DEF,
+            (AVS_LIST(void) *) &repr->instances, (void *) (intptr_t) 1);
+    if (retval || (retval = _anjay_sec_object_validate(repr))) {
+        _anjay_sec_destroy_instances(&repr->instances);
+        repr->instances = backup.instances;
+        anjay_persistence_journal_reset(journal);
+    } else {
+        _anjay_sec_destroy_instances(&backup.instances);
+        clear_modified(repr);
+    }
+    return retval;
+}
+
+static const char DTLS_SESSIONS_MAGIC[] = { 'S', 'E', 'C', 'S' };
+
+typedef struct {
+    anjay_ssid_t ssid;
+    uint32_t credentials_digest;
+    void *data;
+    size_t size;
+} dtls_session_entry_t;
+
+static int handle_dtls_session(anjay_persistence_context_t *ctx,
+                               void *element_,
+                               void *user_ptr) {
+    (void) user_ptr;
+    dtls_session_entry_t *element = (dtls_session_entry_t *) element_;
+    int retval;
+    (void) ((retval = anjay_persistence_u16(ctx, &element->ssid))
+            || (retval = anjay_persistence_u32(ctx,
+                                               &element->credentials_digest))
+            || (retval = anjay_persistence_sized_buffer(ctx, &element->data,
+                                                        &element->size)));
+    return retval;
+}
+
+static bool session_empty(const anjay_dtls_session_t *session) {
+    for (size_t i = 0; i < sizeof(session->buffer); ++i) {
+        if (session->buffer[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int anjay_security_object_persist_dtls_sessions(
+        anjay_t *anjay, avs_stream_abstract_t *out_stream) {
+    AVS_LIST(dtls_session_entry_t) entries = NULL;
+    AVS_LIST(dtls_session_entry_t) *tail = &entries;
+    AVS_LIST(const anjay_dtls_session_t) session;
+    AVS_LIST_FOREACH(session, _anjay_dtls_sessions(anjay)) {
+        if (session_empty(session)) {
+            continue;
+        }
+        if (!(*tail = AVS_LIST_NEW_ELEMENT(dtls_session_entry_t))) {
+            persistence_log(ERROR, "Out of memory");
+            AVS_LIST_CLEAR(&entries);
+            return -1;
+        }
+        (*tail)->ssid = session->ssid;
+        (*tail)->credentials_digest = session->credentials_digest;
+        // only read by the store context
+        (*tail)->data = (void *) (intptr_t) session->buffer;
+        (*tail)->size = sizeof(session->buffer);
+        tail = AVS_LIST_NEXT_PTR(tail);
+    }
+
+    int retval = avs_stream_write(out_stream, DTLS_SESSIONS_MAGIC,
+                                  sizeof(DTLS_SESSIONS_MAGIC));
+    anjay_persistence_context_t *ctx = NULL;
+    if (!retval && !(ctx = anjay_persistence_store_context_new(out_stream))) {
+        persistence_log(ERROR, "Out of memory");
+        retval = -1;
+    }
+    if (!retval) {
+        (void) ((retval = anjay_persistence_list(
+                         ctx, (AVS_LIST(void) *) &entries,
+                         sizeof(dtls_session_entry_t), handle_dtls_session,
+                         NULL))
+                || (retval = anjay_persistence_context_flush(ctx)));
+    }
+    anjay_persistence_context_delete(ctx);
+    AVS_LIST_CLEAR(&entries);
+    return retval;
+}
+
+int anjay_security_object_restore_dtls_sessions(
+        anjay_t *anjay, avs_stream_abstract_t *in_stream) {
+    char magic_header[sizeof(DTLS_SESSIONS_MAGIC)];
+    int retval = avs_stream_read_reliably(in_stream, magic_header,
+                                          sizeof(magic_header));
+    if (retval) {
+        persistence_log(ERROR, "Could not read DTLS session state header");
+        return retval;
+    }
+    if (memcmp(magic_header, DTLS_SESSIONS_MAGIC,
+               sizeof(DTLS_SESSIONS_MAGIC))) {
+        persistence_log(ERROR, "Header magic constant mismatch");
+        return -1;
+    }
+    anjay_persistence_context_t *ctx =
+            anjay_persistence_restore_context_new(in_stream);
+    if (!ctx) {
+        persistence_log(ERROR, "Cannot create persistence restore context");
+        return -1;
+    }
+    AVS_LIST(dtls_session_entry_t) entries = NULL;
+    retval = anjay_persistence_list(ctx, (AVS_LIST(void) *) &entries,
+                                    sizeof(dtls_session_entry_t),
+                                    handle_dtls_session, NULL);
+    anjay_persistence_context_delete(ctx);
+
+    AVS_LIST_CLEAR(&entries) {
+        if (!retval) {
+            if (entries->size != ANJAY_DTLS_SESSION_BUFFER_SIZE) {
+                // session state is stored in a format internal to avs_net,
+                // so it cannot be used if the buffer size has changed
+                persistence_log(WARNING, "Ignoring DTLS session state for "
+                                "SSID %" PRIu16 ": size %lu does not match",
+                                entries->ssid, (unsigned long) entries->size);
+            } else {
+                retval = _anjay_dtls_session_restore(
+                        anjay, entries->ssid, entries->credentials_digest,
+                        (const uint8_t *) entries->data);
+            }
+        }
+        free(entries->data);
+    }
+    return retval;
+}
+
 #ifdef ANJAY_TEST
 #include "test/persistence.c"
 #endif
@@ -228,3 +228,88 @@ AVS_UNIT_TEST(security_persistence, modification_flag_purge) {
     anjay_security_object_purge(env->stored);
     AVS_UNIT_ASSERT_TRUE(anjay_security_object_is_modified(env->stored));
 }
+
+static anjay_t *dtls_sessions_test_anjay_new(void) {
+    anjay_t *anjay = anjay_new(&(const anjay_configuration_t) {
+        .endpoint_name = "urn:dev:os:anjay-test",
+        .in_buffer_size = 4096,
+        .out_buffer_size = 4096
+    });
+    AVS_UNIT_ASSERT_NOT_NULL(anjay);
+    return anjay;
+}
+
+AVS_UNIT_TEST(security_persistence, dtls_sessions_store_restore) {
+    uint8_t session1[ANJAY_DTLS_SESSION_BUFFER_SIZE];
+    memset(session1, 0x11, sizeof(session1));
+    uint8_t session2[ANJAY_DTLS_SESSION_BUFFER_SIZE];
+    memset(session2, 0x22, sizeof(session2));
+    const uint8_t empty[ANJAY_DTLS_SESSION_BUFFER_SIZE] = { 0 };
+
+    anjay_t *anjay = dtls_sessions_test_anjay_new();
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_dtls_session_restore(anjay, 2, 0x2222, session2));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_dtls_session_restore(anjay, 1, 0x1111, session1));
+    // no session established yet - not persisted
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_dtls_session_restore(anjay, 3, 0x3333, empty));
+
+    avs_stream_abstract_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_security_object_persist_dtls_sessions(anjay, stream));
+    anjay_delete(anjay);
+
+    anjay = dtls_sessions_test_anjay_new();
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_security_object_restore_dtls_sessions(anjay, stream));
+    AVS_LIST(const anjay_dtls_session_t) sessions =
+            _anjay_dtls_sessions(anjay);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(sessions), 2);
+    AVS_UNIT_ASSERT_EQUAL(sessions->ssid, 1);
+    AVS_UNIT_ASSERT_EQUAL(sessions->credentials_digest, 0x1111);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(sessions->buffer, session1,
+                                      sizeof(session1));
+    sessions = AVS_LIST_NEXT(sessions);
+    AVS_UNIT_ASSERT_EQUAL(sessions->ssid, 2);
+    AVS_UNIT_ASSERT_EQUAL(sessions->credentials_digest, 0x2222);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(sessions->buffer, session2,
+                                      sizeof(session2));
+    avs_stream_cleanup(&stream);
+    anjay_delete(anjay);
+}
+
+AVS_UNIT_TEST(security_persistence, dtls_sessions_different_buffer_size) {
+    const uint8_t data[] = {
+        'S', 'E', 'C', 'S',
+        0x00, 0x00, 0x00, 0x01, // count
+        0x00, 0x07,             // SSID
+        0x12, 0x34, 0x56, 0x78, // credentials digest
+        0x00, 0x00, 0x00, 0x02, // size
+        0xAA, 0xBB
+    };
+    avs_stream_abstract_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, data, sizeof(data)));
+
+    anjay_t *anjay = dtls_sessions_test_anjay_new();
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_security_object_restore_dtls_sessions(anjay, stream));
+    AVS_UNIT_ASSERT_NULL(_anjay_dtls_sessions(anjay));
+    avs_stream_cleanup(&stream);
+    anjay_delete(anjay);
+}
+
+AVS_UNIT_TEST(security_persistence, dtls_sessions_invalid_magic) {
+    avs_stream_abstract_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, "SEC\1\0\0\0\0", 8));
+
+    anjay_t *anjay = dtls_sessions_test_anjay_new();
+    AVS_UNIT_ASSERT_FAILED(
+            anjay_security_object_restore_dtls_sessions(anjay, stream));
+    AVS_UNIT_ASSERT_NULL(_anjay_dtls_sessions(anjay));
+    avs_stream_cleanup(&stream);
+    anjay_delete(anjay);
+}
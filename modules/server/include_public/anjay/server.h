@@ -18,6 +18,7 @@
 #define ANJAY_INCLUDE_ANJAY_SERVER_H
 
 #include <anjay/dm.h>
+#include <anjay/persistence.h>
 
 #include <avsystem/commons/stream.h>
 
@@ -110,9 +111,47 @@ int anjay_server_object_persist(const anjay_dm_object_def_t *const *obj,
 int anjay_server_object_restore(const anjay_dm_object_def_t *const *obj,
                                 avs_stream_abstract_t *in_stream);
 
+/**
+ * Appends changes made to Server Object Instances since the last call to
+ * @ref anjay_server_object_persist_journal or
+ * @ref anjay_server_object_restore_journal to the @p out_stream . If the
+ * @p journal contains no checkpoint, all Instances are written.
+ *
+ * See @ref anjay_persistence_journal_new for details on the journal format and
+ * @ref anjay_persistence_journal_needs_compaction for compacting it.
+ *
+ * @param obj           Server Object.
+ * @param journal       Journal tracking the Server Object.
+ * @param out_stream    Stream to append to.
+ * @return 0 in case of success, negative value in case of an error.
+ */
+int anjay_server_object_persist_journal(
+        const anjay_dm_object_def_t *const *obj,
+        anjay_persistence_journal_t *journal,
+        avs_stream_abstract_t *out_stream);
+
+/**
+ * Attempts to restore Server Object Instances from a journal stream written
+ * with @ref anjay_server_object_persist_journal.
+ *
+ * Note: if restore fails, then Server Object will be left untouched, on
+ * success though all Instances stored within the Object will be purged.
+ *
+ * @param obj       Server Object.
+ * @param journal   Journal that will track the Server Object.
+ * @param in_stream Stream to read from.
+ * @return 0 in case of success, negative value in case of an error.
+ */
+int anjay_server_object_restore_journal(
+        const anjay_dm_object_def_t *const *obj,
+        anjay_persistence_journal_t *journal,
+        avs_stream_abstract_t *in_stream);
+
 /**
  * Checks whether the Server Object has been modified since last successful
- * call to @ref anjay_server_object_persist or @ref anjay_server_object_restore.
+ * call to @ref anjay_server_object_persist, @ref anjay_server_object_restore,
+ * @ref anjay_server_object_persist_journal or
+ * @ref anjay_server_object_restore_journal.
  */
 bool anjay_server_object_is_modified(const anjay_dm_object_def_t *const *obj);
 
@@ -200,6 +200,18 @@ static int serv_instance_remove(anjay_t *anjay,
     return del_instance(_anjay_serv_get(obj_ptr), iid);
 }
 
+static int
+serv_instance_remove_all(anjay_t *anjay,
+                         const anjay_dm_object_def_t *const *obj_ptr) {
+    (void) anjay;
+    server_repr_t *repr = _anjay_serv_get(obj_ptr);
+    if (repr->instances) {
+        mark_modified(repr);
+    }
+    _anjay_serv_destroy_instances(&repr->instances);
+    return 0;
+}
+
 static int serv_instance_reset(anjay_t *anjay,
                                const anjay_dm_object_def_t *const *obj_ptr,
                                anjay_iid_t iid) {
@@ -446,6 +458,7 @@ static const anjay_dm_object_def_t SERVER = {
         .instance_present = serv_instance_present,
         .instance_create = serv_instance_create,
         .instance_remove = serv_instance_remove,
+        .instance_remove_all = serv_instance_remove_all,
         .instance_reset = serv_instance_reset,
         .resource_present = serv_resource_present,
         .resource_operations = serv_resource_operations,
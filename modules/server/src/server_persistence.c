@@ -56,25 +56,13 @@ static int handle_sized_fields(anjay_persistence_context_t *ctx,
     return retval;
 }
 
-static int persist_instance(anjay_persistence_context_t *ctx,
-                            void *element_,
-                            void *user_data) {
+static int handle_instance(anjay_persistence_context_t *ctx,
+                           void *element_,
+                           void *user_data) {
     (void) user_data;
     server_instance_t *element = (server_instance_t *) element_;
     int retval = 0;
     uint32_t binding = element->data.binding;
-    (void) ((retval = handle_sized_fields(ctx, element_))
-            || (retval = anjay_persistence_u32(ctx, &binding)));
-    return retval;
-}
-
-static int restore_instance(anjay_persistence_context_t *ctx,
-                            void *element_,
-                            void *user_data) {
-    (void) user_data;
-    server_instance_t *element = (server_instance_t *) element_;
-    int retval = 0;
-    uint32_t binding;
     (void) ((retval = handle_sized_fields(ctx, element_))
             || (retval = anjay_persistence_u32(ctx, &binding)));
     if (!retval) {
@@ -113,10 +101,10 @@ int anjay_server_object_persist(const anjay_dm_object_def_t *const *obj,
         persistence_log(ERROR, "Out of memory");
         return -1;
     }
-    retval =
-            anjay_persistence_list(ctx, (AVS_LIST(void) *) &repr->instances,
-                                   sizeof(server_instance_t),
-                                   persist_instance, NULL);
+    (void) ((retval = anjay_persistence_list(
+                     ctx, (AVS_LIST(void) *) &repr->instances,
+                     sizeof(server_instance_t), handle_instance, NULL))
+            || (retval = anjay_persistence_context_flush(ctx)));
     anjay_persistence_context_delete(ctx);
     if (!retval) {
         clear_modified(repr);
@@ -155,7 +143,7 @@ int anjay_server_object_restore(const anjay_dm_object_def_t *const *obj,
             anjay_persistence_list(restore_ctx,
                                    (AVS_LIST(void) *) &repr->instances,
                                    sizeof(server_instance_t),
-                                   restore_instance, NULL);
+                                   handle_instance, NULL);
     if (retval || (retval = _anjay_serv_object_validate(repr))) {
         _anjay_serv_destroy_instances(&repr->instances);
         repr->instances = backup.instances;
@@ -169,6 +157,59 @@ int anjay_server_object_restore(const anjay_dm_object_def_t *const *obj,
     return retval;
 }
 
+static const char JOURNAL_MAGIC[] = { 'S', 'R', 'V', 'J' };
+
+static const anjay_persistence_journal_list_def_t JOURNAL_DEF = {
+    .magic = JOURNAL_MAGIC,
+    .magic_size = sizeof(JOURNAL_MAGIC),
+    .element_size = sizeof(server_instance_t),
+    .handler = handle_instance
+};
+
+int anjay_server_object_persist_journal(
+        const anjay_dm_object_def_t *const *obj,
+        anjay_persistence_journal_t *journal,
+        avs_stream_abstract_t *out_stream) {
+    AVS_STATIC_ASSERT(offsetof(server_instance_t, iid) == 0,
+                      journal_id_offset);
+    server_repr_t *repr = _anjay_serv_get(obj);
+    if (!repr) {
+        return -1;
+    }
+    int retval = anjay_persistence_journal_store_list(
+            journal, out_stream, &JOURNAL_DEF,
+            (AVS_LIST(void) *) &repr->instances, NULL);
+    if (!retval) {
+        clear_modified(repr);
+    }
+    return retval;
+}
+
+int anjay_server_object_restore_journal(
+        const anjay_dm_object_def_t *const *obj,
+        anjay_persistence_journal_t *journal,
+        avs_stream_abstract_t *in_stream) {
+    server_repr_t *repr = _anjay_serv_get(obj);
+    if (!repr) {
+        return -1;
+    }
+    server_repr_t backup = *repr;
+
+    repr->instances = NULL;
+    int retval = anjay_persistence_journal_restore_list(
+            journal, in_stream, &JOURNAL_DEF,
+            (AVS_LIST(void) *) &repr->instances, NULL);
+    if (retval || (retval = _anjay_serv_object_validate(repr))) {
+        _anjay_serv_destroy_instances(&repr->instances);
+        repr->instances = backup.instances;
+        anjay_persistence_journal_reset(journal);
+    } else {
+        _anjay_serv_destroy_instances(&backup.instances);
+        clear_modified(repr);
+    }
+    return retval;
+}
+
 #ifdef ANJAY_TEST
 #include "test/persistence.c"
 #endif
@@ -175,3 +175,48 @@ AVS_UNIT_TEST(server_persistence, modification_flag_purge) {
     anjay_server_object_purge(env->stored);
     AVS_UNIT_ASSERT_TRUE(anjay_server_object_is_modified(env->stored));
 }
+
+AVS_UNIT_TEST(server_persistence, journal_store_restore) {
+    SCOPED_SERVER_PERSISTENCE_TEST_ENV(env);
+    anjay_persistence_journal_t *journal = anjay_persistence_journal_new();
+    AVS_UNIT_ASSERT_NOT_NULL(journal);
+    anjay_server_instance_t instance = {
+        .ssid = 42,
+        .lifetime = 9001,
+        .default_min_period = -1,
+        .default_max_period = -1,
+        .disable_timeout = -1,
+        .binding = ANJAY_BINDING_U,
+        .notification_storing = true
+    };
+    anjay_iid_t iid = 1;
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_server_object_add_instance(env->stored, &instance, &iid));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_server_object_persist_journal(
+            env->stored, journal, env->stream));
+    AVS_UNIT_ASSERT_FALSE(anjay_server_object_is_modified(env->stored));
+
+    instance.ssid = 43;
+    iid = 2;
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_server_object_add_instance(env->stored, &instance, &iid));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_server_object_persist_journal(
+            env->stored, journal, env->stream));
+    // only the new instance has been appended
+    AVS_UNIT_ASSERT_FALSE(anjay_persistence_journal_needs_compaction(journal));
+    anjay_persistence_journal_delete(journal);
+
+    journal = anjay_persistence_journal_new();
+    AVS_UNIT_ASSERT_NOT_NULL(journal);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_server_object_restore_journal(
+            env->restored, journal, env->stream));
+    AVS_UNIT_ASSERT_EQUAL(2, AVS_LIST_SIZE(env->restored_repr->instances));
+    AVS_LIST(server_instance_t) expected = env->stored_repr->instances;
+    AVS_LIST(server_instance_t) actual = env->restored_repr->instances;
+    while (expected) {
+        assert_instances_equal(expected, actual);
+        expected = AVS_LIST_NEXT(expected);
+        actual = AVS_LIST_NEXT(actual);
+    }
+    anjay_persistence_journal_delete(journal);
+}
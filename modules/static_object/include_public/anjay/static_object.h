@@ -0,0 +1,164 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_INCLUDE_ANJAY_STATIC_OBJECT_H
+#define ANJAY_INCLUDE_ANJAY_STATIC_OBJECT_H
+
+#include <stddef.h>
+
+#include <anjay/dm.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Type of a value stored in application memory for a static Resource. */
+typedef enum {
+    /** <c>int32_t</c> */
+    ANJAY_STATIC_RES_I32,
+    /** <c>int64_t</c> */
+    ANJAY_STATIC_RES_I64,
+    /** <c>bool</c> */
+    ANJAY_STATIC_RES_BOOL,
+    /** <c>float</c> */
+    ANJAY_STATIC_RES_FLOAT,
+    /** <c>double</c> */
+    ANJAY_STATIC_RES_DOUBLE,
+    /** Null-terminated string stored in a <c>char</c> array. */
+    ANJAY_STATIC_RES_STRING
+} anjay_static_res_type_t;
+
+/**
+ * Optional callback used to read a Resource whose value cannot be taken
+ * directly from the Instance struct.
+ *
+ * @param anjay    Anjay object to operate on.
+ * @param iid      Object Instance ID.
+ * @param rid      Resource ID.
+ * @param instance Pointer to the Instance struct.
+ * @param ctx      Output context to return the value to, using exactly one of
+ *                 the anjay_ret_* functions.
+ *
+ * @returns 0 on success, a negative value in case of error, as for
+ *          @ref anjay_dm_resource_read_t .
+ */
+typedef int anjay_static_res_getter_t(anjay_t *anjay,
+                                      anjay_iid_t iid,
+                                      anjay_rid_t rid,
+                                      const void *instance,
+                                      anjay_output_ctx_t *ctx);
+
+/** Definition of a single Resource of a static Object. */
+typedef struct {
+    /** Resource ID */
+    anjay_rid_t rid;
+    /** Supported operations; Execute is not supported by static Objects. */
+    anjay_dm_resource_op_mask_t operations;
+    /** Type of the value stored at @ref offset . */
+    anjay_static_res_type_t type;
+    /** Offset of the value within the Instance struct. */
+    size_t offset;
+    /**
+     * Size of the value within the Instance struct; for strings, size of the
+     * whole buffer, including space for the terminating nullbyte. May be 0 if
+     * @ref getter is set, in which case the Resource cannot be written.
+     */
+    size_t size;
+    /** If set, used to read the Resource instead of accessing the struct. */
+    anjay_static_res_getter_t *getter;
+} anjay_static_res_def_t;
+
+/**
+ * Convenience macro for defining a Resource bound to the @p Field member of
+ * @p Struct .
+ */
+#define ANJAY_STATIC_RES(Rid, Ops, Type, Struct, Field) \
+    { \
+        .rid = (Rid), \
+        .operations = (Ops), \
+        .type = (Type), \
+        .offset = offsetof(Struct, Field), \
+        .size = sizeof(((Struct *) 0)->Field) \
+    }
+
+/**
+ * Convenience macro for defining a read-only Resource whose value is returned
+ * by @p Getter .
+ */
+#define ANJAY_STATIC_RES_GETTER(Rid, Getter) \
+    { \
+        .rid = (Rid), \
+        .operations = ANJAY_DM_RESOURCE_OP_BIT_R, \
+        .getter = (Getter) \
+    }
+
+/** Definition of a static Object. */
+typedef struct {
+    /** Object ID */
+    anjay_oid_t oid;
+    /** Object version, as in @ref anjay_dm_object_def_t . */
+    const char *version;
+    /**
+     * Resources of the Object, sorted by Resource ID in strictly ascending
+     * order. All of them are present in every Instance.
+     */
+    const anjay_static_res_def_t *resources;
+    /** Number of elements in @ref resources . */
+    size_t resource_count;
+} anjay_static_object_def_t;
+
+/**
+ * Creates an Object whose Resources are read and written directly from and to
+ * application memory, as described by @p def , without any per-Resource
+ * callbacks other than optional getters.
+ *
+ * Instances are described by @p instances : the Instance with ID <c>i</c>
+ * exists if <c>instances[i]</c> is not NULL and points to the Instance struct.
+ * Neither @p def nor @p instances are copied, so they MUST remain valid until
+ * @ref anjay_static_object_delete is called. The application may change
+ * elements of @p instances and values inside the Instance structs, but it is
+ * then responsible for calling @ref anjay_notify_instances_changed or
+ * @ref anjay_notify_changed , respectively.
+ *
+ * Writes are applied to the Instance structs immediately. Values of all
+ * Resources bound to struct members are copied when a transaction begins and
+ * copied back if it is rolled back. Creating and deleting Instances by the
+ * server is not supported.
+ *
+ * @param def            Object definition.
+ * @param instances      Array of pointers to Instance structs.
+ * @param instance_count Number of elements in @p instances ; it MUST NOT be
+ *                       greater than <c>ANJAY_IID_INVALID</c>.
+ *
+ * @returns Object definition pointer to be passed to
+ *          @ref anjay_register_object , or NULL in case of error.
+ */
+const anjay_dm_object_def_t **
+anjay_static_object_create(const anjay_static_object_def_t *def,
+                           void *const *instances,
+                           size_t instance_count);
+
+/**
+ * Frees an Object created using @ref anjay_static_object_create . It MUST NOT
+ * be registered in any Anjay object at the time of calling this function.
+ */
+void anjay_static_object_delete(const anjay_dm_object_def_t **obj);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ANJAY_INCLUDE_ANJAY_STATIC_OBJECT_H */
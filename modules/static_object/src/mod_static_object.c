@@ -0,0 +1,373 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <avsystem/commons/log.h>
+#include <avsystem/commons/utils.h>
+
+#include <anjay/static_object.h>
+
+VISIBILITY_SOURCE_BEGIN
+
+#define static_obj_log(level, ...) avs_log(static_object, level, __VA_ARGS__)
+
+typedef struct {
+    const anjay_dm_object_def_t *def_ptr;
+    anjay_dm_object_def_t def;
+    const anjay_static_object_def_t *static_def;
+    void *const *instances;
+    size_t instance_count;
+    // total size of the struct-bound Resources of a single Instance
+    size_t backup_size;
+    // values of struct-bound Resources saved at transaction_begin
+    char *backup;
+    anjay_rid_t rids[];
+} static_object_t;
+
+static static_object_t *
+get_obj(const anjay_dm_object_def_t *const *obj_ptr) {
+    assert(obj_ptr);
+    return AVS_CONTAINER_OF(obj_ptr, static_object_t, def_ptr);
+}
+
+static void *get_instance(const static_object_t *obj, anjay_iid_t iid) {
+    return iid < obj->instance_count ? obj->instances[iid] : NULL;
+}
+
+static const anjay_static_res_def_t *
+find_resource(const static_object_t *obj, anjay_rid_t rid) {
+    size_t left = 0;
+    size_t right = obj->static_def->resource_count;
+    while (left < right) {
+        size_t mid = (left + right) / 2;
+        const anjay_static_res_def_t *res = &obj->static_def->resources[mid];
+        if (res->rid == rid) {
+            return res;
+        } else if (res->rid < rid) {
+            left = mid + 1;
+        } else {
+            right = mid;
+        }
+    }
+    return NULL;
+}
+
+static int static_instance_it(anjay_t *anjay,
+                              const anjay_dm_object_def_t *const *obj_ptr,
+                              anjay_iid_t *out,
+                              void **cookie) {
+    (void) anjay;
+    static_object_t *obj = get_obj(obj_ptr);
+    uintptr_t index = (uintptr_t) *cookie;
+    while (index < obj->instance_count && !obj->instances[index]) {
+        ++index;
+    }
+    if (index < obj->instance_count) {
+        *out = (anjay_iid_t) index;
+        *cookie = (void *) (index + 1);
+    } else {
+        *out = ANJAY_IID_INVALID;
+    }
+    return 0;
+}
+
+static int static_instance_present(anjay_t *anjay,
+                                   const anjay_dm_object_def_t *const *obj_ptr,
+                                   anjay_iid_t iid) {
+    (void) anjay;
+    return get_instance(get_obj(obj_ptr), iid) != NULL;
+}
+
+static int static_resource_operations(anjay_t *anjay,
+                                      const anjay_dm_object_def_t *const *obj_ptr,
+                                      anjay_rid_t rid,
+                                      anjay_dm_resource_op_mask_t *out) {
+    (void) anjay;
+    const anjay_static_res_def_t *res = find_resource(get_obj(obj_ptr), rid);
+    if (!res) {
+        return ANJAY_ERR_NOT_FOUND;
+    }
+    *out = res->operations;
+    return 0;
+}
+
+static int
+static_instance_resources(anjay_t *anjay,
+                          const anjay_dm_object_def_t *const *obj_ptr,
+                          anjay_iid_t iid,
+                          anjay_dm_resource_op_mask_t *out) {
+    (void) anjay;
+    (void) iid;
+    static_object_t *obj = get_obj(obj_ptr);
+    // supported_rids are in the same order as the definition table
+    for (size_t i = 0; i < obj->static_def->resource_count; ++i) {
+        out[i] = (anjay_dm_resource_op_mask_t) (
+                ANJAY_DM_RESOURCE_PRESENT
+                | obj->static_def->resources[i].operations);
+    }
+    return 0;
+}
+
+static int read_value(anjay_t *anjay,
+                      anjay_iid_t iid,
+                      const void *instance,
+                      const anjay_static_res_def_t *res,
+                      anjay_output_ctx_t *ctx) {
+    if (res->getter) {
+        return res->getter(anjay, iid, res->rid, instance, ctx);
+    }
+    const void *value = (const char *) instance + res->offset;
+    switch (res->type) {
+    case ANJAY_STATIC_RES_I32:
+        return anjay_ret_i32(ctx, *(const int32_t *) value);
+    case ANJAY_STATIC_RES_I64:
+        return anjay_ret_i64(ctx, *(const int64_t *) value);
+    case ANJAY_STATIC_RES_BOOL:
+        return anjay_ret_bool(ctx, *(const bool *) value);
+    case ANJAY_STATIC_RES_FLOAT:
+        return anjay_ret_float(ctx, *(const float *) value);
+    case ANJAY_STATIC_RES_DOUBLE:
+        return anjay_ret_double(ctx, *(const double *) value);
+    case ANJAY_STATIC_RES_STRING:
+        return anjay_ret_string(ctx, (const char *) value);
+    }
+    static_obj_log(ERROR, "invalid type of resource %u", res->rid);
+    return ANJAY_ERR_INTERNAL;
+}
+
+static int static_resource_read(anjay_t *anjay,
+                                const anjay_dm_object_def_t *const *obj_ptr,
+                                anjay_iid_t iid,
+                                anjay_rid_t rid,
+                                anjay_output_ctx_t *ctx) {
+    static_object_t *obj = get_obj(obj_ptr);
+    const void *instance = get_instance(obj, iid);
+    const anjay_static_res_def_t *res = find_resource(obj, rid);
+    if (!instance || !res) {
+        return ANJAY_ERR_NOT_FOUND;
+    }
+    return read_value(anjay, iid, instance, res, ctx);
+}
+
+static int static_instance_read(anjay_t *anjay,
+                                const anjay_dm_object_def_t *const *obj_ptr,
+                                anjay_iid_t iid,
+                                anjay_output_ctx_t *ctx) {
+    static_object_t *obj = get_obj(obj_ptr);
+    const void *instance = get_instance(obj, iid);
+    if (!instance) {
+        return ANJAY_ERR_NOT_FOUND;
+    }
+    int result = 0;
+    for (size_t i = 0; !result && i < obj->static_def->resource_count; ++i) {
+        const anjay_static_res_def_t *res = &obj->static_def->resources[i];
+        if (res->operations & ANJAY_DM_RESOURCE_OP_BIT_R) {
+            (void) ((result = anjay_ret_resource_id(ctx, res->rid))
+                    || (result = read_value(anjay, iid, instance, res, ctx)));
+        }
+    }
+    return result;
+}
+
+static int write_string(anjay_input_ctx_t *ctx, char *out, size_t size) {
+    // read into a temporary buffer not to leave a truncated value on error
+    char *buf = (char *) malloc(size);
+    if (!buf) {
+        static_obj_log(ERROR, "out of memory");
+        return ANJAY_ERR_INTERNAL;
+    }
+    int result = anjay_get_string(ctx, buf, size);
+    if (result == ANJAY_BUFFER_TOO_SHORT) {
+        result = ANJAY_ERR_BAD_REQUEST;
+    } else if (!result) {
+        memcpy(out, buf, size);
+    }
+    free(buf);
+    return result;
+}
+
+static int static_resource_write(anjay_t *anjay,
+                                 const anjay_dm_object_def_t *const *obj_ptr,
+                                 anjay_iid_t iid,
+                                 anjay_rid_t rid,
+                                 anjay_input_ctx_t *ctx) {
+    (void) anjay;
+    static_object_t *obj = get_obj(obj_ptr);
+    void *instance = get_instance(obj, iid);
+    const anjay_static_res_def_t *res = find_resource(obj, rid);
+    if (!instance || !res) {
+        return ANJAY_ERR_NOT_FOUND;
+    }
+    if (!res->size) {
+        return ANJAY_ERR_METHOD_NOT_ALLOWED;
+    }
+    void *value = (char *) instance + res->offset;
+    switch (res->type) {
+    case ANJAY_STATIC_RES_I32:
+        return anjay_get_i32(ctx, (int32_t *) value);
+    case ANJAY_STATIC_RES_I64:
+        return anjay_get_i64(ctx, (int64_t *) value);
+    case ANJAY_STATIC_RES_BOOL:
+        return anjay_get_bool(ctx, (bool *) value);
+    case ANJAY_STATIC_RES_FLOAT:
+        return anjay_get_float(ctx, (float *) value);
+    case ANJAY_STATIC_RES_DOUBLE:
+        return anjay_get_double(ctx, (double *) value);
+    case ANJAY_STATIC_RES_STRING:
+        return write_string(ctx, (char *) value, res->size);
+    }
+    static_obj_log(ERROR, "invalid type of resource %u", res->rid);
+    return ANJAY_ERR_INTERNAL;
+}
+
+static void copy_backup(static_object_t *obj, bool restore) {
+    char *backup = obj->backup;
+    for (size_t iid = 0; iid < obj->instance_count; ++iid) {
+        char *instance = (char *) obj->instances[iid];
+        for (size_t i = 0; i < obj->static_def->resource_count; ++i) {
+            const anjay_static_res_def_t *res = &obj->static_def->resources[i];
+            if (instance && res->size) {
+                if (restore) {
+                    memcpy(instance + res->offset, backup, res->size);
+                } else {
+                    memcpy(backup, instance + res->offset, res->size);
+                }
+            }
+            backup += res->size;
+        }
+    }
+}
+
+static int
+static_transaction_begin(anjay_t *anjay,
+                         const anjay_dm_object_def_t *const *obj_ptr) {
+    (void) anjay;
+    static_object_t *obj = get_obj(obj_ptr);
+    assert(!obj->backup);
+    if (!obj->backup_size || !obj->instance_count) {
+        return 0;
+    }
+    if (!(obj->backup = (char *) malloc(obj->instance_count
+                                        * obj->backup_size))) {
+        static_obj_log(ERROR, "out of memory");
+        return ANJAY_ERR_INTERNAL;
+    }
+    copy_backup(obj, false);
+    return 0;
+}
+
+static int
+static_transaction_commit(anjay_t *anjay,
+                          const anjay_dm_object_def_t *const *obj_ptr) {
+    (void) anjay;
+    static_object_t *obj = get_obj(obj_ptr);
+    free(obj->backup);
+    obj->backup = NULL;
+    return 0;
+}
+
+static int
+static_transaction_rollback(anjay_t *anjay,
+                            const anjay_dm_object_def_t *const *obj_ptr) {
+    (void) anjay;
+    static_object_t *obj = get_obj(obj_ptr);
+    if (obj->backup) {
+        copy_backup(obj, true);
+        free(obj->backup);
+        obj->backup = NULL;
+    }
+    return 0;
+}
+
+static const anjay_dm_handlers_t STATIC_OBJECT_HANDLERS = {
+    .instance_it = static_instance_it,
+    .instance_present = static_instance_present,
+    .resource_present = anjay_dm_resource_present_TRUE,
+    .resource_operations = static_resource_operations,
+    .instance_resources = static_instance_resources,
+    .resource_read = static_resource_read,
+    .instance_read = static_instance_read,
+    .resource_write = static_resource_write,
+    .transaction_begin = static_transaction_begin,
+    .transaction_validate = anjay_dm_transaction_NOOP,
+    .transaction_commit = static_transaction_commit,
+    .transaction_rollback = static_transaction_rollback
+};
+
+static bool def_valid(const anjay_static_object_def_t *def) {
+    for (size_t i = 0; i < def->resource_count; ++i) {
+        const anjay_static_res_def_t *res = &def->resources[i];
+        if (i > 0 && res->rid <= def->resources[i - 1].rid) {
+            static_obj_log(ERROR, "resources of /%u not sorted", def->oid);
+            return false;
+        }
+        if (!res->getter && !res->size) {
+            static_obj_log(ERROR, "neither offset nor getter set for /%u/*/%u",
+                           def->oid, res->rid);
+            return false;
+        }
+    }
+    return true;
+}
+
+const anjay_dm_object_def_t **
+anjay_static_object_create(const anjay_static_object_def_t *def,
+                           void *const *instances,
+                           size_t instance_count) {
+    if (!def || (instance_count && !instances)
+            || instance_count > ANJAY_IID_INVALID || !def_valid(def)) {
+        return NULL;
+    }
+    static_object_t *obj = (static_object_t *) calloc(
+            1, sizeof(static_object_t)
+                       + def->resource_count * sizeof(anjay_rid_t));
+    if (!obj) {
+        static_obj_log(ERROR, "out of memory");
+        return NULL;
+    }
+    for (size_t i = 0; i < def->resource_count; ++i) {
+        obj->rids[i] = def->resources[i].rid;
+        obj->backup_size += def->resources[i].size;
+    }
+    obj->def.oid = def->oid;
+    obj->def.version = def->version;
+    obj->def.supported_rids.count = def->resource_count;
+    obj->def.supported_rids.rids = obj->rids;
+    obj->def.handlers = STATIC_OBJECT_HANDLERS;
+    obj->def_ptr = &obj->def;
+    obj->static_def = def;
+    obj->instances = instances;
+    obj->instance_count = instance_count;
+    return &obj->def_ptr;
+}
+
+void anjay_static_object_delete(const anjay_dm_object_def_t **obj) {
+    if (obj) {
+        static_object_t *static_obj = get_obj(obj);
+        free(static_obj->backup);
+        free(static_obj);
+    }
+}
+
+#ifdef ANJAY_TEST
+#include "test/static_object.c"
+#endif // ANJAY_TEST
@@ -0,0 +1,455 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <inttypes.h>
+
+#include <avsystem/commons/unit/test.h>
+
+#include <anjay_modules/dm_utils.h>
+#include <anjay_modules/time_defs.h>
+
+#include "../../../../src/io/vtable.h"
+
+typedef struct {
+    int32_t number;
+    int64_t big_number;
+    bool flag;
+    double ratio;
+    char name[16];
+} test_instance_t;
+
+#define TEST_RES_NUMBER 0
+#define TEST_RES_BIG_NUMBER 1
+#define TEST_RES_FLAG 2
+#define TEST_RES_RATIO 3
+#define TEST_RES_NAME 4
+#define TEST_RES_SECRET 5
+#define TEST_RES_COMPUTED 6
+
+static int get_computed(anjay_t *anjay,
+                        anjay_iid_t iid,
+                        anjay_rid_t rid,
+                        const void *instance,
+                        anjay_output_ctx_t *ctx) {
+    (void) anjay;
+    (void) iid;
+    AVS_UNIT_ASSERT_EQUAL(rid, TEST_RES_COMPUTED);
+    return anjay_ret_i32(ctx,
+                         2 * ((const test_instance_t *) instance)->number);
+}
+
+static const anjay_static_res_def_t TEST_RESOURCES[] = {
+    ANJAY_STATIC_RES(TEST_RES_NUMBER,
+                     ANJAY_DM_RESOURCE_OP_BIT_R | ANJAY_DM_RESOURCE_OP_BIT_W,
+                     ANJAY_STATIC_RES_I32, test_instance_t, number),
+    ANJAY_STATIC_RES(TEST_RES_BIG_NUMBER, ANJAY_DM_RESOURCE_OP_BIT_R,
+                     ANJAY_STATIC_RES_I64, test_instance_t, big_number),
+    ANJAY_STATIC_RES(TEST_RES_FLAG, ANJAY_DM_RESOURCE_OP_BIT_R,
+                     ANJAY_STATIC_RES_BOOL, test_instance_t, flag),
+    ANJAY_STATIC_RES(TEST_RES_RATIO, ANJAY_DM_RESOURCE_OP_BIT_R,
+                     ANJAY_STATIC_RES_DOUBLE, test_instance_t, ratio),
+    ANJAY_STATIC_RES(TEST_RES_NAME,
+                     ANJAY_DM_RESOURCE_OP_BIT_R | ANJAY_DM_RESOURCE_OP_BIT_W,
+                     ANJAY_STATIC_RES_STRING, test_instance_t, name),
+    ANJAY_STATIC_RES(TEST_RES_SECRET, ANJAY_DM_RESOURCE_OP_BIT_W,
+                     ANJAY_STATIC_RES_I32, test_instance_t, number),
+    ANJAY_STATIC_RES_GETTER(TEST_RES_COMPUTED, get_computed)
+};
+
+static const anjay_static_object_def_t TEST_OBJECT = {
+    .oid = 1337,
+    .resources = TEST_RESOURCES,
+    .resource_count = AVS_ARRAY_SIZE(TEST_RESOURCES)
+};
+
+//// COUNTING OUTPUT CONTEXT ///////////////////////////////////////////////////
+
+typedef struct {
+    const anjay_output_ctx_vtable_t *vtable;
+    size_t ids;
+    size_t values;
+    int64_t sum;
+} counting_out_t;
+
+static int counting_set_id(anjay_output_ctx_t *ctx,
+                           anjay_id_type_t type,
+                           uint16_t id) {
+    AVS_UNIT_ASSERT_EQUAL(type, ANJAY_ID_RID);
+    counting_out_t *out = (counting_out_t *) ctx;
+    ++out->ids;
+    out->sum += id;
+    return 0;
+}
+
+static int counting_i32(anjay_output_ctx_t *ctx, int32_t value) {
+    counting_out_t *out = (counting_out_t *) ctx;
+    ++out->values;
+    out->sum += value;
+    return 0;
+}
+
+static int counting_i64(anjay_output_ctx_t *ctx, int64_t value) {
+    counting_out_t *out = (counting_out_t *) ctx;
+    ++out->values;
+    out->sum += value;
+    return 0;
+}
+
+static int counting_bool(anjay_output_ctx_t *ctx, bool value) {
+    counting_out_t *out = (counting_out_t *) ctx;
+    ++out->values;
+    out->sum += value;
+    return 0;
+}
+
+static int counting_double(anjay_output_ctx_t *ctx, double value) {
+    counting_out_t *out = (counting_out_t *) ctx;
+    ++out->values;
+    out->sum += (int64_t) value;
+    return 0;
+}
+
+static int counting_string(anjay_output_ctx_t *ctx, const char *value) {
+    counting_out_t *out = (counting_out_t *) ctx;
+    ++out->values;
+    out->sum += (int64_t) strlen(value);
+    return 0;
+}
+
+static const anjay_output_ctx_vtable_t COUNTING_OUT_VTABLE = {
+    .i32 = counting_i32,
+    .i64 = counting_i64,
+    .boolean = counting_bool,
+    .f64 = counting_double,
+    .string = counting_string,
+    .set_id = counting_set_id
+};
+
+#define COUNTING_OUT_INIT { .vtable = &COUNTING_OUT_VTABLE }
+
+//// TESTS /////////////////////////////////////////////////////////////////////
+
+AVS_UNIT_TEST(static_object, create_rejects_unsorted) {
+    const anjay_static_res_def_t resources[] = {
+        ANJAY_STATIC_RES(1, ANJAY_DM_RESOURCE_OP_BIT_R, ANJAY_STATIC_RES_I32,
+                         test_instance_t, number),
+        ANJAY_STATIC_RES(0, ANJAY_DM_RESOURCE_OP_BIT_R, ANJAY_STATIC_RES_I32,
+                         test_instance_t, number)
+    };
+    const anjay_static_object_def_t def = {
+        .oid = 1337,
+        .resources = resources,
+        .resource_count = AVS_ARRAY_SIZE(resources)
+    };
+    AVS_UNIT_ASSERT_NULL(anjay_static_object_create(&def, NULL, 0));
+}
+
+AVS_UNIT_TEST(static_object, instance_it_skips_null) {
+    test_instance_t first = { 0 };
+    test_instance_t second = { 0 };
+    void *instances[] = { NULL, &first, NULL, &second };
+    const anjay_dm_object_def_t **obj =
+            anjay_static_object_create(&TEST_OBJECT, instances,
+                                       AVS_ARRAY_SIZE(instances));
+    AVS_UNIT_ASSERT_NOT_NULL(obj);
+    AVS_UNIT_ASSERT_EQUAL((*obj)->supported_rids.count,
+                          AVS_ARRAY_SIZE(TEST_RESOURCES));
+
+    anjay_iid_t iid;
+    void *cookie = NULL;
+    AVS_UNIT_ASSERT_SUCCESS((*obj)->handlers.instance_it(NULL, obj, &iid,
+                                                         &cookie));
+    AVS_UNIT_ASSERT_EQUAL(iid, 1);
+    AVS_UNIT_ASSERT_SUCCESS((*obj)->handlers.instance_it(NULL, obj, &iid,
+                                                         &cookie));
+    AVS_UNIT_ASSERT_EQUAL(iid, 3);
+    AVS_UNIT_ASSERT_SUCCESS((*obj)->handlers.instance_it(NULL, obj, &iid,
+                                                         &cookie));
+    AVS_UNIT_ASSERT_EQUAL(iid, ANJAY_IID_INVALID);
+
+    AVS_UNIT_ASSERT_EQUAL((*obj)->handlers.instance_present(NULL, obj, 0), 0);
+    AVS_UNIT_ASSERT_EQUAL((*obj)->handlers.instance_present(NULL, obj, 1), 1);
+    AVS_UNIT_ASSERT_EQUAL((*obj)->handlers.instance_present(NULL, obj, 4), 0);
+    anjay_static_object_delete(obj);
+}
+
+AVS_UNIT_TEST(static_object, instance_read) {
+    test_instance_t instance = {
+        .number = 5,
+        .big_number = 100,
+        .flag = true,
+        .ratio = 7.0,
+        .name = "abc"
+    };
+    void *instances[] = { &instance };
+    const anjay_dm_object_def_t **obj =
+            anjay_static_object_create(&TEST_OBJECT, instances, 1);
+    AVS_UNIT_ASSERT_NOT_NULL(obj);
+
+    counting_out_t out = COUNTING_OUT_INIT;
+    AVS_UNIT_ASSERT_SUCCESS((*obj)->handlers.instance_read(
+            NULL, obj, 0, (anjay_output_ctx_t *) &out));
+    // the write-only Resource 5 is skipped
+    AVS_UNIT_ASSERT_EQUAL(out.ids, 6);
+    AVS_UNIT_ASSERT_EQUAL(out.values, 6);
+    AVS_UNIT_ASSERT_EQUAL(out.sum, (0 + 1 + 2 + 3 + 4 + 6)
+                                           + (5 + 100 + 1 + 7 + 3 + 10));
+
+    anjay_dm_resource_op_mask_t masks[AVS_ARRAY_SIZE(TEST_RESOURCES)] = { 0 };
+    AVS_UNIT_ASSERT_SUCCESS((*obj)->handlers.instance_resources(NULL, obj, 0,
+                                                                masks));
+    AVS_UNIT_ASSERT_EQUAL(masks[TEST_RES_SECRET],
+                          ANJAY_DM_RESOURCE_PRESENT
+                                  | ANJAY_DM_RESOURCE_OP_BIT_W);
+    AVS_UNIT_ASSERT_EQUAL(masks[TEST_RES_COMPUTED],
+                          ANJAY_DM_RESOURCE_PRESENT
+                                  | ANJAY_DM_RESOURCE_OP_BIT_R);
+    anjay_static_object_delete(obj);
+}
+
+//// CONSTANT INPUT CONTEXT //////////////////////////////////////////////////
+
+typedef struct {
+    const anjay_input_ctx_vtable_t *vtable;
+    int32_t i32;
+    const char *string;
+} constant_in_t;
+
+static int constant_i32(anjay_input_ctx_t *ctx, int32_t *out) {
+    *out = ((constant_in_t *) ctx)->i32;
+    return 0;
+}
+
+static int constant_string(anjay_input_ctx_t *ctx, char *out, size_t size) {
+    const char *value = ((constant_in_t *) ctx)->string;
+    if (strlen(value) >= size) {
+        return ANJAY_BUFFER_TOO_SHORT;
+    }
+    strcpy(out, value);
+    return 0;
+}
+
+static const anjay_input_ctx_vtable_t CONSTANT_IN_VTABLE = {
+    .i32 = constant_i32,
+    .string = constant_string
+};
+
+static void write_number_and_name(const anjay_dm_object_def_t **obj,
+                                  anjay_iid_t iid,
+                                  int32_t number,
+                                  const char *name) {
+    constant_in_t in = { &CONSTANT_IN_VTABLE, number, name };
+    AVS_UNIT_ASSERT_SUCCESS((*obj)->handlers.resource_write(
+            NULL, obj, iid, TEST_RES_NUMBER, (anjay_input_ctx_t *) &in));
+    AVS_UNIT_ASSERT_SUCCESS((*obj)->handlers.resource_write(
+            NULL, obj, iid, TEST_RES_NAME, (anjay_input_ctx_t *) &in));
+}
+
+AVS_UNIT_TEST(static_object, transaction) {
+    test_instance_t first = { .number = 1, .name = "first" };
+    test_instance_t second = { .number = 2, .name = "second" };
+    void *instances[] = { &first, NULL, &second };
+    const anjay_dm_object_def_t **obj =
+            anjay_static_object_create(&TEST_OBJECT, instances,
+                                       AVS_ARRAY_SIZE(instances));
+    AVS_UNIT_ASSERT_NOT_NULL(obj);
+
+    // rolled back writes are reverted
+    AVS_UNIT_ASSERT_SUCCESS((*obj)->handlers.transaction_begin(NULL, obj));
+    write_number_and_name(obj, 0, 10, "changed");
+    write_number_and_name(obj, 2, 20, "changed too");
+    AVS_UNIT_ASSERT_EQUAL(first.number, 10);
+    AVS_UNIT_ASSERT_EQUAL_STRING(second.name, "changed too");
+    AVS_UNIT_ASSERT_SUCCESS((*obj)->handlers.transaction_validate(NULL, obj));
+    AVS_UNIT_ASSERT_SUCCESS((*obj)->handlers.transaction_rollback(NULL, obj));
+    AVS_UNIT_ASSERT_EQUAL(first.number, 1);
+    AVS_UNIT_ASSERT_EQUAL_STRING(first.name, "first");
+    AVS_UNIT_ASSERT_EQUAL(second.number, 2);
+    AVS_UNIT_ASSERT_EQUAL_STRING(second.name, "second");
+
+    // committed writes are kept
+    AVS_UNIT_ASSERT_SUCCESS((*obj)->handlers.transaction_begin(NULL, obj));
+    write_number_and_name(obj, 2, 20, "committed");
+    AVS_UNIT_ASSERT_SUCCESS((*obj)->handlers.transaction_validate(NULL, obj));
+    AVS_UNIT_ASSERT_SUCCESS((*obj)->handlers.transaction_commit(NULL, obj));
+    AVS_UNIT_ASSERT_EQUAL(second.number, 20);
+    AVS_UNIT_ASSERT_EQUAL_STRING(second.name, "committed");
+
+    // a transaction left open is cleaned up along with the object
+    AVS_UNIT_ASSERT_SUCCESS((*obj)->handlers.transaction_begin(NULL, obj));
+    anjay_static_object_delete(obj);
+}
+
+//// BENCHMARK /////////////////////////////////////////////////////////////////
+
+// handler-based equivalent of TEST_OBJECT, written the way demo objects are
+
+static test_instance_t *bench_instances;
+
+static int bench_resource_operations(anjay_t *anjay,
+                                     const anjay_dm_object_def_t *const *obj_ptr,
+                                     anjay_rid_t rid,
+                                     anjay_dm_resource_op_mask_t *out) {
+    (void) anjay;
+    (void) obj_ptr;
+    switch (rid) {
+    case TEST_RES_NUMBER:
+    case TEST_RES_NAME:
+        *out = ANJAY_DM_RESOURCE_OP_BIT_R | ANJAY_DM_RESOURCE_OP_BIT_W;
+        return 0;
+    case TEST_RES_SECRET:
+        *out = ANJAY_DM_RESOURCE_OP_BIT_W;
+        return 0;
+    default:
+        *out = ANJAY_DM_RESOURCE_OP_BIT_R;
+        return 0;
+    }
+}
+
+static int bench_resource_read(anjay_t *anjay,
+                               const anjay_dm_object_def_t *const *obj_ptr,
+                               anjay_iid_t iid,
+                               anjay_rid_t rid,
+                               anjay_output_ctx_t *ctx) {
+    (void) obj_ptr;
+    const test_instance_t *instance = &bench_instances[iid];
+    switch (rid) {
+    case TEST_RES_NUMBER:
+        return anjay_ret_i32(ctx, instance->number);
+    case TEST_RES_BIG_NUMBER:
+        return anjay_ret_i64(ctx, instance->big_number);
+    case TEST_RES_FLAG:
+        return anjay_ret_bool(ctx, instance->flag);
+    case TEST_RES_RATIO:
+        return anjay_ret_double(ctx, instance->ratio);
+    case TEST_RES_NAME:
+        return anjay_ret_string(ctx, instance->name);
+    case TEST_RES_COMPUTED:
+        return get_computed(anjay, iid, rid, instance, ctx);
+    default:
+        return ANJAY_ERR_METHOD_NOT_ALLOWED;
+    }
+}
+
+static const anjay_dm_object_def_t BENCH_OBJECT_DEF = {
+    .oid = 1338,
+    .supported_rids = ANJAY_DM_SUPPORTED_RIDS(0, 1, 2, 3, 4, 5, 6),
+    .handlers = {
+        .resource_present = anjay_dm_resource_present_TRUE,
+        .resource_operations = bench_resource_operations,
+        .resource_read = bench_resource_read
+    }
+};
+static const anjay_dm_object_def_t *const BENCH_OBJECT = &BENCH_OBJECT_DEF;
+
+#define BENCH_INSTANCES 200
+#define BENCH_ROUNDS 20
+
+// the same steps read_instance() in dm_core.c performs for each Resource
+static void bench_read_per_resource(anjay_t *anjay,
+                                    const anjay_dm_object_def_t *const *obj,
+                                    anjay_iid_t iid,
+                                    anjay_output_ctx_t *ctx) {
+    for (size_t i = 0; i < (*obj)->supported_rids.count; ++i) {
+        anjay_rid_t rid = (*obj)->supported_rids.rids[i];
+        anjay_dm_resource_op_mask_t mask = ANJAY_DM_RESOURCE_OP_NONE;
+        AVS_UNIT_ASSERT_EQUAL(
+                _anjay_dm_resource_present(anjay, obj, iid, rid, NULL), 1);
+        AVS_UNIT_ASSERT_SUCCESS(
+                _anjay_dm_resource_operations(anjay, obj, rid, &mask, NULL));
+        if (mask & ANJAY_DM_RESOURCE_OP_BIT_R) {
+            AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(ctx, ANJAY_ID_RID,
+                                                         rid));
+            AVS_UNIT_ASSERT_SUCCESS(
+                    _anjay_dm_resource_read(anjay, obj, iid, rid, ctx, NULL));
+        }
+    }
+}
+
+static int64_t elapsed_us(avs_time_monotonic_t start) {
+    int64_t result = 0;
+    AVS_UNIT_ASSERT_SUCCESS(avs_time_duration_to_scalar(
+            &result, AVS_TIME_US,
+            avs_time_monotonic_diff(avs_time_monotonic_now(), start)));
+    return result;
+}
+
+AVS_UNIT_TEST(static_object, benchmark_against_handlers) {
+    anjay_t *anjay = anjay_new(&(const anjay_configuration_t) {
+        .endpoint_name = "urn:dev:os:anjay-test",
+        .in_buffer_size = 4096,
+        .out_buffer_size = 4096
+    });
+    AVS_UNIT_ASSERT_NOT_NULL(anjay);
+
+    test_instance_t *instances = (test_instance_t *) calloc(
+            BENCH_INSTANCES, sizeof(test_instance_t));
+    void **instance_ptrs = (void **) calloc(BENCH_INSTANCES, sizeof(void *));
+    AVS_UNIT_ASSERT_NOT_NULL(instances);
+    AVS_UNIT_ASSERT_NOT_NULL(instance_ptrs);
+    for (size_t i = 0; i < BENCH_INSTANCES; ++i) {
+        instances[i].number = (int32_t) i;
+        instances[i].big_number = (int64_t) i * 1000;
+        instances[i].flag = (i % 2 != 0);
+        instances[i].ratio = (double) i / 2;
+        strcpy(instances[i].name, "instance");
+        instance_ptrs[i] = &instances[i];
+    }
+    bench_instances = instances;
+    const anjay_dm_object_def_t **static_obj =
+            anjay_static_object_create(&TEST_OBJECT, instance_ptrs,
+                                       BENCH_INSTANCES);
+    AVS_UNIT_ASSERT_NOT_NULL(static_obj);
+    AVS_UNIT_ASSERT_TRUE(_anjay_dm_instance_read_usable(anjay, static_obj));
+
+    counting_out_t handler_out = COUNTING_OUT_INIT;
+    avs_time_monotonic_t start = avs_time_monotonic_now();
+    for (int round = 0; round < BENCH_ROUNDS; ++round) {
+        for (anjay_iid_t iid = 0; iid < BENCH_INSTANCES; ++iid) {
+            bench_read_per_resource(anjay, &BENCH_OBJECT, iid,
+                                    (anjay_output_ctx_t *) &handler_out);
+        }
+    }
+    const int64_t handler_us = elapsed_us(start);
+
+    counting_out_t static_out = COUNTING_OUT_INIT;
+    start = avs_time_monotonic_now();
+    for (int round = 0; round < BENCH_ROUNDS; ++round) {
+        for (anjay_iid_t iid = 0; iid < BENCH_INSTANCES; ++iid) {
+            AVS_UNIT_ASSERT_SUCCESS(_anjay_dm_instance_read(
+                    anjay, static_obj, iid,
+                    (anjay_output_ctx_t *) &static_out, NULL));
+        }
+    }
+    const int64_t static_us = elapsed_us(start);
+
+    static_obj_log(INFO,
+                   "reading %d instances %d times: handler-based %" PRId64
+                   " us, static %" PRId64 " us",
+                   BENCH_INSTANCES, BENCH_ROUNDS, handler_us, static_us);
+
+    // both objects must have returned exactly the same data
+    AVS_UNIT_ASSERT_EQUAL(handler_out.ids, static_out.ids);
+    AVS_UNIT_ASSERT_EQUAL(handler_out.values, static_out.values);
+    AVS_UNIT_ASSERT_EQUAL(handler_out.sum, static_out.sum);
+
+    anjay_static_object_delete(static_obj);
+    free(instance_ptrs);
+    free(instances);
+    anjay_delete(anjay);
+}
@@ -98,11 +98,41 @@ static int init(anjay_t *anjay,
         return -1;
     }
 
+    if (config->block_response_cache_size
+            && _anjay_coap_stream_enable_block_cache(
+                    anjay->comm_stream, config->block_response_cache_size,
+                    &anjay->clock)) {
+        anjay_log(ERROR, "could not enable block response cache");
+        return -1;
+    }
+
+#ifdef WITH_DISCOVER
+    _anjay_discover_cache_init(&anjay->discover_cache,
+                               config->discover_cache_size);
+#else // WITH_DISCOVER
+    if (config->discover_cache_size) {
+        anjay_log(ERROR, "Discover support not compiled in");
+        return -1;
+    }
+#endif // WITH_DISCOVER
+
+    _anjay_clock_init(&anjay->clock, config->monotonic_clock,
+                      config->real_clock, config->clock_arg);
+
     anjay->sched = _anjay_sched_new(anjay);
     if (!anjay->sched) {
         return -1;
     }
 
+    _anjay_resolver_init(&anjay->resolver, config->resolve_handler,
+                         config->resolve_handler_arg,
+                         config->refresh_dns_cache_in_background);
+
+    _anjay_exchanges_init(anjay);
+    _anjay_server_stats_init(anjay);
+    anjay->nstart = config->nstart ? config->nstart : 1;
+    anjay->queue_mode_park_sockets = config->queue_mode_park_sockets;
+
     if (_anjay_observe_init(anjay, config->confirmable_notifications)) {
         return -1;
     }
@@ -153,6 +183,7 @@ anjay_t *anjay_new(const anjay_configuration_t *config) {
 }
 
 void _anjay_release_server_stream_without_scheduling_queue(anjay_t *anjay) {
+    _anjay_server_stats_charge_to(anjay, ANJAY_SSID_ANY);
     memset(&anjay->current_connection, 0, sizeof(anjay->current_connection));
     avs_stream_reset(anjay->comm_stream);
     if (avs_stream_net_setsock(anjay->comm_stream, NULL)) {
@@ -167,9 +198,15 @@ void anjay_delete(anjay_t *anjay) {
     _anjay_downloader_cleanup(&anjay->downloader);
 #endif // WITH_DOWNLOADER
 
+    // pending exchanges refer to server connections, and their retransmission
+    // jobs would otherwise be run by _anjay_sched_delete() below
+    _anjay_exchanges_cleanup(anjay);
     _anjay_bootstrap_cleanup(anjay);
     _anjay_servers_cleanup(anjay);
+    // referenced by server sockets, so released only after them
+    _anjay_dtls_sessions_cleanup(anjay);
     _anjay_sched_del(anjay->sched, &anjay->reload_servers_sched_job_handle);
+    _anjay_resolver_cleanup(anjay);
 
     _anjay_sched_delete(&anjay->sched);
 
@@ -177,7 +214,11 @@ void anjay_delete(anjay_t *anjay) {
     avs_stream_cleanup(&anjay->comm_stream);
 
     _anjay_dm_cleanup(anjay);
+#ifdef WITH_DISCOVER
+    _anjay_discover_cache_cleanup(&anjay->discover_cache);
+#endif // WITH_DISCOVER
     _anjay_observe_cleanup(anjay);
+    _anjay_server_stats_cleanup(anjay);
     _anjay_notify_clear_queue(&anjay->scheduled_notify.queue);
 
     free(anjay->in_buffer);
@@ -526,7 +567,7 @@ static int parse_dm_uri(const avs_coap_msg_t *msg,
     return 0;
 }
 
-static int parse_request_uri(const avs_coap_msg_t *msg,
+int _anjay_parse_request_uri(const avs_coap_msg_t *msg,
                              bool *out_is_bs,
                              anjay_uri_path_t *out_uri) {
     int result = parse_bs_uri(msg, out_is_bs);
@@ -573,7 +614,8 @@ static int parse_request(const avs_coap_msg_t *msg,
     out_request->msg_type = avs_coap_msg_get_type(msg);
     out_request->request_code = avs_coap_msg_get_code(msg);
     if (parse_observe(msg, &out_request->observe)
-        || parse_request_uri(msg, &out_request->is_bs_uri, &out_request->uri)
+        || _anjay_parse_request_uri(msg, &out_request->is_bs_uri,
+                                    &out_request->uri)
         || parse_attributes(msg, &out_request->attributes)
         || avs_coap_msg_get_content_format(msg, &out_request->content_format)
         || parse_action(msg, out_request)) {
@@ -659,7 +701,7 @@ static int handle_request(anjay_t *anjay,
 
     int finish_result = 0;
     if (request->msg_type == AVS_COAP_MSG_CONFIRMABLE) {
-        finish_result = avs_stream_finish_message(anjay->comm_stream);
+        finish_result = _anjay_comm_stream_finish_message(anjay);
     }
 
     if (_anjay_dm_current_ssid(anjay) != ANJAY_SSID_BOOTSTRAP) {
@@ -678,8 +720,16 @@ static int handle_incoming_message(anjay_t *anjay) {
     }
 
     const avs_coap_msg_t *request_msg;
-    if ((result = _anjay_coap_stream_get_incoming_msg(anjay->comm_stream,
-                                                      &request_msg))) {
+    _anjay_trace_begin(anjay, "net", "recv", 0);
+    result = _anjay_coap_stream_get_incoming_msg(anjay->comm_stream,
+                                                 &request_msg);
+    _anjay_trace_end(anjay, "net", "recv", 0);
+    if (!result || result == AVS_COAP_CTX_ERR_DUPLICATE
+            || result == AVS_COAP_CTX_ERR_MSG_WAS_PING) {
+        _anjay_server_stats_record_incoming(
+                anjay, anjay->current_connection.server->ssid);
+    }
+    if (result) {
         if (result == AVS_COAP_CTX_ERR_DUPLICATE) {
             anjay_log(TRACE, "duplicate request received");
             return 0;
@@ -692,17 +742,60 @@ static int handle_incoming_message(anjay_t *anjay) {
         }
     }
 
+    // a Reset not matched to any exchange may still be a response to
+    // a Non-confirmable Notification; it is handled as Cancel Observe below
+    const bool is_reset =
+            (avs_coap_msg_get_type(request_msg) == AVS_COAP_MSG_RESET);
+    if (!_anjay_exchange_handle_response(
+            anjay, anjay->current_connection.server->ssid,
+            anjay->current_connection.conn_type, request_msg)) {
+        return 0;
+    } else if (avs_coap_msg_get_type(request_msg)
+                   == AVS_COAP_MSG_ACKNOWLEDGEMENT) {
+        anjay_log(DEBUG, "ignoring unexpected Acknowledgement %" PRIu16,
+                  avs_coap_msg_get_id(request_msg));
+        return 0;
+    } else if (!is_reset && !avs_coap_msg_is_request(request_msg)) {
+        anjay_log(DEBUG, "unexpected response: %s",
+                  AVS_COAP_CODE_STRING(avs_coap_msg_get_code(request_msg)));
+        if (avs_coap_msg_get_type(request_msg) == AVS_COAP_MSG_CONFIRMABLE) {
+            _anjay_trace_begin(anjay, "net", "send", 0);
+            avs_coap_ctx_send_empty(anjay->coap_ctx,
+                                    _anjay_connection_get_online_socket(
+                                            _anjay_get_server_connection(
+                                                    anjay->current_connection)),
+                                    AVS_COAP_MSG_RESET,
+                                    avs_coap_msg_get_id(request_msg));
+            _anjay_trace_end(anjay, "net", "send", 0);
+        }
+        return 0;
+    } else if (!is_reset
+                   && anjay->current_connection.server->registration_exchange) {
+        // requests are not handled until the registration is finished,
+        // just like if we were blocked waiting for the response
+        anjay_log(DEBUG, "registration in progress, rejecting request");
+        if (_anjay_coap_stream_set_error(anjay->comm_stream,
+                                         -ANJAY_ERR_SERVICE_UNAVAILABLE)
+                || _anjay_comm_stream_finish_message(anjay)) {
+            anjay_log(WARNING, "could not send Service Unavailable response");
+        }
+        return 0;
+    }
+
     avs_coap_msg_identity_t request_identity = AVS_COAP_MSG_IDENTITY_EMPTY;
     anjay_request_t request;
-    if (_anjay_coap_stream_get_request_identity(anjay->comm_stream,
-                                                &request_identity)
-            || avs_coap_msg_validate_critical_options(
-                    request_msg, critical_option_validator)
-            || parse_request(request_msg, &request)) {
+    _anjay_trace_begin(anjay, "coap", "parse_request", 0);
+    result = (_anjay_coap_stream_get_request_identity(anjay->comm_stream,
+                                                      &request_identity)
+              || avs_coap_msg_validate_critical_options(
+                         request_msg, critical_option_validator)
+              || parse_request(request_msg, &request));
+    _anjay_trace_end(anjay, "coap", "parse_request", 0);
+    if (result) {
         if (avs_coap_msg_code_is_request(avs_coap_msg_get_code(request_msg))) {
             if (_anjay_coap_stream_set_error(anjay->comm_stream,
                                              -ANJAY_ERR_BAD_OPTION)
-                    || avs_stream_finish_message(anjay->comm_stream)) {
+                    || _anjay_comm_stream_finish_message(anjay)) {
                 anjay_log(WARNING, "could not send Bad Option response");
             }
         }
@@ -711,7 +804,10 @@ static int handle_incoming_message(anjay_t *anjay) {
 
     _anjay_coap_stream_set_block_request_validator(
             anjay->comm_stream, block_request_equality_validator, &request);
-    return handle_request(anjay, &request_identity, &request);
+    _anjay_trace_begin(anjay, "coap", "handle_request", 0);
+    result = handle_request(anjay, &request_identity, &request);
+    _anjay_trace_end(anjay, "coap", "handle_request", 0);
+    return result;
 }
 
 anjay_server_connection_t *
@@ -753,6 +849,7 @@ int _anjay_bind_server_stream(anjay_t *anjay, anjay_connection_ref_t ref) {
 
     assert(!anjay->current_connection.server);
     anjay->current_connection = ref;
+    _anjay_server_stats_charge_to(anjay, ref.server->ssid);
     return 0;
 }
 
@@ -790,7 +887,11 @@ static int queue_mode_close_socket(anjay_t *anjay, void *args_) {
     if (!ref.server) {
         return -1;
     }
-    _anjay_connection_suspend(ref);
+    if (anjay->queue_mode_park_sockets) {
+        _anjay_connection_park(ref);
+    } else {
+        _anjay_connection_suspend(ref);
+    }
     return 0;
 }
 
@@ -836,6 +937,22 @@ void _anjay_release_server_stream(anjay_t *anjay) {
     _anjay_release_server_stream_without_scheduling_queue(anjay);
 }
 
+int _anjay_comm_stream_finish_message(anjay_t *anjay) {
+    _anjay_trace_begin(anjay, "net", "send", 0);
+    int result = avs_stream_finish_message(anjay->comm_stream);
+    _anjay_trace_end(anjay, "net", "send", 0);
+    return result;
+}
+
+int _anjay_comm_stream_get_response(anjay_t *anjay,
+                                    const avs_coap_msg_t **out_msg) {
+    _anjay_trace_begin(anjay, "net", "recv", 0);
+    int result = _anjay_coap_stream_get_incoming_msg(anjay->comm_stream,
+                                                     out_msg);
+    _anjay_trace_end(anjay, "net", "recv", 0);
+    return result;
+}
+
 size_t _anjay_num_non_bootstrap_servers(anjay_t *anjay) {
     size_t num_servers = 0;
     {
@@ -933,6 +1050,22 @@ int anjay_sched_run(anjay_t *anjay) {
     return 0;
 }
 
+int anjay_sched_run_bounded(anjay_t *anjay,
+                            size_t max_tasks,
+                            avs_time_duration_t time_budget) {
+    avs_time_monotonic_t deadline =
+            avs_time_monotonic_add(_anjay_time_monotonic_now(anjay),
+                                   time_budget);
+    ssize_t tasks_executed =
+            _anjay_sched_run_bounded(anjay->sched, max_tasks, deadline);
+    if (tasks_executed < 0) {
+        anjay_log(ERROR, "sched_run failed");
+        return -1;
+    }
+
+    return _anjay_sched_has_due_tasks(anjay->sched) ? 1 : 0;
+}
+
 anjay_download_handle_t anjay_download(anjay_t *anjay,
                                        const anjay_download_config_t *config) {
 #ifdef WITH_DOWNLOADER
@@ -994,7 +1127,26 @@ uint64_t anjay_get_num_incoming_retransmissions(anjay_t *anjay) {
 
 uint64_t anjay_get_num_outgoing_retransmissions(anjay_t *anjay) {
 #ifdef WITH_NET_STATS
-    return avs_coap_ctx_get_num_outgoing_retransmissions(anjay->coap_ctx);
+    return avs_coap_ctx_get_num_outgoing_retransmissions(anjay->coap_ctx)
+           + anjay->exchanges.num_retransmissions;
+#else
+    (void) anjay;
+    return 0;
+#endif
+}
+
+uint64_t anjay_get_num_dtls_full_handshakes(anjay_t *anjay) {
+#ifdef WITH_NET_STATS
+    return anjay->num_dtls_full_handshakes;
+#else
+    (void) anjay;
+    return 0;
+#endif
+}
+
+uint64_t anjay_get_num_dtls_resumed_handshakes(anjay_t *anjay) {
+#ifdef WITH_NET_STATS
+    return anjay->num_dtls_resumed_handshakes;
 #else
     (void) anjay;
     return 0;
@@ -21,8 +21,15 @@
 #include <avsystem/commons/stream.h>
 #include <avsystem/commons/net.h>
 
+#include "clock.h"
+#include "coap_exchange.h"
 #include "dm_core.h"
+#include "dm/discover.h"
+#include "dtls_session.h"
 #include "observe_core.h"
+#include "resolver.h"
+#include "server_stats.h"
+#include "trace.h"
 
 #include "servers.h"
 #include "utils_core.h"
@@ -45,8 +52,13 @@ struct anjay_struct {
     bool offline;
     avs_net_ssl_version_t dtls_version;
     avs_net_socket_configuration_t udp_socket_config;
+    anjay_clock_t clock;
     anjay_sched_t *sched;
+    anjay_resolver_t resolver;
     anjay_dm_t dm;
+#ifdef WITH_DISCOVER
+    anjay_discover_cache_t discover_cache;
+#endif // WITH_DISCOVER
     uint16_t udp_listen_port;
     anjay_servers_t servers;
     anjay_sched_handle_t reload_servers_sched_job_handle;
@@ -58,6 +70,9 @@ struct anjay_struct {
 #endif
     avs_coap_tx_params_t udp_tx_params;
     avs_coap_ctx_t *coap_ctx;
+    anjay_exchanges_t exchanges;
+    uint16_t nstart;
+    bool queue_mode_park_sockets;
     avs_stream_abstract_t *comm_stream;
     anjay_connection_ref_t current_connection;
     anjay_scheduled_notify_t scheduled_notify;
@@ -74,6 +89,16 @@ struct anjay_struct {
     anjay_downloader_t downloader;
 #endif // WITH_DOWNLOADER
     uint32_t max_icmp_failures;
+
+    AVS_LIST(anjay_dtls_session_t) dtls_sessions;
+#ifdef WITH_NET_STATS
+    uint64_t num_dtls_full_handshakes;
+    uint64_t num_dtls_resumed_handshakes;
+    anjay_server_stats_registry_t server_stats;
+#endif // WITH_NET_STATS
+#ifdef WITH_TRACE
+    anjay_trace_t trace;
+#endif // WITH_TRACE
 };
 
 #define ANJAY_DM_DEFAULT_PMIN_VALUE 1
@@ -97,8 +122,31 @@ void _anjay_release_server_stream_without_scheduling_queue(anjay_t *anjay);
 
 void _anjay_release_server_stream(anjay_t *anjay);
 
+/**
+ * Sends the message prepared in anjay->comm_stream, just like
+ * avs_stream_finish_message() does, and reports it as a "net" trace event.
+ */
+int _anjay_comm_stream_finish_message(anjay_t *anjay);
+
+/**
+ * Waits for the response to the request sent with
+ * _anjay_comm_stream_finish_message(), just like
+ * _anjay_coap_stream_get_incoming_msg() does, and reports it as a "net" trace
+ * event.
+ */
+int _anjay_comm_stream_get_response(anjay_t *anjay,
+                                    const avs_coap_msg_t **out_msg);
+
 size_t _anjay_num_non_bootstrap_servers(anjay_t *anjay);
 
+/**
+ * Extracts the data model path (or Bootstrap-Finish "/bs" path, in which case
+ * @p out_is_bs is set to true) from Uri-Path options of @p msg.
+ */
+int _anjay_parse_request_uri(const avs_coap_msg_t *msg,
+                             bool *out_is_bs,
+                             anjay_uri_path_t *out_uri);
+
 /**
  * @param anjay Pointer to the Anjay object, passed to scheduled jobs. Not
  *              dereferenced by the scheduler object.
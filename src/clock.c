@@ -0,0 +1,62 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include "anjay_core.h"
+#include "clock.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+static avs_time_monotonic_t system_monotonic_clock(void *arg) {
+    (void) arg;
+    return avs_time_monotonic_now();
+}
+
+static avs_time_real_t system_real_clock(void *arg) {
+    (void) arg;
+    return avs_time_real_now();
+}
+
+void _anjay_clock_init(anjay_clock_t *clock,
+                       anjay_monotonic_clock_t *monotonic,
+                       anjay_real_clock_t *real,
+                       void *arg) {
+    *clock = (anjay_clock_t) {
+        .monotonic = monotonic ? monotonic : system_monotonic_clock,
+        .real = real ? real : system_real_clock,
+        .arg = arg
+    };
+}
+
+avs_time_monotonic_t _anjay_clock_monotonic_now(const anjay_clock_t *clock) {
+    if (!clock) {
+        return avs_time_monotonic_now();
+    }
+    return clock->monotonic(clock->arg);
+}
+
+avs_time_monotonic_t _anjay_time_monotonic_now(anjay_t *anjay) {
+    // the scheduler is used without an Anjay instance in unit tests
+    return _anjay_clock_monotonic_now(anjay ? &anjay->clock : NULL);
+}
+
+avs_time_real_t _anjay_time_real_now(anjay_t *anjay) {
+    if (!anjay) {
+        return avs_time_real_now();
+    }
+    return anjay->clock.real(anjay->clock.arg);
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_CLOCK_H
+#define ANJAY_CLOCK_H
+
+#include <avsystem/commons/time.h>
+
+#include <anjay/core.h>
+
+#include "utils_core.h"
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+typedef struct {
+    anjay_monotonic_clock_t *monotonic;
+    anjay_real_clock_t *real;
+    void *arg;
+} anjay_clock_t;
+
+void _anjay_clock_init(anjay_clock_t *clock,
+                       anjay_monotonic_clock_t *monotonic,
+                       anjay_real_clock_t *real,
+                       void *arg);
+
+/**
+ * Returns current monotonic time, as reported by @p clock . System time is
+ * used if @p clock is NULL.
+ */
+avs_time_monotonic_t _anjay_clock_monotonic_now(const anjay_clock_t *clock);
+
+/**
+ * Returns current monotonic time, as reported by the clock configured for
+ * @p anjay . System time is used if @p anjay is NULL.
+ */
+avs_time_monotonic_t _anjay_time_monotonic_now(anjay_t *anjay);
+
+/**
+ * Returns current real time, as reported by the clock configured for
+ * @p anjay . System time is used if @p anjay is NULL.
+ */
+avs_time_real_t _anjay_time_real_now(anjay_t *anjay);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_CLOCK_H */
@@ -0,0 +1,225 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include <avsystem/commons/coap/msg_opt.h>
+
+#define ANJAY_COAP_STREAM_INTERNALS
+
+#include "../coap_log.h"
+
+#include "cache.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+typedef struct {
+    avs_net_abstract_socket_t *socket;
+    avs_time_monotonic_t expire_time;
+    coap_block_cache_key_t *key;
+    uint8_t *payload;
+    coap_block_cache_entry_t entry;
+} cache_item_t;
+
+struct coap_block_cache {
+    const anjay_clock_t *clock;
+    size_t max_size;
+    size_t size;
+    // oldest first
+    AVS_LIST(cache_item_t) items;
+};
+
+coap_block_cache_t *_anjay_coap_block_cache_new(size_t max_size,
+                                                const anjay_clock_t *clock) {
+    coap_block_cache_t *cache =
+            (coap_block_cache_t *) calloc(1, sizeof(coap_block_cache_t));
+    if (cache) {
+        cache->clock = clock;
+        cache->max_size = max_size;
+    }
+    return cache;
+}
+
+static size_t item_size(const cache_item_t *item) {
+    return item->key->size + item->entry.payload_size;
+}
+
+static void delete_item(coap_block_cache_t *cache,
+                        AVS_LIST(cache_item_t) *item_ptr) {
+    assert(cache->size >= item_size(*item_ptr));
+    cache->size -= item_size(*item_ptr);
+    free((*item_ptr)->key);
+    free((*item_ptr)->payload);
+    AVS_LIST_DELETE(item_ptr);
+}
+
+void _anjay_coap_block_cache_delete(coap_block_cache_t **cache_ptr) {
+    if (!*cache_ptr) {
+        return;
+    }
+    while ((*cache_ptr)->items) {
+        delete_item(*cache_ptr, &(*cache_ptr)->items);
+    }
+    free(*cache_ptr);
+    *cache_ptr = NULL;
+}
+
+size_t _anjay_coap_block_cache_max_size(const coap_block_cache_t *cache) {
+    return cache->max_size;
+}
+
+static bool is_key_option(uint32_t opt_number) {
+    // only critical options may change the meaning of a request
+    return (opt_number % 2) && opt_number != AVS_COAP_OPT_BLOCK2;
+}
+
+coap_block_cache_key_t *
+_anjay_coap_block_cache_key_new(const avs_coap_msg_t *request) {
+    size_t size = 0;
+    for (avs_coap_opt_iterator_t it = avs_coap_opt_begin(request);
+            !avs_coap_opt_end(&it); avs_coap_opt_next(&it)) {
+        if (is_key_option(avs_coap_opt_number(&it))) {
+            size += 2 * sizeof(uint32_t)
+                    + avs_coap_opt_content_length(it.curr_opt);
+        }
+    }
+
+    coap_block_cache_key_t *key = (coap_block_cache_key_t *) malloc(
+            offsetof(coap_block_cache_key_t, data) + size);
+    if (!key) {
+        return NULL;
+    }
+    key->size = size;
+
+    uint8_t *ptr = key->data;
+    for (avs_coap_opt_iterator_t it = avs_coap_opt_begin(request);
+            !avs_coap_opt_end(&it); avs_coap_opt_next(&it)) {
+        uint32_t number = avs_coap_opt_number(&it);
+        if (!is_key_option(number)) {
+            continue;
+        }
+        uint32_t length = avs_coap_opt_content_length(it.curr_opt);
+        memcpy(ptr, &number, sizeof(number));
+        ptr += sizeof(number);
+        memcpy(ptr, &length, sizeof(length));
+        ptr += sizeof(length);
+        memcpy(ptr, avs_coap_opt_value(it.curr_opt), length);
+        ptr += length;
+    }
+    assert(ptr == key->data + size);
+    return key;
+}
+
+static bool keys_equal(const coap_block_cache_key_t *a,
+                       const coap_block_cache_key_t *b) {
+    return a->size == b->size && !memcmp(a->data, b->data, a->size);
+}
+
+static void drop_expired(coap_block_cache_t *cache) {
+    avs_time_monotonic_t now = _anjay_clock_monotonic_now(cache->clock);
+    AVS_LIST(cache_item_t) *item_ptr;
+    AVS_LIST(cache_item_t) helper;
+    AVS_LIST_DELETABLE_FOREACH_PTR(item_ptr, helper, &cache->items) {
+        if (!avs_time_monotonic_before(now, (*item_ptr)->expire_time)) {
+            coap_log(TRACE, "block cache: dropping expired entry");
+            delete_item(cache, item_ptr);
+        }
+    }
+}
+
+static AVS_LIST(cache_item_t) *
+find_item_ptr(coap_block_cache_t *cache,
+              avs_net_abstract_socket_t *socket,
+              const coap_block_cache_key_t *key) {
+    AVS_LIST(cache_item_t) *item_ptr;
+    AVS_LIST_FOREACH_PTR(item_ptr, &cache->items) {
+        if ((*item_ptr)->socket == socket
+                && keys_equal((*item_ptr)->key, key)) {
+            return item_ptr;
+        }
+    }
+    return NULL;
+}
+
+const coap_block_cache_entry_t *
+_anjay_coap_block_cache_find(coap_block_cache_t *cache,
+                             avs_net_abstract_socket_t *socket,
+                             const coap_block_cache_key_t *key) {
+    drop_expired(cache);
+    AVS_LIST(cache_item_t) *item_ptr = find_item_ptr(cache, socket, key);
+    return item_ptr ? &(*item_ptr)->entry : NULL;
+}
+
+const coap_block_cache_entry_t *
+_anjay_coap_block_cache_put(coap_block_cache_t *cache,
+                            avs_net_abstract_socket_t *socket,
+                            coap_block_cache_key_t **key_ptr,
+                            uint8_t **payload_ptr,
+                            const coap_block_cache_entry_t *entry_template,
+                            avs_time_duration_t lifetime) {
+    size_t size = (*key_ptr)->size + entry_template->payload_size;
+    if (size > cache->max_size) {
+        coap_log(DEBUG, "block cache: response of %lu B does not fit",
+                 (unsigned long) entry_template->payload_size);
+        return NULL;
+    }
+
+    AVS_LIST(cache_item_t) item = AVS_LIST_NEW_ELEMENT(cache_item_t);
+    if (!item) {
+        coap_log(ERROR, "out of memory");
+        return NULL;
+    }
+
+    drop_expired(cache);
+    AVS_LIST(cache_item_t) *old_item_ptr =
+            find_item_ptr(cache, socket, *key_ptr);
+    if (old_item_ptr) {
+        delete_item(cache, old_item_ptr);
+    }
+    while (cache->size + size > cache->max_size) {
+        assert(cache->items);
+        coap_log(TRACE, "block cache: dropping oldest entry");
+        delete_item(cache, &cache->items);
+    }
+
+    item->socket = socket;
+    item->expire_time =
+            avs_time_monotonic_add(_anjay_clock_monotonic_now(cache->clock),
+                                   lifetime);
+    item->key = *key_ptr;
+    item->payload = *payload_ptr;
+    item->entry = *entry_template;
+    item->entry.payload = item->payload;
+
+    *key_ptr = NULL;
+    *payload_ptr = NULL;
+    cache->size += size;
+    AVS_LIST_APPEND(&cache->items, item);
+    return &item->entry;
+}
+
+void _anjay_coap_block_cache_forget_socket(coap_block_cache_t *cache,
+                                           avs_net_abstract_socket_t *socket) {
+    AVS_LIST(cache_item_t) *item_ptr;
+    AVS_LIST(cache_item_t) helper;
+    AVS_LIST_DELETABLE_FOREACH_PTR(item_ptr, helper, &cache->items) {
+        if ((*item_ptr)->socket == socket) {
+            delete_item(cache, item_ptr);
+        }
+    }
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_COAP_BLOCK_CACHE_H
+#define ANJAY_COAP_BLOCK_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <avsystem/commons/coap/msg.h>
+#include <avsystem/commons/list.h>
+#include <avsystem/commons/net.h>
+#include <avsystem/commons/time.h>
+
+#include "../../clock.h"
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+#ifdef WITH_BLOCK_SEND
+
+#define ANJAY_COAP_BLOCK_CACHE_ETAG_SIZE 4
+
+/**
+ * Identifies a request whose response may be cached: all critical options
+ * of the request (Uri-Path, Uri-Query, Accept, ...) except for Block2, in
+ * the order they appear in the message.
+ */
+typedef struct {
+    size_t size;
+    uint8_t data[];
+} coap_block_cache_key_t;
+
+typedef struct {
+    uint8_t code;
+    uint16_t format;
+    uint8_t etag[ANJAY_COAP_BLOCK_CACHE_ETAG_SIZE];
+    // largest block size that fits in a single outgoing message
+    uint16_t max_block_size;
+    size_t payload_size;
+    const uint8_t *payload;
+} coap_block_cache_entry_t;
+
+typedef struct coap_block_cache coap_block_cache_t;
+
+/**
+ * Creates a cache of full response payloads, used to serve Block2 requests
+ * without generating the response again.
+ *
+ * @param max_size Limit on the total size of cached keys and payloads.
+ * @param clock    Clock used to expire entries; system clock if NULL. Must
+ *                 outlive the cache.
+ *
+ * @returns Created cache on success, NULL on failure.
+ */
+coap_block_cache_t *_anjay_coap_block_cache_new(size_t max_size,
+                                                const anjay_clock_t *clock);
+
+void _anjay_coap_block_cache_delete(coap_block_cache_t **cache_ptr);
+
+size_t _anjay_coap_block_cache_max_size(const coap_block_cache_t *cache);
+
+/**
+ * @returns Key identifying @p request, allocated using malloc(), or NULL if
+ *          out of memory.
+ */
+coap_block_cache_key_t *
+_anjay_coap_block_cache_key_new(const avs_coap_msg_t *request);
+
+/**
+ * Looks up a non-expired response to the request identified by @p key,
+ * received on @p socket. Expired entries are dropped.
+ *
+ * @returns Cached entry or NULL if there is none. The entry is valid until
+ *          the next call to any other function operating on @p cache.
+ */
+const coap_block_cache_entry_t *
+_anjay_coap_block_cache_find(coap_block_cache_t *cache,
+                             avs_net_abstract_socket_t *socket,
+                             const coap_block_cache_key_t *key);
+
+/**
+ * Stores a response payload, dropping the oldest entries if necessary and
+ * replacing the previous response to the same request, if any.
+ *
+ * @param cache          Cache to operate on.
+ * @param socket         Socket on which the request was received.
+ * @param key_ptr        Key identifying the request. Ownership is taken over
+ *                       on success.
+ * @param payload_ptr    Payload allocated using malloc(). Ownership is taken
+ *                       over on success.
+ * @param entry_template Response details to store, including the ETag
+ *                       generated for it. The payload pointer is ignored.
+ * @param lifetime       Time after which the entry expires.
+ *
+ * @returns Stored entry, valid until the next call to any other function
+ *          operating on @p cache, or NULL if the entry could not be stored.
+ */
+const coap_block_cache_entry_t *
+_anjay_coap_block_cache_put(coap_block_cache_t *cache,
+                            avs_net_abstract_socket_t *socket,
+                            coap_block_cache_key_t **key_ptr,
+                            uint8_t **payload_ptr,
+                            const coap_block_cache_entry_t *entry_template,
+                            avs_time_duration_t lifetime);
+
+/**
+ * Drops all entries stored for @p socket. Must be called before the socket is
+ * freed, as another one might then be allocated at the same address.
+ */
+void _anjay_coap_block_cache_forget_socket(coap_block_cache_t *cache,
+                                           avs_net_abstract_socket_t *socket);
+
+#endif // WITH_BLOCK_SEND
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif // ANJAY_COAP_BLOCK_CACHE_H
@@ -21,6 +21,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "../stream/out.h"
+
 VISIBILITY_PRIVATE_HEADER_BEGIN
 
 #ifdef WITH_BLOCK_SEND
@@ -35,6 +37,14 @@ int _anjay_coap_block_transfer_write(coap_block_transfer_ctx_t *ctx,
 
 int _anjay_coap_block_transfer_finish(coap_block_transfer_ctx_t *ctx);
 
+/**
+ * @returns Largest block size, not greater than @p original_block_size, for
+ *          which a block message with headers described by <c>out->info</c>
+ *          fits in @p out, or 0 if even the smallest block does not fit.
+ */
+uint16_t _anjay_coap_block_calculate_size(uint16_t original_block_size,
+                                          const coap_output_buffer_t *out);
+
 #else
 
 #define _anjay_coap_block_transfer_delete(ctx) ((void) 0)
@@ -20,7 +20,9 @@
 #include <avsystem/commons/stream.h>
 #include <avsystem/commons/coap/ctx.h>
 #include <avsystem/commons/coap/msg_builder.h>
+#include <avsystem/commons/net.h>
 
+#include "../clock.h"
 #include "../utils_core.h"
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
@@ -34,6 +36,32 @@ int _anjay_coap_stream_create(avs_stream_abstract_t **stream_,
                               uint8_t *out_buffer,
                               size_t out_buffer_size);
 
+/**
+ * Enables caching of successful responses to GET requests that do not fit in
+ * a single message. Such responses are generated in full, stored under
+ * a generated ETag and sent block by block, each block on a separate request.
+ * Any block may then be requested again, in any order, until
+ * EXCHANGE_LIFETIME passes.
+ *
+ * @param stream   CoAP stream to operate on.
+ * @param max_size Limit on the total size of cached responses, in bytes.
+ *                 Responses larger than that are sent without caching.
+ * @param clock    Clock used to expire cached responses; system clock if
+ *                 NULL. Must outlive @p stream .
+ *
+ * @returns 0 on success, a negative value in case of error.
+ */
+int _anjay_coap_stream_enable_block_cache(avs_stream_abstract_t *stream,
+                                          size_t max_size,
+                                          const anjay_clock_t *clock);
+
+/**
+ * Drops any responses cached for requests received on @p socket. Must be
+ * called before @p socket is freed.
+ */
+void _anjay_coap_stream_forget_socket(avs_stream_abstract_t *stream,
+                                      avs_net_abstract_socket_t *socket);
+
 typedef enum {
     ANJAY_COAP_OBSERVE_NONE,
     ANJAY_COAP_OBSERVE_REGISTER,
@@ -79,6 +107,26 @@ int _anjay_coap_stream_setup_request(
 int _anjay_coap_stream_set_error(avs_stream_abstract_t *stream,
                                  uint8_t code);
 
+/**
+ * Builds the request prepared using @ref _anjay_coap_stream_setup_request and
+ * the data written so far, but instead of sending it, returns its copy in
+ * @p out_msg, so that it can be sent without blocking on the response. The
+ * copy is allocated using malloc() and shall be freed by the caller.
+ *
+ * @returns @li 0 on success,
+ *          @li a positive value if the payload did not fit in a single message
+ *              and is being sent block-wise - such requests cannot be
+ *              detached; the stream is left intact, so the request may still
+ *              be finished synchronously using avs_stream_finish_message(),
+ *          @li a negative value in case of error.
+ *          The stream is reset afterwards, unless a positive value is
+ *          returned.
+ */
+int _anjay_coap_stream_detach_request(avs_stream_abstract_t *stream,
+                                      avs_coap_msg_t **out_msg);
+
+bool _anjay_is_coap_stream(avs_stream_abstract_t *stream);
+
 /** NOTE: Pointer acquired with this function is only valid until receiving next
  * CoAP packet. Note that this might mean invalidation during the same stream
  * exchange if block transfer is in progress. */
@@ -25,6 +25,8 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
 /** Auxiliary constants for common Content-Format Option values */
 
 #define ANJAY_COAP_FORMAT_APPLICATION_LINK 40
+#define ANJAY_COAP_FORMAT_SENML_JSON 110
+#define ANJAY_COAP_FORMAT_SENML_CBOR 112
 
 #define ANJAY_COAP_FORMAT_PLAINTEXT 0
 #define ANJAY_COAP_FORMAT_OPAQUE 42
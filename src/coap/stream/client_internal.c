@@ -30,6 +30,8 @@
 #include "common.h"
 
 #include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
 
 VISIBILITY_SOURCE_BEGIN
 
@@ -360,6 +362,27 @@ int _anjay_coap_client_finish_request(coap_client_t *client) {
     }
 }
 
+int _anjay_coap_client_detach_request(coap_client_t *client,
+                                      avs_coap_msg_t **out_msg) {
+    if (client->state != COAP_CLIENT_STATE_HAS_REQUEST_HEADER) {
+        coap_log(TRACE, "unexpected client state: %d", client->state);
+        return -1;
+    }
+    if (has_block_ctx(client)) {
+        coap_log(DEBUG, "block-wise requests cannot be detached");
+        return 1;
+    }
+
+    const avs_coap_msg_t *msg = _anjay_coap_out_build_msg(&client->common.out);
+    const size_t msg_size = offsetof(avs_coap_msg_t, content) + msg->length;
+    if (!(*out_msg = (avs_coap_msg_t *) malloc(msg_size))) {
+        coap_log(ERROR, "out of memory");
+        return -1;
+    }
+    memcpy(*out_msg, msg, msg_size);
+    return 0;
+}
+
 int _anjay_coap_client_read(coap_client_t *client,
                             size_t *out_bytes_read,
                             char *out_message_finished,
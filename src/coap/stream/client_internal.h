@@ -115,6 +115,19 @@ int _anjay_coap_client_get_or_receive_msg(coap_client_t *client,
  */
 int _anjay_coap_client_finish_request(coap_client_t *client);
 
+/**
+ * Builds the prepared request and stores its heap-allocated copy in
+ * @p out_msg instead of sending it.
+ *
+ * @returns @li 0 on success,
+ *          @li a positive value if the request is a block-wise one - the
+ *              client state is not modified in that case,
+ *          @li a negative value if the client has no prepared request, or out
+ *              of memory.
+ */
+int _anjay_coap_client_detach_request(coap_client_t *client,
+                                      avs_coap_msg_t **out_msg);
+
 int _anjay_coap_client_read(coap_client_t *client,
                             size_t *out_bytes_read,
                             char *out_message_finished,
@@ -19,6 +19,7 @@
 
 #include <avsystem/commons/coap/msg_builder.h>
 
+#include "../block/cache.h"
 #include "../coap_stream.h"
 #include "in.h"
 #include "out.h"
@@ -35,6 +36,11 @@ typedef struct coap_stream_common {
 
     coap_input_buffer_t in;
     coap_output_buffer_t out;
+
+#ifdef WITH_BLOCK_SEND
+    // NULL unless enabled using _anjay_coap_stream_enable_block_cache()
+    coap_block_cache_t *block_cache;
+#endif // WITH_BLOCK_SEND
 } coap_stream_common_t;
 
 int _anjay_coap_common_fill_msg_info(avs_coap_msg_info_t *info,
@@ -36,8 +36,10 @@ VISIBILITY_SOURCE_BEGIN
 
 #ifdef WITH_BLOCK_SEND
 #define has_block_ctx(server) ((server)->block_ctx)
+#define has_cache_key(server) ((server)->cache_key)
 #else
 #define has_block_ctx(server) (false)
+#define has_cache_key(server) (false)
 #endif
 
 static inline bool has_error(coap_server_t *server) {
@@ -52,6 +54,16 @@ static bool is_server_reset(const coap_server_t *server) {
     return server->state == COAP_SERVER_STATE_RESET;
 }
 
+#ifdef WITH_BLOCK_SEND
+static void drop_cached_payload(coap_server_t *server) {
+    server->caching_response = false;
+    free(server->cache_payload);
+    server->cache_payload = NULL;
+    server->cache_payload_size = 0;
+    server->cache_payload_capacity = 0;
+}
+#endif // WITH_BLOCK_SEND
+
 void _anjay_coap_server_reset(coap_server_t *server) {
     server->state = COAP_SERVER_STATE_RESET;
     AVS_LIST_CLEAR(&server->expected_block_opts);
@@ -60,6 +72,9 @@ void _anjay_coap_server_reset(coap_server_t *server) {
 #ifdef WITH_BLOCK_SEND
     memset(&server->block_relation_validator, 0,
            sizeof(server->block_relation_validator));
+    free(server->cache_key);
+    server->cache_key = NULL;
+    drop_cached_payload(server);
 #endif // WITH_BLOCK_SEND
 }
 
@@ -113,6 +128,14 @@ int _anjay_coap_server_setup_response(coap_server_t *server,
         block = &server->curr_block;
     }
 
+#ifdef WITH_BLOCK_SEND
+    drop_cached_payload(server);
+    if (server->cache_key && details->msg_code == AVS_COAP_CODE_CONTENT) {
+        server->caching_response = true;
+        server->cached_response_format = details->format;
+    }
+#endif // WITH_BLOCK_SEND
+
     _anjay_coap_out_setup_mtu(&server->common.out, server->common.socket);
     return _anjay_coap_out_setup_msg(&server->common.out,
                                      &server->request_identity, details, block);
@@ -146,11 +169,21 @@ static void setup_error_response(coap_server_t *server) {
     (void)result;
 }
 
+#ifdef WITH_BLOCK_SEND
+static int finish_cached_response(coap_server_t *server);
+#endif // WITH_BLOCK_SEND
+
 int _anjay_coap_server_finish_response(coap_server_t *server) {
     if (has_error(server)) {
         setup_error_response(server);
     }
 
+#ifdef WITH_BLOCK_SEND
+    if (server->caching_response) {
+        return finish_cached_response(server);
+    }
+#endif // WITH_BLOCK_SEND
+
     if (has_block_ctx(server)) {
         int result = _anjay_coap_block_transfer_finish(server->block_ctx);
         server->request_identity =
@@ -223,20 +256,124 @@ typedef enum process_result {
     /** Not a valid request message. last_error_code may be set to enforce a
      * particular response code. */
     PROCESS_INITIAL_INVALID_REQUEST,
+
+    /** The request has already been responded to, using a cached response */
+    PROCESS_INITIAL_HANDLED,
 } process_result_t;
 
+#ifdef WITH_BLOCK_SEND
+/**
+ * Sends a single block of a cached response. @p info shall be filled with all
+ * the response headers, except for Block2, which is added by this function.
+ */
+static int send_cached_block(coap_server_t *server,
+                             avs_coap_msg_info_t *info,
+                             const coap_block_cache_entry_t *entry,
+                             const avs_coap_block_info_t *requested_block) {
+    avs_coap_block_info_t block = *requested_block;
+    if (block.size > entry->max_block_size) {
+        // send the block containing the requested offset, as large as the
+        // output buffer allows
+        block.seq_num = get_block_offset(&block) / entry->max_block_size;
+        block.size = entry->max_block_size;
+    }
+
+    size_t offset = get_block_offset(&block);
+    if (offset >= entry->payload_size) {
+        coap_log(DEBUG, "block %" PRIu32 " out of range", block.seq_num);
+        _anjay_coap_server_set_error(server, -ANJAY_ERR_BAD_OPTION);
+        return -1;
+    }
+    size_t length = AVS_MIN(block.size, entry->payload_size - offset);
+    block.has_more = (offset + length < entry->payload_size);
+
+    avs_coap_msg_info_opt_remove_by_number(info, AVS_COAP_OPT_BLOCK2);
+    if (avs_coap_msg_info_opt_block(info, &block)) {
+        return -1;
+    }
+
+    size_t storage_size =
+            avs_coap_msg_info_get_packet_storage_size(info, length);
+    void *storage = malloc(storage_size);
+    if (!storage) {
+        coap_log(ERROR, "out of memory");
+        return -1;
+    }
+
+    avs_coap_msg_builder_t builder;
+    int result = avs_coap_msg_builder_init(
+            &builder, avs_coap_ensure_aligned_buffer(storage), storage_size,
+            info);
+    if (!result) {
+        size_t written = avs_coap_msg_builder_payload(
+                &builder, entry->payload + offset, length);
+        assert(written == length);
+        (void) written;
+
+        coap_log(TRACE, "sending cached block %" PRIu32 " (size %" PRIu16
+                 "), has_more=%d", block.seq_num, block.size,
+                 (int) block.has_more);
+        result = avs_coap_ctx_send(server->common.coap_ctx,
+                                   server->common.socket,
+                                   avs_coap_msg_builder_get_msg(&builder));
+    }
+    free(storage);
+    return result;
+}
+
+static int add_etag_option(avs_coap_msg_info_t *info,
+                           const coap_block_cache_entry_t *entry) {
+    return avs_coap_msg_info_opt_opaque(info, AVS_COAP_OPT_ETAG, entry->etag,
+                                        sizeof(entry->etag));
+}
+
+static process_result_t serve_cached_block(coap_server_t *server,
+                                           const avs_coap_msg_t *msg) {
+    const coap_block_cache_entry_t *entry =
+            _anjay_coap_block_cache_find(server->common.block_cache,
+                                         server->common.socket,
+                                         server->cache_key);
+    if (!entry) {
+        coap_log(DEBUG, "response not cached, generating it again");
+        return PROCESS_INITIAL_OK;
+    }
+
+    const anjay_msg_details_t details = {
+        .msg_type = avs_coap_msg_get_type(msg) == AVS_COAP_MSG_CONFIRMABLE
+                ? AVS_COAP_MSG_ACKNOWLEDGEMENT
+                : AVS_COAP_MSG_NON_CONFIRMABLE,
+        .msg_code = entry->code,
+        .format = entry->format
+    };
+    avs_coap_msg_info_t info = avs_coap_msg_info_init();
+    int result = -1;
+    if (!_anjay_coap_common_fill_msg_info(&info, &details,
+                                          &server->request_identity, NULL)
+            && !add_etag_option(&info, entry)) {
+        result = send_cached_block(server, &info, entry, &server->curr_block);
+    }
+    avs_coap_msg_info_reset(&info);
+
+    if (result && has_error(server)) {
+        return PROCESS_INITIAL_INVALID_REQUEST;
+    } else if (result) {
+        coap_log(ERROR, "could not send cached block");
+    }
+    return PROCESS_INITIAL_HANDLED;
+}
+#endif // WITH_BLOCK_SEND
+
 static process_result_t process_initial_request(coap_server_t *server,
                                                 const avs_coap_msg_t *msg) {
     assert(is_server_reset(server));
 
-    avs_coap_msg_type_t type = avs_coap_msg_get_type(msg);
-    if (!avs_coap_msg_is_request(msg)
-            // incoming Reset may still require some kind of reaction,
-            // so it should be handled by upper layers
-            && type != AVS_COAP_MSG_RESET) {
-        coap_log(DEBUG, "invalid request: %s",
-                 AVS_COAP_CODE_STRING(avs_coap_msg_get_code(msg)));
-        return PROCESS_INITIAL_INVALID_REQUEST;
+    if (!avs_coap_msg_is_request(msg)) {
+        // incoming Reset, Acknowledgement or Separate Response may still
+        // require some kind of reaction (e.g. it may finish an outstanding
+        // Confirmable exchange), so it should be handled by upper layers
+        server->state = COAP_SERVER_STATE_HAS_REQUEST;
+        server->request_identity = avs_coap_msg_get_identity(msg);
+        return PROCESS_INITIAL_OK;
     }
 
     avs_coap_block_info_t block1;
@@ -257,6 +394,14 @@ static process_result_t process_initial_request(coap_server_t *server,
     }
     server->state = COAP_SERVER_STATE_HAS_REQUEST;
 
+#ifdef WITH_BLOCK_SEND
+    if (server->common.block_cache && !block1.valid
+            && avs_coap_msg_get_code(msg) == AVS_COAP_CODE_GET) {
+        // if the key cannot be allocated, the response is just not cached
+        server->cache_key = _anjay_coap_block_cache_key_new(msg);
+    }
+#endif // WITH_BLOCK_SEND
+
     if (block1.valid) {
         server->curr_block = block1;
         server->state = COAP_SERVER_STATE_HAS_BLOCK1_REQUEST;
@@ -270,7 +415,9 @@ static process_result_t process_initial_request(coap_server_t *server,
                  get_block_offset(&server->curr_block),
                  server->curr_block.size);
 
-        if (server->curr_block.seq_num != 0) {
+        // with the response cache enabled, any block of a response may be
+        // requested; it is served from the cache or generated again
+        if (server->curr_block.seq_num != 0 && !has_cache_key(server)) {
             coap_log(ERROR, "initial block seq_num nonzero");
             _anjay_coap_server_set_error(server,
                                          -ANJAY_ERR_REQUEST_ENTITY_INCOMPLETE);
@@ -285,6 +432,12 @@ static process_result_t process_initial_request(coap_server_t *server,
     }
     server->request_identity = avs_coap_msg_get_identity(msg);
 
+#ifdef WITH_BLOCK_SEND
+    if (block2.valid && block2.seq_num != 0 && server->cache_key) {
+        return serve_cached_block(server, msg);
+    }
+#endif // WITH_BLOCK_SEND
+
     assert(!is_server_reset(server));
     return PROCESS_INITIAL_OK;
 }
@@ -327,6 +480,10 @@ static int receive_request(coap_server_t *server) {
         return -1;
     case PROCESS_INITIAL_OK:
         return 0;
+    case PROCESS_INITIAL_HANDLED:
+        // the request needs no further handling, just like a duplicate
+        // answered from the message cache
+        return AVS_COAP_CTX_ERR_DUPLICATE;
     }
 
     assert(0 && "invalid enum value");
@@ -658,6 +815,12 @@ static int block_write(coap_server_t *server,
                        const void *data,
                        size_t data_length) {
     if (!server->block_ctx) {
+        if (server->curr_block.valid && server->curr_block.seq_num != 0) {
+            coap_log(ERROR, "cannot start block-wise response at block %"
+                     PRIu32 " without caching it", server->curr_block.seq_num);
+            return -1;
+        }
+
         uint16_t block_size = server->curr_block.valid
                 ? server->curr_block.size
                 : AVS_COAP_MSG_BLOCK_MAX_SIZE;
@@ -697,9 +860,9 @@ static bool block_response_requested(coap_server_t *server) {
                && server->curr_block.type == AVS_COAP_BLOCK2;
 }
 
-int _anjay_coap_server_write(coap_server_t *server,
-                             const void *data,
-                             size_t data_length) {
+static int write_uncached(coap_server_t *server,
+                          const void *data,
+                          size_t data_length) {
     size_t bytes_written = 0;
     if (!has_block_ctx(server) && !block_response_requested(server)) {
         bytes_written = _anjay_coap_out_write(&server->common.out,
@@ -715,3 +878,138 @@ int _anjay_coap_server_write(coap_server_t *server,
     return block_write(server, (const uint8_t*) data + bytes_written,
                        data_length - bytes_written);
 }
+
+#ifdef WITH_BLOCK_SEND
+/**
+ * Stops collecting the response in the cache buffer and passes the data
+ * collected so far to the regular, streaming write path.
+ */
+static int flush_cached_payload(coap_server_t *server) {
+    uint8_t *payload = server->cache_payload;
+    size_t payload_size = server->cache_payload_size;
+    server->cache_payload = NULL;
+    drop_cached_payload(server);
+
+    int result = write_uncached(server, payload, payload_size);
+    free(payload);
+    return result;
+}
+
+static int cache_write(coap_server_t *server,
+                       const void *data,
+                       size_t data_length) {
+    size_t max_size =
+            _anjay_coap_block_cache_max_size(server->common.block_cache);
+    size_t new_size = server->cache_payload_size + data_length;
+    if (new_size > max_size) {
+        coap_log(DEBUG, "response too large to be cached");
+        int result = flush_cached_payload(server);
+        return result ? result : write_uncached(server, data, data_length);
+    }
+
+    if (new_size > server->cache_payload_capacity) {
+        size_t new_capacity = AVS_MAX(2 * server->cache_payload_capacity,
+                                      new_size);
+        new_capacity = AVS_MIN(new_capacity, max_size);
+        uint8_t *new_payload =
+                (uint8_t *) realloc(server->cache_payload, new_capacity);
+        if (!new_payload) {
+            coap_log(DEBUG, "out of memory, not caching the response");
+            int result = flush_cached_payload(server);
+            return result ? result : write_uncached(server, data, data_length);
+        }
+        server->cache_payload = new_payload;
+        server->cache_payload_capacity = new_capacity;
+    }
+
+    memcpy(server->cache_payload + server->cache_payload_size, data,
+           data_length);
+    server->cache_payload_size = new_size;
+    return 0;
+}
+
+static int finish_cached_response(coap_server_t *server) {
+    coap_output_buffer_t *out = &server->common.out;
+    size_t bytes_written = 0;
+    if (!block_response_requested(server) || !server->cache_payload_size) {
+        bytes_written = _anjay_coap_out_write(out, server->cache_payload,
+                                              server->cache_payload_size);
+        if (bytes_written == server->cache_payload_size) {
+            // fits in a single message, there is no need to cache it
+            drop_cached_payload(server);
+            return avs_coap_ctx_send(server->common.coap_ctx,
+                                     server->common.socket,
+                                     _anjay_coap_out_build_msg(out));
+        }
+    }
+
+    coap_block_cache_entry_t entry_template = {
+        .code = AVS_COAP_CODE_CONTENT,
+        .format = server->cached_response_format,
+        .payload_size = server->cache_payload_size
+    };
+    uint32_t etag = _anjay_rand32(&server->common.in.rand_seed);
+    AVS_STATIC_ASSERT(sizeof(etag) == sizeof(entry_template.etag), etag_size);
+    memcpy(entry_template.etag, &etag, sizeof(etag));
+
+    if (add_etag_option(&out->info, &entry_template)) {
+        return -1;
+    }
+    entry_template.max_block_size =
+            _anjay_coap_block_calculate_size(AVS_COAP_MSG_BLOCK_MAX_SIZE, out);
+    if (!entry_template.max_block_size) {
+        return -1;
+    }
+
+    avs_coap_tx_params_t tx_params =
+            avs_coap_ctx_get_tx_params(server->common.coap_ctx);
+    const coap_block_cache_entry_t *entry = _anjay_coap_block_cache_put(
+            server->common.block_cache, server->common.socket,
+            &server->cache_key, &server->cache_payload, &entry_template,
+            avs_coap_exchange_lifetime(&tx_params));
+    if (!entry) {
+        // send the rest of the response in the usual way
+        avs_coap_msg_info_opt_remove_by_number(&out->info, AVS_COAP_OPT_ETAG);
+        uint8_t *payload = server->cache_payload;
+        server->cache_payload = NULL;
+        drop_cached_payload(server);
+        int result = block_write(server, payload + bytes_written,
+                                 entry_template.payload_size - bytes_written);
+        free(payload);
+        if (!result) {
+            result = _anjay_coap_server_finish_response(server);
+        }
+        return result;
+    }
+    drop_cached_payload(server);
+
+    avs_coap_block_info_t block = {
+        .type = AVS_COAP_BLOCK2,
+        .valid = true,
+        .seq_num = 0,
+        .size = entry->max_block_size
+    };
+    if (block_response_requested(server)) {
+        block = server->curr_block;
+    }
+    int result = send_cached_block(server, &out->info, entry, &block);
+    if (result && has_error(server)) {
+        setup_error_response(server);
+        result = avs_coap_ctx_send(server->common.coap_ctx,
+                                   server->common.socket,
+                                   _anjay_coap_out_build_msg(out));
+    }
+    return result;
+}
+#endif // WITH_BLOCK_SEND
+
+int _anjay_coap_server_write(coap_server_t *server,
+                             const void *data,
+                             size_t data_length) {
+#ifdef WITH_BLOCK_SEND
+    if (server->caching_response) {
+        return cache_write(server, data, data_length);
+    }
+#endif // WITH_BLOCK_SEND
+    return write_uncached(server, data, data_length);
+}
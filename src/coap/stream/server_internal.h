@@ -68,6 +68,16 @@ typedef struct coap_server {
 #ifdef WITH_BLOCK_SEND
     coap_block_transfer_ctx_t *block_ctx;
     anjay_coap_block_request_validator_ctx_t block_relation_validator;
+
+    // non-NULL if the response to the current request may be cached
+    coap_block_cache_key_t *cache_key;
+    // if set, the response payload is collected in cache_payload instead of
+    // being sent as it is written
+    bool caching_response;
+    uint16_t cached_response_format;
+    uint8_t *cache_payload;
+    size_t cache_payload_size;
+    size_t cache_payload_capacity;
 #endif
     coap_id_source_t *static_id_source;
 
@@ -266,6 +266,10 @@ static int coap_close(avs_stream_abstract_t *stream_) {
     stream->data.common.in.buffer = NULL;
     stream->data.common.out.buffer = NULL;
 
+#ifdef WITH_BLOCK_SEND
+    _anjay_coap_block_cache_delete(&stream->data.common.block_cache);
+#endif // WITH_BLOCK_SEND
+
     _anjay_coap_id_source_release(&stream->id_source);
 
     return 0;
@@ -324,6 +328,40 @@ int _anjay_coap_stream_create(avs_stream_abstract_t **stream_,
     return 0;
 }
 
+int _anjay_coap_stream_enable_block_cache(avs_stream_abstract_t *stream_,
+                                          size_t max_size,
+                                          const anjay_clock_t *clock) {
+    coap_stream_t *stream = (coap_stream_t *) stream_;
+    assert(stream->vtable == &COAP_STREAM_VTABLE);
+#ifdef WITH_BLOCK_SEND
+    assert(!stream->data.common.block_cache);
+    stream->data.common.block_cache =
+            _anjay_coap_block_cache_new(max_size, clock);
+    return stream->data.common.block_cache ? 0 : -1;
+#else // WITH_BLOCK_SEND
+    (void) stream;
+    (void) max_size;
+    (void) clock;
+    coap_log(ERROR, "caching block-wise responses not supported");
+    return -1;
+#endif // WITH_BLOCK_SEND
+}
+
+void _anjay_coap_stream_forget_socket(avs_stream_abstract_t *stream_,
+                                      avs_net_abstract_socket_t *socket) {
+    coap_stream_t *stream = (coap_stream_t *) stream_;
+    assert(stream->vtable == &COAP_STREAM_VTABLE);
+#ifdef WITH_BLOCK_SEND
+    if (stream->data.common.block_cache) {
+        _anjay_coap_block_cache_forget_socket(stream->data.common.block_cache,
+                                              socket);
+    }
+#else // WITH_BLOCK_SEND
+    (void) stream;
+    (void) socket;
+#endif // WITH_BLOCK_SEND
+}
+
 int _anjay_coap_stream_get_tx_params(
         avs_stream_abstract_t *stream_,
         avs_coap_tx_params_t *out_tx_params) {
@@ -405,6 +443,28 @@ int _anjay_coap_stream_set_error(avs_stream_abstract_t *stream_,
     return 0;
 }
 
+int _anjay_coap_stream_detach_request(avs_stream_abstract_t *stream_,
+                                      avs_coap_msg_t **out_msg) {
+    coap_stream_t *stream = (coap_stream_t*)stream_;
+    assert(stream->vtable == &COAP_STREAM_VTABLE);
+
+    int result = -1;
+    if (stream->state != STREAM_STATE_CLIENT) {
+        coap_log(ERROR, "detach_request called while not in CLIENT state");
+    } else {
+        result = _anjay_coap_client_detach_request(get_client(stream),
+                                                   out_msg);
+    }
+    if (result <= 0) {
+        reset(stream);
+    }
+    return result;
+}
+
+bool _anjay_is_coap_stream(avs_stream_abstract_t *stream) {
+    return stream && ((coap_stream_t *) stream)->vtable == &COAP_STREAM_VTABLE;
+}
+
 int _anjay_coap_stream_get_incoming_msg(avs_stream_abstract_t *stream_,
                                         const avs_coap_msg_t **out_msg) {
     coap_stream_t *stream = (coap_stream_t*)stream_;
@@ -21,6 +21,7 @@
 
 #include <anjay_test/coap/stream.h>
 #include <anjay_test/coap/socket.h>
+#include <anjay_test/mock_clock.h>
 
 #define ANJAY_COAP_STREAM_INTERNALS
 
@@ -32,6 +33,8 @@
 #include "../block/response.h"
 #include "../block/transfer_impl.h"
 
+#include "utils.h"
+
 typedef struct test_ctx {
     avs_net_abstract_socket_t *mocksock;
     avs_stream_abstract_t *stream;
@@ -195,3 +198,128 @@ AVS_UNIT_TEST(block_response, considers_buffer_size) {
                 4096),
             0);
 }
+
+#define CACHED_PAYLOAD \
+        "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do " \
+        "eiusmod tempor incididunt ut labore et dolore magna aliqua."
+
+typedef struct {
+    uint8_t size;
+    uint8_t value[ANJAY_COAP_BLOCK_CACHE_ETAG_SIZE];
+} test_etag_t;
+
+static const anjay_msg_details_t CACHED_RESPONSE_DETAILS = {
+    .msg_type = AVS_COAP_MSG_ACKNOWLEDGEMENT,
+    .msg_code = AVS_COAP_CODE_CONTENT,
+    .format = AVS_COAP_FORMAT_NONE
+};
+
+static void expect_cached_block(test_ctx_t *test,
+                                uint16_t msg_id,
+                                uint32_t seq_num,
+                                const test_etag_t *etag) {
+    const avs_coap_msg_t *res =
+            COAP_MSG(ACK, CONTENT, ID(msg_id),
+                     BLOCK2(seq_num, 32, CACHED_PAYLOAD),
+                     .etag = (const anjay_etag_t *) etag);
+    avs_unit_mocksock_expect_output(test->mocksock, &res->content,
+                                    res->length);
+}
+
+static int request_block(test_ctx_t *test,
+                         uint16_t msg_id,
+                         uint32_t seq_num) {
+    const avs_coap_msg_t *req = COAP_MSG(CON, GET, ID(msg_id),
+                                         BLOCK2(seq_num, 32),
+                                         PATH("1", "2", "3"));
+    avs_unit_mocksock_input(test->mocksock, &req->content, req->length);
+    const avs_coap_msg_t *msg;
+    return _anjay_coap_stream_get_incoming_msg(test->stream, &msg);
+}
+
+AVS_UNIT_TEST(block_response, cached_blocks_in_any_order) {
+    _anjay_mock_clock_start(avs_time_monotonic_from_scalar(1000, AVS_TIME_S));
+    test_ctx_t test = setup(4096, 4096);
+    avs_unit_mocksock_expect_connect(test.mocksock, "", "");
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_connect(test.mocksock, "", ""));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_coap_stream_enable_block_cache(test.stream, 4096,
+                                                  NULL));
+
+    // the ETag is generated using the seed set by the mock stream
+    anjay_rand_seed_t seed = 4;
+    uint32_t etag_value = _anjay_rand32(&seed);
+    test_etag_t etag = { .size = sizeof(etag_value) };
+    memcpy(etag.value, &etag_value, sizeof(etag_value));
+
+    // the response is generated once, and the first block is sent
+    AVS_UNIT_ASSERT_SUCCESS(request_block(&test, 1, 0));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_stream_setup_response(
+            test.stream, &CACHED_RESPONSE_DETAILS));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(test.stream, CACHED_PAYLOAD,
+                                             sizeof(CACHED_PAYLOAD) - 1));
+    expect_cached_block(&test, 1, 0, &etag);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_finish_message(test.stream));
+    avs_stream_reset(test.stream);
+
+    // subsequent blocks are served straight from the cache, in any order
+    expect_cached_block(&test, 2, 3, &etag);
+    AVS_UNIT_ASSERT_EQUAL(request_block(&test, 2, 3),
+                          AVS_COAP_CTX_ERR_DUPLICATE);
+    expect_cached_block(&test, 3, 1, &etag);
+    AVS_UNIT_ASSERT_EQUAL(request_block(&test, 3, 1),
+                          AVS_COAP_CTX_ERR_DUPLICATE);
+    expect_cached_block(&test, 4, 1, &etag);
+    AVS_UNIT_ASSERT_EQUAL(request_block(&test, 4, 1),
+                          AVS_COAP_CTX_ERR_DUPLICATE);
+
+    // block out of range
+    const avs_coap_msg_t *bad_option = COAP_MSG(ACK, BAD_OPTION, ID(5),
+                                                NO_PAYLOAD);
+    avs_unit_mocksock_expect_output(test.mocksock, &bad_option->content,
+                                    bad_option->length);
+    AVS_UNIT_ASSERT_FAILED(request_block(&test, 5, 4));
+
+    // after EXCHANGE_LIFETIME, the request is passed to the upper layer
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(248, AVS_TIME_S));
+    AVS_UNIT_ASSERT_SUCCESS(request_block(&test, 6, 2));
+    avs_stream_reset(test.stream);
+
+    avs_unit_mocksock_assert_io_clean(test.mocksock);
+    teardown(&test);
+    _anjay_mock_clock_finish();
+}
+
+AVS_UNIT_TEST(block_response, cache_dropped_with_socket) {
+    _anjay_mock_clock_start(avs_time_monotonic_from_scalar(1000, AVS_TIME_S));
+    test_ctx_t test = setup(4096, 4096);
+    avs_unit_mocksock_expect_connect(test.mocksock, "", "");
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_connect(test.mocksock, "", ""));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_coap_stream_enable_block_cache(test.stream, 4096,
+                                                  NULL));
+
+    anjay_rand_seed_t seed = 4;
+    uint32_t etag_value = _anjay_rand32(&seed);
+    test_etag_t etag = { .size = sizeof(etag_value) };
+    memcpy(etag.value, &etag_value, sizeof(etag_value));
+
+    AVS_UNIT_ASSERT_SUCCESS(request_block(&test, 1, 0));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_coap_stream_setup_response(
+            test.stream, &CACHED_RESPONSE_DETAILS));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(test.stream, CACHED_PAYLOAD,
+                                             sizeof(CACHED_PAYLOAD) - 1));
+    expect_cached_block(&test, 1, 0, &etag);
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_finish_message(test.stream));
+    avs_stream_reset(test.stream);
+
+    // a socket allocated later at the same address must not be served
+    // responses cached for the old one
+    _anjay_coap_stream_forget_socket(test.stream, test.mocksock);
+    AVS_UNIT_ASSERT_SUCCESS(request_block(&test, 2, 1));
+    avs_stream_reset(test.stream);
+
+    avs_unit_mocksock_assert_io_clean(test.mocksock);
+    teardown(&test);
+    _anjay_mock_clock_finish();
+}
@@ -0,0 +1,370 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include <avsystem/commons/coap/msg_identity.h>
+#include <avsystem/commons/coap/tx_params.h>
+
+#include "anjay_core.h"
+#include "coap_exchange.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+struct anjay_exchange {
+    anjay_exchange_id_t id;
+    anjay_ssid_t ssid;
+    anjay_connection_type_t conn_type;
+    avs_coap_msg_identity_t identity;
+
+    avs_coap_msg_t *msg;
+    anjay_server_stats_exchange_t stats_exchange;
+    avs_time_monotonic_t request_time;
+    avs_coap_retry_state_t retry_state;
+    // retransmission job, or Separate Response timeout job if separate is set
+    anjay_sched_handle_t retransmit_job;
+    // an empty ACK to the request has been received, retransmissions stopped
+    bool separate;
+
+    anjay_exchange_handler_t *handler;
+    void *handler_arg;
+};
+
+void _anjay_exchanges_init(anjay_t *anjay) {
+    anjay->exchanges = (anjay_exchanges_t) {
+        .rand_seed = (anjay_rand_seed_t)
+                _anjay_time_real_now(anjay).since_real_epoch.nanoseconds,
+        .next_id = 1,
+        .pending = NULL,
+        .num_retransmissions = 0
+    };
+}
+
+static void delete_exchange(anjay_t *anjay,
+                            AVS_LIST(anjay_exchange_t) *exchange_ptr) {
+    _anjay_sched_del(anjay->sched, &(*exchange_ptr)->retransmit_job);
+    free((*exchange_ptr)->msg);
+    AVS_LIST_DELETE(exchange_ptr);
+}
+
+void _anjay_exchanges_cleanup(anjay_t *anjay) {
+    while (anjay->exchanges.pending) {
+        delete_exchange(anjay, &anjay->exchanges.pending);
+    }
+}
+
+static AVS_LIST(anjay_exchange_t) *find_exchange_ptr(anjay_t *anjay,
+                                                     anjay_exchange_id_t id) {
+    AVS_LIST(anjay_exchange_t) *exchange_ptr;
+    AVS_LIST_FOREACH_PTR(exchange_ptr, &anjay->exchanges.pending) {
+        if ((*exchange_ptr)->id == id) {
+            return exchange_ptr;
+        }
+    }
+    return NULL;
+}
+
+static void finish_exchange(anjay_t *anjay,
+                            AVS_LIST(anjay_exchange_t) *exchange_ptr,
+                            anjay_exchange_result_t result,
+                            const avs_coap_msg_t *response) {
+    const anjay_exchange_id_t id = (*exchange_ptr)->id;
+    if (result == ANJAY_EXCHANGE_RESPONSE) {
+        _anjay_server_stats_record_latency(anjay, (*exchange_ptr)->ssid,
+                                           (*exchange_ptr)->stats_exchange,
+                                           (*exchange_ptr)->request_time);
+    }
+    anjay_exchange_handler_t *handler = (*exchange_ptr)->handler;
+    void *handler_arg = (*exchange_ptr)->handler_arg;
+    // the handler may start a new exchange, so remove this one first
+    delete_exchange(anjay, exchange_ptr);
+    handler(anjay, id, result, response, handler_arg);
+}
+
+static avs_net_abstract_socket_t *
+get_exchange_socket(anjay_t *anjay, const anjay_exchange_t *exchange) {
+    anjay_connection_ref_t ref = {
+        .server = _anjay_servers_find_active(&anjay->servers, exchange->ssid),
+        .conn_type = exchange->conn_type
+    };
+    if (!ref.server) {
+        return NULL;
+    }
+    return _anjay_connection_get_online_socket(
+            _anjay_get_server_connection(ref));
+}
+
+static int send_exchange_msg(anjay_t *anjay,
+                             const anjay_exchange_t *exchange,
+                             bool retransmission) {
+    avs_net_abstract_socket_t *socket = get_exchange_socket(anjay, exchange);
+    if (!socket) {
+        anjay_log(ERROR, "server connection is not online");
+        return -1;
+    }
+    // retransmissions are sent outside of any server stream
+    const anjay_ssid_t charged_ssid = _anjay_server_stats_charged_ssid(anjay);
+    _anjay_server_stats_charge_to(anjay, exchange->ssid);
+    _anjay_trace_begin(anjay, "net", "send", 0);
+    int result = avs_coap_ctx_send(anjay->coap_ctx, socket, exchange->msg);
+    _anjay_trace_end(anjay, "net", "send", 0);
+    if (!result && retransmission) {
+        // counted before switching back, so it is charged to exchange->ssid
+        ++anjay->exchanges.num_retransmissions;
+    }
+    _anjay_server_stats_charge_to(anjay, charged_ssid);
+    if (result) {
+        anjay_log(DEBUG, "could not send Confirmable message %" PRIu16 ": %d",
+                  exchange->identity.msg_id, result);
+    }
+    return result;
+}
+
+static int retransmit_job(anjay_t *anjay, void *id);
+
+static int schedule_retransmission(anjay_t *anjay,
+                                   anjay_exchange_t *exchange) {
+    avs_coap_update_retry_state(
+            &exchange->retry_state,
+            _anjay_tx_params_for_conn_type(anjay, exchange->conn_type),
+            &anjay->exchanges.rand_seed);
+    _anjay_sched_del(anjay->sched, &exchange->retransmit_job);
+    if (_anjay_sched(anjay->sched, &exchange->retransmit_job,
+                     exchange->retry_state.recv_timeout, retransmit_job,
+                     (void *) exchange->id)) {
+        anjay_log(ERROR,
+                  "could not schedule retransmission of message %" PRIu16,
+                  exchange->identity.msg_id);
+        return -1;
+    }
+    return 0;
+}
+
+static int retransmit_job(anjay_t *anjay, void *id_) {
+    anjay_exchange_id_t id = (anjay_exchange_id_t) id_;
+    AVS_LIST(anjay_exchange_t) *exchange_ptr = find_exchange_ptr(anjay, id);
+    if (!exchange_ptr) {
+        anjay_log(DEBUG, "exchange id = %" PRIuPTR " not found", id);
+        return 0;
+    }
+
+    anjay_exchange_t *exchange = *exchange_ptr;
+    if (exchange->separate) {
+        anjay_log(ERROR, "Separate Response to message %" PRIu16
+                  " not received", exchange->identity.msg_id);
+        finish_exchange(anjay, exchange_ptr, ANJAY_EXCHANGE_TIMEOUT, NULL);
+        return 0;
+    }
+
+    const avs_coap_tx_params_t *tx_params =
+            _anjay_tx_params_for_conn_type(anjay, exchange->conn_type);
+    if (exchange->retry_state.retry_count > tx_params->max_retransmit) {
+        anjay_log(ERROR,
+                  "Limit of retransmissions reached for message %" PRIu16,
+                  exchange->identity.msg_id);
+        finish_exchange(anjay, exchange_ptr, ANJAY_EXCHANGE_TIMEOUT, NULL);
+        return 0;
+    }
+
+    anjay_log(DEBUG, "retransmitting message %" PRIu16,
+              exchange->identity.msg_id);
+    // a failed retransmission is treated just like a lost packet, unless
+    // the connection is gone altogether
+    if ((send_exchange_msg(anjay, exchange, true)
+                    && !get_exchange_socket(anjay, exchange))
+            || schedule_retransmission(anjay, exchange)) {
+        finish_exchange(anjay, exchange_ptr, ANJAY_EXCHANGE_TIMEOUT, NULL);
+    }
+    return 0;
+}
+
+int _anjay_exchange_send_confirmable(anjay_t *anjay,
+                                     anjay_ssid_t ssid,
+                                     anjay_connection_type_t conn_type,
+                                     avs_coap_msg_t *msg,
+                                     anjay_server_stats_exchange_t
+                                             stats_exchange,
+                                     anjay_exchange_handler_t *handler,
+                                     void *handler_arg,
+                                     anjay_exchange_id_t *out_id) {
+    assert(msg);
+    assert(avs_coap_msg_get_type(msg) == AVS_COAP_MSG_CONFIRMABLE);
+    assert(handler);
+
+    AVS_LIST(anjay_exchange_t) exchange =
+            AVS_LIST_NEW_ELEMENT(anjay_exchange_t);
+    if (!exchange) {
+        anjay_log(ERROR, "Out of memory");
+        free(msg);
+        return -1;
+    }
+    exchange->id = anjay->exchanges.next_id++;
+    exchange->ssid = ssid;
+    exchange->conn_type = conn_type;
+    exchange->identity = avs_coap_msg_get_identity(msg);
+    exchange->msg = msg;
+    exchange->stats_exchange = stats_exchange;
+    exchange->request_time = _anjay_time_monotonic_now(anjay);
+    exchange->handler = handler;
+    exchange->handler_arg = handler_arg;
+
+    int result;
+    if ((result = send_exchange_msg(anjay, exchange, false))
+            || (result = schedule_retransmission(anjay, exchange))) {
+        delete_exchange(anjay, &exchange);
+        return result;
+    }
+
+    if (out_id) {
+        *out_id = exchange->id;
+    }
+    AVS_LIST_APPEND(&anjay->exchanges.pending, exchange);
+    return 0;
+}
+
+size_t _anjay_exchange_count_pending(anjay_t *anjay,
+                                     anjay_ssid_t ssid,
+                                     anjay_connection_type_t conn_type) {
+    size_t result = 0;
+    AVS_LIST(anjay_exchange_t) exchange;
+    AVS_LIST_FOREACH(exchange, anjay->exchanges.pending) {
+        if (exchange->ssid == ssid && exchange->conn_type == conn_type) {
+            ++result;
+        }
+    }
+    return result;
+}
+
+static bool is_request_exchange(const anjay_exchange_t *exchange) {
+    return avs_coap_msg_code_is_request(avs_coap_msg_get_code(exchange->msg));
+}
+
+static void
+wait_for_separate_response(anjay_t *anjay,
+                           AVS_LIST(anjay_exchange_t) *exchange_ptr) {
+    anjay_exchange_t *exchange = *exchange_ptr;
+    anjay_log(DEBUG, "empty ACK received for message %" PRIu16
+              ", waiting for Separate Response", exchange->identity.msg_id);
+    exchange->separate = true;
+    _anjay_sched_del(anjay->sched, &exchange->retransmit_job);
+    if (_anjay_sched(anjay->sched, &exchange->retransmit_job,
+                     AVS_COAP_SEPARATE_RESPONSE_TIMEOUT, retransmit_job,
+                     (void *) exchange->id)) {
+        anjay_log(ERROR, "could not schedule Separate Response timeout");
+        finish_exchange(anjay, exchange_ptr, ANJAY_EXCHANGE_TIMEOUT, NULL);
+    }
+}
+
+static int handle_ack_or_reset(anjay_t *anjay,
+                               AVS_LIST(anjay_exchange_t) *exchange_ptr,
+                               const avs_coap_msg_t *msg) {
+    anjay_exchange_t *exchange = *exchange_ptr;
+    const uint16_t msg_id = avs_coap_msg_get_id(msg);
+    const bool is_empty = (avs_coap_msg_get_code(msg) == AVS_COAP_CODE_EMPTY);
+    // empty ACK and Reset messages carry no token
+    if (exchange->separate
+            || exchange->identity.msg_id != msg_id
+            || (!is_empty
+                    && !avs_coap_msg_token_matches(msg, &exchange->identity))) {
+        return -1;
+    }
+
+    if (avs_coap_msg_get_type(msg) == AVS_COAP_MSG_RESET) {
+        anjay_log(DEBUG, "Reset received for message %" PRIu16, msg_id);
+        finish_exchange(anjay, exchange_ptr, ANJAY_EXCHANGE_RESET, msg);
+    } else if (is_empty && is_request_exchange(exchange)) {
+        wait_for_separate_response(anjay, exchange_ptr);
+    } else {
+        anjay_log(DEBUG, "Acknowledgement received for message %" PRIu16,
+                  msg_id);
+        finish_exchange(anjay, exchange_ptr, ANJAY_EXCHANGE_RESPONSE, msg);
+    }
+    return 0;
+}
+
+static int handle_separate_response(anjay_t *anjay,
+                                    AVS_LIST(anjay_exchange_t) *exchange_ptr,
+                                    const avs_coap_msg_t *msg) {
+    anjay_exchange_t *exchange = *exchange_ptr;
+    // the Separate ACK might have been lost, so the response is accepted
+    // even if the exchange is not marked as separate yet
+    if (!is_request_exchange(exchange)
+            || avs_coap_msg_get_code(msg) == AVS_COAP_CODE_EMPTY
+            || !avs_coap_msg_token_matches(msg, &exchange->identity)) {
+        return -1;
+    }
+
+    anjay_log(DEBUG, "Separate Response received for message %" PRIu16,
+              exchange->identity.msg_id);
+    if (avs_coap_msg_get_type(msg) == AVS_COAP_MSG_CONFIRMABLE) {
+        avs_net_abstract_socket_t *socket =
+                get_exchange_socket(anjay, exchange);
+        int result = -1;
+        if (socket) {
+            _anjay_trace_begin(anjay, "net", "send", 0);
+            result = avs_coap_ctx_send_empty(anjay->coap_ctx, socket,
+                                             AVS_COAP_MSG_ACKNOWLEDGEMENT,
+                                             avs_coap_msg_get_id(msg));
+            _anjay_trace_end(anjay, "net", "send", 0);
+        }
+        if (result) {
+            anjay_log(WARNING, "could not acknowledge Separate Response");
+        }
+    }
+    finish_exchange(anjay, exchange_ptr, ANJAY_EXCHANGE_RESPONSE, msg);
+    return 0;
+}
+
+int _anjay_exchange_handle_response(anjay_t *anjay,
+                                    anjay_ssid_t ssid,
+                                    anjay_connection_type_t conn_type,
+                                    const avs_coap_msg_t *msg) {
+    if (avs_coap_msg_is_request(msg)) {
+        return -1;
+    }
+
+    avs_coap_msg_type_t type = avs_coap_msg_get_type(msg);
+    const bool is_ack_or_reset = (type == AVS_COAP_MSG_ACKNOWLEDGEMENT
+                                  || type == AVS_COAP_MSG_RESET);
+    AVS_LIST(anjay_exchange_t) *exchange_ptr;
+    AVS_LIST_FOREACH_PTR(exchange_ptr, &anjay->exchanges.pending) {
+        if ((*exchange_ptr)->ssid != ssid
+                || (*exchange_ptr)->conn_type != conn_type) {
+            continue;
+        }
+        if (!(is_ack_or_reset
+                ? handle_ack_or_reset(anjay, exchange_ptr, msg)
+                : handle_separate_response(anjay, exchange_ptr, msg))) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void _anjay_exchange_cancel(anjay_t *anjay, anjay_exchange_id_t *id_ptr) {
+    if (*id_ptr == ANJAY_EXCHANGE_ID_INVALID) {
+        return;
+    }
+    AVS_LIST(anjay_exchange_t) *exchange_ptr =
+            find_exchange_ptr(anjay, *id_ptr);
+    if (exchange_ptr) {
+        delete_exchange(anjay, exchange_ptr);
+    }
+    *id_ptr = ANJAY_EXCHANGE_ID_INVALID;
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_COAP_EXCHANGE_H
+#define ANJAY_COAP_EXCHANGE_H
+
+#include <avsystem/commons/coap/msg.h>
+#include <avsystem/commons/list.h>
+
+#include <anjay_modules/servers.h>
+
+#include "server_stats.h"
+#include "utils_core.h"
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+typedef uintptr_t anjay_exchange_id_t;
+
+#define ANJAY_EXCHANGE_ID_INVALID ((anjay_exchange_id_t) 0)
+
+typedef struct anjay_exchange anjay_exchange_t;
+
+typedef struct {
+    anjay_rand_seed_t rand_seed;
+    anjay_exchange_id_t next_id;
+    AVS_LIST(anjay_exchange_t) pending;
+    /**
+     * Retransmissions sent by the exchange engine; avs_coap only counts the
+     * ones it performs itself.
+     */
+    uint64_t num_retransmissions;
+} anjay_exchanges_t;
+
+typedef enum {
+    /** A matching Acknowledgement or Separate Response has been received. */
+    ANJAY_EXCHANGE_RESPONSE,
+    /** A matching Reset has been received. */
+    ANJAY_EXCHANGE_RESET,
+    /** Retransmission limit has been reached, or the connection went away. */
+    ANJAY_EXCHANGE_TIMEOUT
+} anjay_exchange_result_t;
+
+/**
+ * Called exactly once when an exchange finishes, unless it is cancelled
+ * with @ref _anjay_exchange_cancel first.
+ *
+ * @param response Received message. Only valid for ANJAY_EXCHANGE_RESPONSE
+ *                 and ANJAY_EXCHANGE_RESET, NULL otherwise. The pointer is
+ *                 valid only until the handler returns.
+ */
+typedef void anjay_exchange_handler_t(anjay_t *anjay,
+                                      anjay_exchange_id_t id,
+                                      anjay_exchange_result_t result,
+                                      const avs_coap_msg_t *response,
+                                      void *arg);
+
+/**
+ * Initializes @c anjay->exchanges. Must be called after the clock has been
+ * set up, as the retransmission jitter seed is taken from it.
+ */
+void _anjay_exchanges_init(anjay_t *anjay);
+
+/**
+ * Cancels all pending exchanges without calling their handlers.
+ */
+void _anjay_exchanges_cleanup(anjay_t *anjay);
+
+/**
+ * Sends a Confirmable message over the @p conn_type connection to the server
+ * @p ssid and returns immediately. Retransmissions are driven by the scheduler,
+ * according to the transmission parameters of the connection. The response is
+ * matched by @ref _anjay_exchange_handle_response and passed to @p handler.
+ *
+ * Acknowledgements are matched by Message ID and, unless empty, by token. If
+ * @p msg is a request, an empty ACK only stops the retransmissions, and the
+ * exchange is finished by a Separate Response matched by token. Otherwise, an
+ * empty ACK finishes the exchange just as a piggybacked response does.
+ *
+ * @param msg            Message to send, allocated using malloc(). Ownership
+ *                       is taken over by this function regardless of the
+ *                       result.
+ * @param stats_exchange Kind of the exchange, used to record its round-trip
+ *                       time in the server statistics.
+ * @param out_id         Identifier of the created exchange, that may be passed
+ *                       to @ref _anjay_exchange_cancel. May be NULL.
+ *
+ * @returns 0 if the message was sent, a negative value in case of error - the
+ *          handler will not be called in that case.
+ */
+int _anjay_exchange_send_confirmable(anjay_t *anjay,
+                                     anjay_ssid_t ssid,
+                                     anjay_connection_type_t conn_type,
+                                     avs_coap_msg_t *msg,
+                                     anjay_server_stats_exchange_t
+                                             stats_exchange,
+                                     anjay_exchange_handler_t *handler,
+                                     void *handler_arg,
+                                     anjay_exchange_id_t *out_id);
+
+/**
+ * @returns Number of exchanges currently pending on the @p conn_type
+ *          connection to the server @p ssid. Used to enforce the NSTART limit.
+ */
+size_t _anjay_exchange_count_pending(anjay_t *anjay,
+                                     anjay_ssid_t ssid,
+                                     anjay_connection_type_t conn_type);
+
+/**
+ * Checks whether @p msg, received on the @p conn_type connection to the server
+ * @p ssid, is a response to one of the pending exchanges. If so, the exchange
+ * is updated or finished accordingly, and its handler called if appropriate.
+ * Confirmable Separate Responses are acknowledged.
+ *
+ * @returns 0 if the message has been consumed, a nonzero value if it shall be
+ *          handled as usual.
+ */
+int _anjay_exchange_handle_response(anjay_t *anjay,
+                                    anjay_ssid_t ssid,
+                                    anjay_connection_type_t conn_type,
+                                    const avs_coap_msg_t *msg);
+
+/**
+ * Removes a pending exchange without calling its handler. Does nothing if
+ * the exchange has already finished.
+ */
+void _anjay_exchange_cancel(anjay_t *anjay, anjay_exchange_id_t *id_ptr);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_COAP_EXCHANGE_H */
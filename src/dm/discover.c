@@ -16,7 +16,12 @@
 
 #include <config.h>
 
+#include <assert.h>
 #include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <avsystem/commons/stream/stream_membuf.h>
 
 #include <anjay_modules/time_defs.h>
 
@@ -184,6 +189,7 @@ typedef enum {
 } discover_resource_hint_t;
 
 static int discover_resource(anjay_t *anjay,
+                             avs_stream_abstract_t *stream,
                              const anjay_dm_object_def_t *const *obj,
                              anjay_iid_t iid,
                              anjay_rid_t rid,
@@ -220,14 +226,48 @@ static int discover_resource(anjay_t *anjay,
     if (result) {
         return result;
     }
-    return print_discovered_resource(anjay->comm_stream, obj, iid, rid,
-                                     resource_dim, &resource_attributes);
+    return print_discovered_resource(stream, obj, iid, rid, resource_dim,
+                                     &resource_attributes);
+}
+
+static int
+discover_instance_resources_bulk(anjay_t *anjay,
+                                 avs_stream_abstract_t *stream,
+                                 const anjay_dm_object_def_t *const *obj,
+                                 anjay_iid_t iid,
+                                 discover_resource_hint_t hint) {
+    const size_t count = (*obj)->supported_rids.count;
+    if (!count) {
+        return 0;
+    }
+    anjay_dm_resource_op_mask_t *masks = (anjay_dm_resource_op_mask_t *)
+            calloc(count, sizeof(anjay_dm_resource_op_mask_t));
+    if (!masks) {
+        anjay_log(ERROR, "out of memory");
+        return ANJAY_ERR_INTERNAL;
+    }
+    int result = _anjay_dm_instance_resources(anjay, obj, iid, masks, NULL);
+    for (size_t i = 0; !result && i < count; ++i) {
+        if (masks[i] & ANJAY_DM_RESOURCE_PRESENT) {
+            (void) ((result = print_separator(stream))
+                    || (result = discover_resource(
+                            anjay, stream, obj, iid,
+                            (*obj)->supported_rids.rids[i], hint)));
+        }
+    }
+    free(masks);
+    return result;
 }
 
 static int discover_instance_resources(anjay_t *anjay,
+                                       avs_stream_abstract_t *stream,
                                        const anjay_dm_object_def_t *const *obj,
                                        anjay_iid_t iid,
                                        discover_resource_hint_t hint) {
+    if (_anjay_dm_instance_resources_usable(anjay, obj)) {
+        return discover_instance_resources_bulk(anjay, stream, obj, iid,
+                                                hint);
+    }
     int result = 0;
     for (size_t i = 0; i < (*obj)->supported_rids.count; ++i) {
         result = _anjay_dm_resource_present(anjay, obj, iid,
@@ -236,9 +276,9 @@ static int discover_instance_resources(anjay_t *anjay,
         if (result <= 0) {
             continue;
         }
-        result = print_separator(anjay->comm_stream);
+        result = print_separator(stream);
         if (!result) {
-            result = discover_resource(anjay, obj, iid,
+            result = discover_resource(anjay, stream, obj, iid,
                                        (*obj)->supported_rids.rids[i], hint);
         }
     }
@@ -248,53 +288,247 @@ static int discover_instance_resources(anjay_t *anjay,
 static int discover_object_instance(anjay_t *anjay,
                                     const anjay_dm_object_def_t *const *obj,
                                     anjay_iid_t iid,
-                                    void *dummy) {
-    (void) dummy;
+                                    void *stream_) {
+    avs_stream_abstract_t *stream = (avs_stream_abstract_t *) stream_;
     int result = 0;
-    (void) ((result = print_separator(anjay->comm_stream))
+    (void) ((result = print_separator(stream))
             || (result = print_discovered_instance(
-                    anjay->comm_stream, obj, iid,
-                    &ANJAY_DM_INTERNAL_ATTRS_EMPTY))
-            || (result = discover_instance_resources(anjay, obj, iid,
+                    stream, obj, iid, &ANJAY_DM_INTERNAL_ATTRS_EMPTY))
+            || (result = discover_instance_resources(anjay, stream, obj, iid,
                                                      NO_ATTRIBS)));
     return result;
 }
 
 int _anjay_discover_object(anjay_t *anjay,
+                           avs_stream_abstract_t *stream,
                            const anjay_dm_object_def_t *const *obj) {
     anjay_dm_internal_attrs_t object_attributes;
     int result = 0;
     (void) ((result = read_object_level_attributes(anjay, obj,
                                                    &object_attributes))
-            || (result = print_discovered_object(anjay->comm_stream, obj,
+            || (result = print_discovered_object(stream, obj,
                                                  &object_attributes)));
     if (result) {
         return result;
     }
     return _anjay_dm_foreach_instance(anjay, obj, discover_object_instance,
-                                      NULL);
+                                      stream);
 }
 
 int _anjay_discover_instance(anjay_t *anjay,
+                             avs_stream_abstract_t *stream,
                              const anjay_dm_object_def_t *const *obj,
                              anjay_iid_t iid) {
     anjay_dm_internal_attrs_t instance_attributes;
     int result = 0;
     (void) ((result = read_instance_level_attributes(anjay, obj, iid,
                                                      &instance_attributes))
-            || (result = print_discovered_instance(anjay->comm_stream, obj, iid,
+            || (result = print_discovered_instance(stream, obj, iid,
                                                    &instance_attributes)));
     if (result) {
         return result;
     }
-    return discover_instance_resources(anjay, obj, iid, WITH_RESOURCE_ATTRIBS);
+    return discover_instance_resources(anjay, stream, obj, iid,
+                                       WITH_RESOURCE_ATTRIBS);
 }
 
 int _anjay_discover_resource(anjay_t *anjay,
+                             avs_stream_abstract_t *stream,
                              const anjay_dm_object_def_t *const *obj,
                              anjay_iid_t iid,
                              anjay_rid_t rid) {
-    return discover_resource(anjay, obj, iid, rid, WITH_INHERITED_ATTRIBS);
+    return discover_resource(anjay, stream, obj, iid, rid,
+                             WITH_INHERITED_ATTRIBS);
+}
+
+struct anjay_discover_cache_entry {
+    anjay_ssid_t ssid;
+    anjay_uri_path_t uri;
+    size_t payload_size;
+    char payload[];
+};
+
+static size_t entry_size(const anjay_discover_cache_entry_t *entry) {
+    return sizeof(*entry) + entry->payload_size;
+}
+
+void _anjay_discover_cache_init(anjay_discover_cache_t *cache,
+                                size_t max_size) {
+    *cache = (anjay_discover_cache_t) {
+        .max_size = max_size,
+        .size = 0,
+        .entries = NULL
+    };
+}
+
+static void
+delete_cache_entry(anjay_discover_cache_t *cache,
+                   AVS_LIST(anjay_discover_cache_entry_t) *entry_ptr) {
+    assert(cache->size >= entry_size(*entry_ptr));
+    cache->size -= entry_size(*entry_ptr);
+    AVS_LIST_DELETE(entry_ptr);
+}
+
+void _anjay_discover_cache_cleanup(anjay_discover_cache_t *cache) {
+    while (cache->entries) {
+        delete_cache_entry(cache, &cache->entries);
+    }
+}
+
+static bool paths_overlap(const anjay_uri_path_t *left,
+                          const anjay_uri_path_t *right) {
+    if (!left->has_oid || !right->has_oid) {
+        return true;
+    }
+    if (left->oid != right->oid) {
+        return false;
+    }
+    if (!left->has_iid || !right->has_iid) {
+        return true;
+    }
+    if (left->iid != right->iid) {
+        return false;
+    }
+    return !left->has_rid || !right->has_rid || left->rid == right->rid;
+}
+
+void _anjay_discover_cache_invalidate(anjay_t *anjay,
+                                      anjay_ssid_t ssid,
+                                      const anjay_uri_path_t *path) {
+    anjay_discover_cache_t *cache = &anjay->discover_cache;
+    AVS_LIST(anjay_discover_cache_entry_t) *entry_ptr;
+    AVS_LIST(anjay_discover_cache_entry_t) helper;
+    AVS_LIST_DELETABLE_FOREACH_PTR(entry_ptr, helper, &cache->entries) {
+        if ((ssid == ANJAY_SSID_ANY || (*entry_ptr)->ssid == ssid)
+                && paths_overlap(&(*entry_ptr)->uri, path)) {
+            delete_cache_entry(cache, entry_ptr);
+        }
+    }
+}
+
+static AVS_LIST(anjay_discover_cache_entry_t) *
+find_cache_entry_ptr(anjay_discover_cache_t *cache,
+                     anjay_ssid_t ssid,
+                     const anjay_uri_path_t *uri) {
+    AVS_LIST(anjay_discover_cache_entry_t) *entry_ptr;
+    AVS_LIST_FOREACH_PTR(entry_ptr, &cache->entries) {
+        if ((*entry_ptr)->ssid == ssid
+                && _anjay_uri_path_equal(&(*entry_ptr)->uri, uri)) {
+            return entry_ptr;
+        }
+    }
+    return NULL;
+}
+
+static void insert_cache_entry(anjay_discover_cache_t *cache,
+                               anjay_ssid_t ssid,
+                               const anjay_uri_path_t *uri,
+                               const char *payload,
+                               size_t payload_size) {
+    if (sizeof(anjay_discover_cache_entry_t) + payload_size
+            > cache->max_size) {
+        anjay_log(DEBUG, "Discover response too large to be cached");
+        return;
+    }
+    AVS_LIST(anjay_discover_cache_entry_t) entry =
+            (AVS_LIST(anjay_discover_cache_entry_t)) AVS_LIST_NEW_BUFFER(
+                    sizeof(anjay_discover_cache_entry_t) + payload_size);
+    if (!entry) {
+        anjay_log(WARNING, "out of memory, not caching Discover response");
+        return;
+    }
+    entry->ssid = ssid;
+    entry->uri = *uri;
+    entry->payload_size = payload_size;
+    memcpy(entry->payload, payload, payload_size);
+
+    // drop least recently used entries, i.e. ones at the end of the list
+    while (cache->size + entry_size(entry) > cache->max_size) {
+        assert(cache->entries);
+        AVS_LIST(anjay_discover_cache_entry_t) *last_ptr = &cache->entries;
+        while (AVS_LIST_NEXT(*last_ptr)) {
+            last_ptr = AVS_LIST_NEXT_PTR(last_ptr);
+        }
+        delete_cache_entry(cache, last_ptr);
+    }
+    cache->size += entry_size(entry);
+    AVS_LIST_INSERT(&cache->entries, entry);
+}
+
+static int read_whole_stream(avs_stream_abstract_t *stream,
+                             char **out_data,
+                             size_t *out_size) {
+    size_t capacity = 0;
+    char message_finished = 0;
+    *out_data = NULL;
+    *out_size = 0;
+    while (!message_finished) {
+        if (*out_size == capacity) {
+            capacity = capacity ? 2 * capacity : 256;
+            char *new_data = (char *) realloc(*out_data, capacity);
+            if (!new_data) {
+                anjay_log(ERROR, "out of memory");
+                goto error;
+            }
+            *out_data = new_data;
+        }
+        size_t bytes_read;
+        if (avs_stream_read(stream, &bytes_read, &message_finished,
+                            *out_data + *out_size, capacity - *out_size)) {
+            goto error;
+        }
+        *out_size += bytes_read;
+    }
+    return 0;
+error:
+    free(*out_data);
+    *out_data = NULL;
+    return -1;
+}
+
+int _anjay_discover_cached(anjay_t *anjay,
+                           const anjay_dm_object_def_t *const *obj,
+                           const anjay_uri_path_t *uri,
+                           anjay_discover_handler_t *handler) {
+    anjay_discover_cache_t *cache = &anjay->discover_cache;
+    if (!cache->max_size) {
+        return handler(anjay, anjay->comm_stream, obj, uri);
+    }
+
+    const anjay_ssid_t ssid = _anjay_dm_current_ssid(anjay);
+    AVS_LIST(anjay_discover_cache_entry_t) *entry_ptr =
+            find_cache_entry_ptr(cache, ssid, uri);
+    if (entry_ptr) {
+        anjay_log(TRACE, "using cached Discover response");
+        AVS_LIST(anjay_discover_cache_entry_t) entry =
+                AVS_LIST_DETACH(entry_ptr);
+        AVS_LIST_INSERT(&cache->entries, entry);
+        return avs_stream_write(anjay->comm_stream, entry->payload,
+                                entry->payload_size);
+    }
+
+    avs_stream_abstract_t *membuf = avs_stream_membuf_create();
+    if (!membuf) {
+        anjay_log(ERROR, "out of memory");
+        return ANJAY_ERR_INTERNAL;
+    }
+    char *payload = NULL;
+    size_t payload_size = 0;
+    int result = handler(anjay, membuf, obj, uri);
+    if (!result) {
+        if (read_whole_stream(membuf, &payload, &payload_size)) {
+            result = ANJAY_ERR_INTERNAL;
+        } else {
+            result = avs_stream_write(anjay->comm_stream, payload,
+                                      payload_size);
+        }
+    }
+    if (!result) {
+        insert_cache_entry(cache, ssid, uri, payload, payload_size);
+    }
+    free(payload);
+    avs_stream_cleanup(&membuf);
+    return result;
 }
 
 #ifdef WITH_BOOTSTRAP
@@ -18,12 +18,29 @@
 #define ANJAY_DM_DISCOVER_H
 
 #include <anjay/dm.h>
+#include <avsystem/commons/list.h>
 #include <avsystem/commons/stream_v_table.h>
 #include <avsystem/commons/stream.h>
 
+#include <anjay_modules/dm_utils.h>
+
 VISIBILITY_PRIVATE_HEADER_BEGIN
 
 #ifdef WITH_DISCOVER
+typedef struct anjay_discover_cache_entry anjay_discover_cache_entry_t;
+
+typedef struct {
+    size_t max_size;
+    size_t size;
+    // most recently used first
+    AVS_LIST(anjay_discover_cache_entry_t) entries;
+} anjay_discover_cache_t;
+
+void _anjay_discover_cache_init(anjay_discover_cache_t *cache,
+                                size_t max_size);
+
+void _anjay_discover_cache_cleanup(anjay_discover_cache_t *cache);
+
 /**
  * Performs LwM2M Discover operation on specified Object:
  *  - lists all attributes assigned to the Object (for specified Server)
@@ -31,10 +48,12 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
  *  - lists all present Resources for each Object Instance.
  *
  * @param anjay     ANJAY object to operate on.
+ * @param stream    Stream to write the response payload to.
  * @param obj       Object on which Discover shall be performed.
  * @return 0 on success, negative value in case of an error.
  */
 int _anjay_discover_object(anjay_t *anjay,
+                           avs_stream_abstract_t *stream,
                            const anjay_dm_object_def_t *const *obj);
 
 /**
@@ -44,11 +63,13 @@ int _anjay_discover_object(anjay_t *anjay,
  *    (these are not inherited from upper levels).
  *
  * @param anjay     ANJAY object to operate on.
+ * @param stream    Stream to write the response payload to.
  * @param obj       Object whose instance is being queried.
  * @param iid       Instance on which Discover shall be performed.
  * @return 0 on success, negative value in case of an error.
  */
 int _anjay_discover_instance(anjay_t *anjay,
+                             avs_stream_abstract_t *stream,
                              const anjay_dm_object_def_t *const *obj,
                              anjay_iid_t iid);
 
@@ -57,16 +78,43 @@ int _anjay_discover_instance(anjay_t *anjay,
  *  - lists all attributes assigned to this Resource
  *
  * @param anjay     ANJAY object to operate on.
+ * @param stream    Stream to write the response payload to.
  * @param obj       Object whose resource is being queried.
  * @param iid       Instance whose resource is being queried.
  * @param rid       Resource on which Discover shall be performed.
  * @return 0 on success, negative value in case of an error.
  */
 int _anjay_discover_resource(anjay_t *anjay,
+                             avs_stream_abstract_t *stream,
                              const anjay_dm_object_def_t *const *obj,
                              anjay_iid_t iid,
                              anjay_rid_t rid);
 
+typedef int anjay_discover_handler_t(anjay_t *anjay,
+                                     avs_stream_abstract_t *stream,
+                                     const anjay_dm_object_def_t *const *obj,
+                                     const anjay_uri_path_t *uri);
+
+/**
+ * Writes the Discover response payload for @p uri, as seen by the current
+ * server, to anjay->comm_stream.
+ *
+ * If the Discover cache is enabled, the payload is looked up in the cache
+ * first. Otherwise, it is generated by @p handler, and stored in the cache on
+ * success. Cached payloads stay valid until dropped by
+ * @ref _anjay_discover_cache_invalidate .
+ *
+ * @param anjay     ANJAY object to operate on.
+ * @param obj       Object on which Discover shall be performed.
+ * @param uri       Path on which Discover shall be performed.
+ * @param handler   Function that generates the payload into a given stream.
+ * @return 0 on success, negative value in case of an error.
+ */
+int _anjay_discover_cached(anjay_t *anjay,
+                           const anjay_dm_object_def_t *const *obj,
+                           const anjay_uri_path_t *uri,
+                           anjay_discover_handler_t *handler);
+
 #ifdef WITH_BOOTSTRAP
 /**
  * Performs LwM2M Bootstrap Discover operation on the specified Object @p obj.
@@ -92,13 +92,47 @@ bool _anjay_dm_handler_implemented(anjay_t *anjay,
     return get_handler(anjay, obj_ptr, current_module, handler_offset) != NULL;
 }
 
+/**
+ * Checks whether a bulk handler (operating on a whole Instance or Object) may
+ * be used instead of the finer-grained handlers it replaces: the Object needs
+ * to implement it, and no installed module may override any of the replaced
+ * handlers without overriding the bulk one as well, as it would be bypassed
+ * otherwise.
+ */
+static bool bulk_handler_usable(anjay_t *anjay,
+                                const anjay_dm_object_def_t *const *obj_ptr,
+                                size_t bulk_offset,
+                                const size_t *replaced_offsets,
+                                size_t replaced_count) {
+    if (!has_handler(&(*obj_ptr)->handlers, bulk_offset)) {
+        return false;
+    }
+    AVS_LIST(anjay_dm_installed_module_t) module;
+    AVS_LIST_FOREACH(module, anjay->dm.modules) {
+        const anjay_dm_handlers_t *overlay = &module->def->overlay_handlers;
+        if (has_handler(overlay, bulk_offset)) {
+            continue;
+        }
+        for (size_t i = 0; i < replaced_count; ++i) {
+            if (has_handler(overlay, replaced_offsets[i])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 #define CHECKED_TAIL_CALL_HANDLER(Anjay, ObjPtr, Current, HandlerName, ...) \
     do { \
         const anjay_dm_handlers_t *handler = \
                 get_handler((Anjay), (ObjPtr), (Current), \
                             offsetof(anjay_dm_handlers_t, HandlerName)); \
         if (handler) { \
-            return handler->HandlerName(__VA_ARGS__); \
+            _anjay_trace_begin((Anjay), "dm", #HandlerName, \
+                               (*(ObjPtr))->oid); \
+            int handler_result = handler->HandlerName(__VA_ARGS__); \
+            _anjay_trace_end((Anjay), "dm", #HandlerName, (*(ObjPtr))->oid); \
+            return handler_result; \
         } else { \
             anjay_log(ERROR, #HandlerName " handler not set for object /%u", \
                       (*(ObjPtr))->oid); \
@@ -187,6 +221,28 @@ int _anjay_dm_instance_remove(anjay_t *anjay,
                               instance_remove, anjay, obj_ptr, iid);
 }
 
+bool _anjay_dm_instance_remove_all_usable(
+        anjay_t *anjay, const anjay_dm_object_def_t *const *obj_ptr) {
+    static const size_t REPLACED[] = {
+        offsetof(anjay_dm_handlers_t, instance_remove)
+    };
+    return bulk_handler_usable(
+            anjay, obj_ptr, offsetof(anjay_dm_handlers_t, instance_remove_all),
+            REPLACED, AVS_ARRAY_SIZE(REPLACED));
+}
+
+int _anjay_dm_instance_remove_all(anjay_t *anjay,
+                                  const anjay_dm_object_def_t *const *obj_ptr,
+                                  const anjay_dm_module_t *current_module) {
+    dm_log(TRACE, "instance_remove_all /%u", (*obj_ptr)->oid);
+    int result = _anjay_dm_transaction_include_object(anjay, obj_ptr);
+    if (result) {
+        return result;
+    }
+    CHECKED_TAIL_CALL_HANDLER(anjay, obj_ptr, current_module,
+                              instance_remove_all, anjay, obj_ptr);
+}
+
 int _anjay_dm_instance_read_default_attrs(anjay_t *anjay,
                                           const anjay_dm_object_def_t *const *obj_ptr,
                                           anjay_iid_t iid,
@@ -274,6 +330,54 @@ int _anjay_dm_resource_operations(anjay_t *anjay,
                               resource_operations, anjay, obj_ptr, rid, out);
 }
 
+bool _anjay_dm_instance_resources_usable(
+        anjay_t *anjay, const anjay_dm_object_def_t *const *obj_ptr) {
+    static const size_t REPLACED[] = {
+        offsetof(anjay_dm_handlers_t, resource_present),
+        offsetof(anjay_dm_handlers_t, resource_operations)
+    };
+    return bulk_handler_usable(
+            anjay, obj_ptr, offsetof(anjay_dm_handlers_t, instance_resources),
+            REPLACED, AVS_ARRAY_SIZE(REPLACED));
+}
+
+int _anjay_dm_instance_resources(anjay_t *anjay,
+                                 const anjay_dm_object_def_t *const *obj_ptr,
+                                 anjay_iid_t iid,
+                                 anjay_dm_resource_op_mask_t *out,
+                                 const anjay_dm_module_t *current_module) {
+    anjay_log(TRACE, "instance_resources /%u/%u", (*obj_ptr)->oid, iid);
+    const anjay_dm_handlers_t *handler =
+            get_handler(anjay, obj_ptr, current_module,
+                        offsetof(anjay_dm_handlers_t, instance_resources));
+    if (!handler) {
+        anjay_log(ERROR, "instance_resources handler not set for object /%u",
+                  (*obj_ptr)->oid);
+        return ANJAY_ERR_METHOD_NOT_ALLOWED;
+    }
+    const size_t count = (*obj_ptr)->supported_rids.count;
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = ANJAY_DM_RESOURCE_OP_NONE;
+    }
+    _anjay_trace_begin(anjay, "dm", "instance_resources", (*obj_ptr)->oid);
+    int result = handler->instance_resources(anjay, obj_ptr, iid, out);
+    _anjay_trace_end(anjay, "dm", "instance_resources", (*obj_ptr)->oid);
+    if (!result
+            && !_anjay_dm_handler_implemented(
+                       anjay, obj_ptr, current_module,
+                       offsetof(anjay_dm_handlers_t, resource_operations))) {
+        for (size_t i = 0; i < count; ++i) {
+            if (out[i] & ANJAY_DM_RESOURCE_PRESENT) {
+                out[i] = ANJAY_DM_RESOURCE_PRESENT
+                         | ANJAY_DM_RESOURCE_OP_BIT_R
+                         | ANJAY_DM_RESOURCE_OP_BIT_W
+                         | ANJAY_DM_RESOURCE_OP_BIT_E;
+            }
+        }
+    }
+    return result;
+}
+
 int _anjay_dm_resource_read(anjay_t *anjay,
                             const anjay_dm_object_def_t *const *obj_ptr,
                             anjay_iid_t iid,
@@ -285,6 +389,26 @@ int _anjay_dm_resource_read(anjay_t *anjay,
                               resource_read, anjay, obj_ptr, iid, rid, ctx);
 }
 
+bool _anjay_dm_instance_read_usable(
+        anjay_t *anjay, const anjay_dm_object_def_t *const *obj_ptr) {
+    static const size_t REPLACED[] = {
+        offsetof(anjay_dm_handlers_t, resource_read)
+    };
+    return bulk_handler_usable(
+            anjay, obj_ptr, offsetof(anjay_dm_handlers_t, instance_read),
+            REPLACED, AVS_ARRAY_SIZE(REPLACED));
+}
+
+int _anjay_dm_instance_read(anjay_t *anjay,
+                            const anjay_dm_object_def_t *const *obj_ptr,
+                            anjay_iid_t iid,
+                            anjay_output_ctx_t *ctx,
+                            const anjay_dm_module_t *current_module) {
+    anjay_log(TRACE, "instance_read /%u/%u", (*obj_ptr)->oid, iid);
+    CHECKED_TAIL_CALL_HANDLER(anjay, obj_ptr, current_module,
+                              instance_read, anjay, obj_ptr, iid, ctx);
+}
+
 int _anjay_dm_resource_write(anjay_t *anjay,
                              const anjay_dm_object_def_t *const *obj_ptr,
                              anjay_iid_t iid,
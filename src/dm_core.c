@@ -21,6 +21,7 @@
 #include <math.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <anjay/core.h>
 #include <avsystem/commons/stream.h>
@@ -385,10 +386,51 @@ static int read_resource(anjay_t *anjay,
     return read_present_resource(anjay, obj, iid, rid, out_ctx);
 }
 
+static int read_instance_bulk(anjay_t *anjay,
+                              const anjay_dm_object_def_t *const *obj,
+                              anjay_iid_t iid,
+                              anjay_output_ctx_t *out_ctx) {
+    const size_t count = (*obj)->supported_rids.count;
+    if (!count) {
+        return 0;
+    }
+    anjay_dm_resource_op_mask_t *masks = (anjay_dm_resource_op_mask_t *)
+            calloc(count, sizeof(anjay_dm_resource_op_mask_t));
+    if (!masks) {
+        anjay_log(ERROR, "out of memory");
+        return ANJAY_ERR_INTERNAL;
+    }
+    int result = _anjay_dm_instance_resources(anjay, obj, iid, masks, NULL);
+    for (size_t i = 0; !result && i < count; ++i) {
+        const anjay_rid_t rid = (*obj)->supported_rids.rids[i];
+        if (!(masks[i] & ANJAY_DM_RESOURCE_PRESENT)) {
+            continue;
+        }
+        if (!(masks[i] & ANJAY_DM_RESOURCE_OP_BIT_R)) {
+            anjay_log(DEBUG, "Read /%u/*/%u is not supported", (*obj)->oid,
+                      rid);
+            continue;
+        }
+        result = read_resource_internal(anjay, obj, iid, rid, out_ctx);
+        if (result == ANJAY_ERR_METHOD_NOT_ALLOWED
+                || result == ANJAY_ERR_NOT_FOUND) {
+            result = 0;
+        }
+    }
+    free(masks);
+    return result;
+}
+
 static int read_instance(anjay_t *anjay,
                          const anjay_dm_object_def_t *const *obj,
                          anjay_iid_t iid,
                          anjay_output_ctx_t *out_ctx) {
+    if (_anjay_dm_instance_read_usable(anjay, obj)) {
+        return _anjay_dm_instance_read(anjay, obj, iid, out_ctx, NULL);
+    }
+    if (_anjay_dm_instance_resources_usable(anjay, obj)) {
+        return read_instance_bulk(anjay, obj, iid, out_ctx);
+    }
     for (size_t i = 0; i < (*obj)->supported_rids.count; ++i) {
         int result = ensure_resource_present(anjay, obj, iid,
                                              (*obj)->supported_rids.rids[i]);
@@ -464,12 +506,19 @@ dm_read_spawn_ctx(avs_stream_abstract_t *stream,
             ret = _anjay_handle_requested_format(&requested_format,
                                                  ANJAY_COAP_FORMAT_JSON);
         }
+#endif
+#ifdef WITH_SENML_CBOR
+        if (ret) {
+            ret = _anjay_handle_requested_format(&requested_format,
+                                                 ANJAY_COAP_FORMAT_SENML_CBOR);
+        }
 #endif
         if (ret) {
             *errno_ptr = ret;
             anjay_log(ERROR,
                       "Got option: Accept: %" PRIu16 ", but reads on "
-                      "non-resource paths only support TLV and JSON formats",
+                      "non-resource paths only support TLV, JSON and "
+                      "SenML CBOR formats",
                       details->requested_format);
             return NULL;
         }
@@ -674,6 +723,30 @@ request_attrs_empty(const anjay_request_attributes_t *attrs) {
 }
 
 #ifdef WITH_DISCOVER
+static int discover_path(anjay_t *anjay,
+                         avs_stream_abstract_t *stream,
+                         const anjay_dm_object_def_t *const *obj,
+                         const anjay_uri_path_t *uri) {
+    int result;
+    if (uri->has_iid) {
+        if (!(result = ensure_instance_present(anjay, obj, uri->iid))) {
+            if (uri->has_rid) {
+                if (!(result = ensure_resource_supported_and_present(
+                        anjay, obj, uri->iid, uri->rid))) {
+                    result = _anjay_discover_resource(anjay, stream, obj,
+                                                      uri->iid, uri->rid);
+                }
+            } else {
+                result = _anjay_discover_instance(anjay, stream, obj,
+                                                  uri->iid);
+            }
+        }
+    } else {
+        result = _anjay_discover_object(anjay, stream, obj);
+    }
+    return result;
+}
+
 static int dm_discover(anjay_t *anjay,
                        const anjay_dm_object_def_t *const *obj,
                        const anjay_request_t *request) {
@@ -692,21 +765,7 @@ static int dm_discover(anjay_t *anjay,
         return result;
     }
 
-    if (request->uri.has_iid) {
-        if (!(result = ensure_instance_present(anjay, obj, request->uri.iid))) {
-            if (request->uri.has_rid) {
-                if (!(result = ensure_resource_supported_and_present(
-                        anjay, obj, request->uri.iid, request->uri.rid))) {
-                    result = _anjay_discover_resource(
-                            anjay, obj, request->uri.iid, request->uri.rid);
-                }
-            } else {
-                result = _anjay_discover_instance(anjay, obj, request->uri.iid);
-            }
-        }
-    } else {
-        result = _anjay_discover_object(anjay, obj);
-    }
+    result = _anjay_discover_cached(anjay, obj, &request->uri, discover_path);
 
     if (result) {
         anjay_log(ERROR, "Discover %s failed!",
@@ -1022,6 +1081,10 @@ static int dm_write_attributes(anjay_t *anjay,
     } else {
         result = dm_write_object_attrs(anjay, obj, &request->attributes);
     }
+    // attribute handlers may have failed after a partial update,
+    // so cached Discover responses are dropped regardless of the result
+    _anjay_discover_cache_invalidate(anjay, _anjay_dm_current_ssid(anjay),
+                                     &request->uri);
 #ifdef WITH_OBSERVE
     if (!result) {
         // ensure that new attributes are "seen" by the observe code
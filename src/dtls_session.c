@@ -0,0 +1,135 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include <avsystem/commons/utils.h>
+
+#include "anjay_core.h"
+#include "dtls_session.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+/* 32-bit FNV-1a */
+#define DIGEST_OFFSET_BASIS UINT32_C(0x811c9dc5)
+#define DIGEST_PRIME UINT32_C(0x01000193)
+
+static uint32_t digest_update(uint32_t digest,
+                              const void *data,
+                              size_t size) {
+    const uint8_t *bytes = (const uint8_t *) data;
+    for (size_t i = 0; i < size; ++i) {
+        digest = (digest ^ bytes[i]) * DIGEST_PRIME;
+    }
+    return digest;
+}
+
+static uint32_t digest_update_sized(uint32_t digest,
+                                    const void *data,
+                                    size_t size) {
+    // the digest is persisted, so it must not depend on the byte order
+    uint32_t size32 = avs_convert_be32((uint32_t) size);
+    digest = digest_update(digest, &size32, sizeof(size32));
+    return digest_update(digest, data, size);
+}
+
+uint32_t
+_anjay_dtls_credentials_digest(anjay_udp_security_mode_t security_mode,
+                               const anjay_server_dtls_keys_t *keys) {
+    uint8_t mode = (uint8_t) security_mode;
+    uint32_t digest = digest_update(DIGEST_OFFSET_BASIS, &mode, 1);
+    digest = digest_update_sized(digest, keys->pk_or_identity,
+                                 keys->pk_or_identity_size);
+    digest = digest_update_sized(digest, keys->server_pk_or_identity,
+                                 keys->server_pk_or_identity_size);
+    return digest_update_sized(digest, keys->secret_key,
+                               keys->secret_key_size);
+}
+
+static AVS_LIST(anjay_dtls_session_t) *
+find_session_ptr(anjay_t *anjay, anjay_ssid_t ssid) {
+    AVS_LIST(anjay_dtls_session_t) *session_ptr;
+    AVS_LIST_FOREACH_PTR(session_ptr, &anjay->dtls_sessions) {
+        if ((*session_ptr)->ssid >= ssid) {
+            break;
+        }
+    }
+    return session_ptr;
+}
+
+static anjay_dtls_session_t *get_session(anjay_t *anjay,
+                                         anjay_ssid_t ssid,
+                                         uint32_t credentials_digest) {
+    AVS_LIST(anjay_dtls_session_t) *session_ptr =
+            find_session_ptr(anjay, ssid);
+    if (!*session_ptr || (*session_ptr)->ssid != ssid) {
+        AVS_LIST(anjay_dtls_session_t) session =
+                AVS_LIST_NEW_ELEMENT(anjay_dtls_session_t);
+        if (!session) {
+            anjay_log(ERROR, "out of memory");
+            return NULL;
+        }
+        session->ssid = ssid;
+        session->credentials_digest = credentials_digest;
+        AVS_LIST_INSERT(session_ptr, session);
+    }
+    return *session_ptr;
+}
+
+uint8_t *_anjay_dtls_session_buffer(anjay_t *anjay,
+                                    anjay_ssid_t ssid,
+                                    uint32_t credentials_digest) {
+    anjay_dtls_session_t *session =
+            get_session(anjay, ssid, credentials_digest);
+    if (!session) {
+        return NULL;
+    }
+    if (session->credentials_digest != credentials_digest) {
+        anjay_log(INFO, "credentials for SSID %u changed, dropping DTLS "
+                  "session", ssid);
+        memset(session->buffer, 0, sizeof(session->buffer));
+        session->credentials_digest = credentials_digest;
+    }
+    return session->buffer;
+}
+
+AVS_LIST(const anjay_dtls_session_t) _anjay_dtls_sessions(anjay_t *anjay) {
+    return anjay->dtls_sessions;
+}
+
+int _anjay_dtls_session_restore(anjay_t *anjay,
+                                anjay_ssid_t ssid,
+                                uint32_t credentials_digest,
+                                const uint8_t *data) {
+    anjay_dtls_session_t *session =
+            get_session(anjay, ssid, credentials_digest);
+    if (!session) {
+        return -1;
+    }
+    session->credentials_digest = credentials_digest;
+    memcpy(session->buffer, data, sizeof(session->buffer));
+    return 0;
+}
+
+void _anjay_dtls_sessions_cleanup(anjay_t *anjay) {
+    AVS_LIST_CLEAR(&anjay->dtls_sessions);
+}
+
+#ifdef ANJAY_TEST
+#include "test/dtls_session.c"
+#endif // ANJAY_TEST
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_DTLS_SESSION_H
+#define ANJAY_DTLS_SESSION_H
+
+#include <avsystem/commons/list.h>
+
+#include <anjay/core.h>
+#include <anjay/dm.h>
+
+#include <anjay_modules/dtls_session.h>
+#include <anjay_modules/servers.h>
+
+#include "utils_core.h"
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/**
+ * @returns Digest of the Security mode and DTLS credentials, used to detect
+ *          that the session state no longer matches the Security Instance.
+ */
+uint32_t
+_anjay_dtls_credentials_digest(anjay_udp_security_mode_t security_mode,
+                               const anjay_server_dtls_keys_t *keys);
+
+/**
+ * Returns the buffer that shall be passed to avs_net as the session
+ * resumption buffer of sockets connecting to the server @p ssid, creating it
+ * if necessary. If the session has been established with credentials other
+ * than @p credentials_digest, it is dropped first.
+ *
+ * The buffer stays valid until @ref _anjay_dtls_sessions_cleanup is called,
+ * so it may be safely referenced by sockets that outlive the server entry.
+ *
+ * @returns Pointer to a buffer of ANJAY_DTLS_SESSION_BUFFER_SIZE bytes, or
+ *          NULL if out of memory.
+ */
+uint8_t *_anjay_dtls_session_buffer(anjay_t *anjay,
+                                    anjay_ssid_t ssid,
+                                    uint32_t credentials_digest);
+
+void _anjay_dtls_sessions_cleanup(anjay_t *anjay);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_DTLS_SESSION_H */
@@ -361,14 +361,25 @@ static int delete_instance(anjay_t *anjay,
     return retval;
 }
 
-static int delete_object(anjay_t *anjay,
-                         const anjay_dm_object_def_t *const *obj,
-                         void *retval_ptr_) {
+static int delete_all_instances(anjay_t *anjay,
+                                const anjay_dm_object_def_t *const *obj) {
+    int retval = _anjay_dm_instance_remove_all(anjay, obj, NULL);
+    if (retval) {
+        anjay_log(ERROR, "delete_all_instances: cannot delete /%d: %d",
+                  (*obj)->oid, retval);
+    } else {
+        retval = _anjay_notify_queue_all_instances_removed(
+                &anjay->bootstrap.notification_queue, (*obj)->oid);
+    }
+    return retval;
+}
+
+static int delete_each_instance(anjay_t *anjay,
+                                const anjay_dm_object_def_t *const *obj) {
     // deleting from within _anjay_dm_foreach_instance()
     // would possibly invalidate cookies, so we use a temporary list
     AVS_LIST(anjay_iid_t) iids = NULL;
     AVS_LIST(anjay_iid_t) *iids_it = &iids;
-    int *retval_ptr = (int *) retval_ptr_;
     int retval = _anjay_dm_foreach_instance(anjay, obj, append_iid, &iids_it);
     if (!retval) {
         AVS_LIST(anjay_iid_t) iid;
@@ -391,6 +402,26 @@ static int delete_object(anjay_t *anjay,
         }
     }
     AVS_LIST_CLEAR(&iids);
+    return retval;
+}
+
+static int delete_object(anjay_t *anjay,
+                         const anjay_dm_object_def_t *const *obj,
+                         void *retval_ptr_) {
+    int *retval_ptr = (int *) retval_ptr_;
+    int retval;
+    // the Bootstrap-Server Account needs to survive in the Security object,
+    // so it is always cleared one instance at a time
+    if ((*obj)->oid != ANJAY_DM_OID_SECURITY
+            && _anjay_dm_instance_remove_all_usable(anjay, obj)) {
+        retval = delete_all_instances(anjay, obj);
+        if (retval == ANJAY_ERR_METHOD_NOT_ALLOWED) {
+            // non-modifiable Object, see delete_each_instance()
+            retval = 0;
+        }
+    } else {
+        retval = delete_each_instance(anjay, obj);
+    }
     if (!*retval_ptr) {
         *retval_ptr = retval;
     }
@@ -627,9 +658,9 @@ int _anjay_bootstrap_perform_action(anjay_t *anjay,
     return invoke_action(anjay, request);
 }
 
-static int check_request_bootstrap_response(avs_stream_abstract_t *stream) {
+static int check_request_bootstrap_response(anjay_t *anjay) {
     const avs_coap_msg_t *response;
-    if (_anjay_coap_stream_get_incoming_msg(stream, &response)) {
+    if (_anjay_comm_stream_get_response(anjay, &response)) {
         anjay_log(ERROR, "could not get response");
         return -1;
     }
@@ -671,9 +702,8 @@ static int send_request_bootstrap(anjay_t *anjay) {
 
     if ((result = _anjay_coap_stream_setup_request(anjay->comm_stream, &details,
                                                    NULL))
-            || (result = avs_stream_finish_message(anjay->comm_stream))
-            || (result = check_request_bootstrap_response(
-                    anjay->comm_stream))) {
+            || (result = _anjay_comm_stream_finish_message(anjay))
+            || (result = check_request_bootstrap_response(anjay))) {
         anjay_log(ERROR, "could not request bootstrap");
     } else {
         anjay_log(INFO, "Request Bootstrap sent");
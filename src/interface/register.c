@@ -28,6 +28,7 @@
 #include "register.h"
 #include "../dm_core.h"
 #include "../dm/query.h"
+#include "../server_stats.h"
 #include "../utils_core.h"
 
 #include "../coap/content_format.h"
@@ -152,8 +153,8 @@ static int get_server_lifetime(anjay_t *anjay,
     return 0;
 }
 
-static int send_register(anjay_t *anjay,
-                         const anjay_update_parameters_t *params) {
+static int write_register(anjay_t *anjay,
+                          const anjay_update_parameters_t *params) {
     const anjay_url_t *const server_uri =
             &anjay->current_connection.server->uri;
     anjay_msg_details_t details = {
@@ -183,11 +184,9 @@ static int send_register(anjay_t *anjay,
     }
 
     if (_anjay_coap_stream_setup_request(anjay->comm_stream, &details, NULL)
-            || send_objects_list(anjay->comm_stream, params->dm)
-            || avs_stream_finish_message(anjay->comm_stream)) {
-        anjay_log(ERROR, "could not send Register message");
+            || send_objects_list(anjay->comm_stream, params->dm)) {
+        anjay_log(ERROR, "could not prepare Register message");
     } else {
-        anjay_log(INFO, "Register sent");
         result = 0;
     }
 
@@ -198,14 +197,8 @@ cleanup:
 }
 
 static int
-check_register_response(avs_stream_abstract_t *stream,
-                        AVS_LIST(const anjay_string_t) *out_endpoint_path) {
-    const avs_coap_msg_t *response;
-    if (_anjay_coap_stream_get_incoming_msg(stream, &response)) {
-        anjay_log(ERROR, "could not get response");
-        return -1;
-    }
-
+check_register_response_msg(const avs_coap_msg_t *response,
+                            AVS_LIST(const anjay_string_t) *out_endpoint_path) {
     if (avs_coap_msg_get_code(response) != AVS_COAP_CODE_CREATED) {
         anjay_log(ERROR, "server responded with %s (expected %s)",
                   AVS_COAP_CODE_STRING(avs_coap_msg_get_code(response)),
@@ -227,6 +220,17 @@ check_register_response(avs_stream_abstract_t *stream,
     return 0;
 }
 
+static int
+check_register_response(anjay_t *anjay,
+                        AVS_LIST(const anjay_string_t) *out_endpoint_path) {
+    const avs_coap_msg_t *response;
+    if (_anjay_comm_stream_get_response(anjay, &response)) {
+        anjay_log(ERROR, "could not get response");
+        return -1;
+    }
+    return check_register_response_msg(response, out_endpoint_path);
+}
+
 static void clear_dm_cache(AVS_LIST(anjay_dm_cache_object_t) *cache_ptr) {
     AVS_LIST_CLEAR(cache_ptr) {
         AVS_LIST_CLEAR(&(*cache_ptr)->instances);
@@ -310,8 +314,9 @@ static int query_dm(anjay_t *anjay, AVS_LIST(anjay_dm_cache_object_t) *out) {
     return retval;
 }
 
-static avs_time_monotonic_t get_registration_expire_time(int64_t lifetime_s) {
-    return avs_time_monotonic_add(avs_time_monotonic_now(),
+static avs_time_monotonic_t get_registration_expire_time(anjay_t *anjay,
+                                                         int64_t lifetime_s) {
+    return avs_time_monotonic_add(_anjay_time_monotonic_now(anjay),
                                   avs_time_duration_from_scalar(lifetime_s,
                                                                 AVS_TIME_S));
 }
@@ -341,7 +346,8 @@ error:
 }
 
 static void
-update_registration_info(anjay_registration_info_t *info,
+update_registration_info(anjay_t *anjay,
+                         anjay_registration_info_t *info,
                          anjay_update_parameters_t *move_params) {
     clear_dm_cache(&info->last_update_params.dm);
     info->last_update_params.dm = move_params->dm;
@@ -352,14 +358,16 @@ update_registration_info(anjay_registration_info_t *info,
     info->last_update_params.binding_mode = move_params->binding_mode;
 
     info->expire_time =
-            get_registration_expire_time(info->last_update_params.lifetime_s);
+            get_registration_expire_time(anjay,
+                                         info->last_update_params.lifetime_s);
 }
 
 static void
-registration_info_init(anjay_registration_info_t *info,
+registration_info_init(anjay_t *anjay,
+                       anjay_registration_info_t *info,
                        AVS_LIST(const anjay_string_t) *move_endpoint_path,
                        anjay_update_parameters_t *move_params) {
-    update_registration_info(info, move_params);
+    update_registration_info(anjay, info, move_params);
 
     info->endpoint_path = *move_endpoint_path;
     *move_endpoint_path = NULL;
@@ -370,35 +378,119 @@ void _anjay_registration_info_cleanup(anjay_registration_info_t *info) {
     cleanup_update_parameters(&info->last_update_params);
 }
 
+static void
+commit_registration(anjay_t *anjay,
+                    anjay_active_server_info_t *server,
+                    AVS_LIST(const anjay_string_t) *move_endpoint_path,
+                    anjay_update_parameters_t *move_params) {
+    _anjay_registration_info_cleanup(&server->registration_info);
+    registration_info_init(anjay, &server->registration_info,
+                           move_endpoint_path, move_params);
+}
+
+/**
+ * Sends the Register request prepared with write_register() and waits for the
+ * response.
+ */
+static int finish_register_sync(anjay_t *anjay,
+                                anjay_update_parameters_t *params) {
+    const avs_time_monotonic_t request_time =
+            _anjay_time_monotonic_now(anjay);
+    if (_anjay_comm_stream_finish_message(anjay)) {
+        anjay_log(ERROR, "could not send Register message");
+        return -1;
+    }
+    anjay_log(INFO, "Register sent");
+
+    AVS_LIST(const anjay_string_t) endpoint_path = NULL;
+    int result = check_register_response(anjay, &endpoint_path);
+    if (!result) {
+        _anjay_server_stats_record_latency(
+                anjay, anjay->current_connection.server->ssid,
+                ANJAY_SERVER_STATS_REGISTER, request_time);
+        commit_registration(anjay, anjay->current_connection.server,
+                            &endpoint_path, params);
+    }
+    AVS_LIST_CLEAR(&endpoint_path);
+    return result;
+}
+
 int _anjay_register(anjay_t *anjay) {
     anjay_update_parameters_t new_params;
     if (init_update_parameters(anjay, &new_params)) {
         return -1;
     }
 
-    AVS_LIST(const anjay_string_t) endpoint_path = NULL;
-    int result = -1;
-
-    if (send_register(anjay, &new_params)
-            || (result = check_register_response(anjay->comm_stream, &endpoint_path))) {
+    int result;
+    if ((result = write_register(anjay, &new_params))
+            || (result = finish_register_sync(anjay, &new_params))) {
         anjay_log(ERROR, "could not register to server %u",
                   _anjay_dm_current_ssid(anjay));
-        goto fail;
     }
 
-    _anjay_registration_info_cleanup(
-            &anjay->current_connection.server->registration_info);
-    registration_info_init(
-            &anjay->current_connection.server->registration_info,
-            &endpoint_path, &new_params);
-    result = 0;
+    cleanup_update_parameters(&new_params);
+    return result;
+}
+
+int _anjay_register_async(anjay_t *anjay,
+                          anjay_exchange_handler_t *handler,
+                          void *handler_arg) {
+    anjay_active_server_info_t *server = anjay->current_connection.server;
+    assert(!server->registration_exchange);
+
+    anjay_update_parameters_t new_params;
+    if (init_update_parameters(anjay, &new_params)) {
+        return -1;
+    }
+
+    avs_coap_msg_t *msg = NULL;
+    int result = write_register(anjay, &new_params);
+    if (!result) {
+        result = _anjay_coap_stream_detach_request(anjay->comm_stream, &msg);
+    }
+    if (result > 0) {
+        // block-wise Register can only be performed synchronously
+        result = finish_register_sync(anjay, &new_params);
+    } else if (!result
+            && !(result = _anjay_exchange_send_confirmable(
+                    anjay, server->ssid, anjay->current_connection.conn_type,
+                    msg, ANJAY_SERVER_STATS_REGISTER, handler, handler_arg,
+                    &server->registration_exchange))) {
+        anjay_log(INFO, "Register sent");
+        cleanup_update_parameters(&server->registration_params);
+        server->registration_params = new_params;
+        new_params.dm = NULL;
+    }
 
-fail:
+    if (result) {
+        anjay_log(ERROR, "could not register to server %u", server->ssid);
+    }
     cleanup_update_parameters(&new_params);
+    return result;
+}
+
+int _anjay_register_finish(anjay_t *anjay,
+                           anjay_active_server_info_t *server,
+                           const avs_coap_msg_t *response) {
+    AVS_LIST(const anjay_string_t) endpoint_path = NULL;
+    int result = check_register_response_msg(response, &endpoint_path);
+    if (!result) {
+        commit_registration(anjay, server, &endpoint_path,
+                            &server->registration_params);
+    } else {
+        anjay_log(ERROR, "could not register to server %u", server->ssid);
+    }
+    cleanup_update_parameters(&server->registration_params);
     AVS_LIST_CLEAR(&endpoint_path);
     return result;
 }
 
+void _anjay_register_abort(anjay_t *anjay,
+                           anjay_active_server_info_t *server) {
+    _anjay_exchange_cancel(anjay, &server->registration_exchange);
+    cleanup_update_parameters(&server->registration_params);
+}
+
 static bool iid_lists_equal(AVS_LIST(anjay_iid_t) left,
                             AVS_LIST(anjay_iid_t) right) {
     while (left && right) {
@@ -431,8 +523,8 @@ static bool dm_caches_equal(AVS_LIST(anjay_dm_cache_object_t) left,
     return !(left || right);
 }
 
-static int send_update(anjay_t *anjay,
-                       const anjay_update_parameters_t *new_params) {
+static int write_update(anjay_t *anjay,
+                        const anjay_update_parameters_t *new_params) {
     const anjay_active_server_info_t *server = anjay->current_connection.server;
     const anjay_update_parameters_t *old_params =
             &server->registration_info.last_update_params;
@@ -459,17 +551,13 @@ static int send_update(anjay_t *anjay,
                                                    binding_mode, NULL)
     };
 
-    int result = -1;
+    int result;
     if ((result = _anjay_coap_stream_setup_request(anjay->comm_stream, &details,
                                                    NULL))
             || (dm_changed_since_last_update
                 && (result = send_objects_list(anjay->comm_stream,
-                                               new_params->dm)))
-            || (result = avs_stream_finish_message(anjay->comm_stream))) {
-        anjay_log(ERROR, "could not send Update message");
-    } else {
-        anjay_log(INFO, "Update sent");
-        result = 0;
+                                               new_params->dm)))) {
+        anjay_log(ERROR, "could not prepare Update message");
     }
 
     // request_uri must not be cleared here
@@ -477,13 +565,7 @@ static int send_update(anjay_t *anjay,
     return result;
 }
 
-static int check_update_response(avs_stream_abstract_t *stream) {
-    const avs_coap_msg_t *response;
-    if (_anjay_coap_stream_get_incoming_msg(stream, &response)) {
-        anjay_log(ERROR, "could not get response");
-        return -1;
-    }
-
+static int check_update_response_msg(const avs_coap_msg_t *response) {
     const uint8_t code = avs_coap_msg_get_code(response);
     if (code == AVS_COAP_CODE_CHANGED) {
         anjay_log(INFO, "registration successfully updated");
@@ -516,31 +598,99 @@ static int check_update_response(avs_stream_abstract_t *stream) {
     }
 }
 
-int _anjay_update_registration(anjay_t *anjay) {
+static int check_update_response(anjay_t *anjay) {
+    const avs_coap_msg_t *response;
+    if (_anjay_comm_stream_get_response(anjay, &response)) {
+        anjay_log(ERROR, "could not get response");
+        return -1;
+    }
+    return check_update_response_msg(response);
+}
+
+/**
+ * Sends the Update request prepared with write_update() and waits for the
+ * response.
+ */
+static int finish_update_sync(anjay_t *anjay,
+                              anjay_update_parameters_t *params) {
+    const avs_time_monotonic_t request_time =
+            _anjay_time_monotonic_now(anjay);
+    int result;
+    if ((result = _anjay_comm_stream_finish_message(anjay))) {
+        anjay_log(ERROR, "could not send Update message");
+        return result;
+    }
+    anjay_log(INFO, "Update sent");
+
+    if (!(result = check_update_response(anjay))) {
+        _anjay_server_stats_record_latency(
+                anjay, anjay->current_connection.server->ssid,
+                ANJAY_SERVER_STATS_UPDATE, request_time);
+        update_registration_info(
+                anjay, &anjay->current_connection.server->registration_info,
+                params);
+    }
+    return result;
+}
+
+int _anjay_update_registration_async(anjay_t *anjay,
+                                     anjay_exchange_handler_t *handler,
+                                     void *handler_arg) {
+    anjay_active_server_info_t *server = anjay->current_connection.server;
+    // a newer Update supersedes the one still in progress
+    _anjay_update_registration_abort(anjay, server);
+
     anjay_update_parameters_t new_params;
     if (init_update_parameters(anjay, &new_params)) {
         return -1;
     }
 
-    int retval = -1;
-    if ((retval = send_update(anjay, &new_params))
-            || (retval = check_update_response(anjay->comm_stream))) {
+    avs_coap_msg_t *msg = NULL;
+    int result = write_update(anjay, &new_params);
+    if (!result) {
+        result = _anjay_coap_stream_detach_request(anjay->comm_stream, &msg);
+    }
+    if (result > 0) {
+        // block-wise Update can only be performed synchronously
+        result = finish_update_sync(anjay, &new_params);
+    } else if (!result
+            && !(result = _anjay_exchange_send_confirmable(
+                    anjay, server->ssid, anjay->current_connection.conn_type,
+                    msg, ANJAY_SERVER_STATS_UPDATE, handler, handler_arg,
+                    &server->update_exchange))) {
+        anjay_log(INFO, "Update sent");
+        server->update_params = new_params;
+        new_params.dm = NULL;
+    }
+
+    if (result && result != ANJAY_REGISTRATION_UPDATE_REJECTED) {
         anjay_log(ERROR, "could not update registration");
-        goto finish;
     }
+    cleanup_update_parameters(&new_params);
+    return result;
+}
 
-    update_registration_info(
-            &anjay->current_connection.server->registration_info, &new_params);
-    retval = 0;
+int _anjay_update_registration_finish(anjay_t *anjay,
+                                      anjay_active_server_info_t *server,
+                                      const avs_coap_msg_t *response) {
+    int result = check_update_response_msg(response);
+    if (!result) {
+        update_registration_info(anjay, &server->registration_info,
+                                 &server->update_params);
+    }
+    cleanup_update_parameters(&server->update_params);
+    return result;
+}
 
-finish:
-    cleanup_update_parameters(&new_params);
-    return retval;
+void _anjay_update_registration_abort(anjay_t *anjay,
+                                      anjay_active_server_info_t *server) {
+    _anjay_exchange_cancel(anjay, &server->update_exchange);
+    cleanup_update_parameters(&server->update_params);
 }
 
-static int check_deregister_response(avs_stream_abstract_t *stream) {
+static int check_deregister_response(anjay_t *anjay) {
     const avs_coap_msg_t *response;
-    if (_anjay_coap_stream_get_incoming_msg(stream, &response)) {
+    if (_anjay_comm_stream_get_response(anjay, &response)) {
         anjay_log(ERROR, "could not get response");
         return -1;
     }
@@ -567,8 +717,8 @@ int _anjay_deregister(anjay_t *anjay) {
     int result;
     if ((result = _anjay_coap_stream_setup_request(anjay->comm_stream, &details,
                                                    NULL))
-            || (result = avs_stream_finish_message(anjay->comm_stream))
-            || (result = check_deregister_response(anjay->comm_stream))) {
+            || (result = _anjay_comm_stream_finish_message(anjay))
+            || (result = check_deregister_response(anjay))) {
         anjay_log(ERROR, "Could not perform De-registration");
     } else {
         anjay_log(INFO, "De-register sent");
@@ -577,6 +727,8 @@ int _anjay_deregister(anjay_t *anjay) {
 }
 
 avs_time_duration_t
-_anjay_register_time_remaining(const anjay_registration_info_t *info) {
-    return avs_time_monotonic_diff(info->expire_time, avs_time_monotonic_now());
+_anjay_register_time_remaining(anjay_t *anjay,
+                               const anjay_registration_info_t *info) {
+    return avs_time_monotonic_diff(info->expire_time,
+                                   _anjay_time_monotonic_now(anjay));
 }
@@ -25,16 +25,76 @@ void _anjay_registration_info_cleanup(anjay_registration_info_t *info);
 
 int _anjay_register(anjay_t *anjay);
 
+/**
+ * Sends a Register request to the server the stream is currently bound to,
+ * without waiting for the response. @p handler is called when the exchange
+ * finishes, and shall call @ref _anjay_register_finish on success.
+ *
+ * If the request needs to be sent block-wise, it is performed synchronously
+ * instead, just like @ref _anjay_register - in that case, registration_exchange
+ * of the server is not set when this function returns.
+ */
+int _anjay_register_async(anjay_t *anjay,
+                          anjay_exchange_handler_t *handler,
+                          void *handler_arg);
+
+/**
+ * Processes the response to a Register request sent with
+ * @ref _anjay_register_async and updates the registration info of @p server.
+ */
+int _anjay_register_finish(anjay_t *anjay,
+                           anjay_active_server_info_t *server,
+                           const avs_coap_msg_t *response);
+
+/**
+ * Cancels a Register request sent with @ref _anjay_register_async, if any.
+ */
+void _anjay_register_abort(anjay_t *anjay,
+                           anjay_active_server_info_t *server);
+
 #define ANJAY_REGISTRATION_UPDATE_REJECTED 1
 
 /**
+ * Sends an Update request to the server the stream is currently bound to,
+ * without waiting for the response. @p handler is called when the exchange
+ * finishes, and shall call @ref _anjay_update_registration_finish on success.
+ * An Update still in progress is cancelled first.
+ *
+ * If the request needs to be sent block-wise, it is performed synchronously
+ * instead - in that case, update_exchange of the server is not set when this
+ * function returns.
+ *
  * @returns:
  * - 0 on success,
  * - a negative value on error,
+ * - ANJAY_REGISTRATION_UPDATE_REJECTED if the synchronous Update has been
+ *   rejected by the server with a 4.xx error.
+ */
+int _anjay_update_registration_async(anjay_t *anjay,
+                                     anjay_exchange_handler_t *handler,
+                                     void *handler_arg);
+
+/**
+ * Processes the response to an Update request sent with
+ * @ref _anjay_update_registration_async and updates the registration info of
+ * @p server.
+ *
+ * @returns:
+ * - 0 on success,
+ * - a negative value if the server responded with an unexpected code,
  * - ANJAY_REGISTRATION_UPDATE_REJECTED if the server responded with 4.xx error
  *   so the Update message should not be retransmitted.
  */
-int _anjay_update_registration(anjay_t *anjay);
+int _anjay_update_registration_finish(anjay_t *anjay,
+                                      anjay_active_server_info_t *server,
+                                      const avs_coap_msg_t *response);
+
+/**
+ * Cancels an Update request sent with @ref _anjay_update_registration_async,
+ * if any.
+ */
+void _anjay_update_registration_abort(anjay_t *anjay,
+                                      anjay_active_server_info_t *server);
 
 int _anjay_deregister(anjay_t *anjay);
 
@@ -42,7 +102,8 @@ int _anjay_deregister(anjay_t *anjay);
  * @returns Amount of time from now until the server registration expires.
  */
 avs_time_duration_t
-_anjay_register_time_remaining(const anjay_registration_info_t *info);
+_anjay_register_time_remaining(anjay_t *anjay,
+                               const anjay_registration_info_t *info);
 
 VISIBILITY_PRIVATE_HEADER_END
 
@@ -17,6 +17,9 @@
 #include <config.h>
 
 #include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #include <avsystem/commons/unit/test.h>
 
@@ -583,6 +586,164 @@ AVS_UNIT_TEST(bootstrap_delete, bs) {
     DM_TEST_FINISH;
 }
 
+#define BULK_INSTANCES 10000
+
+typedef struct {
+    const anjay_dm_object_def_t *def;
+    size_t count;
+    bool present[BULK_INSTANCES];
+    unsigned remove_calls;
+    unsigned remove_all_calls;
+} bulk_object_t;
+
+static bulk_object_t *get_bulk_object(const anjay_dm_object_def_t *const *obj) {
+    return AVS_CONTAINER_OF(obj, bulk_object_t, def);
+}
+
+static int bulk_instance_it(anjay_t *anjay,
+                            const anjay_dm_object_def_t *const *obj_ptr,
+                            anjay_iid_t *out,
+                            void **cookie) {
+    (void) anjay;
+    bulk_object_t *obj = get_bulk_object(obj_ptr);
+    uintptr_t index = (uintptr_t) *cookie;
+    while (index < BULK_INSTANCES && !obj->present[index]) {
+        ++index;
+    }
+    if (index < BULK_INSTANCES) {
+        *out = (anjay_iid_t) index;
+        *cookie = (void *) (index + 1);
+    } else {
+        *out = ANJAY_IID_INVALID;
+    }
+    return 0;
+}
+
+static int bulk_instance_present(anjay_t *anjay,
+                                 const anjay_dm_object_def_t *const *obj_ptr,
+                                 anjay_iid_t iid) {
+    (void) anjay;
+    return iid < BULK_INSTANCES && get_bulk_object(obj_ptr)->present[iid];
+}
+
+static int bulk_instance_remove(anjay_t *anjay,
+                                const anjay_dm_object_def_t *const *obj_ptr,
+                                anjay_iid_t iid) {
+    (void) anjay;
+    bulk_object_t *obj = get_bulk_object(obj_ptr);
+    AVS_UNIT_ASSERT_TRUE(obj->present[iid]);
+    obj->present[iid] = false;
+    --obj->count;
+    ++obj->remove_calls;
+    return 0;
+}
+
+static int
+bulk_instance_remove_all(anjay_t *anjay,
+                         const anjay_dm_object_def_t *const *obj_ptr) {
+    (void) anjay;
+    bulk_object_t *obj = get_bulk_object(obj_ptr);
+    memset(obj->present, 0, sizeof(obj->present));
+    obj->count = 0;
+    ++obj->remove_all_calls;
+    return 0;
+}
+
+#define BULK_OBJECT_DEF(Oid, RemoveAll) \
+    (const anjay_dm_object_def_t) { \
+        .oid = (Oid), \
+        .supported_rids = ANJAY_DM_SUPPORTED_RIDS(0), \
+        .handlers = { \
+            .instance_it = bulk_instance_it, \
+            .instance_present = bulk_instance_present, \
+            .instance_remove = bulk_instance_remove, \
+            .instance_remove_all = (RemoveAll), \
+            .transaction_begin = anjay_dm_transaction_NOOP, \
+            .transaction_validate = anjay_dm_transaction_NOOP, \
+            .transaction_commit = anjay_dm_transaction_NOOP, \
+            .transaction_rollback = anjay_dm_transaction_NOOP \
+        } \
+    }
+
+static bulk_object_t *bulk_object_new(const anjay_dm_object_def_t *def) {
+    bulk_object_t *obj = (bulk_object_t *) calloc(1, sizeof(bulk_object_t));
+    AVS_UNIT_ASSERT_NOT_NULL(obj);
+    obj->def = def;
+    obj->count = BULK_INSTANCES;
+    for (size_t i = 0; i < BULK_INSTANCES; ++i) {
+        obj->present[i] = true;
+    }
+    return obj;
+}
+
+static double bulk_delete_ms(anjay_t *anjay,
+                             avs_net_abstract_socket_t *mocksock,
+                             const char *request,
+                             size_t request_size) {
+    avs_unit_mocksock_input(mocksock, request, request_size);
+    // the Message ID is the same in the request and the response
+    char response[4] = "\x60\x42";
+    memcpy(&response[2], &request[2], 2);
+    avs_unit_mocksock_expect_output(mocksock, response, sizeof(response));
+    // the monotonic clock is mocked, so measure used processor time instead
+    clock_t start = clock();
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksock));
+    return 1000.0 * (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+AVS_UNIT_TEST(bootstrap_delete, object_remove_all_10k_instances) {
+    static const anjay_dm_object_def_t BULK_DEF =
+            BULK_OBJECT_DEF(1000, bulk_instance_remove_all);
+    static const anjay_dm_object_def_t PER_INSTANCE_DEF =
+            BULK_OBJECT_DEF(1001, NULL);
+    bulk_object_t *bulk = bulk_object_new(&BULK_DEF);
+    bulk_object_t *per_instance = bulk_object_new(&PER_INSTANCE_DEF);
+    DM_TEST_INIT_GENERIC((DM_TEST_DEFAULT_OBJECTS, &bulk->def,
+                          &per_instance->def),
+                         (ANJAY_SSID_BOOTSTRAP), ());
+
+    static const char BULK_REQUEST[] =
+            "\x40\x04\xFA\x3E" // CoAP header
+            "\xB4" "1000"; // OID
+    const double bulk_ms = bulk_delete_ms(anjay, mocksocks[0], BULK_REQUEST,
+                                          sizeof(BULK_REQUEST) - 1);
+    AVS_UNIT_ASSERT_EQUAL(bulk->remove_all_calls, 1);
+    AVS_UNIT_ASSERT_EQUAL(bulk->remove_calls, 0);
+    AVS_UNIT_ASSERT_EQUAL(bulk->count, 0);
+
+    static const char PER_INSTANCE_REQUEST[] =
+            "\x40\x04\xFA\x3F" // CoAP header
+            "\xB4" "1001"; // OID
+    const double per_instance_ms =
+            bulk_delete_ms(anjay, mocksocks[0], PER_INSTANCE_REQUEST,
+                           sizeof(PER_INSTANCE_REQUEST) - 1);
+    AVS_UNIT_ASSERT_EQUAL(per_instance->remove_calls, BULK_INSTANCES);
+    AVS_UNIT_ASSERT_EQUAL(per_instance->count, 0);
+
+    anjay_log(INFO, "Bootstrap Delete of %d instances: %.3f ms with "
+              "instance_remove_all, %.3f ms with instance_remove",
+              BULK_INSTANCES, bulk_ms, per_instance_ms);
+
+    // a single "all instances removed" entry is queued for the bulk object
+    AVS_LIST(anjay_notify_queue_object_entry_t) entry;
+    AVS_LIST_FOREACH(entry, anjay->bootstrap.notification_queue) {
+        if (entry->oid == 1000) {
+            break;
+        }
+    }
+    AVS_UNIT_ASSERT_NOT_NULL(entry);
+    AVS_UNIT_ASSERT_TRUE(entry->instance_set_changes.instance_set_changed);
+    AVS_UNIT_ASSERT_NULL(entry->instance_set_changes.known_removed_iids);
+    AVS_UNIT_ASSERT_NULL(entry->resources_changed);
+
+    DM_TEST_FINISH;
+    free(bulk);
+    free(per_instance);
+}
+
+#undef BULK_OBJECT_DEF
+#undef BULK_INSTANCES
+
 static int assert_null_notify_perform(anjay_t *anjay,
                                       anjay_notify_queue_t queue) {
     (void) anjay;
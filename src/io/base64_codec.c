@@ -0,0 +1,455 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <config.h>
+
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "base64_codec.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+/*
+ * The SIMD variants are selected at compile time, based on the instruction
+ * sets enabled for the target (e.g. -mssse3, -mavx2, or AArch64 which always
+ * has NEON). The scalar code is used for the remainder of each call and on
+ * all other targets.
+ */
+
+#define BASE64_INVALID_CHAR 0xFF
+
+static const char BASE64_ALPHABET[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// maps characters to 6-bit values; padding is handled separately
+static const uint8_t BASE64_DECODE_TABLE[256] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0x3E, 0xFF, 0xFF, 0xFF, 0x3F,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B,
+    0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+    0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+    0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16,
+    0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20,
+    0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30,
+    0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+static void encode_groups_scalar(char *out,
+                                 const uint8_t *in,
+                                 size_t num_groups) {
+    for (; num_groups; --num_groups, in += 3, out += 4) {
+        const uint32_t group = ((uint32_t) in[0] << 16)
+                               | ((uint32_t) in[1] << 8)
+                               | (uint32_t) in[2];
+        out[0] = BASE64_ALPHABET[(group >> 18) & 0x3F];
+        out[1] = BASE64_ALPHABET[(group >> 12) & 0x3F];
+        out[2] = BASE64_ALPHABET[(group >> 6) & 0x3F];
+        out[3] = BASE64_ALPHABET[group & 0x3F];
+    }
+}
+
+static int decode_groups_scalar(uint8_t *out,
+                                const char *in,
+                                size_t num_groups) {
+    for (; num_groups; --num_groups, in += 4, out += 3) {
+        const uint8_t a = BASE64_DECODE_TABLE[(uint8_t) in[0]];
+        const uint8_t b = BASE64_DECODE_TABLE[(uint8_t) in[1]];
+        const uint8_t c = BASE64_DECODE_TABLE[(uint8_t) in[2]];
+        const uint8_t d = BASE64_DECODE_TABLE[(uint8_t) in[3]];
+        // valid values are 6-bit, BASE64_INVALID_CHAR has the top bits set
+        if ((a | b | c | d) & 0xC0) {
+            return -1;
+        }
+        out[0] = (uint8_t) ((a << 2) | (b >> 4));
+        out[1] = (uint8_t) ((b << 4) | (c >> 2));
+        out[2] = (uint8_t) ((c << 6) | d);
+    }
+    return 0;
+}
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+
+/*
+ * x86 variants, after the well-known PSHUFB-based algorithms by Wojciech Mula
+ * and Alfred Klomp. Each 128-bit lane converts 12 bytes into 16 characters
+ * and vice versa.
+ */
+
+/* splits each 3-byte group into four 6-bit values, one per byte */
+#define SIMD_ENC_RESHUFFLE(Bits, Prefix, In)                                 \
+    Prefix##_or_si##Bits(                                                    \
+            Prefix##_mulhi_epu16(                                            \
+                    Prefix##_and_si##Bits((In),                              \
+                                          Prefix##_set1_epi32(0x0FC0FC00)),  \
+                    Prefix##_set1_epi32(0x04000040)),                        \
+            Prefix##_mullo_epi16(                                            \
+                    Prefix##_and_si##Bits((In),                              \
+                                          Prefix##_set1_epi32(0x003F03F0)),  \
+                    Prefix##_set1_epi32(0x01000010)))
+
+static inline __m128i sse_enc_translate(__m128i in) {
+    // offsets to add to 6-bit values 0-25, 26-51, 52-61, 62 and 63
+    const __m128i lut = _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4,
+                                      -4, -4, -4, -4, -19, -16, 0, 0);
+    __m128i indices = _mm_subs_epu8(in, _mm_set1_epi8(51));
+    indices = _mm_sub_epi8(indices, _mm_cmpgt_epi8(in, _mm_set1_epi8(25)));
+    return _mm_add_epi8(in, _mm_shuffle_epi8(lut, indices));
+}
+
+static inline __m128i sse_enc_split(__m128i in) {
+    in = _mm_shuffle_epi8(in, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4,
+                                            7, 6, 8, 7, 10, 9, 11, 10));
+    return SIMD_ENC_RESHUFFLE(128, _mm, in);
+}
+
+/* returns false if any of the characters is invalid */
+static inline bool sse_dec_translate(__m128i *inout) {
+    const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11,
+                                         0x11, 0x11, 0x11, 0x11,
+                                         0x11, 0x11, 0x13, 0x1A,
+                                         0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02,
+                                         0x04, 0x08, 0x04, 0x08,
+                                         0x10, 0x10, 0x10, 0x10,
+                                         0x10, 0x10, 0x10, 0x10);
+    const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                           0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask_2f = _mm_set1_epi8(0x2F);
+    const __m128i hi_nibbles =
+            _mm_and_si128(_mm_srli_epi32(*inout, 4), mask_2f);
+    const __m128i lo_nibbles = _mm_and_si128(*inout, mask_2f);
+    const __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+    const __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi),
+                                         _mm_setzero_si128()))
+            != 0xFFFF) {
+        return false;
+    }
+    const __m128i roll = _mm_shuffle_epi8(
+            lut_roll,
+            _mm_add_epi8(_mm_cmpeq_epi8(*inout, mask_2f), hi_nibbles));
+    *inout = _mm_add_epi8(*inout, roll);
+    return true;
+}
+
+/* packs four 6-bit values into 3 bytes; the last 4 bytes are zeroed */
+static inline __m128i sse_dec_merge(__m128i in) {
+    const __m128i merged_ab_bc =
+            _mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140));
+    const __m128i merged = _mm_madd_epi16(merged_ab_bc,
+                                          _mm_set1_epi32(0x00011000));
+    return _mm_shuffle_epi8(merged,
+                            _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8,
+                                          14, 13, 12, -1, -1, -1, -1));
+}
+
+#endif // defined(__AVX2__) || defined(__SSSE3__)
+
+#if defined(__AVX2__)
+
+static inline __m256i avx2_enc_translate(__m256i in) {
+    const __m256i lut = _mm256_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4,
+                                         -4, -4, -4, -4, -19, -16, 0, 0,
+                                         65, 71, -4, -4, -4, -4, -4, -4,
+                                         -4, -4, -4, -4, -19, -16, 0, 0);
+    __m256i indices = _mm256_subs_epu8(in, _mm256_set1_epi8(51));
+    indices = _mm256_sub_epi8(indices,
+                              _mm256_cmpgt_epi8(in, _mm256_set1_epi8(25)));
+    return _mm256_add_epi8(in, _mm256_shuffle_epi8(lut, indices));
+}
+
+static size_t encode_groups_simd(char *out,
+                                 const uint8_t *in,
+                                 size_t num_groups) {
+    const __m256i split = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4,
+                                           7, 6, 8, 7, 10, 9, 11, 10,
+                                           1, 0, 2, 1, 4, 3, 5, 4,
+                                           7, 6, 8, 7, 10, 9, 11, 10);
+    size_t groups_done = 0;
+    // each iteration consumes 8 groups, but loads 28 bytes
+    while (num_groups - groups_done >= 10) {
+        __m256i data = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(
+                        _mm_loadu_si128((const __m128i *) in)),
+                _mm_loadu_si128((const __m128i *) (in + 12)), 1);
+        data = _mm256_shuffle_epi8(data, split);
+        data = avx2_enc_translate(SIMD_ENC_RESHUFFLE(256, _mm256, data));
+        _mm256_storeu_si256((__m256i *) out, data);
+        in += 24;
+        out += 32;
+        groups_done += 8;
+    }
+    return groups_done;
+}
+
+static size_t decode_groups_simd(uint8_t *out,
+                                 const char *in,
+                                 size_t num_groups,
+                                 bool *out_invalid) {
+    size_t groups_done = 0;
+    // each iteration consumes 8 groups, but stores 28 bytes
+    while (num_groups - groups_done >= 10) {
+        __m128i lo = _mm_loadu_si128((const __m128i *) in);
+        __m128i hi = _mm_loadu_si128((const __m128i *) (in + 16));
+        if (!sse_dec_translate(&lo) || !sse_dec_translate(&hi)) {
+            *out_invalid = true;
+            break;
+        }
+        _mm_storeu_si128((__m128i *) out, sse_dec_merge(lo));
+        _mm_storeu_si128((__m128i *) (out + 12), sse_dec_merge(hi));
+        in += 32;
+        out += 24;
+        groups_done += 8;
+    }
+    return groups_done;
+}
+
+#elif defined(__SSSE3__)
+
+static size_t encode_groups_simd(char *out,
+                                 const uint8_t *in,
+                                 size_t num_groups) {
+    size_t groups_done = 0;
+    // each iteration consumes 4 groups, but loads 16 bytes
+    while (num_groups - groups_done >= 6) {
+        __m128i data = _mm_loadu_si128((const __m128i *) in);
+        data = sse_enc_translate(sse_enc_split(data));
+        _mm_storeu_si128((__m128i *) out, data);
+        in += 12;
+        out += 16;
+        groups_done += 4;
+    }
+    return groups_done;
+}
+
+static size_t decode_groups_simd(uint8_t *out,
+                                 const char *in,
+                                 size_t num_groups,
+                                 bool *out_invalid) {
+    size_t groups_done = 0;
+    // each iteration consumes 4 groups, but stores 16 bytes
+    while (num_groups - groups_done >= 6) {
+        __m128i data = _mm_loadu_si128((const __m128i *) in);
+        if (!sse_dec_translate(&data)) {
+            *out_invalid = true;
+            break;
+        }
+        _mm_storeu_si128((__m128i *) out, sse_dec_merge(data));
+        in += 16;
+        out += 12;
+        groups_done += 4;
+    }
+    return groups_done;
+}
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+static size_t encode_groups_simd(char *out,
+                                 const uint8_t *in,
+                                 size_t num_groups) {
+    const uint8x16x4_t alphabet = {
+        {
+            vld1q_u8((const uint8_t *) BASE64_ALPHABET),
+            vld1q_u8((const uint8_t *) BASE64_ALPHABET + 16),
+            vld1q_u8((const uint8_t *) BASE64_ALPHABET + 32),
+            vld1q_u8((const uint8_t *) BASE64_ALPHABET + 48)
+        }
+    };
+    const uint8x16_t mask = vdupq_n_u8(0x3F);
+    size_t groups_done = 0;
+    while (num_groups - groups_done >= 16) {
+        const uint8x16x3_t data = vld3q_u8(in);
+        uint8x16x4_t result;
+        result.val[0] = vshrq_n_u8(data.val[0], 2);
+        result.val[1] = vandq_u8(vorrq_u8(vshrq_n_u8(data.val[1], 4),
+                                          vshlq_n_u8(data.val[0], 4)),
+                                 mask);
+        result.val[2] = vandq_u8(vorrq_u8(vshrq_n_u8(data.val[2], 6),
+                                          vshlq_n_u8(data.val[1], 2)),
+                                 mask);
+        result.val[3] = vandq_u8(data.val[2], mask);
+        for (size_t i = 0; i < 4; ++i) {
+            result.val[i] = vqtbl4q_u8(alphabet, result.val[i]);
+        }
+        vst4q_u8((uint8_t *) out, result);
+        in += 48;
+        out += 64;
+        groups_done += 16;
+    }
+    return groups_done;
+}
+
+static size_t decode_groups_simd(uint8_t *out,
+                                 const char *in,
+                                 size_t num_groups,
+                                 bool *out_invalid) {
+    const uint8x16x4_t table_lo = {
+        {
+            vld1q_u8(BASE64_DECODE_TABLE),
+            vld1q_u8(BASE64_DECODE_TABLE + 16),
+            vld1q_u8(BASE64_DECODE_TABLE + 32),
+            vld1q_u8(BASE64_DECODE_TABLE + 48)
+        }
+    };
+    const uint8x16x4_t table_hi = {
+        {
+            vld1q_u8(BASE64_DECODE_TABLE + 64),
+            vld1q_u8(BASE64_DECODE_TABLE + 80),
+            vld1q_u8(BASE64_DECODE_TABLE + 96),
+            vld1q_u8(BASE64_DECODE_TABLE + 112)
+        }
+    };
+    const uint8x16_t offset = vdupq_n_u8(64);
+    size_t groups_done = 0;
+    while (num_groups - groups_done >= 16) {
+        uint8x16x4_t data = vld4q_u8((const uint8_t *) in);
+        uint8x16_t invalid = vdupq_n_u8(0);
+        for (size_t i = 0; i < 4; ++i) {
+            // out-of-range indices yield 0, so at most one lookup matches;
+            // characters >= 128 miss both tables and are flagged separately
+            const uint8x16_t chars = data.val[i];
+            data.val[i] = vorrq_u8(
+                    vqtbl4q_u8(table_lo, chars),
+                    vqtbl4q_u8(table_hi, vsubq_u8(chars, offset)));
+            invalid = vorrq_u8(invalid,
+                               vorrq_u8(data.val[i],
+                                        vcgeq_u8(chars,
+                                                 vdupq_n_u8(128))));
+        }
+        if (vmaxvq_u8(invalid) > 0x3F) {
+            *out_invalid = true;
+            break;
+        }
+        uint8x16x3_t result;
+        result.val[0] = vorrq_u8(vshlq_n_u8(data.val[0], 2),
+                                 vshrq_n_u8(data.val[1], 4));
+        result.val[1] = vorrq_u8(vshlq_n_u8(data.val[1], 4),
+                                 vshrq_n_u8(data.val[2], 2));
+        result.val[2] = vorrq_u8(vshlq_n_u8(data.val[2], 6), data.val[3]);
+        vst3q_u8(out, result);
+        in += 64;
+        out += 48;
+        groups_done += 16;
+    }
+    return groups_done;
+}
+
+#else // no SIMD
+
+static size_t encode_groups_simd(char *out,
+                                 const uint8_t *in,
+                                 size_t num_groups) {
+    (void) out;
+    (void) in;
+    (void) num_groups;
+    return 0;
+}
+
+static size_t decode_groups_simd(uint8_t *out,
+                                 const char *in,
+                                 size_t num_groups,
+                                 bool *out_invalid) {
+    (void) out;
+    (void) in;
+    (void) num_groups;
+    (void) out_invalid;
+    return 0;
+}
+
+#endif
+
+void _anjay_base64_encode_groups(char *out,
+                                 const uint8_t *in,
+                                 size_t num_groups) {
+    const size_t groups_done = encode_groups_simd(out, in, num_groups);
+    encode_groups_scalar(out + 4 * groups_done, in + 3 * groups_done,
+                         num_groups - groups_done);
+}
+
+int _anjay_base64_decode_groups(uint8_t *out,
+                                const char *in,
+                                size_t num_groups) {
+    bool invalid = false;
+    const size_t groups_done =
+            decode_groups_simd(out, in, num_groups, &invalid);
+    if (invalid) {
+        return -1;
+    }
+    return decode_groups_scalar(out + 3 * groups_done, in + 4 * groups_done,
+                                num_groups - groups_done);
+}
+
+int _anjay_base64_decode_group(uint8_t *out,
+                               const char *in,
+                               bool is_last_group) {
+    size_t num_padding = 0;
+    if (is_last_group && in[3] == '=') {
+        num_padding = (in[2] == '=') ? 2 : 1;
+    }
+    uint32_t group = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        uint8_t value = 0;
+        if (i < 4 - num_padding
+                && (value = BASE64_DECODE_TABLE[(uint8_t) in[i]])
+                        == BASE64_INVALID_CHAR) {
+            return -1;
+        }
+        group = (group << 6) | value;
+    }
+    // bits that are not part of any decoded byte must be zero, otherwise
+    // several encodings would map to the same data
+    if (group & ((UINT32_C(1) << (8 * num_padding)) - 1)) {
+        return -1;
+    }
+    out[0] = (uint8_t) (group >> 16);
+    out[1] = (uint8_t) (group >> 8);
+    out[2] = (uint8_t) group;
+    return (int) (3 - num_padding);
+}
+
+#ifdef ANJAY_TEST
+#include "test/base64_codec.c"
+#endif // ANJAY_TEST
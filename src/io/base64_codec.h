@@ -0,0 +1,63 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef ANJAY_IO_BASE64_CODEC_H
+#define ANJAY_IO_BASE64_CODEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../utils_core.h"
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/**
+ * Encodes @p num_groups complete 3-byte groups from @p in into exactly
+ * 4 * @p num_groups characters at @p out, using the standard (RFC 4648,
+ * section 4) alphabet. Uses SIMD instructions if the target supports them.
+ */
+void _anjay_base64_encode_groups(char *out,
+                                 const uint8_t *in,
+                                 size_t num_groups);
+
+/**
+ * Decodes @p num_groups complete 4-character groups without padding from
+ * @p in into exactly 3 * @p num_groups bytes at @p out. Uses SIMD
+ * instructions if the target supports them.
+ *
+ * @returns 0 on success, -1 if any of the characters is invalid. Contents of
+ *          @p out are unspecified in the latter case.
+ */
+int _anjay_base64_decode_groups(uint8_t *out,
+                                const char *in,
+                                size_t num_groups);
+
+/**
+ * Decodes a single 4-character group into @p out. Padding characters are
+ * accepted only if @p is_last_group is true, and the bits they replace must
+ * be zero.
+ *
+ * @returns number of decoded bytes (1-3), or -1 if the group is invalid.
+ */
+int _anjay_base64_decode_group(uint8_t *out,
+                               const char *in,
+                               bool is_last_group);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_IO_BASE64_CODEC_H */
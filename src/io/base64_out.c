@@ -15,12 +15,17 @@
  */
 
 #include <config.h>
+
+#include <assert.h>
+#include <string.h>
+
 #include <avsystem/commons/stream.h>
-#include <avsystem/commons/base64.h>
+#include <avsystem/commons/utils.h>
 
 #include <anjay/core.h>
 
 #include "../utils_core.h"
+#include "base64_codec.h"
 #include "base64_out.h"
 #include "vtable.h"
 
@@ -29,55 +34,54 @@ VISIBILITY_SOURCE_BEGIN
 typedef struct base64_ret_bytes_ctx {
     const anjay_ret_bytes_ctx_vtable_t *vtable;
     avs_stream_abstract_t *stream;
-    uint8_t bytes_cached[2];
+    /* bytes of an incomplete 3-byte group, carried over between appends */
+    uint8_t bytes_cached[3];
     size_t num_bytes_cached;
     size_t num_bytes_left;
 } base64_ret_bytes_ctx_t;
 
-#define TEXT_CHUNK_SIZE 3 * 64u
-AVS_STATIC_ASSERT(TEXT_CHUNK_SIZE % 3 == 0, chunk_must_be_a_multiple_of_3);
+/* Number of 3-byte groups encoded into a single avs_stream_write() call */
+#define BASE64_GROUPS_PER_WRITE 64u
 
-static int base64_ret_encode_and_write(base64_ret_bytes_ctx_t *ctx,
-                                       const uint8_t *buffer,
-                                       const size_t buffer_size) {
-    if (!buffer_size) {
-        return 0;
-    }
-    size_t encoded_size = avs_base64_encoded_size(buffer_size);
-    assert(encoded_size <= 4 * (TEXT_CHUNK_SIZE / 3) + 1);
-    char encoded[encoded_size];
-    int retval = avs_base64_encode(encoded, sizeof(encoded), buffer, buffer_size);
-    if (retval) {
-        return retval;
-    }
-    return avs_stream_write(ctx->stream, encoded, sizeof(encoded) - 1);
-}
-
-static int base64_ret_bytes_flush(base64_ret_bytes_ctx_t *ctx,
-                                  const uint8_t **dataptr,
-                                  size_t bytes_to_write) {
-    uint8_t chunk[TEXT_CHUNK_SIZE];
-    while (bytes_to_write > 0) {
-        memcpy(chunk, ctx->bytes_cached, ctx->num_bytes_cached);
-        size_t new_bytes_written =
-                AVS_MIN(TEXT_CHUNK_SIZE - ctx->num_bytes_cached,
-                          bytes_to_write);
-        assert(new_bytes_written <= TEXT_CHUNK_SIZE);
-        memcpy(&chunk[ctx->num_bytes_cached], *dataptr, new_bytes_written);
-        *dataptr += new_bytes_written;
-
-        int retval;
-        if ((retval = base64_ret_encode_and_write(
-                     ctx, chunk, new_bytes_written + ctx->num_bytes_cached))) {
+/**
+ * Encodes @p num_groups complete 3-byte groups, reading them directly from
+ * @p data, without any intermediate copies of the input.
+ */
+static int encode_and_write_groups(base64_ret_bytes_ctx_t *ctx,
+                                   const uint8_t *data,
+                                   size_t num_groups) {
+    char encoded[4 * BASE64_GROUPS_PER_WRITE];
+    while (num_groups) {
+        const size_t groups_to_write = AVS_MIN(num_groups,
+                                               BASE64_GROUPS_PER_WRITE);
+        _anjay_base64_encode_groups(encoded, data, groups_to_write);
+        int retval = avs_stream_write(ctx->stream, encoded,
+                                      4 * groups_to_write);
+        if (retval) {
             return retval;
         }
-        bytes_to_write -= new_bytes_written;
-        ctx->num_bytes_left -= new_bytes_written;
-        ctx->num_bytes_cached = 0;
+        data += 3 * groups_to_write;
+        num_groups -= groups_to_write;
     }
     return 0;
 }
 
+static int encode_and_write_final_group(base64_ret_bytes_ctx_t *ctx) {
+    assert(ctx->num_bytes_cached < 3);
+    if (!ctx->num_bytes_cached) {
+        return 0;
+    }
+    uint8_t group[3] = { 0 };
+    memcpy(group, ctx->bytes_cached, ctx->num_bytes_cached);
+    char encoded[4];
+    _anjay_base64_encode_groups(encoded, group, 1);
+    encoded[3] = '=';
+    if (ctx->num_bytes_cached == 1) {
+        encoded[2] = '=';
+    }
+    return avs_stream_write(ctx->stream, encoded, sizeof(encoded));
+}
+
 static int base64_ret_bytes_append(anjay_ret_bytes_ctx_t *ctx_,
                                    const void *data,
                                    size_t size) {
@@ -85,24 +89,34 @@ static int base64_ret_bytes_append(anjay_ret_bytes_ctx_t *ctx_,
     if (size > ctx->num_bytes_left) {
         return -1;
     }
+    ctx->num_bytes_left -= size;
+
     const uint8_t *dataptr = (const uint8_t *) data;
-    size_t bytes_to_store;
-    if (size + ctx->num_bytes_cached < 3) {
-        bytes_to_store = size;
-    } else {
-        bytes_to_store = (ctx->num_bytes_cached + size) % 3;
+    if (ctx->num_bytes_cached) {
+        const size_t bytes_to_cache = AVS_MIN(size,
+                                              3 - ctx->num_bytes_cached);
+        memcpy(&ctx->bytes_cached[ctx->num_bytes_cached], dataptr,
+               bytes_to_cache);
+        ctx->num_bytes_cached += bytes_to_cache;
+        dataptr += bytes_to_cache;
+        size -= bytes_to_cache;
+        if (ctx->num_bytes_cached < 3) {
+            return 0;
+        }
+        int retval = encode_and_write_groups(ctx, ctx->bytes_cached, 1);
+        if (retval) {
+            return retval;
+        }
+        ctx->num_bytes_cached = 0;
     }
-    assert(bytes_to_store <= 2);
 
-    int retval = base64_ret_bytes_flush(ctx, &dataptr, size - bytes_to_store);
+    int retval = encode_and_write_groups(ctx, dataptr, size / 3);
     if (retval) {
         return retval;
     }
-    assert(ctx->num_bytes_cached + bytes_to_store
-               <= sizeof(ctx->bytes_cached));
-    memcpy(&ctx->bytes_cached[ctx->num_bytes_cached], dataptr, bytes_to_store);
-    ctx->num_bytes_cached += bytes_to_store;
-    ctx->num_bytes_left -= bytes_to_store;
+    ctx->num_bytes_cached = size % 3;
+    memcpy(ctx->bytes_cached, &dataptr[size - ctx->num_bytes_cached],
+           ctx->num_bytes_cached);
     return 0;
 }
 
@@ -130,8 +144,7 @@ int _anjay_base64_ret_bytes_ctx_close(anjay_ret_bytes_ctx_t *ctx_) {
         /* Some bytes were not written as we have expected */
         return -1;
     }
-    return base64_ret_encode_and_write(ctx, ctx->bytes_cached,
-                                       ctx->num_bytes_cached);
+    return encode_and_write_final_group(ctx);
 }
 
 void
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_IO_CBOR_H
+#define ANJAY_IO_CBOR_H
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/* RFC 7049, section 2.1 - Major Types */
+typedef enum {
+    CBOR_MAJOR_TYPE_UINT = 0,
+    CBOR_MAJOR_TYPE_NEGATIVE_INT = 1,
+    CBOR_MAJOR_TYPE_BYTE_STRING = 2,
+    CBOR_MAJOR_TYPE_TEXT_STRING = 3,
+    CBOR_MAJOR_TYPE_ARRAY = 4,
+    CBOR_MAJOR_TYPE_MAP = 5,
+    CBOR_MAJOR_TYPE_TAG = 6,
+    CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE = 7
+} cbor_major_type_t;
+
+/* Additional information values with special meaning */
+#define CBOR_EXT_LENGTH_1BYTE 24
+#define CBOR_EXT_LENGTH_2BYTE 25
+#define CBOR_EXT_LENGTH_4BYTE 26
+#define CBOR_EXT_LENGTH_8BYTE 27
+#define CBOR_INDEFINITE_LENGTH 31
+
+#define CBOR_VALUE_FALSE 20
+#define CBOR_VALUE_TRUE 21
+#define CBOR_VALUE_NULL 22
+#define CBOR_VALUE_UNDEFINED 23
+#define CBOR_VALUE_FLOAT_16 CBOR_EXT_LENGTH_2BYTE
+#define CBOR_VALUE_FLOAT_32 CBOR_EXT_LENGTH_4BYTE
+#define CBOR_VALUE_FLOAT_64 CBOR_EXT_LENGTH_8BYTE
+
+#define CBOR_INITIAL_BYTE(MajorType, AdditionalInfo) \
+    ((uint8_t) (((MajorType) << 5) | (AdditionalInfo)))
+
+#define CBOR_INDEFINITE_ARRAY \
+    CBOR_INITIAL_BYTE(CBOR_MAJOR_TYPE_ARRAY, CBOR_INDEFINITE_LENGTH)
+#define CBOR_BREAK \
+    CBOR_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE, CBOR_INDEFINITE_LENGTH)
+
+/* Longest possible encoding of a data item header: initial byte + uint64 */
+#define CBOR_MAX_HEADER_SIZE 9
+
+/* RFC 8428, section 6 - SenML labels, as used in the CBOR representation */
+#define SENML_LABEL_BASE_NAME (-2)
+#define SENML_LABEL_BASE_TIME (-3)
+#define SENML_LABEL_BASE_UNIT (-4)
+#define SENML_LABEL_BASE_VALUE (-5)
+#define SENML_LABEL_BASE_SUM (-6)
+#define SENML_LABEL_NAME 0
+#define SENML_LABEL_UNIT 1
+#define SENML_LABEL_VALUE 2
+#define SENML_LABEL_STRING_VALUE 3
+#define SENML_LABEL_BOOLEAN_VALUE 4
+#define SENML_LABEL_SUM 5
+#define SENML_LABEL_TIME 6
+#define SENML_LABEL_UPDATE_TIME 7
+#define SENML_LABEL_DATA_VALUE 8
+
+/* LwM2M 1.1 extension for Object Link values; always a text string label */
+#define SENML_EXT_OBJLNK_LABEL "vlo"
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_IO_CBOR_H */
@@ -80,6 +80,19 @@ static anjay_output_ctx_t *spawn_json(dynamic_out_t *ctx) {
 }
 #endif
 
+#ifdef WITH_SENML_CBOR
+static anjay_output_ctx_t *spawn_senml_cbor(dynamic_out_t *ctx) {
+    anjay_output_ctx_t *result =
+            _anjay_output_senml_cbor_create(ctx->stream, ctx->errno_ptr,
+                                            &ctx->details, &ctx->uri);
+    if (result && ctx->id >= 0
+            && _anjay_output_set_id(result, ctx->id_type, (uint16_t) ctx->id)) {
+        _anjay_output_ctx_destroy(&result);
+    }
+    return result;
+}
+#endif
+
 static anjay_output_ctx_t *spawn_backend(dynamic_out_t *ctx, uint16_t format) {
     switch (_anjay_translate_legacy_content_format(format)) {
     case ANJAY_COAP_FORMAT_OPAQUE:
@@ -91,6 +104,10 @@ static anjay_output_ctx_t *spawn_backend(dynamic_out_t *ctx, uint16_t format) {
 #ifdef WITH_JSON
     case ANJAY_COAP_FORMAT_JSON:
         return spawn_json(ctx);
+#endif
+#ifdef WITH_SENML_CBOR
+    case ANJAY_COAP_FORMAT_SENML_CBOR:
+        return spawn_senml_cbor(ctx);
 #endif
     default:
         anjay_log(ERROR, "Unsupported output format: %" PRIu16, format);
@@ -319,6 +336,16 @@ int _anjay_input_dynamic_create(anjay_input_ctx_t **out,
         return _anjay_input_tlv_create(out, stream_ptr, autoclose);
     case ANJAY_COAP_FORMAT_OPAQUE:
         return _anjay_input_opaque_create(out, stream_ptr, autoclose);
+#ifdef WITH_JSON
+    case ANJAY_COAP_FORMAT_JSON:
+        return _anjay_input_json_create(out, stream_ptr, autoclose);
+    case ANJAY_COAP_FORMAT_SENML_JSON:
+        return _anjay_input_senml_json_create(out, stream_ptr, autoclose);
+#endif
+#ifdef WITH_SENML_CBOR
+    case ANJAY_COAP_FORMAT_SENML_CBOR:
+        return _anjay_input_senml_cbor_create(out, stream_ptr, autoclose);
+#endif
     default:
         return ANJAY_ERR_BAD_REQUEST;
     }
@@ -0,0 +1,971 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <avsystem/commons/log.h>
+#include <avsystem/commons/stream.h>
+#include <avsystem/commons/utils.h>
+
+#include "../io_core.h"
+#include "../utils_core.h"
+#include "senml_in.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+/*
+ * Incremental parser for LwM2M JSON (application/vnd.oma.lwm2m+json) and
+ * SenML JSON (application/senml+json) payloads. The payload is read from the
+ * stream in small chunks, so Block1 transfers are decoded as the blocks arrive
+ * and only a single record is ever kept in memory. Nesting is tracked
+ * explicitly instead of through recursion, so that malicious payloads cannot
+ * exhaust the stack.
+ */
+
+#define json_log(level, ...) avs_log(json_in, level, __VA_ARGS__)
+
+/* Long enough for a basename or name of any valid LwM2M path */
+#define MAX_NAME_SIZE sizeof("/65535/65535/65535/65535")
+
+/* Long enough for any of the keys we are interested in */
+#define MAX_KEY_SIZE sizeof("vlo")
+
+/* Long enough for any sensible textual representation of a number */
+#define MAX_NUMBER_SIZE 64
+
+/* Maximum nesting level of values that are skipped over */
+#define MAX_SKIP_DEPTH 32
+
+#define JSON_EOF (-1)
+
+typedef enum {
+    JSON_FORMAT_LWM2M,
+    JSON_FORMAT_SENML
+} json_format_t;
+
+typedef enum {
+    /* nothing has been parsed yet */
+    JSON_STATE_INITIAL,
+    /* inside the array of records, before the first record */
+    JSON_STATE_FIRST_RECORD,
+    /* inside the array of records, after at least one record */
+    JSON_STATE_NEXT_RECORD,
+    /* the whole payload has been parsed */
+    JSON_STATE_FINISHED
+} json_state_t;
+
+typedef struct {
+    const anjay_senml_decoder_vtable_t *vtable;
+    avs_stream_abstract_t *stream;
+    bool autoclose;
+    json_format_t format;
+    json_state_t state;
+    /* LwM2M JSON only: true if the "e" array has already been parsed */
+    bool records_parsed;
+
+    /* chunk of the payload that is currently being parsed */
+    char chunk[64];
+    size_t chunk_pos;
+    size_t chunk_size;
+    bool stream_finished;
+
+    /* basename persists between records */
+    char basename[MAX_NAME_SIZE];
+    size_t basename_size;
+    /* LwM2M JSON only: basename is derived from the request path, i.e. the
+     * payload has not specified "bn" (yet) */
+    bool basename_implicit;
+
+    char *value_buf;
+    size_t value_buf_capacity;
+    char *bytes_buf;
+    size_t bytes_buf_capacity;
+} json_decoder_t;
+
+typedef struct {
+    char *data;
+    size_t size;
+    size_t capacity;
+    /* if true, data is dec->value_buf and is reallocated as necessary;
+     * otherwise, characters that do not fit are discarded */
+    bool growable;
+    bool truncated;
+} json_string_t;
+
+typedef enum {
+    LABEL_OTHER,
+    LABEL_UNSUPPORTED,
+    LABEL_BASE_NAME,
+    LABEL_NAME,
+    LABEL_VALUE,
+    LABEL_STRING_VALUE,
+    LABEL_BOOLEAN_VALUE,
+    LABEL_DATA_VALUE,
+    LABEL_OBJLNK_VALUE,
+    LABEL_RECORDS
+} label_t;
+
+typedef struct {
+    const char *key;
+    label_t label;
+} label_def_t;
+
+static const label_def_t SENML_RECORD_LABELS[] = {
+    { "bn", LABEL_BASE_NAME },
+    { "n", LABEL_NAME },
+    { "v", LABEL_VALUE },
+    { "vs", LABEL_STRING_VALUE },
+    { "vb", LABEL_BOOLEAN_VALUE },
+    { "vd", LABEL_DATA_VALUE },
+    { "vlo", LABEL_OBJLNK_VALUE },
+    { "bv", LABEL_UNSUPPORTED },
+    { "bs", LABEL_UNSUPPORTED },
+    { "s", LABEL_UNSUPPORTED },
+    { NULL, LABEL_OTHER }
+};
+
+static const label_def_t LWM2M_JSON_RECORD_LABELS[] = {
+    { "n", LABEL_NAME },
+    { "v", LABEL_VALUE },
+    { "sv", LABEL_STRING_VALUE },
+    { "bv", LABEL_BOOLEAN_VALUE },
+    { "ov", LABEL_OBJLNK_VALUE },
+    { NULL, LABEL_OTHER }
+};
+
+static const label_def_t LWM2M_JSON_TOPLEVEL_LABELS[] = {
+    { "bn", LABEL_BASE_NAME },
+    { "e", LABEL_RECORDS },
+    { NULL, LABEL_OTHER }
+};
+
+static int bad_request(const char *msg) {
+    json_log(DEBUG, "%s", msg);
+    return ANJAY_ERR_BAD_REQUEST;
+}
+
+static int peek_char(json_decoder_t *dec, int *out_char) {
+    while (dec->chunk_pos == dec->chunk_size && !dec->stream_finished) {
+        char message_finished;
+        dec->chunk_pos = 0;
+        dec->chunk_size = 0;
+        int result = avs_stream_read(dec->stream, &dec->chunk_size,
+                                     &message_finished,
+                                     dec->chunk, sizeof(dec->chunk));
+        if (result) {
+            return result;
+        }
+        dec->stream_finished = !!message_finished;
+    }
+    *out_char = (dec->chunk_pos < dec->chunk_size)
+            ? (unsigned char) dec->chunk[dec->chunk_pos] : JSON_EOF;
+    return 0;
+}
+
+static int next_char(json_decoder_t *dec, int *out_char) {
+    int result = peek_char(dec, out_char);
+    if (result) {
+        return result;
+    }
+    if (*out_char == JSON_EOF) {
+        return bad_request("premature end of JSON payload");
+    }
+    ++dec->chunk_pos;
+    return 0;
+}
+
+static int peek_token(json_decoder_t *dec, int *out_char) {
+    int result;
+    while (!(result = peek_char(dec, out_char))
+            && (*out_char == ' ' || *out_char == '\t'
+                    || *out_char == '\n' || *out_char == '\r')) {
+        ++dec->chunk_pos;
+    }
+    return result;
+}
+
+static int expect_token(json_decoder_t *dec, char token) {
+    int ch;
+    int result = peek_token(dec, &ch);
+    if (result) {
+        return result;
+    }
+    if (ch != (unsigned char) token) {
+        json_log(DEBUG, "expected '%c' in JSON payload", token);
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    ++dec->chunk_pos;
+    return 0;
+}
+
+static int expect_end(json_decoder_t *dec) {
+    int ch;
+    int result = peek_token(dec, &ch);
+    if (!result && ch != JSON_EOF) {
+        result = bad_request("garbage after JSON payload");
+    }
+    return result;
+}
+
+static int append_to_string(json_decoder_t *dec,
+                            json_string_t *str,
+                            const char *data,
+                            size_t size) {
+    if (str->size + size > str->capacity && str->growable) {
+        size_t new_capacity = AVS_MAX(2 * str->capacity, str->size + size);
+        new_capacity = AVS_MAX(new_capacity, 64);
+        char *new_buf = (char *) realloc(dec->value_buf, new_capacity);
+        if (!new_buf) {
+            json_log(ERROR, "out of memory");
+            return -1;
+        }
+        str->data = dec->value_buf = new_buf;
+        str->capacity = dec->value_buf_capacity = new_capacity;
+    }
+    if (str->size + size > str->capacity) {
+        str->truncated = true;
+        size = str->capacity - str->size;
+    }
+    if (size) {
+        memcpy(str->data + str->size, data, size);
+        str->size += size;
+    }
+    return 0;
+}
+
+static int read_hex_quad(json_decoder_t *dec, uint32_t *out_value) {
+    *out_value = 0;
+    for (int i = 0; i < 4; ++i) {
+        int ch;
+        int result = next_char(dec, &ch);
+        if (result) {
+            return result;
+        }
+        uint32_t digit;
+        if (ch >= '0' && ch <= '9') {
+            digit = (uint32_t) (ch - '0');
+        } else if (ch >= 'a' && ch <= 'f') {
+            digit = (uint32_t) (ch - 'a' + 10);
+        } else if (ch >= 'A' && ch <= 'F') {
+            digit = (uint32_t) (ch - 'A' + 10);
+        } else {
+            return bad_request("invalid \\u escape sequence");
+        }
+        *out_value = (*out_value << 4) | digit;
+    }
+    return 0;
+}
+
+static int read_unicode_escape(json_decoder_t *dec, json_string_t *str) {
+    uint32_t code_point;
+    int result = read_hex_quad(dec, &code_point);
+    if (result) {
+        return result;
+    }
+    if (code_point >= 0xDC00 && code_point <= 0xDFFF) {
+        return bad_request("unpaired UTF-16 surrogate");
+    } else if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+        int backslash, u;
+        uint32_t low;
+        if ((result = next_char(dec, &backslash))
+                || (result = next_char(dec, &u))) {
+            return result;
+        }
+        if (backslash != '\\' || u != 'u') {
+            return bad_request("unpaired UTF-16 surrogate");
+        }
+        if ((result = read_hex_quad(dec, &low))) {
+            return result;
+        }
+        if (low < 0xDC00 || low > 0xDFFF) {
+            return bad_request("unpaired UTF-16 surrogate");
+        }
+        code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+    }
+
+    char utf8[4];
+    size_t utf8_size;
+    if (code_point < 0x80) {
+        utf8[0] = (char) code_point;
+        utf8_size = 1;
+    } else if (code_point < 0x800) {
+        utf8[0] = (char) (0xC0 | (code_point >> 6));
+        utf8[1] = (char) (0x80 | (code_point & 0x3F));
+        utf8_size = 2;
+    } else if (code_point < 0x10000) {
+        utf8[0] = (char) (0xE0 | (code_point >> 12));
+        utf8[1] = (char) (0x80 | ((code_point >> 6) & 0x3F));
+        utf8[2] = (char) (0x80 | (code_point & 0x3F));
+        utf8_size = 3;
+    } else {
+        utf8[0] = (char) (0xF0 | (code_point >> 18));
+        utf8[1] = (char) (0x80 | ((code_point >> 12) & 0x3F));
+        utf8[2] = (char) (0x80 | ((code_point >> 6) & 0x3F));
+        utf8[3] = (char) (0x80 | (code_point & 0x3F));
+        utf8_size = 4;
+    }
+    return append_to_string(dec, str, utf8, utf8_size);
+}
+
+static int read_escape(json_decoder_t *dec, json_string_t *str) {
+    int ch;
+    int result = next_char(dec, &ch);
+    if (result) {
+        return result;
+    }
+    char unescaped;
+    switch (ch) {
+    case '"':
+    case '\\':
+    case '/':
+        unescaped = (char) ch;
+        break;
+    case 'b':
+        unescaped = '\b';
+        break;
+    case 'f':
+        unescaped = '\f';
+        break;
+    case 'n':
+        unescaped = '\n';
+        break;
+    case 'r':
+        unescaped = '\r';
+        break;
+    case 't':
+        unescaped = '\t';
+        break;
+    case 'u':
+        return read_unicode_escape(dec, str);
+    default:
+        return bad_request("invalid escape sequence");
+    }
+    return append_to_string(dec, str, &unescaped, 1);
+}
+
+static int read_string(json_decoder_t *dec, json_string_t *str) {
+    int result = expect_token(dec, '"');
+    if (result) {
+        return result;
+    }
+    str->size = 0;
+    str->truncated = false;
+    while (true) {
+        int ch;
+        if ((result = peek_char(dec, &ch))) {
+            return result;
+        }
+        if (ch == JSON_EOF) {
+            return bad_request("unterminated JSON string");
+        }
+        /* copy all regular characters in the chunk in one go */
+        const char *start = &dec->chunk[dec->chunk_pos];
+        const char *const end = &dec->chunk[dec->chunk_size];
+        const char *ptr = start;
+        while (ptr < end && *ptr != '"' && *ptr != '\\'
+                && (unsigned char) *ptr >= 0x20) {
+            ++ptr;
+        }
+        if ((result = append_to_string(dec, str, start,
+                                       (size_t) (ptr - start)))) {
+            return result;
+        }
+        dec->chunk_pos += (size_t) (ptr - start);
+        if (ptr == end) {
+            continue;
+        }
+        ++dec->chunk_pos;
+        if (*ptr == '"') {
+            return 0;
+        } else if (*ptr != '\\') {
+            return bad_request("unescaped control character in JSON string");
+        } else if ((result = read_escape(dec, str))) {
+            return result;
+        }
+    }
+}
+
+static int read_literal(json_decoder_t *dec, const char *literal) {
+    int result = 0;
+    for (; *literal && !result; ++literal) {
+        int ch;
+        if (!(result = next_char(dec, &ch)) && ch != *literal) {
+            result = bad_request("invalid JSON literal");
+        }
+    }
+    return result;
+}
+
+static bool is_number_char(int ch) {
+    return (ch >= '0' && ch <= '9') || ch == '-' || ch == '+' || ch == '.'
+            || ch == 'e' || ch == 'E';
+}
+
+/**
+ * Reads a number into @p out_buf, which needs to be MAX_NUMBER_SIZE bytes
+ * long.
+ */
+static int read_number_token(json_decoder_t *dec,
+                             char *out_buf,
+                             bool *out_is_int) {
+    int ch;
+    int result = peek_token(dec, &ch);
+    if (result) {
+        return result;
+    }
+    if (ch != '-' && !(ch >= '0' && ch <= '9')) {
+        return bad_request("expected a number in JSON payload");
+    }
+    size_t size = 0;
+    *out_is_int = true;
+    while (!(result = peek_char(dec, &ch)) && is_number_char(ch)) {
+        if (size >= MAX_NUMBER_SIZE - 1) {
+            return bad_request("JSON number too long");
+        }
+        if (ch == '.' || ch == 'e' || ch == 'E') {
+            *out_is_int = false;
+        }
+        out_buf[size++] = (char) ch;
+        ++dec->chunk_pos;
+    }
+    out_buf[size] = '\0';
+    return result;
+}
+
+static int read_number(json_decoder_t *dec, anjay_senml_record_t *out_record) {
+    char buf[MAX_NUMBER_SIZE];
+    bool is_int;
+    int result = read_number_token(dec, buf, &is_int);
+    if (result) {
+        return result;
+    }
+    out_record->type = ANJAY_SENML_VALUE_NUMBER;
+    long long ll;
+    if (is_int && !_anjay_safe_strtoll(buf, &ll)) {
+        out_record->value.number.is_int = true;
+        out_record->value.number.i = (int64_t) ll;
+        out_record->value.number.d = (double) ll;
+        return 0;
+    }
+    /* integers that do not fit in int64_t are handled as doubles */
+    out_record->value.number.is_int = false;
+    if (_anjay_safe_strtod(buf, &out_record->value.number.d)) {
+        return bad_request("invalid JSON number");
+    }
+    return 0;
+}
+
+static int read_bool(json_decoder_t *dec, anjay_senml_record_t *out_record) {
+    int ch;
+    int result = peek_token(dec, &ch);
+    if (result) {
+        return result;
+    }
+    out_record->type = ANJAY_SENML_VALUE_BOOL;
+    out_record->value.boolean = (ch == 't');
+    return read_literal(dec, ch == 't' ? "true" : "false");
+}
+
+/**
+ * Skips over any JSON value. Nesting is tracked with a bit stack in which each
+ * set bit denotes an object and each cleared bit denotes an array.
+ */
+static int skip_value(json_decoder_t *dec) {
+    json_string_t discard = { NULL, 0, 0, false, false };
+    uint32_t nesting_stack = 0;
+    unsigned depth = 0;
+    int result;
+    do {
+        int ch;
+        if ((result = peek_token(dec, &ch))) {
+            return result;
+        }
+        switch (ch) {
+        case '{':
+        case '[':
+            if (depth >= MAX_SKIP_DEPTH) {
+                return bad_request("JSON value nested too deeply");
+            }
+            nesting_stack = (nesting_stack << 1) | (ch == '{');
+            ++depth;
+            ++dec->chunk_pos;
+            continue;
+        case '}':
+        case ']':
+            if (!depth || (nesting_stack & 1) != (ch == '}')) {
+                return bad_request("mismatched brackets in JSON payload");
+            }
+            nesting_stack >>= 1;
+            --depth;
+            ++dec->chunk_pos;
+            break;
+        case ',':
+        case ':':
+            if (!depth) {
+                return bad_request("unexpected separator in JSON payload");
+            }
+            ++dec->chunk_pos;
+            continue;
+        case '"':
+            result = read_string(dec, &discard);
+            break;
+        case 't':
+            result = read_literal(dec, "true");
+            break;
+        case 'f':
+            result = read_literal(dec, "false");
+            break;
+        case 'n':
+            result = read_literal(dec, "null");
+            break;
+        default: {
+            char buf[MAX_NUMBER_SIZE];
+            bool is_int;
+            result = read_number_token(dec, buf, &is_int);
+            break;
+        }
+        }
+        if (result) {
+            return result;
+        }
+    } while (depth);
+    return 0;
+}
+
+static int read_label(json_decoder_t *dec,
+                      const label_def_t *defs,
+                      label_t *out_label) {
+    char key[MAX_KEY_SIZE];
+    json_string_t str = { key, 0, sizeof(key), false, false };
+    int result;
+    if ((result = read_string(dec, &str))
+            || (result = expect_token(dec, ':'))) {
+        return result;
+    }
+    *out_label = LABEL_OTHER;
+    if (!str.truncated) {
+        for (; defs->key; ++defs) {
+            if (strlen(defs->key) == str.size
+                    && !memcmp(defs->key, key, str.size)) {
+                *out_label = defs->label;
+                break;
+            }
+        }
+    }
+    return 0;
+}
+
+static int read_name(json_decoder_t *dec, char *buf, size_t *out_size) {
+    json_string_t str = { buf, 0, MAX_NAME_SIZE - 1, false, false };
+    int result = read_string(dec, &str);
+    if (!result && str.truncated) {
+        result = bad_request("SenML name too long");
+    }
+    *out_size = str.size;
+    return result;
+}
+
+static int ensure_bytes_buf(json_decoder_t *dec, size_t size) {
+    if (size > dec->bytes_buf_capacity) {
+        char *new_buf = (char *) realloc(dec->bytes_buf, size);
+        if (!new_buf) {
+            json_log(ERROR, "out of memory");
+            return -1;
+        }
+        dec->bytes_buf = new_buf;
+        dec->bytes_buf_capacity = size;
+    }
+    return 0;
+}
+
+static int base64_digit(char ch) {
+    if (ch >= 'A' && ch <= 'Z') {
+        return ch - 'A';
+    } else if (ch >= 'a' && ch <= 'z') {
+        return ch - 'a' + 26;
+    } else if (ch >= '0' && ch <= '9') {
+        return ch - '0' + 52;
+    } else if (ch == '+' || ch == '-') {
+        return 62;
+    } else if (ch == '/' || ch == '_') {
+        return 63;
+    }
+    return -1;
+}
+
+/**
+ * Decodes base64 data into dec->bytes_buf. Both the standard and the URL-safe
+ * alphabet are accepted, and padding is optional, as SenML mandates the
+ * URL-safe alphabet without padding, but the standard one is used in practice.
+ *
+ * @returns 0 on success, ANJAY_ERR_BAD_REQUEST if @p data is not valid base64,
+ *          or -1 in case of memory allocation failure.
+ */
+static int decode_base64(json_decoder_t *dec,
+                         const char *data, size_t size,
+                         size_t *out_size) {
+    if (size % 4 == 0) {
+        for (int i = 0; i < 2 && size && data[size - 1] == '='; ++i) {
+            --size;
+        }
+    }
+    if (size % 4 == 1) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    *out_size = size / 4 * 3 + (size % 4 ? size % 4 - 1 : 0);
+    /* allocate at least one byte so that empty data is not NULL */
+    int result = ensure_bytes_buf(dec, AVS_MAX(*out_size, 1));
+    if (result) {
+        return result;
+    }
+    uint8_t *out = (uint8_t *) dec->bytes_buf;
+    uint32_t accumulator = 0;
+    size_t bits = 0;
+    for (size_t i = 0; i < size; ++i) {
+        int digit = base64_digit(data[i]);
+        if (digit < 0) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        accumulator = (accumulator << 6) | (uint32_t) digit;
+        if ((bits += 6) >= 8) {
+            bits -= 8;
+            *out++ = (uint8_t) (accumulator >> bits);
+        }
+    }
+    assert(out == (uint8_t *) dec->bytes_buf + *out_size);
+    return 0;
+}
+
+static int read_value_string(json_decoder_t *dec,
+                             anjay_senml_value_type_t type,
+                             anjay_senml_record_t *out_record) {
+    json_string_t str = {
+        dec->value_buf, 0, dec->value_buf_capacity, true, false
+    };
+    int result = read_string(dec, &str);
+    if (result) {
+        return result;
+    }
+    out_record->type = type;
+    out_record->data = str.data ? str.data : "";
+    out_record->data_size = str.size;
+    if (type == ANJAY_SENML_VALUE_BYTES) {
+        if ((result = decode_base64(dec, str.data, str.size,
+                                    &out_record->data_size))) {
+            return result == ANJAY_ERR_BAD_REQUEST
+                    ? bad_request("invalid base64 data in JSON payload")
+                    : result;
+        }
+        out_record->data = dec->bytes_buf;
+    } else if (type == ANJAY_SENML_VALUE_STRING
+            && dec->format == JSON_FORMAT_LWM2M) {
+        /* LwM2M JSON has no separate type for opaque data */
+        switch (decode_base64(dec, str.data, str.size,
+                              &out_record->bytes_data_size)) {
+        case 0:
+            out_record->bytes_data = dec->bytes_buf;
+            break;
+        case ANJAY_ERR_BAD_REQUEST:
+            break;
+        default:
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int read_record_value(json_decoder_t *dec,
+                             label_t label,
+                             anjay_senml_record_t *out_record) {
+    switch (label) {
+    case LABEL_VALUE:
+        return read_number(dec, out_record);
+    case LABEL_STRING_VALUE:
+        return read_value_string(dec, ANJAY_SENML_VALUE_STRING, out_record);
+    case LABEL_BOOLEAN_VALUE:
+        return read_bool(dec, out_record);
+    case LABEL_DATA_VALUE:
+        return read_value_string(dec, ANJAY_SENML_VALUE_BYTES, out_record);
+    default:
+        assert(label == LABEL_OBJLNK_VALUE);
+        return read_value_string(dec, ANJAY_SENML_VALUE_OBJLNK, out_record);
+    }
+}
+
+static int read_record(json_decoder_t *dec, anjay_senml_record_t *out_record) {
+    const label_def_t *const defs = (dec->format == JSON_FORMAT_SENML)
+            ? SENML_RECORD_LABELS : LWM2M_JSON_RECORD_LABELS;
+    char name[MAX_NAME_SIZE];
+    size_t name_size = 0;
+    bool has_value = false;
+    int result = expect_token(dec, '{');
+    int ch;
+    while (!result && !(result = peek_token(dec, &ch)) && ch != '}') {
+        label_t label;
+        if ((result = read_label(dec, defs, &label))) {
+            return result;
+        }
+        if (label == LABEL_OTHER) {
+            result = skip_value(dec);
+        } else if (label == LABEL_UNSUPPORTED) {
+            result = bad_request("unsupported SenML label");
+        } else if (label == LABEL_BASE_NAME) {
+            dec->basename_implicit = false;
+            result = read_name(dec, dec->basename, &dec->basename_size);
+        } else if (label == LABEL_NAME) {
+            result = read_name(dec, name, &name_size);
+        } else if (has_value) {
+            result = bad_request("more than one value in a SenML record");
+        } else {
+            has_value = true;
+            result = read_record_value(dec, label, out_record);
+        }
+        if (result || (result = peek_token(dec, &ch))) {
+            break;
+        }
+        if (ch == ',') {
+            ++dec->chunk_pos;
+            /* another member is mandatory after a comma */
+            if (!(result = peek_token(dec, &ch)) && ch != '"') {
+                result = bad_request("expected a key in JSON object");
+            }
+        } else if (ch != '}') {
+            result = bad_request("expected ',' or '}' in JSON object");
+        }
+    }
+    if (result) {
+        return result;
+    }
+    ++dec->chunk_pos;
+    if (!has_value) {
+        return bad_request("SenML record without a value");
+    }
+
+    const char *relative_name = name;
+    size_t relative_name_size = name_size;
+    if (dec->basename_implicit && name_size && name[0] == '/') {
+        /* the implicit basename ends with a slash already */
+        ++relative_name;
+        --relative_name_size;
+    }
+    char path[2 * MAX_NAME_SIZE];
+    memcpy(path, dec->basename, dec->basename_size);
+    memcpy(path + dec->basename_size, relative_name, relative_name_size);
+    result = _anjay_senml_parse_path(out_record, path,
+                                     dec->basename_size + relative_name_size);
+    if (result && dec->basename_implicit && name_size > dec->basename_size
+            && !memcmp(name, dec->basename, dec->basename_size)) {
+        /* the name is not valid relative to the request path, but it may be
+         * an absolute path within it */
+        result = _anjay_senml_parse_path(out_record, name, name_size);
+    }
+    return result;
+}
+
+/**
+ * Parses members of the top-level LwM2M JSON object until either the
+ * beginning of the "e" array, or the end of the object.
+ */
+static int read_lwm2m_json_members(json_decoder_t *dec, bool after_member) {
+    int ch;
+    int result;
+    while (!(result = peek_token(dec, &ch))) {
+        if (ch == '}') {
+            ++dec->chunk_pos;
+            dec->state = JSON_STATE_FINISHED;
+            return expect_end(dec);
+        }
+        if (after_member && (result = expect_token(dec, ','))) {
+            return result;
+        }
+        label_t label;
+        if ((result = read_label(dec, LWM2M_JSON_TOPLEVEL_LABELS, &label))) {
+            return result;
+        }
+        if (label == LABEL_RECORDS) {
+            if (dec->records_parsed) {
+                return bad_request("duplicate \"e\" member in LwM2M JSON");
+            }
+            if (!(result = expect_token(dec, '['))) {
+                dec->state = JSON_STATE_FIRST_RECORD;
+            }
+            return result;
+        } else if (label == LABEL_BASE_NAME) {
+            if (dec->records_parsed) {
+                /* it would not apply to records we already returned */
+                return bad_request("\"bn\" after \"e\" in LwM2M JSON");
+            }
+            dec->basename_implicit = false;
+            result = read_name(dec, dec->basename, &dec->basename_size);
+        } else {
+            result = skip_value(dec);
+        }
+        if (result) {
+            return result;
+        }
+        after_member = true;
+    }
+    return result;
+}
+
+static int json_next_record(anjay_senml_decoder_t *dec_,
+                            anjay_senml_record_t *out_record) {
+    json_decoder_t *dec = (json_decoder_t *) dec_;
+    int result = 0;
+    int ch;
+    while (!result) {
+        switch (dec->state) {
+        case JSON_STATE_INITIAL:
+            if (dec->format == JSON_FORMAT_SENML) {
+                if (!(result = expect_token(dec, '['))) {
+                    dec->state = JSON_STATE_FIRST_RECORD;
+                }
+            } else if (!(result = expect_token(dec, '{'))) {
+                result = read_lwm2m_json_members(dec, false);
+            }
+            break;
+        case JSON_STATE_FIRST_RECORD:
+        case JSON_STATE_NEXT_RECORD:
+            if ((result = peek_token(dec, &ch))) {
+                break;
+            }
+            if (ch != ']') {
+                if (dec->state == JSON_STATE_NEXT_RECORD
+                        && (result = expect_token(dec, ','))) {
+                    break;
+                }
+                dec->state = JSON_STATE_NEXT_RECORD;
+                return read_record(dec, out_record);
+            }
+            ++dec->chunk_pos;
+            if (dec->format == JSON_FORMAT_SENML) {
+                dec->state = JSON_STATE_FINISHED;
+                result = expect_end(dec);
+            } else {
+                dec->records_parsed = true;
+                result = read_lwm2m_json_members(dec, true);
+            }
+            break;
+        case JSON_STATE_FINISHED:
+            return ANJAY_GET_INDEX_END;
+        }
+    }
+    return result;
+}
+
+static void json_delete(anjay_senml_decoder_t *dec_) {
+    json_decoder_t *dec = (json_decoder_t *) dec_;
+    if (dec->autoclose) {
+        avs_stream_cleanup(&dec->stream);
+    }
+    free(dec->value_buf);
+    free(dec->bytes_buf);
+    free(dec);
+}
+
+static const anjay_senml_decoder_vtable_t JSON_DECODER_VTABLE = {
+    .next_record = json_next_record,
+    .delete_ = json_delete
+};
+
+static size_t append_path_id(char *out, uint16_t id) {
+    char buf[sizeof("65535")];
+    size_t size = 0;
+    do {
+        buf[sizeof(buf) - ++size] = (char) ('0' + id % 10);
+        id = (uint16_t) (id / 10);
+    } while (id);
+    memcpy(out, &buf[sizeof(buf) - size], size);
+    out[size] = '/';
+    return size + 1;
+}
+
+static int json_in_create(anjay_input_ctx_t **out,
+                          avs_stream_abstract_t **stream_ptr,
+                          bool autoclose,
+                          json_format_t format,
+                          const anjay_uri_path_t *base_path) {
+    json_decoder_t *dec = (json_decoder_t *) calloc(1, sizeof(json_decoder_t));
+    if (!dec) {
+        *out = NULL;
+        return -1;
+    }
+    dec->vtable = &JSON_DECODER_VTABLE;
+    dec->stream = *stream_ptr;
+    dec->format = format;
+    if (format == JSON_FORMAT_LWM2M) {
+        /* in LwM2M JSON, names are relative to the request path if the
+         * payload does not specify a basename */
+        dec->basename_implicit = true;
+        dec->basename[dec->basename_size++] = '/';
+        if (base_path->has_oid) {
+            dec->basename_size +=
+                    append_path_id(&dec->basename[dec->basename_size],
+                                   base_path->oid);
+        }
+        if (base_path->has_iid) {
+            dec->basename_size +=
+                    append_path_id(&dec->basename[dec->basename_size],
+                                   base_path->iid);
+        }
+        if (base_path->has_rid) {
+            dec->basename_size +=
+                    append_path_id(&dec->basename[dec->basename_size],
+                                   base_path->rid);
+        }
+    }
+    if (autoclose) {
+        dec->autoclose = true;
+        *stream_ptr = NULL;
+    }
+    return _anjay_input_senml_create(out, (anjay_senml_decoder_t *) dec,
+                                     base_path);
+}
+
+static int json_in_create_for_request(anjay_input_ctx_t **out,
+                                      avs_stream_abstract_t **stream_ptr,
+                                      bool autoclose,
+                                      json_format_t format) {
+    anjay_uri_path_t base_path;
+    int result = _anjay_input_senml_get_request_path(*stream_ptr, &base_path);
+    if (result) {
+        *out = NULL;
+        return result;
+    }
+    return json_in_create(out, stream_ptr, autoclose, format, &base_path);
+}
+
+int _anjay_input_json_create(anjay_input_ctx_t **out,
+                             avs_stream_abstract_t **stream_ptr,
+                             bool autoclose) {
+    return json_in_create_for_request(out, stream_ptr, autoclose,
+                                      JSON_FORMAT_LWM2M);
+}
+
+int _anjay_input_senml_json_create(anjay_input_ctx_t **out,
+                                   avs_stream_abstract_t **stream_ptr,
+                                   bool autoclose) {
+    return json_in_create_for_request(out, stream_ptr, autoclose,
+                                      JSON_FORMAT_SENML);
+}
+
+#ifdef ANJAY_TEST
+#include "test/json_in.c"
+#endif
@@ -36,6 +36,11 @@
 
 VISIBILITY_SOURCE_BEGIN
 
+#define MAX_PATH_STRING_LEN sizeof("/65535/65535/65535/65535")
+
+/* "%f" representation of -DBL_MAX is 317 characters long */
+#define JSON_MAX_NUMBER_LEN 320
+
 typedef struct {
     anjay_id_type_t type;
     int32_t id;
@@ -52,22 +57,6 @@ typedef enum {
     JSON_DATA_STRING
 } json_data_type_t;
 
-static const char *data_type_to_string(json_data_type_t type) {
-    switch(type) {
-    case JSON_DATA_F32:
-    case JSON_DATA_F64:
-    case JSON_DATA_I32:
-    case JSON_DATA_I64:
-        return "v";
-    case JSON_DATA_BOOL:
-        return "bv";
-    case JSON_DATA_OBJLNK:
-        return "ov";
-    default:
-        return "sv";
-    }
-}
-
 typedef struct {
     json_id_t id;
     json_data_type_t type;
@@ -97,6 +86,10 @@ typedef struct json_out_struct {
     size_t num_path_elems;
     /* Number of elements in the node_path which form a basename */
     size_t num_base_path_elems;
+    /* Textual form of path[num_base_path_elems:num_path_elems], used as the
+       "n" field of emitted elements; empty if the path is the basename. */
+    char child_path[MAX_PATH_STRING_LEN];
+    size_t child_path_len;
 
     bool needs_separator;
     json_out_array_t array_ctx;
@@ -105,6 +98,50 @@ typedef struct json_out_struct {
     json_id_t next_id;
 } json_out_t;
 
+/**
+ * Formats @p value as decimal digits at @p out, without a terminating nullbyte.
+ * @p out must be able to hold at least MAX_U64_DIGITS characters.
+ *
+ * @returns number of characters written.
+ */
+#define MAX_U64_DIGITS (sizeof("18446744073709551615") - 1)
+
+static size_t format_u64(char *out, uint64_t value) {
+    char digits[MAX_U64_DIGITS];
+    size_t num_digits = 0;
+    do {
+        digits[num_digits++] = (char) ('0' + (value % 10));
+        value /= 10;
+    } while (value);
+    for (size_t i = 0; i < num_digits; ++i) {
+        out[i] = digits[num_digits - 1 - i];
+    }
+    return num_digits;
+}
+
+static size_t format_i64(char *out, int64_t value) {
+    if (value < 0) {
+        *out = '-';
+        /* negate in unsigned arithmetic so that INT64_MIN is handled */
+        return 1 + format_u64(out + 1, UINT64_C(0) - (uint64_t) value);
+    }
+    return format_u64(out, (uint64_t) value);
+}
+
+/**
+ * Path of the currently processed element, relative to the basename, is
+ * rendered into ctx->child_path once per set_id() instead of once per value.
+ */
+static void update_child_path(json_out_t *ctx) {
+    size_t len = 0;
+    for (size_t i = ctx->num_base_path_elems; i < ctx->num_path_elems; ++i) {
+        ctx->child_path[len++] = '/';
+        len += format_u64(&ctx->child_path[len], (uint16_t) ctx->path[i].id);
+    }
+    assert(len < sizeof(ctx->child_path));
+    ctx->child_path_len = len;
+}
+
 static json_id_t *last_path_elem(json_out_t *ctx) {
     if (!ctx->num_path_elems) {
         return NULL;
@@ -160,117 +197,176 @@ update_node_path(json_out_t *ctx, anjay_id_type_t type, uint16_t id) {
         ctx->num_base_path_elems = ctx->num_path_elems;
         json_log(ERROR, "num_path_elems < num_base_path_elems!");
     }
+    update_child_path(ctx);
 }
 
-#define MAX_CHILD_PATH_LEN sizeof("/65535/65535/65535")
+typedef struct {
+    anjay_oid_t oid;
+    anjay_iid_t iid;
+} packed_objlnk_t;
+
+/**
+ * Element header, scalar value and the closing brace are assembled here, so
+ * that every scalar element ends up in the underlying stream with a single
+ * avs_stream_write() call.
+ */
+typedef struct {
+    char data[sizeof("{\"n\":\"\",\"sv\":") + MAX_PATH_STRING_LEN
+              + sizeof("\"65535:65535\"}") + JSON_MAX_NUMBER_LEN];
+    size_t size;
+} json_elem_buf_t;
 
-static size_t
-count_child_path_elems(json_out_t *ctx) {
-    return ctx->num_path_elems - ctx->num_base_path_elems;
+static void elem_buf_append(json_elem_buf_t *buf, const char *data,
+                            size_t size) {
+    assert(buf->size + size <= sizeof(buf->data));
+    memcpy(&buf->data[buf->size], data, size);
+    buf->size += size;
 }
 
-static ssize_t child_path_to_string(json_out_t *ctx, char *dest, size_t size) {
-    switch (count_child_path_elems(ctx)) {
-    case 1:
-        return avs_simple_snprintf(dest, size, "/%"PRId32,
-                                   ctx->path[ctx->num_base_path_elems].id);
-    case 2:
-        return avs_simple_snprintf(dest, size, "/%"PRId32"/%"PRId32,
-                                   ctx->path[ctx->num_base_path_elems].id,
-                                   ctx->path[ctx->num_base_path_elems + 1].id);
-    case 3:
-        return avs_simple_snprintf(dest, size, "/%"PRId32"/%"PRId32"/%"PRId32,
-                                   ctx->path[ctx->num_base_path_elems].id,
-                                   ctx->path[ctx->num_base_path_elems + 1].id,
-                                   ctx->path[ctx->num_base_path_elems + 2].id);
-    default:
-        return -1;
-    }
+#define ELEM_BUF_APPEND_LITERAL(Buf, Literal) \
+    elem_buf_append((Buf), (Literal), sizeof(Literal) - 1)
+
+static int elem_buf_flush(json_out_t *ctx, json_elem_buf_t *buf) {
+    int retval = avs_stream_write(ctx->stream, buf->data, buf->size);
+    buf->size = 0;
+    return retval;
 }
 
-typedef struct {
-    anjay_oid_t oid;
-    anjay_iid_t iid;
-} packed_objlnk_t;
+/**
+ * RFC 4627 section 2.5 Strings:
+ *
+ * "(...)
+ *  All Unicode characters may be placed within the
+ *  quotation marks except for the characters that must be escaped:
+ *  quotation mark, reverse solidus, and the control characters (U+0000
+ *  through U+001F).
+ * "
+ *
+ * Each entry is either 0 (character is copied verbatim), 'u' (character is
+ * written as \u00XX) or the character that follows the backslash.
+ */
+static const char JSON_ESCAPE_TABLE[128] = {
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+    'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+    ['"'] = '"',
+    ['\\'] = '\\'
+};
 
-static int write_quoted_string(avs_stream_abstract_t *stream,
-                               const char *value) {
-    int retval = avs_stream_write(stream, "\"", 1);
-    if (retval) {
-        return retval;
-    }
-    for (size_t i = 0; i < strlen(value); ++i) {
-        /**
-         * RFC 4627 section 2.5 Strings:
-         *
-         * "(...)
-         *  All Unicode characters may be placed within the
-         *  quotation marks except for the characters that must be escaped:
-         *  quotation mark, reverse solidus, and the control characters (U+0000
-         *  through U+001F).
-         * "
-         */
-        if (value[i] == '\\' || value[i] == '"') {
-            retval = avs_stream_write(stream, "\\", 1);
-        }
-        if (retval) {
-            return retval;
-        }
+static char json_escape_char(uint8_t c) {
+    return c < sizeof(JSON_ESCAPE_TABLE) ? JSON_ESCAPE_TABLE[c] : 0;
+}
 
-        if (value[i] == '\b') {
-            retval = avs_stream_write(stream, "\\b", 2);
-        } else if (value[i] == '\f') {
-            retval = avs_stream_write(stream, "\\f", 2);
-        } else if (value[i] == '\n') {
-            retval = avs_stream_write(stream, "\\n", 2);
-        } else if (value[i] == '\r') {
-            retval = avs_stream_write(stream, "\\r", 2);
-        } else if (value[i] == '\t') {
-            retval = avs_stream_write(stream, "\\t", 2);
-        } else if ((uint8_t) value[i] < 0x20) {
-            const int nibble0 = ((uint8_t)value[i] >> 4) & 0xF;
-            const int nibble1 = ((uint8_t)value[i]) & 0xF;
-            retval =
-                    avs_stream_write_f(stream, "\\u00%x%x", nibble0, nibble1);
-        } else {
-            retval = avs_stream_write(stream, &value[i], 1);
+static int write_escaped_string(avs_stream_abstract_t *stream,
+                                const char *value) {
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    const char *run_start = value;
+    const char *ptr = value;
+    for (; *ptr; ++ptr) {
+        const char escape = json_escape_char((uint8_t) *ptr);
+        if (!escape) {
+            continue;
+        }
+        char escaped[sizeof("\\u00XX") - 1] = { '\\', escape };
+        size_t escaped_size = 2;
+        if (escape == 'u') {
+            escaped[2] = '0';
+            escaped[3] = '0';
+            escaped[4] = HEX_DIGITS[((uint8_t) *ptr >> 4) & 0xF];
+            escaped[5] = HEX_DIGITS[(uint8_t) *ptr & 0xF];
+            escaped_size = sizeof(escaped);
         }
-        if (retval) {
+        int retval;
+        if ((ptr > run_start
+                    && (retval = avs_stream_write(stream, run_start,
+                                                  (size_t) (ptr - run_start))))
+                || (retval = avs_stream_write(stream, escaped,
+                                              escaped_size))) {
             return retval;
         }
+        run_start = ptr + 1;
     }
-    return avs_stream_write(stream, "\"", 1);
+    if (ptr > run_start) {
+        return avs_stream_write(stream, run_start, (size_t) (ptr - run_start));
+    }
+    return 0;
 }
 
-static int write_variable(avs_stream_abstract_t *stream,
-                          json_data_type_t type,
-                          const void *value) {
-    int retval =
-            avs_stream_write_f(stream, "\"%s\":", data_type_to_string(type));
-    if (retval) {
-        return retval;
+static void append_element_header(json_out_t *ctx,
+                                  json_elem_buf_t *buf,
+                                  json_data_type_t type) {
+    if (ctx->child_path_len) {
+        ELEM_BUF_APPEND_LITERAL(buf, "{\"n\":\"");
+        elem_buf_append(buf, ctx->child_path, ctx->child_path_len);
+        ELEM_BUF_APPEND_LITERAL(buf, "\",");
+    } else {
+        ELEM_BUF_APPEND_LITERAL(buf, "{");
     }
+    switch (type) {
+    case JSON_DATA_F32:
+    case JSON_DATA_F64:
+    case JSON_DATA_I32:
+    case JSON_DATA_I64:
+        ELEM_BUF_APPEND_LITERAL(buf, "\"v\":");
+        break;
+    case JSON_DATA_BOOL:
+        ELEM_BUF_APPEND_LITERAL(buf, "\"bv\":");
+        break;
+    case JSON_DATA_OBJLNK:
+        ELEM_BUF_APPEND_LITERAL(buf, "\"ov\":");
+        break;
+    default:
+        ELEM_BUF_APPEND_LITERAL(buf, "\"sv\":");
+        break;
+    }
+}
 
+static int append_floating_point(json_elem_buf_t *buf, double value) {
+    char *dest = &buf->data[buf->size];
+    ssize_t result = avs_simple_snprintf(dest, JSON_MAX_NUMBER_LEN + 1,
+                                         "%f", value);
+    if (result < 0) {
+        json_log(ERROR, "cannot format floating-point value");
+        return -1;
+    }
+    buf->size += (size_t) result;
+    return 0;
+}
+
+static int append_scalar_value(json_elem_buf_t *buf,
+                               json_data_type_t type,
+                               const void *value) {
     switch (type) {
     case JSON_DATA_I32:
-        return avs_stream_write_f(stream, "%" PRIi32, *(const int32_t *) value);
+        buf->size += format_i64(&buf->data[buf->size],
+                                *(const int32_t *) value);
+        return 0;
     case JSON_DATA_I64:
-        return avs_stream_write_f(stream, "%" PRIi64, *(const int64_t *) value);
+        buf->size += format_i64(&buf->data[buf->size],
+                                *(const int64_t *) value);
+        return 0;
     case JSON_DATA_F32:
-        return avs_stream_write_f(stream, "%f", *(const float *) value);
+        return append_floating_point(buf, *(const float *) value);
     case JSON_DATA_F64:
-        return avs_stream_write_f(stream, "%f", *(const double *) value);
+        return append_floating_point(buf, *(const double *) value);
     case JSON_DATA_BOOL:
-        return avs_stream_write_f(stream, "%s",
-                                  (*(const bool *) value) ? "true" : "false");
+        if (*(const bool *) value) {
+            ELEM_BUF_APPEND_LITERAL(buf, "true");
+        } else {
+            ELEM_BUF_APPEND_LITERAL(buf, "false");
+        }
+        return 0;
     case JSON_DATA_OBJLNK:
         {
             const packed_objlnk_t objlnk = *(const packed_objlnk_t *) value;
-            return avs_stream_write_f(stream, "\"%" PRIu16 ":%" PRIu16 "\"",
-                                      objlnk.oid, objlnk.iid);
+            ELEM_BUF_APPEND_LITERAL(buf, "\"");
+            buf->size += format_u64(&buf->data[buf->size], objlnk.oid);
+            ELEM_BUF_APPEND_LITERAL(buf, ":");
+            buf->size += format_u64(&buf->data[buf->size], objlnk.iid);
+            ELEM_BUF_APPEND_LITERAL(buf, "\"");
+            return 0;
         }
-    case JSON_DATA_STRING:
-        return write_quoted_string(stream, (const char *) value);
     default:
         json_log(ERROR, "Unsupported json data type: %d", (int) type);
         return -1;
@@ -279,43 +375,41 @@ static int write_variable(avs_stream_abstract_t *stream,
 
 static int write_uri(avs_stream_abstract_t *stream,
                      const anjay_uri_path_t *path) {
-    int retval = avs_stream_write_f(stream, "/%d", path->oid);
-    if (!retval && path->has_iid) {
-        retval = avs_stream_write_f(stream, "/%d", path->iid);
-    }
-    if (!retval && path->has_rid) {
-        retval = avs_stream_write_f(stream, "/%d", path->rid);
-    }
-    return retval;
-}
-
-static int write_element_name(json_out_t *ctx) {
-    const char *name = NULL;
-    char buf[MAX_CHILD_PATH_LEN];
-    if (count_child_path_elems(ctx)) {
-        if (child_path_to_string(ctx, buf, sizeof(buf)) < 0) {
-            return -1;
-        }
-        name = buf;
+    char buf[MAX_PATH_STRING_LEN];
+    size_t size = 0;
+    buf[size++] = '/';
+    size += format_u64(&buf[size], path->oid);
+    if (path->has_iid) {
+        buf[size++] = '/';
+        size += format_u64(&buf[size], path->iid);
     }
-
-    int retval;
-    if (name) {
-        retval = avs_stream_write_f(ctx->stream, "{\"n\":\"%s\",", name);
-    } else {
-        retval = avs_stream_write(ctx->stream, "{", 1);
+    if (path->has_rid) {
+        buf[size++] = '/';
+        size += format_u64(&buf[size], path->rid);
     }
-    return retval;
+    return avs_stream_write(stream, buf, size);
 }
 
 static int write_response_element(json_out_t *ctx,
                                   json_data_type_t type,
                                   const void *value) {
-    int retval;
-    (void) ((retval = write_element_name(ctx))
-            || (retval = write_variable(ctx->stream, type, value))
-            || (retval = avs_stream_write(ctx->stream, "}", 1)));
-    return retval;
+    json_elem_buf_t buf;
+    buf.size = 0;
+    append_element_header(ctx, &buf, type);
+    if (type == JSON_DATA_STRING) {
+        int retval;
+        ELEM_BUF_APPEND_LITERAL(&buf, "\"");
+        (void) ((retval = elem_buf_flush(ctx, &buf))
+                || (retval = write_escaped_string(ctx->stream,
+                                                  (const char *) value))
+                || (retval = avs_stream_write(ctx->stream, "\"}", 2)));
+        return retval;
+    }
+    if (append_scalar_value(&buf, type, value)) {
+        return -1;
+    }
+    ELEM_BUF_APPEND_LITERAL(&buf, "}");
+    return elem_buf_flush(ctx, &buf);
 }
 
 static int process_array_value(json_out_t *ctx,
@@ -387,13 +481,14 @@ static anjay_ret_bytes_ctx_t *json_ret_bytes(anjay_output_ctx_t *ctx_,
         return NULL;
     }
 
-    int retval;
-    (void) ((retval = maybe_write_separator(ctx))
-            || (retval = write_element_name(ctx))
-            || (retval = avs_stream_write_f(ctx->stream, "\"%s\":\"",
-                                            data_type_to_string(
-                                                    JSON_DATA_STRING))));
-    if (retval) {
+    if (maybe_write_separator(ctx)) {
+        return NULL;
+    }
+    json_elem_buf_t buf;
+    buf.size = 0;
+    append_element_header(ctx, &buf, JSON_DATA_STRING);
+    ELEM_BUF_APPEND_LITERAL(&buf, "\"");
+    if (elem_buf_flush(ctx, &buf)) {
         return NULL;
     }
     ctx->bytes = _anjay_base64_ret_bytes_ctx_new(ctx->stream, length);
@@ -515,7 +610,7 @@ static int json_set_id(anjay_output_ctx_t *ctx_,
             return result;
         }
     }
-    json_log(INFO, "set_id(%p, type=%d, id=%d)", (void *) ctx_, (int) type,
+    json_log(TRACE, "set_id(%p, type=%d, id=%d)", (void *) ctx_, (int) type,
              (int) id);
     return 0;
 }
@@ -556,9 +651,9 @@ static const anjay_output_ctx_vtable_t JSON_OUT_VTABLE = {
 static int write_response_preamble(avs_stream_abstract_t *stream,
                                    const anjay_uri_path_t *base) {
     int retval;
-    (void) ((retval = avs_stream_write_f(stream, "%s", "{\"bn\":\""))
+    (void) ((retval = avs_stream_write(stream, "{\"bn\":\"", 7))
             || (retval = write_uri(stream, base))
-            || (retval = avs_stream_write_f(stream, "%s", "\",\"e\":[")));
+            || (retval = avs_stream_write(stream, "\",\"e\":[", 7)));
     return retval;
 }
 
@@ -586,6 +681,7 @@ _anjay_output_json_create(avs_stream_abstract_t *stream,
             update_node_path(ctx, ANJAY_ID_RID, uri->rid);
             ++ctx->num_base_path_elems;
         }
+        update_child_path(ctx);
 
         if ((*errno_ptr = _anjay_handle_requested_format(
                      &inout_details->format, ANJAY_COAP_FORMAT_JSON))
@@ -603,3 +699,7 @@ error:
     free(ctx);
     return NULL;
 }
+
+#ifdef ANJAY_TEST
+#include "test/json_out.c"
+#endif
@@ -0,0 +1,558 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <assert.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <avsystem/commons/log.h>
+#include <avsystem/commons/stream.h>
+#include <avsystem/commons/utils.h>
+
+#include "../io_core.h"
+#include "cbor.h"
+#include "senml_in.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+#define cbor_log(level, ...) avs_log(senml_cbor, level, __VA_ARGS__)
+
+/* Long enough for a basename or name of any valid LwM2M path */
+#define MAX_NAME_SIZE sizeof("/65535/65535/65535/65535")
+
+/* Upper bound on the length of a single string or opaque value; the length
+ * comes from the (untrusted) payload, so it must not drive allocations
+ * directly. Larger resources are expected to use plain Opaque format. */
+#define MAX_VALUE_SIZE (64 * 1024)
+
+typedef struct {
+    const anjay_senml_decoder_vtable_t *vtable;
+    avs_stream_abstract_t *stream;
+    bool autoclose;
+
+    bool array_started;
+    bool array_indefinite;
+    uint64_t records_left;
+
+    /* basename persists between records, as defined in RFC 8428 */
+    char basename[MAX_NAME_SIZE];
+    size_t basename_size;
+
+    char *value_buf;
+    size_t value_buf_capacity;
+} senml_cbor_decoder_t;
+
+typedef struct {
+    uint8_t major_type;
+    uint8_t additional_info;
+    /* argument of the data item; for floating-point values, their raw bits */
+    uint64_t value;
+} cbor_header_t;
+
+static bool is_break(const cbor_header_t *header) {
+    return header->major_type == CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE
+            && header->additional_info == CBOR_INDEFINITE_LENGTH;
+}
+
+static int read_bytes(senml_cbor_decoder_t *dec, void *out, size_t size) {
+    if (avs_stream_read_reliably(dec->stream, out, size)) {
+        cbor_log(DEBUG, "premature end of CBOR payload");
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    return 0;
+}
+
+static int read_header(senml_cbor_decoder_t *dec, cbor_header_t *out) {
+    uint8_t initial_byte;
+    int result;
+    do {
+        if ((result = read_bytes(dec, &initial_byte, 1))) {
+            return result;
+        }
+        out->major_type = (uint8_t) (initial_byte >> 5);
+        out->additional_info = (uint8_t) (initial_byte & 0x1F);
+        out->value = 0;
+        if (out->additional_info < CBOR_EXT_LENGTH_1BYTE) {
+            out->value = out->additional_info;
+        } else if (out->additional_info <= CBOR_EXT_LENGTH_8BYTE) {
+            uint8_t bytes[8];
+            const size_t size =
+                    (size_t) 1 << (out->additional_info
+                                   - CBOR_EXT_LENGTH_1BYTE);
+            if ((result = read_bytes(dec, bytes, size))) {
+                return result;
+            }
+            for (size_t i = 0; i < size; ++i) {
+                out->value = (out->value << 8) | bytes[i];
+            }
+        } else if (out->additional_info != CBOR_INDEFINITE_LENGTH) {
+            cbor_log(DEBUG, "reserved CBOR additional information value");
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        /* semantic tags carry no meaning for SenML, skip them */
+    } while (out->major_type == CBOR_MAJOR_TYPE_TAG);
+    return 0;
+}
+
+static int read_string(senml_cbor_decoder_t *dec,
+                       const cbor_header_t *header,
+                       char *buf, size_t buf_size, size_t *out_size) {
+    if (header->additional_info == CBOR_INDEFINITE_LENGTH) {
+        cbor_log(DEBUG, "indefinite-length strings are not supported");
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    if (header->value > buf_size) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    *out_size = (size_t) header->value;
+    return read_bytes(dec, buf, *out_size);
+}
+
+static int read_value_string(senml_cbor_decoder_t *dec,
+                             const cbor_header_t *header,
+                             anjay_senml_record_t *out_record) {
+    if (header->additional_info == CBOR_INDEFINITE_LENGTH
+            || header->value > SIZE_MAX) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    if (header->value > MAX_VALUE_SIZE) {
+        cbor_log(DEBUG, "value too long: %" PRIu64 " bytes, max %u",
+                 header->value, (unsigned) MAX_VALUE_SIZE);
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    if (header->value > dec->value_buf_capacity) {
+        char *new_buf = (char *) realloc(dec->value_buf,
+                                         (size_t) header->value);
+        if (!new_buf) {
+            cbor_log(ERROR, "out of memory");
+            return -1;
+        }
+        dec->value_buf = new_buf;
+        dec->value_buf_capacity = (size_t) header->value;
+    }
+    out_record->data = dec->value_buf;
+    return read_string(dec, header, dec->value_buf, dec->value_buf_capacity,
+                       &out_record->data_size);
+}
+
+static double decode_half_float(uint16_t half) {
+    const int exponent = (half >> 10) & 0x1F;
+    const double mantissa = (double) (half & 0x3FF);
+    double value;
+    if (exponent == 0) {
+        value = mantissa / (double) (1 << 24);
+    } else if (exponent != 0x1F) {
+        value = (mantissa + 1024.0);
+        if (exponent >= 25) {
+            value *= (double) (1 << (exponent - 25));
+        } else {
+            value /= (double) (1 << (25 - exponent));
+        }
+    } else {
+        value = mantissa == 0.0 ? INFINITY : NAN;
+    }
+    return (half & 0x8000) ? -value : value;
+}
+
+static int read_number(senml_cbor_decoder_t *dec,
+                       anjay_senml_record_t *out_record) {
+    cbor_header_t header;
+    int result = read_header(dec, &header);
+    if (result) {
+        return result;
+    }
+    out_record->type = ANJAY_SENML_VALUE_NUMBER;
+    out_record->value.number.is_int = false;
+    switch (header.major_type) {
+    case CBOR_MAJOR_TYPE_UINT:
+        if (header.value <= INT64_MAX) {
+            out_record->value.number.is_int = true;
+            out_record->value.number.i = (int64_t) header.value;
+        }
+        out_record->value.number.d = (double) header.value;
+        return 0;
+    case CBOR_MAJOR_TYPE_NEGATIVE_INT:
+        if (header.value <= INT64_MAX) {
+            out_record->value.number.is_int = true;
+            out_record->value.number.i = -1 - (int64_t) header.value;
+            out_record->value.number.d =
+                    (double) out_record->value.number.i;
+        } else {
+            out_record->value.number.d = -1.0 - (double) header.value;
+        }
+        return 0;
+    case CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE:
+        switch (header.additional_info) {
+        case CBOR_VALUE_FLOAT_16:
+            out_record->value.number.d =
+                    decode_half_float((uint16_t) header.value);
+            return 0;
+        case CBOR_VALUE_FLOAT_32:
+            {
+                union {
+                    uint32_t bits;
+                    float value;
+                } conv;
+                conv.bits = (uint32_t) header.value;
+                out_record->value.number.d = conv.value;
+                return 0;
+            }
+        case CBOR_VALUE_FLOAT_64:
+            {
+                union {
+                    uint64_t bits;
+                    double value;
+                } conv;
+                conv.bits = header.value;
+                out_record->value.number.d = conv.value;
+                return 0;
+            }
+        default:
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+    default:
+        break;
+    }
+    return ANJAY_ERR_BAD_REQUEST;
+}
+
+static int read_bool(senml_cbor_decoder_t *dec,
+                     anjay_senml_record_t *out_record) {
+    cbor_header_t header;
+    int result = read_header(dec, &header);
+    if (result) {
+        return result;
+    }
+    if (header.major_type != CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE
+            || (header.additional_info != CBOR_VALUE_FALSE
+                    && header.additional_info != CBOR_VALUE_TRUE)) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    out_record->type = ANJAY_SENML_VALUE_BOOL;
+    out_record->value.boolean =
+            (header.additional_info == CBOR_VALUE_TRUE);
+    return 0;
+}
+
+static int read_typed_string(senml_cbor_decoder_t *dec,
+                             uint8_t major_type,
+                             anjay_senml_value_type_t value_type,
+                             anjay_senml_record_t *out_record) {
+    cbor_header_t header;
+    int result = read_header(dec, &header);
+    if (result) {
+        return result;
+    }
+    if (header.major_type != major_type) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    out_record->type = value_type;
+    return read_value_string(dec, &header, out_record);
+}
+
+static int skip_bytes(senml_cbor_decoder_t *dec, uint64_t size) {
+    char buf[64];
+    while (size) {
+        const size_t chunk = (size_t) AVS_MIN(size, sizeof(buf));
+        int result = read_bytes(dec, buf, chunk);
+        if (result) {
+            return result;
+        }
+        size -= chunk;
+    }
+    return 0;
+}
+
+static int skip_value(senml_cbor_decoder_t *dec) {
+    cbor_header_t header;
+    int result = read_header(dec, &header);
+    if (result) {
+        return result;
+    }
+    switch (header.major_type) {
+    case CBOR_MAJOR_TYPE_UINT:
+    case CBOR_MAJOR_TYPE_NEGATIVE_INT:
+        return 0;
+    case CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE:
+        return is_break(&header) ? ANJAY_ERR_BAD_REQUEST : 0;
+    case CBOR_MAJOR_TYPE_BYTE_STRING:
+    case CBOR_MAJOR_TYPE_TEXT_STRING:
+        if (header.additional_info != CBOR_INDEFINITE_LENGTH) {
+            return skip_bytes(dec, header.value);
+        }
+        /* fall through */
+    default:
+        /* SenML values are never nested */
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+}
+
+typedef enum {
+    LABEL_OTHER,
+    LABEL_BASE_NAME,
+    LABEL_NAME,
+    LABEL_VALUE,
+    LABEL_STRING_VALUE,
+    LABEL_BOOLEAN_VALUE,
+    LABEL_DATA_VALUE,
+    LABEL_OBJLNK_VALUE,
+    LABEL_UNSUPPORTED
+} label_t;
+
+static label_t int_to_label(int64_t label) {
+    switch (label) {
+    case SENML_LABEL_BASE_NAME:
+        return LABEL_BASE_NAME;
+    case SENML_LABEL_NAME:
+        return LABEL_NAME;
+    case SENML_LABEL_VALUE:
+        return LABEL_VALUE;
+    case SENML_LABEL_STRING_VALUE:
+        return LABEL_STRING_VALUE;
+    case SENML_LABEL_BOOLEAN_VALUE:
+        return LABEL_BOOLEAN_VALUE;
+    case SENML_LABEL_DATA_VALUE:
+        return LABEL_DATA_VALUE;
+    case SENML_LABEL_BASE_VALUE:
+    case SENML_LABEL_BASE_SUM:
+    case SENML_LABEL_SUM:
+        /* these would change the meaning of values */
+        return LABEL_UNSUPPORTED;
+    default:
+        return LABEL_OTHER;
+    }
+}
+
+static int read_label(senml_cbor_decoder_t *dec,
+                      const cbor_header_t *header,
+                      label_t *out_label) {
+    switch (header->major_type) {
+    case CBOR_MAJOR_TYPE_UINT:
+        *out_label = header->value <= INT64_MAX
+                ? int_to_label((int64_t) header->value) : LABEL_OTHER;
+        return 0;
+    case CBOR_MAJOR_TYPE_NEGATIVE_INT:
+        *out_label = header->value <= INT64_MAX
+                ? int_to_label(-1 - (int64_t) header->value) : LABEL_OTHER;
+        return 0;
+    case CBOR_MAJOR_TYPE_TEXT_STRING:
+        {
+            char buf[sizeof(SENML_EXT_OBJLNK_LABEL) - 1];
+            size_t size;
+            if (header->additional_info == CBOR_INDEFINITE_LENGTH) {
+                return ANJAY_ERR_BAD_REQUEST;
+            }
+            if (header->value > sizeof(buf)) {
+                /* unknown and long, just skip it */
+                *out_label = LABEL_OTHER;
+                return skip_bytes(dec, header->value);
+            }
+            int result = read_string(dec, header, buf, sizeof(buf), &size);
+            if (result) {
+                return result;
+            }
+            *out_label = (size == sizeof(buf)
+                          && !memcmp(buf, SENML_EXT_OBJLNK_LABEL, size))
+                    ? LABEL_OBJLNK_VALUE : LABEL_OTHER;
+            return 0;
+        }
+    default:
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+}
+
+static int read_record_fields(senml_cbor_decoder_t *dec,
+                              const cbor_header_t *map_header,
+                              char *name, size_t *inout_name_size,
+                              anjay_senml_record_t *out_record,
+                              bool *out_has_value) {
+    const bool indefinite =
+            (map_header->additional_info == CBOR_INDEFINITE_LENGTH);
+    uint64_t pairs_left = map_header->value;
+    int result = 0;
+    *out_has_value = false;
+    while (indefinite || pairs_left--) {
+        cbor_header_t header;
+        label_t label;
+        if ((result = read_header(dec, &header))) {
+            return result;
+        }
+        if (indefinite && is_break(&header)) {
+            return 0;
+        }
+        if ((result = read_label(dec, &header, &label))) {
+            return result;
+        }
+        if (label == LABEL_OTHER) {
+            result = skip_value(dec);
+        } else if (label == LABEL_UNSUPPORTED) {
+            cbor_log(DEBUG, "unsupported SenML label");
+            return ANJAY_ERR_BAD_REQUEST;
+        } else if (label == LABEL_BASE_NAME || label == LABEL_NAME) {
+            char *buf = (label == LABEL_BASE_NAME) ? dec->basename : name;
+            size_t *size_ptr = (label == LABEL_BASE_NAME)
+                    ? &dec->basename_size : inout_name_size;
+            if (!(result = read_header(dec, &header))) {
+                result = header.major_type == CBOR_MAJOR_TYPE_TEXT_STRING
+                        ? read_string(dec, &header, buf, MAX_NAME_SIZE - 1,
+                                      size_ptr)
+                        : ANJAY_ERR_BAD_REQUEST;
+            }
+        } else if (*out_has_value) {
+            cbor_log(DEBUG, "more than one value in a SenML record");
+            return ANJAY_ERR_BAD_REQUEST;
+        } else {
+            *out_has_value = true;
+            switch (label) {
+            case LABEL_VALUE:
+                result = read_number(dec, out_record);
+                break;
+            case LABEL_STRING_VALUE:
+                result = read_typed_string(dec, CBOR_MAJOR_TYPE_TEXT_STRING,
+                                           ANJAY_SENML_VALUE_STRING,
+                                           out_record);
+                break;
+            case LABEL_BOOLEAN_VALUE:
+                result = read_bool(dec, out_record);
+                break;
+            case LABEL_DATA_VALUE:
+                result = read_typed_string(dec, CBOR_MAJOR_TYPE_BYTE_STRING,
+                                           ANJAY_SENML_VALUE_BYTES,
+                                           out_record);
+                break;
+            default:
+                assert(label == LABEL_OBJLNK_VALUE);
+                result = read_typed_string(dec, CBOR_MAJOR_TYPE_TEXT_STRING,
+                                           ANJAY_SENML_VALUE_OBJLNK,
+                                           out_record);
+                break;
+            }
+        }
+        if (result) {
+            return result;
+        }
+    }
+    return 0;
+}
+
+static int senml_cbor_next_record(anjay_senml_decoder_t *dec_,
+                                  anjay_senml_record_t *out_record) {
+    senml_cbor_decoder_t *dec = (senml_cbor_decoder_t *) dec_;
+    cbor_header_t header;
+    int result;
+    if (!dec->array_started) {
+        if ((result = read_header(dec, &header))) {
+            return result;
+        }
+        if (header.major_type != CBOR_MAJOR_TYPE_ARRAY) {
+            cbor_log(DEBUG, "SenML CBOR payload is not an array");
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        dec->array_started = true;
+        dec->array_indefinite =
+                (header.additional_info == CBOR_INDEFINITE_LENGTH);
+        dec->records_left = header.value;
+    }
+    if (!dec->array_indefinite) {
+        if (!dec->records_left) {
+            return ANJAY_GET_INDEX_END;
+        }
+        --dec->records_left;
+    }
+    if ((result = read_header(dec, &header))) {
+        return result;
+    }
+    if (dec->array_indefinite && is_break(&header)) {
+        dec->records_left = 0;
+        dec->array_indefinite = false;
+        return ANJAY_GET_INDEX_END;
+    }
+    if (header.major_type != CBOR_MAJOR_TYPE_MAP) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+
+    char name[MAX_NAME_SIZE];
+    size_t name_size = 0;
+    bool has_value;
+    if ((result = read_record_fields(dec, &header, name, &name_size,
+                                     out_record, &has_value))) {
+        return result;
+    }
+    if (!has_value) {
+        cbor_log(DEBUG, "SenML record without a value");
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+
+    char path[2 * MAX_NAME_SIZE];
+    memcpy(path, dec->basename, dec->basename_size);
+    memcpy(path + dec->basename_size, name, name_size);
+    return _anjay_senml_parse_path(out_record, path,
+                                   dec->basename_size + name_size);
+}
+
+static void senml_cbor_delete(anjay_senml_decoder_t *dec_) {
+    senml_cbor_decoder_t *dec = (senml_cbor_decoder_t *) dec_;
+    if (dec->autoclose) {
+        avs_stream_cleanup(&dec->stream);
+    }
+    free(dec->value_buf);
+    free(dec);
+}
+
+static const anjay_senml_decoder_vtable_t SENML_CBOR_DECODER_VTABLE = {
+    .next_record = senml_cbor_next_record,
+    .delete_ = senml_cbor_delete
+};
+
+static int senml_cbor_in_create(anjay_input_ctx_t **out,
+                                avs_stream_abstract_t **stream_ptr,
+                                bool autoclose,
+                                const anjay_uri_path_t *base_path) {
+    senml_cbor_decoder_t *dec =
+            (senml_cbor_decoder_t *) calloc(1, sizeof(senml_cbor_decoder_t));
+    if (!dec) {
+        *out = NULL;
+        return -1;
+    }
+    dec->vtable = &SENML_CBOR_DECODER_VTABLE;
+    dec->stream = *stream_ptr;
+    if (autoclose) {
+        dec->autoclose = true;
+        *stream_ptr = NULL;
+    }
+    return _anjay_input_senml_create(out, (anjay_senml_decoder_t *) dec,
+                                     base_path);
+}
+
+int _anjay_input_senml_cbor_create(anjay_input_ctx_t **out,
+                                   avs_stream_abstract_t **stream_ptr,
+                                   bool autoclose) {
+    anjay_uri_path_t base_path;
+    int result = _anjay_input_senml_get_request_path(*stream_ptr, &base_path);
+    if (result) {
+        *out = NULL;
+        return result;
+    }
+    return senml_cbor_in_create(out, stream_ptr, autoclose, &base_path);
+}
+
+#ifdef ANJAY_TEST
+#include "test/senml_cbor_in.c"
+#endif
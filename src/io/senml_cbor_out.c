@@ -0,0 +1,486 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <assert.h>
+#include <string.h>
+
+#include <avsystem/commons/log.h>
+#include <avsystem/commons/stream.h>
+#include <avsystem/commons/utils.h>
+
+#include "../coap/content_format.h"
+
+#include "../io_core.h"
+#include "cbor.h"
+#include "vtable.h"
+
+#define cbor_log(level, ...) avs_log(senml_cbor, level, __VA_ARGS__)
+
+VISIBILITY_SOURCE_BEGIN
+
+#define MAX_PATH_STRING_LEN sizeof("/65535/65535/65535/65535")
+
+typedef struct {
+    anjay_id_type_t type;
+    uint16_t id;
+} cbor_id_t;
+
+typedef struct senml_cbor_out_struct senml_cbor_out_t;
+
+typedef struct {
+    const anjay_ret_bytes_ctx_vtable_t *vtable;
+    senml_cbor_out_t *parent;
+    size_t bytes_left;
+} senml_cbor_bytes_t;
+
+struct senml_cbor_out_struct {
+    const anjay_output_ctx_vtable_t *vtable;
+    avs_stream_abstract_t *stream;
+    int *errno_ptr;
+
+    /* Path to the currently processed element; the first num_base_path_elems
+     * entries form the basename, i.e. the path of the request. */
+    cbor_id_t path[4];
+    size_t num_path_elems;
+    size_t num_base_path_elems;
+    /* Textual forms of the basename and of the rest of the path, used as "bn"
+     * and "n" labels, respectively. Rendered once per set_id() call. */
+    char base_name[MAX_PATH_STRING_LEN];
+    size_t base_name_len;
+    char child_path[MAX_PATH_STRING_LEN];
+    size_t child_path_len;
+
+    /* "bn" is only emitted in the first record */
+    bool base_name_written;
+    senml_cbor_bytes_t bytes;
+};
+
+static size_t format_u16(char *out, uint16_t value) {
+    char digits[sizeof("65535") - 1];
+    size_t num_digits = 0;
+    do {
+        digits[num_digits++] = (char) ('0' + (value % 10));
+        value /= 10;
+    } while (value);
+    for (size_t i = 0; i < num_digits; ++i) {
+        out[i] = digits[num_digits - 1 - i];
+    }
+    return num_digits;
+}
+
+static size_t format_path(char *out, const cbor_id_t *ids, size_t num_ids) {
+    size_t len = 0;
+    for (size_t i = 0; i < num_ids; ++i) {
+        out[len++] = '/';
+        len += format_u16(&out[len], ids[i].id);
+    }
+    assert(len < MAX_PATH_STRING_LEN);
+    return len;
+}
+
+static void update_node_path(senml_cbor_out_t *ctx,
+                             anjay_id_type_t type, uint16_t id) {
+    /* See update_node_path() in json_out.c for the rationale */
+    while (ctx->num_path_elems
+            && type <= ctx->path[ctx->num_path_elems - 1].type) {
+        --ctx->num_path_elems;
+    }
+    if (ctx->num_path_elems >= AVS_ARRAY_SIZE(ctx->path)) {
+        cbor_log(ERROR, "BUG: path too long");
+        return;
+    }
+    ctx->path[ctx->num_path_elems++] = (cbor_id_t) {
+        .type = type,
+        .id = id
+    };
+    if (ctx->num_base_path_elems > ctx->num_path_elems) {
+        assert(0 && "Should never happen");
+        ctx->num_base_path_elems = ctx->num_path_elems;
+        cbor_log(ERROR, "num_path_elems < num_base_path_elems!");
+    }
+    ctx->child_path_len =
+            format_path(ctx->child_path,
+                        &ctx->path[ctx->num_base_path_elems],
+                        ctx->num_path_elems - ctx->num_base_path_elems);
+}
+
+/**
+ * Record header, value and (for strings) value header are assembled here, so
+ * that most records are written with a single avs_stream_write() call.
+ */
+typedef struct {
+    uint8_t data[1 + 2 * (1 + 1 + MAX_PATH_STRING_LEN)
+                 + sizeof(SENML_EXT_OBJLNK_LABEL) + 2 * CBOR_MAX_HEADER_SIZE];
+    size_t size;
+    /* set if the record carries "bn"; committed only once it is written */
+    bool has_base_name;
+} cbor_record_buf_t;
+
+static void record_buf_append(cbor_record_buf_t *buf,
+                              const void *data, size_t size) {
+    assert(buf->size + size <= sizeof(buf->data));
+    memcpy(&buf->data[buf->size], data, size);
+    buf->size += size;
+}
+
+static void append_uint_be(cbor_record_buf_t *buf,
+                           uint64_t value, size_t size) {
+    assert(buf->size + size <= sizeof(buf->data));
+    for (size_t i = size; i > 0; --i) {
+        buf->data[buf->size + i - 1] = (uint8_t) (value & 0xFF);
+        value >>= 8;
+    }
+    buf->size += size;
+}
+
+static void append_header(cbor_record_buf_t *buf,
+                          cbor_major_type_t major_type, uint64_t value) {
+    if (value < CBOR_EXT_LENGTH_1BYTE) {
+        buf->data[buf->size++] = CBOR_INITIAL_BYTE(major_type, value);
+    } else if (value <= UINT8_MAX) {
+        buf->data[buf->size++] =
+                CBOR_INITIAL_BYTE(major_type, CBOR_EXT_LENGTH_1BYTE);
+        append_uint_be(buf, value, 1);
+    } else if (value <= UINT16_MAX) {
+        buf->data[buf->size++] =
+                CBOR_INITIAL_BYTE(major_type, CBOR_EXT_LENGTH_2BYTE);
+        append_uint_be(buf, value, 2);
+    } else if (value <= UINT32_MAX) {
+        buf->data[buf->size++] =
+                CBOR_INITIAL_BYTE(major_type, CBOR_EXT_LENGTH_4BYTE);
+        append_uint_be(buf, value, 4);
+    } else {
+        buf->data[buf->size++] =
+                CBOR_INITIAL_BYTE(major_type, CBOR_EXT_LENGTH_8BYTE);
+        append_uint_be(buf, value, 8);
+    }
+}
+
+static void append_int(cbor_record_buf_t *buf, int64_t value) {
+    if (value < 0) {
+        /* -1 - value, computed without overflowing for INT64_MIN */
+        append_header(buf, CBOR_MAJOR_TYPE_NEGATIVE_INT,
+                      (uint64_t) (-(value + 1)));
+    } else {
+        append_header(buf, CBOR_MAJOR_TYPE_UINT, (uint64_t) value);
+    }
+}
+
+static void append_text(cbor_record_buf_t *buf,
+                        const char *data, size_t size) {
+    append_header(buf, CBOR_MAJOR_TYPE_TEXT_STRING, size);
+    record_buf_append(buf, data, size);
+}
+
+static int finish_bytes(senml_cbor_out_t *ctx) {
+    if (ctx->bytes.vtable && ctx->bytes.bytes_left) {
+        cbor_log(ERROR, "not all declared bytes were written");
+        return -1;
+    }
+    ctx->bytes.vtable = NULL;
+    return 0;
+}
+
+/**
+ * Starts a record in @p buf: map header, "bn" (in the first record only) and
+ * "n" (if the path differs from the basename) followed by @p value_label.
+ * The caller is expected to append the value itself.
+ */
+static int begin_record(senml_cbor_out_t *ctx, cbor_record_buf_t *buf,
+                        int value_label) {
+    int result = finish_bytes(ctx);
+    if (result) {
+        return result;
+    }
+    const bool write_base_name = !ctx->base_name_written
+                                 && ctx->base_name_len;
+    buf->size = 0;
+    buf->has_base_name = write_base_name;
+    append_header(buf, CBOR_MAJOR_TYPE_MAP,
+                  1u + !!write_base_name + !!ctx->child_path_len);
+    if (write_base_name) {
+        append_int(buf, SENML_LABEL_BASE_NAME);
+        append_text(buf, ctx->base_name, ctx->base_name_len);
+    }
+    if (ctx->child_path_len) {
+        append_int(buf, SENML_LABEL_NAME);
+        append_text(buf, ctx->child_path, ctx->child_path_len);
+    }
+    if (value_label >= 0) {
+        append_int(buf, value_label);
+    } else {
+        append_text(buf, SENML_EXT_OBJLNK_LABEL,
+                    sizeof(SENML_EXT_OBJLNK_LABEL) - 1);
+    }
+    return 0;
+}
+
+/* Used in place of a numeric label for the text "vlo" label */
+#define OBJLNK_LABEL (-1)
+
+static int write_record(senml_cbor_out_t *ctx, cbor_record_buf_t *buf) {
+    int retval = avs_stream_write(ctx->stream, buf->data, buf->size);
+    if (!retval && buf->has_base_name) {
+        ctx->base_name_written = true;
+    }
+    return retval;
+}
+
+static int *senml_cbor_errno_ptr(anjay_output_ctx_t *ctx) {
+    return ((senml_cbor_out_t *) ctx)->errno_ptr;
+}
+
+static int bytes_append(anjay_ret_bytes_ctx_t *ctx_,
+                        const void *data,
+                        size_t length) {
+    senml_cbor_bytes_t *ctx = (senml_cbor_bytes_t *) ctx_;
+    if (length > ctx->bytes_left) {
+        cbor_log(ERROR, "tried to write too many bytes, expected %zu, got %zu",
+                 ctx->bytes_left, length);
+        return -1;
+    }
+    int retval = avs_stream_write(ctx->parent->stream, data, length);
+    if (!retval) {
+        ctx->bytes_left -= length;
+    }
+    return retval;
+}
+
+static const anjay_ret_bytes_ctx_vtable_t BYTES_VTABLE = {
+    .append = bytes_append
+};
+
+static anjay_ret_bytes_ctx_t *senml_cbor_ret_bytes(anjay_output_ctx_t *ctx_,
+                                                   size_t length) {
+    senml_cbor_out_t *ctx = (senml_cbor_out_t *) ctx_;
+    cbor_record_buf_t buf;
+    if (begin_record(ctx, &buf, SENML_LABEL_DATA_VALUE)) {
+        return NULL;
+    }
+    append_header(&buf, CBOR_MAJOR_TYPE_BYTE_STRING, length);
+    if (write_record(ctx, &buf)) {
+        return NULL;
+    }
+    ctx->bytes.vtable = &BYTES_VTABLE;
+    ctx->bytes.parent = ctx;
+    ctx->bytes.bytes_left = length;
+    return (anjay_ret_bytes_ctx_t *) &ctx->bytes;
+}
+
+static int senml_cbor_ret_string(anjay_output_ctx_t *ctx_, const char *value) {
+    senml_cbor_out_t *ctx = (senml_cbor_out_t *) ctx_;
+    cbor_record_buf_t buf;
+    const size_t length = strlen(value);
+    int retval;
+    if ((retval = begin_record(ctx, &buf, SENML_LABEL_STRING_VALUE))) {
+        return retval;
+    }
+    append_header(&buf, CBOR_MAJOR_TYPE_TEXT_STRING, length);
+    (void) ((retval = write_record(ctx, &buf))
+            || (retval = avs_stream_write(ctx->stream, value, length)));
+    return retval;
+}
+
+static int senml_cbor_ret_i64(anjay_output_ctx_t *ctx_, int64_t value) {
+    senml_cbor_out_t *ctx = (senml_cbor_out_t *) ctx_;
+    cbor_record_buf_t buf;
+    int retval = begin_record(ctx, &buf, SENML_LABEL_VALUE);
+    if (retval) {
+        return retval;
+    }
+    append_int(&buf, value);
+    return write_record(ctx, &buf);
+}
+
+static int senml_cbor_ret_i32(anjay_output_ctx_t *ctx, int32_t value) {
+    return senml_cbor_ret_i64(ctx, value);
+}
+
+static int senml_cbor_ret_float(anjay_output_ctx_t *ctx_, float value) {
+    senml_cbor_out_t *ctx = (senml_cbor_out_t *) ctx_;
+    cbor_record_buf_t buf;
+    int retval = begin_record(ctx, &buf, SENML_LABEL_VALUE);
+    if (retval) {
+        return retval;
+    }
+    union {
+        float value;
+        uint32_t bits;
+    } conv;
+    conv.value = value;
+    buf.data[buf.size++] = CBOR_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE,
+                                             CBOR_VALUE_FLOAT_32);
+    append_uint_be(&buf, conv.bits, sizeof(conv.bits));
+    return write_record(ctx, &buf);
+}
+
+static int senml_cbor_ret_double(anjay_output_ctx_t *ctx_, double value) {
+    if ((double) (float) value == value) {
+        /* no precision lost, use the shorter encoding */
+        return senml_cbor_ret_float(ctx_, (float) value);
+    }
+    senml_cbor_out_t *ctx = (senml_cbor_out_t *) ctx_;
+    cbor_record_buf_t buf;
+    int retval = begin_record(ctx, &buf, SENML_LABEL_VALUE);
+    if (retval) {
+        return retval;
+    }
+    union {
+        double value;
+        uint64_t bits;
+    } conv;
+    conv.value = value;
+    buf.data[buf.size++] = CBOR_INITIAL_BYTE(CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE,
+                                             CBOR_VALUE_FLOAT_64);
+    append_uint_be(&buf, conv.bits, sizeof(conv.bits));
+    return write_record(ctx, &buf);
+}
+
+static int senml_cbor_ret_bool(anjay_output_ctx_t *ctx_, bool value) {
+    senml_cbor_out_t *ctx = (senml_cbor_out_t *) ctx_;
+    cbor_record_buf_t buf;
+    int retval = begin_record(ctx, &buf, SENML_LABEL_BOOLEAN_VALUE);
+    if (retval) {
+        return retval;
+    }
+    buf.data[buf.size++] = CBOR_INITIAL_BYTE(
+            CBOR_MAJOR_TYPE_FLOAT_OR_SIMPLE,
+            value ? CBOR_VALUE_TRUE : CBOR_VALUE_FALSE);
+    return write_record(ctx, &buf);
+}
+
+static int senml_cbor_ret_objlnk(anjay_output_ctx_t *ctx_,
+                                 anjay_oid_t oid, anjay_iid_t iid) {
+    senml_cbor_out_t *ctx = (senml_cbor_out_t *) ctx_;
+    cbor_record_buf_t buf;
+    int retval = begin_record(ctx, &buf, OBJLNK_LABEL);
+    if (retval) {
+        return retval;
+    }
+    char objlnk[sizeof("65535:65535")];
+    size_t size = format_u16(objlnk, oid);
+    objlnk[size++] = ':';
+    size += format_u16(&objlnk[size], iid);
+    append_text(&buf, objlnk, size);
+    return write_record(ctx, &buf);
+}
+
+static anjay_output_ctx_t *senml_cbor_ret_array_start(anjay_output_ctx_t *ctx) {
+    /* Resource Instances are flattened into separate records by set_id() */
+    return ctx;
+}
+
+static int senml_cbor_ret_array_finish(anjay_output_ctx_t *ctx) {
+    return finish_bytes((senml_cbor_out_t *) ctx);
+}
+
+static anjay_output_ctx_t *
+senml_cbor_ret_object_start(anjay_output_ctx_t *ctx) {
+    return ctx;
+}
+
+static int senml_cbor_ret_object_finish(anjay_output_ctx_t *ctx) {
+    return finish_bytes((senml_cbor_out_t *) ctx);
+}
+
+static int senml_cbor_set_id(anjay_output_ctx_t *ctx_,
+                             anjay_id_type_t type,
+                             uint16_t id) {
+    senml_cbor_out_t *ctx = (senml_cbor_out_t *) ctx_;
+    int result = finish_bytes(ctx);
+    if (!result) {
+        update_node_path(ctx, type, id);
+    }
+    return result;
+}
+
+static int senml_cbor_output_close(anjay_output_ctx_t *ctx_) {
+    senml_cbor_out_t *ctx = (senml_cbor_out_t *) ctx_;
+    const uint8_t array_end = CBOR_BREAK;
+    int result;
+    (void) ((result = finish_bytes(ctx))
+            || (result = avs_stream_write(ctx->stream, &array_end, 1)));
+    return result;
+}
+
+static const anjay_output_ctx_vtable_t SENML_CBOR_OUT_VTABLE = {
+    senml_cbor_errno_ptr,
+    senml_cbor_ret_bytes,
+    senml_cbor_ret_string,
+    senml_cbor_ret_i32,
+    senml_cbor_ret_i64,
+    senml_cbor_ret_float,
+    senml_cbor_ret_double,
+    senml_cbor_ret_bool,
+    senml_cbor_ret_objlnk,
+    senml_cbor_ret_array_start,
+    senml_cbor_ret_array_finish,
+    senml_cbor_ret_object_start,
+    senml_cbor_ret_object_finish,
+    senml_cbor_set_id,
+    senml_cbor_output_close
+};
+
+anjay_output_ctx_t *
+_anjay_output_senml_cbor_create(avs_stream_abstract_t *stream,
+                                int *errno_ptr,
+                                anjay_msg_details_t *inout_details,
+                                const anjay_uri_path_t *uri) {
+    senml_cbor_out_t *ctx =
+            (senml_cbor_out_t *) calloc(1, sizeof(senml_cbor_out_t));
+    if (ctx) {
+        ctx->vtable = &SENML_CBOR_OUT_VTABLE;
+        ctx->errno_ptr = errno_ptr;
+        ctx->stream = stream;
+        if (uri->has_oid) {
+            update_node_path(ctx, ANJAY_ID_OID, uri->oid);
+        }
+        if (uri->has_iid) {
+            assert(uri->has_oid);
+            update_node_path(ctx, ANJAY_ID_IID, uri->iid);
+        }
+        if (uri->has_rid) {
+            assert(uri->has_iid);
+            update_node_path(ctx, ANJAY_ID_RID, uri->rid);
+        }
+        ctx->num_base_path_elems = ctx->num_path_elems;
+        ctx->base_name_len = format_path(ctx->base_name, ctx->path,
+                                         ctx->num_path_elems);
+        ctx->child_path_len = 0;
+
+        const uint8_t array_begin = CBOR_INDEFINITE_ARRAY;
+        if ((*errno_ptr = _anjay_handle_requested_format(
+                     &inout_details->format, ANJAY_COAP_FORMAT_SENML_CBOR))
+            || _anjay_coap_stream_setup_response(stream, inout_details)) {
+            goto error;
+        }
+        if (avs_stream_write(stream, &array_begin, 1)) {
+            cbor_log(ERROR, "cannot write response preamble");
+            goto error;
+        }
+        cbor_log(TRACE, "created SenML CBOR context");
+    }
+    return (anjay_output_ctx_t *) ctx;
+error:
+    free(ctx);
+    return NULL;
+}
+
+#ifdef ANJAY_TEST
+#include "test/senml_cbor_out.c"
+#endif
@@ -0,0 +1,447 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <assert.h>
+#include <string.h>
+
+#include <avsystem/commons/utils.h>
+
+#include "../anjay_core.h"
+#include "../coap/content_format.h"
+#include "senml_in.h"
+#include "vtable.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+typedef struct {
+    anjay_senml_decoder_t *decoder;
+    anjay_senml_record_t record;
+    /* true if record contains an entry that has not been skipped yet */
+    bool has_record;
+    /* true if the decoder reported that there are no more records */
+    bool finished;
+    /* number of bytes of record.data already returned through get_bytes or
+     * get_string */
+    size_t data_offset;
+} senml_in_shared_t;
+
+typedef struct {
+    const anjay_input_ctx_vtable_t *vtable;
+    /* owned by the root context, shared with all nested ones */
+    senml_in_shared_t *shared;
+    bool is_root;
+    anjay_input_ctx_t *child;
+    /* IDs that all records processed through this context need to begin with;
+     * for nested contexts, num_prefix_ids == level */
+    uint16_t prefix_ids[ANJAY_SENML_MAX_PATH_IDS];
+    size_t num_prefix_ids;
+    /* index in the record path of the ID returned by get_id(); this is also
+     * the numeric value of the returned anjay_id_type_t */
+    size_t level;
+    int32_t id;
+} senml_in_t;
+
+int _anjay_senml_parse_path(anjay_senml_record_t *out_record,
+                            const char *path,
+                            size_t path_size) {
+    const char *const end = path + path_size;
+    out_record->num_ids = 0;
+    if (path == end || *path != '/') {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    ++path;
+    while (path < end) {
+        if (out_record->num_ids >= ANJAY_SENML_MAX_PATH_IDS) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        uint32_t value = 0;
+        const char *segment_start = path;
+        for (; path < end && *path != '/'; ++path) {
+            if (*path < '0' || *path > '9'
+                    || (value = value * 10 + (uint32_t) (*path - '0'))
+                            > UINT16_MAX) {
+                return ANJAY_ERR_BAD_REQUEST;
+            }
+        }
+        if (path == segment_start) {
+            /* empty segment is only allowed as a trailing slash */
+            return path == end ? 0 : ANJAY_ERR_BAD_REQUEST;
+        }
+        out_record->ids[out_record->num_ids++] = (uint16_t) value;
+        if (path < end) {
+            /* skip the slash */
+            ++path;
+        }
+    }
+    return 0;
+}
+
+static int ensure_record(senml_in_shared_t *shared) {
+    if (shared->has_record) {
+        return 0;
+    }
+    if (shared->finished) {
+        return ANJAY_GET_INDEX_END;
+    }
+    memset(&shared->record, 0, sizeof(shared->record));
+    int result = shared->decoder->vtable->next_record(shared->decoder,
+                                                      &shared->record);
+    if (result == ANJAY_GET_INDEX_END) {
+        shared->finished = true;
+    } else if (!result) {
+        shared->has_record = true;
+        shared->data_offset = 0;
+    }
+    return result;
+}
+
+static bool record_matches_prefix(const senml_in_t *ctx) {
+    const anjay_senml_record_t *record = &ctx->shared->record;
+    if (record->num_ids < ctx->num_prefix_ids) {
+        return false;
+    }
+    for (size_t i = 0; i < ctx->num_prefix_ids; ++i) {
+        if (record->ids[i] != ctx->prefix_ids[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int senml_get_id(anjay_input_ctx_t *ctx_,
+                        anjay_id_type_t *out_type, uint16_t *out_id) {
+    senml_in_t *ctx = (senml_in_t *) ctx_;
+    if (ctx->id < 0) {
+        int result = ensure_record(ctx->shared);
+        if (result) {
+            return result;
+        }
+        if (!record_matches_prefix(ctx)) {
+            /* For nested contexts, this means that the record belongs to some
+             * sibling of the entry the context was created for. */
+            return ctx->is_root ? ANJAY_ERR_BAD_REQUEST : ANJAY_GET_INDEX_END;
+        }
+        if (ctx->shared->record.num_ids <= ctx->level) {
+            anjay_log(DEBUG, "SenML record does not refer to a Resource");
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        ctx->id = ctx->shared->record.ids[ctx->level];
+    }
+    *out_type = (anjay_id_type_t) ctx->level;
+    *out_id = (uint16_t) ctx->id;
+    return 0;
+}
+
+static int senml_next_entry(anjay_input_ctx_t *ctx_) {
+    senml_in_t *ctx = (senml_in_t *) ctx_;
+    if (ctx->id < 0) {
+        return 0;
+    }
+    int result;
+    while (!(result = ensure_record(ctx->shared))
+            && record_matches_prefix(ctx)
+            && ctx->shared->record.num_ids > ctx->level
+            && ctx->shared->record.ids[ctx->level] == ctx->id) {
+        ctx->shared->has_record = false;
+    }
+    ctx->id = -1;
+    return result == ANJAY_GET_INDEX_END ? 0 : result;
+}
+
+static int get_value_record(senml_in_t *ctx,
+                            anjay_senml_value_type_t expected_type,
+                            const anjay_senml_record_t **out_record) {
+    anjay_id_type_t type;
+    uint16_t id;
+    int result = senml_get_id((anjay_input_ctx_t *) ctx, &type, &id);
+    if (result) {
+        return result == ANJAY_GET_INDEX_END ? ANJAY_ERR_BAD_REQUEST : result;
+    }
+    const anjay_senml_record_t *record = &ctx->shared->record;
+    if (record->num_ids != ctx->level + 1 || record->type != expected_type) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    *out_record = record;
+    return 0;
+}
+
+static int senml_get_some_bytes(anjay_input_ctx_t *ctx_,
+                                size_t *out_bytes_read,
+                                bool *out_message_finished,
+                                void *out_buf,
+                                size_t buf_size) {
+    senml_in_t *ctx = (senml_in_t *) ctx_;
+    const anjay_senml_record_t *record;
+    const char *data;
+    size_t data_size;
+    int result = get_value_record(ctx, ANJAY_SENML_VALUE_BYTES, &record);
+    if (!result) {
+        data = record->data;
+        data_size = record->data_size;
+    } else if (result == ANJAY_ERR_BAD_REQUEST
+            && !get_value_record(ctx, ANJAY_SENML_VALUE_STRING, &record)
+            && record->bytes_data) {
+        /* base64-encoded string in a format without a native bytes type */
+        data = record->bytes_data;
+        data_size = record->bytes_data_size;
+    } else {
+        return result;
+    }
+    assert(ctx->shared->data_offset <= data_size);
+    *out_bytes_read = AVS_MIN(buf_size, data_size - ctx->shared->data_offset);
+    memcpy(out_buf, data + ctx->shared->data_offset, *out_bytes_read);
+    ctx->shared->data_offset += *out_bytes_read;
+    *out_message_finished = (ctx->shared->data_offset == data_size);
+    return 0;
+}
+
+static int senml_get_string(anjay_input_ctx_t *ctx_,
+                            char *out_buf,
+                            size_t buf_size) {
+    senml_in_t *ctx = (senml_in_t *) ctx_;
+    const anjay_senml_record_t *record;
+    if (!buf_size) {
+        return -1;
+    }
+    int result = get_value_record(ctx, ANJAY_SENML_VALUE_STRING, &record);
+    if (result) {
+        return result;
+    }
+    assert(ctx->shared->data_offset <= record->data_size);
+    size_t bytes_to_copy = AVS_MIN(buf_size - 1,
+                                   record->data_size
+                                           - ctx->shared->data_offset);
+    memcpy(out_buf, record->data + ctx->shared->data_offset, bytes_to_copy);
+    out_buf[bytes_to_copy] = '\0';
+    ctx->shared->data_offset += bytes_to_copy;
+    return ctx->shared->data_offset == record->data_size
+            ? 0 : ANJAY_BUFFER_TOO_SHORT;
+}
+
+static int get_integer(senml_in_t *ctx, int64_t min, int64_t max,
+                       int64_t *out_value) {
+    const anjay_senml_record_t *record;
+    int result = get_value_record(ctx, ANJAY_SENML_VALUE_NUMBER, &record);
+    if (result) {
+        return result;
+    }
+    if (record->value.number.is_int) {
+        *out_value = record->value.number.i;
+    } else {
+        const double d = record->value.number.d;
+        /* accept floating-point encoded values only if they are integral */
+        if (!(d >= (double) INT64_MIN && d < (double) INT64_MAX)
+                || (double) (int64_t) d != d) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        *out_value = (int64_t) d;
+    }
+    return (*out_value < min || *out_value > max) ? ANJAY_ERR_BAD_REQUEST : 0;
+}
+
+static int senml_get_i32(anjay_input_ctx_t *ctx, int32_t *out_value) {
+    int64_t value;
+    int result = get_integer((senml_in_t *) ctx, INT32_MIN, INT32_MAX, &value);
+    if (!result) {
+        *out_value = (int32_t) value;
+    }
+    return result;
+}
+
+static int senml_get_i64(anjay_input_ctx_t *ctx, int64_t *out_value) {
+    return get_integer((senml_in_t *) ctx, INT64_MIN, INT64_MAX, out_value);
+}
+
+static int senml_get_double(anjay_input_ctx_t *ctx, double *out_value) {
+    const anjay_senml_record_t *record;
+    int result = get_value_record((senml_in_t *) ctx, ANJAY_SENML_VALUE_NUMBER,
+                                  &record);
+    if (!result) {
+        *out_value = record->value.number.d;
+    }
+    return result;
+}
+
+static int senml_get_float(anjay_input_ctx_t *ctx, float *out_value) {
+    double value;
+    int result = senml_get_double(ctx, &value);
+    if (!result) {
+        *out_value = (float) value;
+    }
+    return result;
+}
+
+static int senml_get_bool(anjay_input_ctx_t *ctx, bool *out_value) {
+    const anjay_senml_record_t *record;
+    int result = get_value_record((senml_in_t *) ctx, ANJAY_SENML_VALUE_BOOL,
+                                  &record);
+    if (!result) {
+        *out_value = record->value.boolean;
+    }
+    return result;
+}
+
+static int parse_objlnk_id(const char **ptr, const char *end,
+                           uint16_t *out_id) {
+    uint32_t value = 0;
+    const char *start = *ptr;
+    for (; *ptr < end && **ptr >= '0' && **ptr <= '9'; ++*ptr) {
+        if ((value = value * 10 + (uint32_t) (**ptr - '0')) > UINT16_MAX) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+    }
+    if (*ptr == start) {
+        return ANJAY_ERR_BAD_REQUEST;
+    }
+    *out_id = (uint16_t) value;
+    return 0;
+}
+
+static int senml_get_objlnk(anjay_input_ctx_t *ctx,
+                            anjay_oid_t *out_oid, anjay_iid_t *out_iid) {
+    const anjay_senml_record_t *record;
+    int result = get_value_record((senml_in_t *) ctx, ANJAY_SENML_VALUE_OBJLNK,
+                                  &record);
+    if (result) {
+        return result;
+    }
+    const char *ptr = record->data;
+    const char *const end = record->data + record->data_size;
+    if ((result = parse_objlnk_id(&ptr, end, out_oid))) {
+        return result;
+    }
+    if (ptr == end || *ptr++ != ':'
+            || (result = parse_objlnk_id(&ptr, end, out_iid))) {
+        return result ? result : ANJAY_ERR_BAD_REQUEST;
+    }
+    return ptr == end ? 0 : ANJAY_ERR_BAD_REQUEST;
+}
+
+static int senml_attach_child(anjay_input_ctx_t *ctx_,
+                              anjay_input_ctx_t *child) {
+    senml_in_t *ctx = (senml_in_t *) ctx_;
+    int result = _anjay_input_ctx_destroy(&ctx->child);
+    if (result) {
+        return result;
+    }
+    ctx->child = child;
+    return 0;
+}
+
+static anjay_input_ctx_t *senml_nested_ctx(anjay_input_ctx_t *ctx_);
+
+static int senml_in_close(anjay_input_ctx_t *ctx_) {
+    senml_in_t *ctx = (senml_in_t *) ctx_;
+    _anjay_input_ctx_destroy(&ctx->child);
+    if (ctx->is_root) {
+        if (ctx->shared->decoder) {
+            ctx->shared->decoder->vtable->delete_(ctx->shared->decoder);
+        }
+        free(ctx->shared);
+    }
+    return 0;
+}
+
+static const anjay_input_ctx_vtable_t SENML_IN_VTABLE = {
+    .some_bytes = senml_get_some_bytes,
+    .string = senml_get_string,
+    .i32 = senml_get_i32,
+    .i64 = senml_get_i64,
+    .f32 = senml_get_float,
+    .f64 = senml_get_double,
+    .boolean = senml_get_bool,
+    .objlnk = senml_get_objlnk,
+    .attach_child = senml_attach_child,
+    .get_id = senml_get_id,
+    .next_entry = senml_next_entry,
+    .close = senml_in_close,
+    .nested_ctx = senml_nested_ctx
+};
+
+static anjay_input_ctx_t *senml_nested_ctx(anjay_input_ctx_t *ctx_) {
+    senml_in_t *ctx = (senml_in_t *) ctx_;
+    anjay_id_type_t type;
+    uint16_t id;
+    if (ctx->level + 1 >= ANJAY_SENML_MAX_PATH_IDS
+            || senml_get_id(ctx_, &type, &id)) {
+        return NULL;
+    }
+    senml_in_t *child = (senml_in_t *) calloc(1, sizeof(senml_in_t));
+    if (!child) {
+        return NULL;
+    }
+    child->vtable = &SENML_IN_VTABLE;
+    child->shared = ctx->shared;
+    memcpy(child->prefix_ids, ctx->shared->record.ids,
+           ctx->level * sizeof(*child->prefix_ids));
+    child->prefix_ids[ctx->level] = id;
+    child->num_prefix_ids = ctx->level + 1;
+    child->level = ctx->level + 1;
+    child->id = -1;
+    if (senml_attach_child(ctx_, (anjay_input_ctx_t *) child)) {
+        free(child);
+        return NULL;
+    }
+    return (anjay_input_ctx_t *) child;
+}
+
+int _anjay_input_senml_create(anjay_input_ctx_t **out,
+                              anjay_senml_decoder_t *decoder,
+                              const anjay_uri_path_t *base_path) {
+    senml_in_t *ctx = (senml_in_t *) calloc(1, sizeof(senml_in_t));
+    *out = (anjay_input_ctx_t *) ctx;
+    if (!ctx || !(ctx->shared = (senml_in_shared_t *)
+                          calloc(1, sizeof(senml_in_shared_t)))) {
+        free(ctx);
+        *out = NULL;
+        decoder->vtable->delete_(decoder);
+        return -1;
+    }
+    ctx->vtable = &SENML_IN_VTABLE;
+    ctx->shared->decoder = decoder;
+    ctx->is_root = true;
+    ctx->id = -1;
+    if (base_path->has_oid) {
+        ctx->prefix_ids[ctx->num_prefix_ids++] = base_path->oid;
+        ctx->level = ANJAY_ID_IID;
+    }
+    if (base_path->has_iid) {
+        ctx->prefix_ids[ctx->num_prefix_ids++] = base_path->iid;
+        ctx->level = ANJAY_ID_RID;
+    }
+    if (base_path->has_rid) {
+        ctx->prefix_ids[ctx->num_prefix_ids++] = base_path->rid;
+    }
+    return 0;
+}
+
+int _anjay_input_senml_get_request_path(avs_stream_abstract_t *stream,
+                                        anjay_uri_path_t *out_path) {
+    const avs_coap_msg_t *msg;
+    bool is_bs;
+    int result;
+    if (!_anjay_is_coap_stream(stream)) {
+        memset(out_path, 0, sizeof(*out_path));
+        return 0;
+    }
+    if ((result = _anjay_coap_stream_get_incoming_msg(stream, &msg))
+            || (result = _anjay_parse_request_uri(msg, &is_bs, out_path))) {
+        return result;
+    }
+    return is_bs ? ANJAY_ERR_BAD_REQUEST : 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_IO_SENML_IN_H
+#define ANJAY_IO_SENML_IN_H
+
+#include <anjay/core.h>
+
+#include "../io_core.h"
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+/**
+ * Common part of input contexts for SenML-like formats, in which the payload is
+ * a flat list of records, each identified by an absolute path. The generic
+ * code in senml_in.c maps such a list onto the hierarchical
+ * get_id/next_entry/nested_ctx model used by the data model code, while
+ * format-specific decoders only need to deliver records one by one.
+ */
+
+#define ANJAY_SENML_MAX_PATH_IDS 4
+
+typedef enum {
+    ANJAY_SENML_VALUE_NUMBER,
+    ANJAY_SENML_VALUE_BOOL,
+    ANJAY_SENML_VALUE_STRING,
+    ANJAY_SENML_VALUE_BYTES,
+    ANJAY_SENML_VALUE_OBJLNK
+} anjay_senml_value_type_t;
+
+typedef struct {
+    /* Absolute path of the record, i.e. concatenation of basename and name */
+    uint16_t ids[ANJAY_SENML_MAX_PATH_IDS];
+    size_t num_ids;
+
+    anjay_senml_value_type_t type;
+    union {
+        struct {
+            /* true if the value was encoded as an integer; i is then exact */
+            bool is_int;
+            int64_t i;
+            double d;
+        } number;
+        bool boolean;
+    } value;
+    /* Contents of STRING, BYTES and OBJLNK values. Not null-terminated. Owned
+     * by the decoder and valid until the next call to next_record. */
+    const char *data;
+    size_t data_size;
+    /* Only for STRING values in formats that carry opaque data as
+     * base64-encoded strings: decoded contents of the string, or NULL if it
+     * is not valid base64. Owned by the decoder, just like data. */
+    const char *bytes_data;
+    size_t bytes_data_size;
+} anjay_senml_record_t;
+
+typedef struct anjay_senml_decoder_struct anjay_senml_decoder_t;
+
+/**
+ * Decodes the next record from the payload into @p out_record.
+ *
+ * @returns 0 on success, ANJAY_GET_INDEX_END if there are no more records,
+ *          ANJAY_ERR_BAD_REQUEST if the payload is malformed, or a different
+ *          negative value in case of other errors.
+ */
+typedef int anjay_senml_decoder_next_record_t(anjay_senml_decoder_t *decoder,
+                                              anjay_senml_record_t *out_record);
+
+/**
+ * Releases all resources associated with the decoder, including the decoder
+ * itself.
+ */
+typedef void anjay_senml_decoder_delete_t(anjay_senml_decoder_t *decoder);
+
+typedef struct {
+    anjay_senml_decoder_next_record_t *next_record;
+    anjay_senml_decoder_delete_t *delete_;
+} anjay_senml_decoder_vtable_t;
+
+struct anjay_senml_decoder_struct {
+    const anjay_senml_decoder_vtable_t *vtable;
+};
+
+/**
+ * Parses an absolute path string, e.g. "/3/0/1", into numeric IDs.
+ *
+ * @returns 0 on success, ANJAY_ERR_BAD_REQUEST if the path is invalid.
+ */
+int _anjay_senml_parse_path(anjay_senml_record_t *out_record,
+                            const char *path,
+                            size_t path_size);
+
+/**
+ * Creates a hierarchical input context on top of @p decoder. Ownership of the
+ * decoder is transferred to the created context, even on failure.
+ *
+ * @param base_path Path of the request that carries the payload. Records that
+ *                  do not belong to this path are rejected.
+ */
+int _anjay_input_senml_create(anjay_input_ctx_t **out,
+                              anjay_senml_decoder_t *decoder,
+                              const anjay_uri_path_t *base_path);
+
+/**
+ * Retrieves the request path from the CoAP message being read through
+ * @p stream, for use as the base_path argument to _anjay_input_senml_create.
+ * If @p stream is not a CoAP stream, an empty (root) path is returned.
+ */
+int _anjay_input_senml_get_request_path(avs_stream_abstract_t *stream,
+                                        anjay_uri_path_t *out_path);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_IO_SENML_IN_H */
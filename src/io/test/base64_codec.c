@@ -0,0 +1,132 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <config.h>
+
+#include <inttypes.h>
+
+#include <avsystem/commons/time.h>
+#include <avsystem/commons/unit/test.h>
+
+#define CODEC_TEST_MAX_GROUPS 300
+
+static void fill_codec_test_data(uint8_t *data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = (uint8_t) (i * 151 + 7);
+    }
+}
+
+AVS_UNIT_TEST(base64_codec, matches_scalar) {
+    static uint8_t data[3 * CODEC_TEST_MAX_GROUPS];
+    fill_codec_test_data(data, sizeof(data));
+    for (size_t num_groups = 0; num_groups <= CODEC_TEST_MAX_GROUPS;
+            ++num_groups) {
+        char encoded[4 * CODEC_TEST_MAX_GROUPS + 1];
+        char expected[4 * CODEC_TEST_MAX_GROUPS + 1];
+        encoded[4 * num_groups] = '!';
+        _anjay_base64_encode_groups(encoded, data, num_groups);
+        encode_groups_scalar(expected, data, num_groups);
+        AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(encoded, expected, 4 * num_groups);
+        // nothing past the output shall be touched
+        AVS_UNIT_ASSERT_EQUAL(encoded[4 * num_groups], '!');
+
+        uint8_t decoded[3 * CODEC_TEST_MAX_GROUPS + 1];
+        decoded[3 * num_groups] = 0xA5;
+        AVS_UNIT_ASSERT_SUCCESS(
+                _anjay_base64_decode_groups(decoded, encoded, num_groups));
+        AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(decoded, data, 3 * num_groups);
+        AVS_UNIT_ASSERT_EQUAL(decoded[3 * num_groups], 0xA5);
+    }
+}
+
+AVS_UNIT_TEST(base64_codec, invalid_chars) {
+    static const char INVALID_CHARS[] = { '\0', ' ', '=', '-', '_', '*',
+                                          '\x7F', '\x80', '\xFF' };
+    char encoded[4 * 40];
+    memset(encoded, 'A', sizeof(encoded));
+    uint8_t decoded[3 * 40];
+    for (size_t pos = 0; pos < sizeof(encoded); ++pos) {
+        for (size_t i = 0; i < sizeof(INVALID_CHARS); ++i) {
+            encoded[pos] = INVALID_CHARS[i];
+            AVS_UNIT_ASSERT_FAILED(
+                    _anjay_base64_decode_groups(decoded, encoded, 40));
+        }
+        encoded[pos] = 'A';
+    }
+}
+
+AVS_UNIT_TEST(base64_codec, final_group) {
+    uint8_t decoded[3];
+    AVS_UNIT_ASSERT_EQUAL(_anjay_base64_decode_group(decoded, "QUJD", true),
+                          3);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(decoded, "ABC", 3);
+    AVS_UNIT_ASSERT_EQUAL(_anjay_base64_decode_group(decoded, "QUI=", true),
+                          2);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(decoded, "AB", 2);
+    AVS_UNIT_ASSERT_EQUAL(_anjay_base64_decode_group(decoded, "QQ==", true),
+                          1);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(decoded, "A", 1);
+
+    // padding is only allowed in the last group
+    AVS_UNIT_ASSERT_FAILED(_anjay_base64_decode_group(decoded, "QUI=", false));
+    // bits replaced by padding must be zero
+    AVS_UNIT_ASSERT_FAILED(_anjay_base64_decode_group(decoded, "QUJ=", true));
+    AVS_UNIT_ASSERT_FAILED(_anjay_base64_decode_group(decoded, "QR==", true));
+    AVS_UNIT_ASSERT_FAILED(_anjay_base64_decode_group(decoded, "Q/==", true));
+}
+
+#define CODEC_BENCH_GROUPS 64
+#define CODEC_BENCH_ROUNDS 20000
+
+static int64_t codec_elapsed_us(avs_time_monotonic_t start) {
+    int64_t result;
+    AVS_UNIT_ASSERT_SUCCESS(avs_time_duration_to_scalar(
+            &result, AVS_TIME_US,
+            avs_time_monotonic_diff(avs_time_monotonic_now(), start)));
+    return result;
+}
+
+AVS_UNIT_TEST(base64_codec, benchmark) {
+    // one chunk as processed by the text/plain input and output contexts
+    static uint8_t data[3 * CODEC_BENCH_GROUPS];
+    static char encoded[4 * CODEC_BENCH_GROUPS];
+    static uint8_t decoded[3 * CODEC_BENCH_GROUPS];
+    fill_codec_test_data(data, sizeof(data));
+
+    avs_time_monotonic_t start = avs_time_monotonic_now();
+    for (int round = 0; round < CODEC_BENCH_ROUNDS; ++round) {
+        encode_groups_scalar(encoded, data, CODEC_BENCH_GROUPS);
+        AVS_UNIT_ASSERT_SUCCESS(decode_groups_scalar(decoded, encoded,
+                                                     CODEC_BENCH_GROUPS));
+    }
+    const int64_t scalar_us = codec_elapsed_us(start);
+
+    start = avs_time_monotonic_now();
+    for (int round = 0; round < CODEC_BENCH_ROUNDS; ++round) {
+        _anjay_base64_encode_groups(encoded, data, CODEC_BENCH_GROUPS);
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_base64_decode_groups(
+                decoded, encoded, CODEC_BENCH_GROUPS));
+    }
+    const int64_t simd_us = codec_elapsed_us(start);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(decoded, data, sizeof(data));
+
+    anjay_log(INFO,
+              "base64 encode+decode of %d bytes %d times: scalar %" PRId64
+              " us, dispatched %" PRId64 " us",
+              3 * CODEC_BENCH_GROUPS, CODEC_BENCH_ROUNDS, scalar_us,
+              simd_us);
+}
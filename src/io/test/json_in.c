@@ -0,0 +1,355 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <avsystem/commons/unit/memstream.h>
+#include <avsystem/commons/unit/test.h>
+
+#include <anjay/core.h>
+
+#define TEST_ENV(Format, Data, ...) \
+    avs_stream_abstract_t *stream = NULL; \
+    AVS_UNIT_ASSERT_SUCCESS(avs_unit_memstream_alloc(&stream, \
+                                                     sizeof(Data))); \
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, Data, \
+                                             sizeof(Data) - 1)); \
+    const anjay_uri_path_t base_path = __VA_ARGS__; \
+    anjay_input_ctx_t *in; \
+    AVS_UNIT_ASSERT_SUCCESS( \
+            json_in_create(&in, &stream, false, (Format), &base_path))
+
+#define TEST_TEARDOWN do { \
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_ctx_destroy(&in)); \
+    avs_stream_cleanup(&stream); \
+} while (0)
+
+#define ASSERT_ID(Ctx, IdType, Id) do { \
+    anjay_id_type_t type; \
+    uint16_t id; \
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_get_id((Ctx), &type, &id)); \
+    AVS_UNIT_ASSERT_EQUAL(type, (IdType)); \
+    AVS_UNIT_ASSERT_EQUAL(id, (Id)); \
+} while (0)
+
+#define ASSERT_NO_MORE_IDS(Ctx) do { \
+    anjay_id_type_t type; \
+    uint16_t id; \
+    AVS_UNIT_ASSERT_EQUAL(_anjay_input_get_id((Ctx), &type, &id), \
+                          ANJAY_GET_INDEX_END); \
+} while (0)
+
+/* reads all records and expects the last one to fail */
+#define ASSERT_FAILS_WITH_BAD_REQUEST(Format, Data, ...) do { \
+    TEST_ENV((Format), Data, __VA_ARGS__); \
+    anjay_id_type_t type; \
+    uint16_t id; \
+    int result; \
+    while (!(result = _anjay_input_get_id(in, &type, &id))) { \
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in)); \
+    } \
+    AVS_UNIT_ASSERT_EQUAL(result, ANJAY_ERR_BAD_REQUEST); \
+    TEST_TEARDOWN; \
+} while (0)
+
+#define URI_ROOT { .has_oid = false }
+
+#define URI_IID(Oid, Iid) \
+    { .oid = (Oid), .iid = (Iid), .has_oid = true, .has_iid = true }
+
+AVS_UNIT_TEST(json_in, lwm2m_json_instance) {
+    TEST_ENV(JSON_FORMAT_LWM2M,
+             "{\"bn\":\"/3/0/\",\"bt\":12345,\"e\":[\n"
+             "  {\"n\":\"1\",\"v\":42},\n"
+             "  {\"n\":\"2\",\"sv\":\"h\\u00e9\\\"llo\\n\"},\n"
+             "  {\"n\":\"3\",\"bv\":true,\"t\":-5},\n"
+             "  {\"n\":\"4\",\"v\":-1.5e0},\n"
+             "  {\"n\":\"5\",\"ov\":\"1:2\"},\n"
+             "  {\"n\":\"6/0\",\"sv\":\"Zm9vYg==\"},\n"
+             "  {\"n\":\"6/1\",\"sv\":\"\"}\n"
+             "]}\n",
+             URI_IID(3, 0));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 1);
+    int32_t i32;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_i32(in, &i32));
+    AVS_UNIT_ASSERT_EQUAL(i32, 42);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 2);
+    char str[16];
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_string(in, str, sizeof(str)));
+    AVS_UNIT_ASSERT_EQUAL_STRING(str, "h\xC3\xA9\"llo\n");
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 3);
+    bool value;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_bool(in, &value));
+    AVS_UNIT_ASSERT_TRUE(value);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 4);
+    double d;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_double(in, &d));
+    AVS_UNIT_ASSERT_EQUAL(d, -1.5);
+    AVS_UNIT_ASSERT_FAILED(anjay_get_i32(in, &i32));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 5);
+    anjay_oid_t oid;
+    anjay_iid_t iid;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_objlnk(in, &oid, &iid));
+    AVS_UNIT_ASSERT_EQUAL(oid, 1);
+    AVS_UNIT_ASSERT_EQUAL(iid, 2);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 6);
+    anjay_input_ctx_t *array = anjay_get_array(in);
+    AVS_UNIT_ASSERT_NOT_NULL(array);
+    anjay_riid_t riid;
+    char buf[8];
+    size_t bytes_read;
+    bool message_finished;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_array_index(array, &riid));
+    AVS_UNIT_ASSERT_EQUAL(riid, 0);
+    /* opaque data is base64-encoded in LwM2M JSON */
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_bytes(array, &bytes_read,
+                                            &message_finished,
+                                            buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, 4);
+    AVS_UNIT_ASSERT_TRUE(message_finished);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, "foob", 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_array_index(array, &riid));
+    AVS_UNIT_ASSERT_EQUAL(riid, 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_bytes(array, &bytes_read,
+                                            &message_finished,
+                                            buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, 0);
+    AVS_UNIT_ASSERT_TRUE(message_finished);
+    AVS_UNIT_ASSERT_EQUAL(anjay_get_array_index(array, &riid),
+                          ANJAY_GET_INDEX_END);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    ASSERT_NO_MORE_IDS(in);
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(json_in, lwm2m_json_implicit_basename) {
+    TEST_ENV(JSON_FORMAT_LWM2M,
+             "{\"e\":[{\"n\":\"7\",\"v\":1}],\"unknown\":{\"a\":[1,{}]}}",
+             URI_IID(3, 0));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 7);
+    int64_t i64;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_i64(in, &i64));
+    AVS_UNIT_ASSERT_EQUAL(i64, 1);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+    ASSERT_NO_MORE_IDS(in);
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(json_in, lwm2m_json_absolute_names) {
+    TEST_ENV(JSON_FORMAT_LWM2M,
+             "{\"e\":[{\"n\":\"/3/0/1\",\"v\":42},"
+             "{\"n\":\"/3/0/14\",\"sv\":\"+02\"}]}",
+             URI_IID(3, 0));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 1);
+    int32_t i32;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_i32(in, &i32));
+    AVS_UNIT_ASSERT_EQUAL(i32, 42);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 14);
+    char str[8];
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_string(in, str, sizeof(str)));
+    AVS_UNIT_ASSERT_EQUAL_STRING(str, "+02");
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+    ASSERT_NO_MORE_IDS(in);
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(json_in, lwm2m_json_anjay_output_without_basename) {
+    /* records of src/io/test/json_out.c outputs, with "bn" stripped */
+    TEST_ENV(JSON_FORMAT_LWM2M,
+             "{\"e\":[{\"n\":\"/1\",\"v\":-2147483648},"
+             "{\"n\":\"/5\",\"ov\":\"65535:0\"},"
+             "{\"n\":\"/65534\",\"v\":-0.500000}]}",
+             URI_IID(3, 0));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 1);
+    int32_t i32;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_i32(in, &i32));
+    AVS_UNIT_ASSERT_EQUAL(i32, INT32_MIN);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 5);
+    anjay_oid_t oid;
+    anjay_iid_t iid;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_objlnk(in, &oid, &iid));
+    AVS_UNIT_ASSERT_EQUAL(oid, 65535);
+    AVS_UNIT_ASSERT_EQUAL(iid, 0);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 65534);
+    double value;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_double(in, &value));
+    AVS_UNIT_ASSERT_EQUAL(value, -0.5);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+    ASSERT_NO_MORE_IDS(in);
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(json_in, lwm2m_json_relative_names_with_slash) {
+    /* "/1/0" is Instance 1 of the requested Object, not Object 1 */
+    TEST_ENV(JSON_FORMAT_LWM2M,
+             "{\"e\":[{\"n\":\"/1/0\",\"v\":5}]}",
+             { .oid = 3, .has_oid = true });
+
+    ASSERT_ID(in, ANJAY_ID_IID, 1);
+    anjay_input_ctx_t *instance = _anjay_input_nested_ctx(in);
+    AVS_UNIT_ASSERT_NOT_NULL(instance);
+    ASSERT_ID(instance, ANJAY_ID_RID, 0);
+    int32_t i32;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_i32(instance, &i32));
+    AVS_UNIT_ASSERT_EQUAL(i32, 5);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(instance));
+    ASSERT_NO_MORE_IDS(instance);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+    ASSERT_NO_MORE_IDS(in);
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(json_in, senml_json_instances) {
+    TEST_ENV(JSON_FORMAT_SENML,
+             "[{\"bn\":\"/1/\",\"n\":\"0/1\",\"v\":86400},"
+             "{\"n\":\"0/6\",\"vb\":false,\"u\":\"s\",\"x\":[null]},"
+             "{\"n\":\"1/1\",\"v\":3.0},"
+             "{\"n\":\"1/7\",\"vs\":\"U\"},"
+             "{\"bn\":\"/5/0/\",\"n\":\"0\",\"vd\":\"AP-_\"}]",
+             URI_ROOT);
+
+    ASSERT_ID(in, ANJAY_ID_OID, 1);
+    anjay_input_ctx_t *object = _anjay_input_nested_ctx(in);
+    AVS_UNIT_ASSERT_NOT_NULL(object);
+
+    ASSERT_ID(object, ANJAY_ID_IID, 0);
+    anjay_input_ctx_t *instance = _anjay_input_nested_ctx(object);
+    AVS_UNIT_ASSERT_NOT_NULL(instance);
+    ASSERT_ID(instance, ANJAY_ID_RID, 1);
+    int32_t i32;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_i32(instance, &i32));
+    AVS_UNIT_ASSERT_EQUAL(i32, 86400);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(instance));
+    ASSERT_ID(instance, ANJAY_ID_RID, 6);
+    bool value;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_bool(instance, &value));
+    AVS_UNIT_ASSERT_FALSE(value);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(instance));
+    ASSERT_NO_MORE_IDS(instance);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(object));
+
+    ASSERT_ID(object, ANJAY_ID_IID, 1);
+    instance = _anjay_input_nested_ctx(object);
+    AVS_UNIT_ASSERT_NOT_NULL(instance);
+    ASSERT_ID(instance, ANJAY_ID_RID, 1);
+    /* integral floating-point values are accepted as integers */
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_i32(instance, &i32));
+    AVS_UNIT_ASSERT_EQUAL(i32, 3);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(instance));
+    ASSERT_ID(instance, ANJAY_ID_RID, 7);
+    char str[4];
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_string(instance, str, sizeof(str)));
+    AVS_UNIT_ASSERT_EQUAL_STRING(str, "U");
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(instance));
+    ASSERT_NO_MORE_IDS(instance);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(object));
+    ASSERT_NO_MORE_IDS(object);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    ASSERT_ID(in, ANJAY_ID_OID, 5);
+    object = _anjay_input_nested_ctx(in);
+    AVS_UNIT_ASSERT_NOT_NULL(object);
+    ASSERT_ID(object, ANJAY_ID_IID, 0);
+    instance = _anjay_input_nested_ctx(object);
+    AVS_UNIT_ASSERT_NOT_NULL(instance);
+    ASSERT_ID(instance, ANJAY_ID_RID, 0);
+    char buf[8];
+    size_t bytes_read;
+    bool message_finished;
+    /* URL-safe base64 without padding, as mandated by SenML */
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_bytes(instance, &bytes_read,
+                                            &message_finished,
+                                            buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, 3);
+    AVS_UNIT_ASSERT_TRUE(message_finished);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, "\x00\xFF\xBF", 3);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(instance));
+    ASSERT_NO_MORE_IDS(instance);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(object));
+    ASSERT_NO_MORE_IDS(object);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    ASSERT_NO_MORE_IDS(in);
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(json_in, senml_json_empty) {
+    TEST_ENV(JSON_FORMAT_SENML, " [ ] ", URI_ROOT);
+    ASSERT_NO_MORE_IDS(in);
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(json_in, malformed) {
+    ASSERT_FAILS_WITH_BAD_REQUEST(JSON_FORMAT_SENML, "", URI_ROOT);
+    ASSERT_FAILS_WITH_BAD_REQUEST(JSON_FORMAT_SENML, "{}", URI_ROOT);
+    ASSERT_FAILS_WITH_BAD_REQUEST(JSON_FORMAT_SENML, "[", URI_ROOT);
+    ASSERT_FAILS_WITH_BAD_REQUEST(JSON_FORMAT_SENML, "[{}]", URI_ROOT);
+    ASSERT_FAILS_WITH_BAD_REQUEST(JSON_FORMAT_SENML, "[] []", URI_ROOT);
+    ASSERT_FAILS_WITH_BAD_REQUEST(JSON_FORMAT_SENML,
+                                  "[{\"n\":\"/1/0/0\",\"v\":1},]", URI_ROOT);
+    ASSERT_FAILS_WITH_BAD_REQUEST(JSON_FORMAT_SENML,
+                                  "[{\"n\":\"/1/0/0\" \"v\":1}]", URI_ROOT);
+    ASSERT_FAILS_WITH_BAD_REQUEST(JSON_FORMAT_SENML,
+                                  "[{\"n\":\"/1/0/0\",\"v\":1,}]", URI_ROOT);
+    ASSERT_FAILS_WITH_BAD_REQUEST(JSON_FORMAT_SENML,
+                                  "[{\"n\":\"/1/0/0\",\"v\":1,\"vb\":true}]",
+                                  URI_ROOT);
+    ASSERT_FAILS_WITH_BAD_REQUEST(JSON_FORMAT_SENML,
+                                  "[{\"n\":\"/1/0/0\",\"bv\":1}]", URI_ROOT);
+    ASSERT_FAILS_WITH_BAD_REQUEST(JSON_FORMAT_SENML,
+                                  "[{\"n\":\"/1/0/0\",\"vd\":\"A\"}]",
+                                  URI_ROOT);
+    ASSERT_FAILS_WITH_BAD_REQUEST(JSON_FORMAT_SENML,
+                                  "[{\"n\":\"/1/0/0\",\"vs\":\"\\ud800\"}]",
+                                  URI_ROOT);
+    ASSERT_FAILS_WITH_BAD_REQUEST(JSON_FORMAT_SENML,
+                                  "[{\"n\":\"/1/0/0\",\"x\":[1}],\"v\":1}]",
+                                  URI_ROOT);
+    ASSERT_FAILS_WITH_BAD_REQUEST(JSON_FORMAT_SENML,
+                                  "[{\"n\":\"/1/0/0\",\"x\":"
+                                  "[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[["
+                                  "]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]],"
+                                  "\"v\":1}]",
+                                  URI_ROOT);
+    ASSERT_FAILS_WITH_BAD_REQUEST(JSON_FORMAT_LWM2M,
+                                  "{\"e\":[{\"n\":\"1\",\"v\":1}],\"bn\":\"/\"}",
+                                  URI_IID(3, 0));
+    ASSERT_FAILS_WITH_BAD_REQUEST(JSON_FORMAT_LWM2M,
+                                  "{\"bn\":\"/3/1/\",\"e\":[{\"n\":\"1\","
+                                  "\"v\":1}]}",
+                                  URI_IID(3, 0));
+}
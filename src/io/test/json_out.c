@@ -0,0 +1,310 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <avsystem/commons/stream_v_table.h>
+#include <avsystem/commons/time.h>
+#include <avsystem/commons/unit/test.h>
+
+#include <anjay/core.h>
+
+static int test_setup_response(avs_stream_abstract_t *stream,
+                               const anjay_msg_details_t *details) {
+    (void) stream;
+    AVS_UNIT_ASSERT_EQUAL(details->format, ANJAY_COAP_FORMAT_JSON);
+    return 0;
+}
+
+static const anjay_coap_stream_ext_t COAPIZATION = {
+    .setup_response = test_setup_response,
+};
+
+static const avs_stream_v_table_extension_t COAPIZED_VTABLE_EXT[] = {
+    { ANJAY_COAP_STREAM_EXTENSION, &COAPIZATION },
+    AVS_STREAM_V_TABLE_EXTENSION_NULL
+};
+
+static avs_stream_v_table_t COAPIZED_VTABLE;
+
+AVS_UNIT_SUITE_INIT(json_out, verbose) {
+    (void) verbose;
+    memcpy(&COAPIZED_VTABLE, AVS_STREAM_OUTBUF_STATIC_INITIALIZER.vtable,
+           sizeof(COAPIZED_VTABLE));
+
+    COAPIZED_VTABLE.extension_list = COAPIZED_VTABLE_EXT;
+}
+
+static const avs_stream_outbuf_t COAPIZED_OUTBUF
+        = {&COAPIZED_VTABLE, NULL, 0, 0, 0};
+
+#define TEST_ENV_COMMON(Uri) \
+    anjay_msg_details_t details = { \
+        .msg_type = AVS_COAP_MSG_NON_CONFIRMABLE, \
+        .format = ANJAY_COAP_FORMAT_JSON \
+    }; \
+    avs_stream_outbuf_t outbuf = COAPIZED_OUTBUF; \
+    avs_stream_outbuf_set_buffer(&outbuf, buf, sizeof(buf)); \
+    int outctx_errno = 0; \
+    const anjay_uri_path_t uri = Uri; \
+    anjay_output_ctx_t *out = \
+            _anjay_output_json_create((avs_stream_abstract_t *) &outbuf, \
+                                      &outctx_errno, &details, &uri); \
+    AVS_UNIT_ASSERT_NOT_NULL(out)
+
+#define TEST_ENV(Size, Uri) char buf[Size]; TEST_ENV_COMMON(Uri)
+
+#define TEST_ENV_HEAP(Size, Uri) \
+    char *buf = (char *) malloc(Size); TEST_ENV_COMMON(Uri)
+
+#define URI_OID(Oid) { .oid = (Oid), .has_oid = true }
+
+#define URI_IID(Oid, Iid) \
+    { .oid = (Oid), .iid = (Iid), .has_oid = true, .has_iid = true }
+
+#define URI_RID(Oid, Iid, Rid) \
+    { .oid = (Oid), .iid = (Iid), .rid = (Rid), \
+      .has_oid = true, .has_iid = true, .has_rid = true }
+
+#define VERIFY_BYTES(Data) do { \
+    AVS_UNIT_ASSERT_EQUAL(avs_stream_outbuf_offset(&outbuf), sizeof(Data) - 1);\
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, Data, sizeof(Data) - 1); \
+} while (0)
+
+AVS_UNIT_TEST(json_out, single_resource) {
+    TEST_ENV(256, URI_RID(3, 0, 9));
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 9));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(out, 42));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    VERIFY_BYTES("{\"bn\":\"/3/0/9\",\"e\":[{\"v\":42}]}");
+}
+
+AVS_UNIT_TEST(json_out, instance_of_scalars) {
+    TEST_ENV(512, URI_IID(3, 0));
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 1));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(out, INT32_MIN));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 2));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i64(out, INT64_MIN));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 3));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i64(out, 0));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 4));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_bool(out, false));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 5));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_objlnk(out, 65535, 0));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 65534));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_double(out, -0.5));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    VERIFY_BYTES("{\"bn\":\"/3/0\",\"e\":["
+                 "{\"n\":\"/1\",\"v\":-2147483648},"
+                 "{\"n\":\"/2\",\"v\":-9223372036854775808},"
+                 "{\"n\":\"/3\",\"v\":0},"
+                 "{\"n\":\"/4\",\"bv\":false},"
+                 "{\"n\":\"/5\",\"ov\":\"65535:0\"},"
+                 "{\"n\":\"/65534\",\"v\":-0.500000}]}");
+}
+
+AVS_UNIT_TEST(json_out, string_escaping) {
+    TEST_ENV(256, URI_RID(3, 0, 0));
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 0));
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_ret_string(out, "a\"b\\c\b\f\n\r\t\x01\x1Fz\xC4\x85"));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    VERIFY_BYTES("{\"bn\":\"/3/0/0\",\"e\":[{\"sv\":"
+                 "\"a\\\"b\\\\c\\b\\f\\n\\r\\t\\u0001\\u001fz\xC4\x85\"}]}");
+}
+
+AVS_UNIT_TEST(json_out, multiple_instance_resource) {
+    TEST_ENV(256, URI_OID(3));
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_IID, 0));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 7));
+    anjay_output_ctx_t *array = anjay_ret_array_start(out);
+    AVS_UNIT_ASSERT_NOT_NULL(array);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_array_index(array, 0));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_string(array, "x"));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_array_index(array, 65535));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_string(array, ""));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_array_finish(array));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    VERIFY_BYTES("{\"bn\":\"/3\",\"e\":["
+                 "{\"n\":\"/0/7/0\",\"sv\":\"x\"},"
+                 "{\"n\":\"/0/7/65535\",\"sv\":\"\"}]}");
+}
+
+AVS_UNIT_TEST(json_out, bytes) {
+    TEST_ENV(256, URI_IID(5, 0));
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 0));
+    anjay_ret_bytes_ctx_t *bytes = anjay_ret_bytes_begin(out, 3);
+    AVS_UNIT_ASSERT_NOT_NULL(bytes);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_bytes_append(bytes, "foo", 3));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 1));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(out, 1));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    VERIFY_BYTES("{\"bn\":\"/5/0\",\"e\":["
+                 "{\"n\":\"/0\",\"sv\":\"Zm9v\"},"
+                 "{\"n\":\"/1\",\"v\":1}]}");
+}
+
+/* Large Read of an object with 1000 integer Resources; the expected payload is
+ * built independently with printf-style formatting. */
+AVS_UNIT_TEST(json_out, thousand_resources) {
+    static const size_t NUM_RESOURCES = 1000;
+    static const size_t BUF_SIZE = 65536;
+    TEST_ENV_HEAP(BUF_SIZE, URI_OID(42));
+    char *expected = (char *) malloc(BUF_SIZE);
+    AVS_UNIT_ASSERT_NOT_NULL(expected);
+    size_t expected_size = 0;
+
+    ssize_t written = avs_simple_snprintf(expected, BUF_SIZE,
+                                          "{\"bn\":\"/42\",\"e\":[");
+    AVS_UNIT_ASSERT_TRUE(written > 0);
+    expected_size += (size_t) written;
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_IID, 1));
+    for (size_t i = 0; i < NUM_RESOURCES; ++i) {
+        const int64_t value = (int64_t) (i * 7919) - 1000000;
+        AVS_UNIT_ASSERT_SUCCESS(
+                _anjay_output_set_id(out, ANJAY_ID_RID, (uint16_t) i));
+        AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i64(out, value));
+
+        written = avs_simple_snprintf(
+                expected + expected_size, BUF_SIZE - expected_size,
+                "%s{\"n\":\"/1/%u\",\"v\":%" PRId64 "}", i ? "," : "",
+                (unsigned) i, value);
+        AVS_UNIT_ASSERT_TRUE(written > 0);
+        expected_size += (size_t) written;
+    }
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+
+    written = avs_simple_snprintf(expected + expected_size,
+                                  BUF_SIZE - expected_size, "]}");
+    AVS_UNIT_ASSERT_TRUE(written > 0);
+    expected_size += (size_t) written;
+
+    AVS_UNIT_ASSERT_EQUAL(avs_stream_outbuf_offset(&outbuf), expected_size);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, expected, expected_size);
+    free(expected);
+    free(buf);
+}
+
+/* Encodes a single integer Resource the way this encoder did before it
+ * stopped using printf-style formatting: a separate avs_stream_write_f() call
+ * for the name, the value type and the value itself. */
+static void legacy_write_i64_element(avs_stream_abstract_t *stream,
+                                     bool first,
+                                     anjay_iid_t iid,
+                                     anjay_rid_t rid,
+                                     int64_t value) {
+    char name[32];
+    AVS_UNIT_ASSERT_TRUE(avs_simple_snprintf(name, sizeof(name),
+                                             "/%" PRId32 "/%" PRId32,
+                                             (int32_t) iid, (int32_t) rid)
+                         > 0);
+    if (!first) {
+        AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, ",", 1));
+    }
+    AVS_UNIT_ASSERT_SUCCESS(
+            avs_stream_write_f(stream, "{\"n\":\"%s\",", name));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write_f(stream, "\"%s\":", "v"));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write_f(stream, "%" PRIi64, value));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, "}", 1));
+}
+
+static int64_t json_out_elapsed_us(avs_time_monotonic_t start) {
+    int64_t result = 0;
+    AVS_UNIT_ASSERT_SUCCESS(avs_time_duration_to_scalar(
+            &result, AVS_TIME_US,
+            avs_time_monotonic_diff(avs_time_monotonic_now(), start)));
+    return result;
+}
+
+static uint64_t bytes_per_second(size_t bytes, int rounds, int64_t us) {
+    return us > 0 ? (uint64_t) bytes * (uint64_t) rounds * 1000000
+                            / (uint64_t) us
+                  : 0;
+}
+
+#define BENCH_RESOURCES 1000
+#define BENCH_ROUNDS 100
+
+AVS_UNIT_TEST(json_out, benchmark_thousand_resources) {
+    static const size_t BUF_SIZE = 65536;
+    char *legacy_buf = (char *) malloc(BUF_SIZE);
+    AVS_UNIT_ASSERT_NOT_NULL(legacy_buf);
+    avs_stream_outbuf_t legacy_outbuf = AVS_STREAM_OUTBUF_STATIC_INITIALIZER;
+    avs_stream_abstract_t *legacy_stream =
+            (avs_stream_abstract_t *) &legacy_outbuf;
+
+    avs_time_monotonic_t start = avs_time_monotonic_now();
+    for (int round = 0; round < BENCH_ROUNDS; ++round) {
+        avs_stream_outbuf_set_buffer(&legacy_outbuf, legacy_buf, BUF_SIZE);
+        AVS_UNIT_ASSERT_SUCCESS(
+                avs_stream_write_f(legacy_stream, "{\"bn\":\"/%d\",\"e\":[",
+                                   42));
+        for (int i = 0; i < BENCH_RESOURCES; ++i) {
+            legacy_write_i64_element(legacy_stream, i == 0, 1,
+                                     (anjay_rid_t) i,
+                                     (int64_t) (i * 7919) - 1000000);
+        }
+        AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(legacy_stream, "]}", 2));
+    }
+    const int64_t legacy_us = json_out_elapsed_us(start);
+    const size_t legacy_size = avs_stream_outbuf_offset(&legacy_outbuf);
+
+    TEST_ENV_HEAP(BUF_SIZE, URI_OID(42));
+    start = avs_time_monotonic_now();
+    for (int round = 0; round < BENCH_ROUNDS; ++round) {
+        if (round) {
+            avs_stream_outbuf_set_buffer(&outbuf, buf, BUF_SIZE);
+            out = _anjay_output_json_create((avs_stream_abstract_t *) &outbuf,
+                                            &outctx_errno, &details, &uri);
+            AVS_UNIT_ASSERT_NOT_NULL(out);
+        }
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_IID, 1));
+        for (int i = 0; i < BENCH_RESOURCES; ++i) {
+            AVS_UNIT_ASSERT_SUCCESS(
+                    _anjay_output_set_id(out, ANJAY_ID_RID, (uint16_t) i));
+            AVS_UNIT_ASSERT_SUCCESS(
+                    anjay_ret_i64(out, (int64_t) (i * 7919) - 1000000));
+        }
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    }
+    const int64_t current_us = json_out_elapsed_us(start);
+    const size_t current_size = avs_stream_outbuf_offset(&outbuf);
+
+    // both encoders must have produced exactly the same payload
+    AVS_UNIT_ASSERT_EQUAL(current_size, legacy_size);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, legacy_buf, current_size);
+
+    json_log(INFO,
+             "encoding %d Resources (%lu bytes) %d times: printf-based %"
+             PRId64 " us (%" PRIu64 " B/s), current %" PRId64 " us (%"
+             PRIu64 " B/s)",
+             BENCH_RESOURCES, (unsigned long) current_size, BENCH_ROUNDS,
+             legacy_us,
+             bytes_per_second(legacy_size, BENCH_ROUNDS, legacy_us),
+             current_us,
+             bytes_per_second(current_size, BENCH_ROUNDS, current_us));
+    free(legacy_buf);
+    free(buf);
+}
+
+#undef BENCH_ROUNDS
+#undef BENCH_RESOURCES
@@ -0,0 +1,240 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <avsystem/commons/unit/memstream.h>
+#include <avsystem/commons/unit/test.h>
+
+#include <anjay/core.h>
+
+#define TEST_ENV(Data, ...) \
+    avs_stream_abstract_t *stream = NULL; \
+    AVS_UNIT_ASSERT_SUCCESS(avs_unit_memstream_alloc(&stream, \
+                                                     sizeof(Data))); \
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, Data, \
+                                             sizeof(Data) - 1)); \
+    const anjay_uri_path_t base_path = __VA_ARGS__; \
+    anjay_input_ctx_t *in; \
+    AVS_UNIT_ASSERT_SUCCESS( \
+            senml_cbor_in_create(&in, &stream, false, &base_path))
+
+#define TEST_TEARDOWN do { \
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_ctx_destroy(&in)); \
+    avs_stream_cleanup(&stream); \
+} while (0)
+
+#define ASSERT_ID(Ctx, IdType, Id) do { \
+    anjay_id_type_t type; \
+    uint16_t id; \
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_get_id((Ctx), &type, &id)); \
+    AVS_UNIT_ASSERT_EQUAL(type, (IdType)); \
+    AVS_UNIT_ASSERT_EQUAL(id, (Id)); \
+} while (0)
+
+#define ASSERT_NO_MORE_IDS(Ctx) do { \
+    anjay_id_type_t type; \
+    uint16_t id; \
+    AVS_UNIT_ASSERT_EQUAL(_anjay_input_get_id((Ctx), &type, &id), \
+                          ANJAY_GET_INDEX_END); \
+} while (0)
+
+#define ASSERT_FAILS_WITH_BAD_REQUEST(Data, ...) do { \
+    TEST_ENV(Data, __VA_ARGS__); \
+    anjay_id_type_t type; \
+    uint16_t id; \
+    AVS_UNIT_ASSERT_EQUAL(_anjay_input_get_id(in, &type, &id), \
+                          ANJAY_ERR_BAD_REQUEST); \
+    TEST_TEARDOWN; \
+} while (0)
+
+#define URI_IID(Oid, Iid) \
+    { .oid = (Oid), .iid = (Iid), .has_oid = true, .has_iid = true }
+
+#define URI_RID(Oid, Iid, Rid) \
+    { .oid = (Oid), .iid = (Iid), .rid = (Rid), \
+      .has_oid = true, .has_iid = true, .has_rid = true }
+
+AVS_UNIT_TEST(senml_cbor_in, instance_of_scalars) {
+    TEST_ENV("\x85"
+             "\xA3\x21\x64/3/0\x00\x62/1\x02\x18\x2A"
+             "\xA2\x00\x62/2\x03\x65" "hello"
+             "\xA2\x00\x62/3\x04\xF5"
+             "\xA2\x00\x62/4\x02\xF9\x3E\x00"
+             "\xA2\x00\x62/5\x63vlo\x63" "1:2",
+             URI_IID(3, 0));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 1);
+    int32_t i32;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_i32(in, &i32));
+    AVS_UNIT_ASSERT_EQUAL(i32, 42);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 2);
+    char str[3];
+    AVS_UNIT_ASSERT_EQUAL(anjay_get_string(in, str, sizeof(str)),
+                          ANJAY_BUFFER_TOO_SHORT);
+    AVS_UNIT_ASSERT_EQUAL_STRING(str, "he");
+    AVS_UNIT_ASSERT_EQUAL(anjay_get_string(in, str, sizeof(str)),
+                          ANJAY_BUFFER_TOO_SHORT);
+    AVS_UNIT_ASSERT_EQUAL_STRING(str, "ll");
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_string(in, str, sizeof(str)));
+    AVS_UNIT_ASSERT_EQUAL_STRING(str, "o");
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 3);
+    bool value;
+    AVS_UNIT_ASSERT_FAILED(anjay_get_i32(in, &i32));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_bool(in, &value));
+    AVS_UNIT_ASSERT_TRUE(value);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 4);
+    double d;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_double(in, &d));
+    AVS_UNIT_ASSERT_EQUAL(d, 1.5);
+    AVS_UNIT_ASSERT_FAILED(anjay_get_i32(in, &i32));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 5);
+    anjay_oid_t oid;
+    anjay_iid_t iid;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_objlnk(in, &oid, &iid));
+    AVS_UNIT_ASSERT_EQUAL(oid, 1);
+    AVS_UNIT_ASSERT_EQUAL(iid, 2);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    ASSERT_NO_MORE_IDS(in);
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_cbor_in, indefinite_length_and_floats) {
+    TEST_ENV("\x9F"
+             "\xBF\x21\x66/3/0/1\x02\xFA\x3F\xC0\x00\x00\xFF"
+             "\xFF",
+             URI_RID(3, 0, 1));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 1);
+    float f;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_float(in, &f));
+    AVS_UNIT_ASSERT_EQUAL(f, 1.5f);
+    int64_t i64;
+    /* non-integral values cannot be read as integers */
+    AVS_UNIT_ASSERT_FAILED(anjay_get_i64(in, &i64));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+    ASSERT_NO_MORE_IDS(in);
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_cbor_in, integral_double) {
+    TEST_ENV("\x81"
+             "\xA2\x21\x66/3/0/1"
+             "\x02\xFB\xC0\x59\x00\x00\x00\x00\x00\x00",
+             URI_RID(3, 0, 1));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 1);
+    int64_t i64;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_i64(in, &i64));
+    AVS_UNIT_ASSERT_EQUAL(i64, -100);
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_cbor_in, bytes) {
+    TEST_ENV("\x81"
+             "\xA2\x21\x66/5/0/0\x08\x43" "foo",
+             URI_RID(5, 0, 0));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 0);
+    char buf[8];
+    size_t bytes_read;
+    bool message_finished;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_bytes(in, &bytes_read,
+                                            &message_finished,
+                                            buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, 3);
+    AVS_UNIT_ASSERT_TRUE(message_finished);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, "foo", 3);
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_cbor_in, multiple_instance_resource) {
+    TEST_ENV("\x84"
+             "\xA3\x21\x64/3/0\x00\x64/7/0\x02\x01"
+             "\xA2\x00\x66/7/300\x02\x02"
+             /* unknown labels are ignored */
+             "\xA3\x00\x62/8\x06\x01\x02\x03"
+             "\xA2\x00\x62/9\x04\xF4",
+             URI_IID(3, 0));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 7);
+    anjay_input_ctx_t *array = anjay_get_array(in);
+    AVS_UNIT_ASSERT_NOT_NULL(array);
+    anjay_riid_t riid;
+    int32_t value;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_array_index(array, &riid));
+    AVS_UNIT_ASSERT_EQUAL(riid, 0);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_i32(array, &value));
+    AVS_UNIT_ASSERT_EQUAL(value, 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_array_index(array, &riid));
+    AVS_UNIT_ASSERT_EQUAL(riid, 300);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_i32(array, &value));
+    AVS_UNIT_ASSERT_EQUAL(value, 2);
+    AVS_UNIT_ASSERT_EQUAL(anjay_get_array_index(array, &riid),
+                          ANJAY_GET_INDEX_END);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 8);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_i32(in, &value));
+    AVS_UNIT_ASSERT_EQUAL(value, 3);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    ASSERT_ID(in, ANJAY_ID_RID, 9);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+    ASSERT_NO_MORE_IDS(in);
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(senml_cbor_in, invalid) {
+    /* not an array */
+    ASSERT_FAILS_WITH_BAD_REQUEST("\xA1\x00\x62/1", URI_IID(3, 0));
+    /* path outside of the request path */
+    ASSERT_FAILS_WITH_BAD_REQUEST("\x81\xA2\x00\x64/4/0\x02\x01",
+                                  URI_IID(3, 0));
+    /* no value */
+    ASSERT_FAILS_WITH_BAD_REQUEST("\x81\xA1\x00\x66/3/0/1",
+                                  URI_IID(3, 0));
+    /* two values */
+    ASSERT_FAILS_WITH_BAD_REQUEST("\x81\xA3\x00\x66/3/0/1\x02\x01"
+                                  "\x04\xF5",
+                                  URI_IID(3, 0));
+    /* nested array as a value of an unknown label */
+    ASSERT_FAILS_WITH_BAD_REQUEST("\x81\xA3\x00\x66/3/0/1\x02\x01"
+                                  "\x18\x20\x80",
+                                  URI_IID(3, 0));
+    /* base value is not supported */
+    ASSERT_FAILS_WITH_BAD_REQUEST("\x81\xA3\x00\x66/3/0/1\x02\x01"
+                                  "\x24\x01",
+                                  URI_IID(3, 0));
+    /* truncated payload */
+    ASSERT_FAILS_WITH_BAD_REQUEST("\x81\xA2\x00\x66/3/0", URI_IID(3, 0));
+    /* simple value (true) under the numeric value label */
+    ASSERT_FAILS_WITH_BAD_REQUEST("\x81\xA2\x00\x66/3/0/1\x02\xF5",
+                                  URI_IID(3, 0));
+    /* string length exceeding the supported maximum */
+    ASSERT_FAILS_WITH_BAD_REQUEST("\x81\xA2\x00\x66/3/0/1"
+                                  "\x03\x7A\xFF\xFF\xFF\xFF",
+                                  URI_IID(3, 0));
+}
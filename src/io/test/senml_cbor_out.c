@@ -0,0 +1,303 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <inttypes.h>
+
+#include <avsystem/commons/stream_v_table.h>
+#include <avsystem/commons/time.h>
+#include <avsystem/commons/unit/test.h>
+
+#include <anjay/core.h>
+
+static int test_setup_response(avs_stream_abstract_t *stream,
+                               const anjay_msg_details_t *details) {
+    (void) stream;
+    AVS_UNIT_ASSERT_EQUAL(details->format, ANJAY_COAP_FORMAT_SENML_CBOR);
+    return 0;
+}
+
+static const anjay_coap_stream_ext_t COAPIZATION = {
+    .setup_response = test_setup_response,
+};
+
+static const avs_stream_v_table_extension_t COAPIZED_VTABLE_EXT[] = {
+    { ANJAY_COAP_STREAM_EXTENSION, &COAPIZATION },
+    AVS_STREAM_V_TABLE_EXTENSION_NULL
+};
+
+static avs_stream_v_table_t COAPIZED_VTABLE;
+
+/* used when comparing against other content formats */
+static int any_format_setup_response(avs_stream_abstract_t *stream,
+                                     const anjay_msg_details_t *details) {
+    (void) stream;
+    (void) details;
+    return 0;
+}
+
+static const anjay_coap_stream_ext_t ANY_FORMAT_COAPIZATION = {
+    .setup_response = any_format_setup_response,
+};
+
+static const avs_stream_v_table_extension_t ANY_FORMAT_VTABLE_EXT[] = {
+    { ANJAY_COAP_STREAM_EXTENSION, &ANY_FORMAT_COAPIZATION },
+    AVS_STREAM_V_TABLE_EXTENSION_NULL
+};
+
+static avs_stream_v_table_t ANY_FORMAT_VTABLE;
+
+AVS_UNIT_SUITE_INIT(senml_cbor_out, verbose) {
+    (void) verbose;
+    memcpy(&COAPIZED_VTABLE, AVS_STREAM_OUTBUF_STATIC_INITIALIZER.vtable,
+           sizeof(COAPIZED_VTABLE));
+
+    COAPIZED_VTABLE.extension_list = COAPIZED_VTABLE_EXT;
+
+    memcpy(&ANY_FORMAT_VTABLE, AVS_STREAM_OUTBUF_STATIC_INITIALIZER.vtable,
+           sizeof(ANY_FORMAT_VTABLE));
+    ANY_FORMAT_VTABLE.extension_list = ANY_FORMAT_VTABLE_EXT;
+}
+
+static const avs_stream_outbuf_t COAPIZED_OUTBUF
+        = {&COAPIZED_VTABLE, NULL, 0, 0, 0};
+
+#define TEST_ENV(Size, Uri) \
+    char buf[Size]; \
+    anjay_msg_details_t details = { \
+        .msg_type = AVS_COAP_MSG_NON_CONFIRMABLE, \
+        .format = ANJAY_COAP_FORMAT_SENML_CBOR \
+    }; \
+    avs_stream_outbuf_t outbuf = COAPIZED_OUTBUF; \
+    avs_stream_outbuf_set_buffer(&outbuf, buf, sizeof(buf)); \
+    int outctx_errno = 0; \
+    const anjay_uri_path_t uri = Uri; \
+    anjay_output_ctx_t *out = _anjay_output_senml_cbor_create( \
+            (avs_stream_abstract_t *) &outbuf, &outctx_errno, &details, \
+            &uri); \
+    AVS_UNIT_ASSERT_NOT_NULL(out)
+
+#define URI_OID(Oid) { .oid = (Oid), .has_oid = true }
+
+#define URI_IID(Oid, Iid) \
+    { .oid = (Oid), .iid = (Iid), .has_oid = true, .has_iid = true }
+
+#define URI_RID(Oid, Iid, Rid) \
+    { .oid = (Oid), .iid = (Iid), .rid = (Rid), \
+      .has_oid = true, .has_iid = true, .has_rid = true }
+
+#define VERIFY_BYTES(Data) do { \
+    AVS_UNIT_ASSERT_EQUAL(avs_stream_outbuf_offset(&outbuf), sizeof(Data) - 1);\
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buf, Data, sizeof(Data) - 1); \
+} while (0)
+
+AVS_UNIT_TEST(senml_cbor_out, single_resource) {
+    TEST_ENV(64, URI_RID(3, 0, 9));
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 9));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(out, 42));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    VERIFY_BYTES("\x9F"
+                 "\xA2\x21\x66/3/0/9\x02\x18\x2A"
+                 "\xFF");
+}
+
+AVS_UNIT_TEST(senml_cbor_out, instance_of_scalars) {
+    TEST_ENV(256, URI_IID(3, 0));
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 1));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(out, -1));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 2));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_bool(out, true));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 3));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_objlnk(out, 1, 2));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 4));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_double(out, 0.5));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 5));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_double(out, 0.1));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 6));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_string(out, "ab"));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 7));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i64(out, INT64_MIN));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    VERIFY_BYTES("\x9F"
+                 "\xA3\x21\x64/3/0\x00\x62/1\x02\x20"
+                 "\xA2\x00\x62/2\x04\xF5"
+                 "\xA2\x00\x62/3\x63vlo\x63" "1:2"
+                 "\xA2\x00\x62/4\x02\xFA\x3F\x00\x00\x00"
+                 "\xA2\x00\x62/5"
+                 "\x02\xFB\x3F\xB9\x99\x99\x99\x99\x99\x9A"
+                 "\xA2\x00\x62/6\x03\x62" "ab"
+                 "\xA2\x00\x62/7"
+                 "\x02\x3B\x7F\xFF\xFF\xFF\xFF\xFF\xFF\xFF"
+                 "\xFF");
+}
+
+AVS_UNIT_TEST(senml_cbor_out, multiple_instance_resource) {
+    TEST_ENV(64, URI_OID(3));
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_IID, 0));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 7));
+    anjay_output_ctx_t *array = anjay_ret_array_start(out);
+    AVS_UNIT_ASSERT_NOT_NULL(array);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_array_index(array, 0));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(array, 100));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_array_index(array, 300));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(array, 1000));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_array_finish(array));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    VERIFY_BYTES("\x9F"
+                 "\xA3\x21\x62/3\x00\x66/0/7/0\x02\x18\x64"
+                 "\xA2\x00\x68/0/7/300\x02\x19\x03\xE8"
+                 "\xFF");
+}
+
+AVS_UNIT_TEST(senml_cbor_out, bytes) {
+    TEST_ENV(64, URI_IID(5, 0));
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 0));
+    anjay_ret_bytes_ctx_t *bytes = anjay_ret_bytes_begin(out, 3);
+    AVS_UNIT_ASSERT_NOT_NULL(bytes);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_bytes_append(bytes, "f", 1));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_bytes_append(bytes, "oo", 2));
+    AVS_UNIT_ASSERT_FAILED(anjay_ret_bytes_append(bytes, "x", 1));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 1));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(out, 1));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    VERIFY_BYTES("\x9F"
+                 "\xA3\x21\x64/5/0\x00\x62/0\x08\x43" "foo"
+                 "\xA2\x00\x62/1\x02\x01"
+                 "\xFF");
+}
+
+AVS_UNIT_TEST(senml_cbor_out, bytes_too_short) {
+    TEST_ENV(64, URI_RID(5, 0, 0));
+
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 0));
+    anjay_ret_bytes_ctx_t *bytes = anjay_ret_bytes_begin(out, 3);
+    AVS_UNIT_ASSERT_NOT_NULL(bytes);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_bytes_append(bytes, "f", 1));
+    AVS_UNIT_ASSERT_FAILED(_anjay_output_ctx_destroy(&out));
+}
+
+typedef enum {
+    COMPARED_FORMAT_TLV,
+#ifdef WITH_JSON
+    COMPARED_FORMAT_JSON,
+#endif // WITH_JSON
+    COMPARED_FORMAT_SENML_CBOR,
+    COMPARED_FORMAT_COUNT
+} compared_format_t;
+
+static const char *const COMPARED_FORMAT_NAMES[] = {
+    [COMPARED_FORMAT_TLV] = "TLV",
+#ifdef WITH_JSON
+    [COMPARED_FORMAT_JSON] = "LwM2M JSON",
+#endif // WITH_JSON
+    [COMPARED_FORMAT_SENML_CBOR] = "SenML CBOR"
+};
+
+/* Encodes Instance /3/0 with the example values from the LwM2M TS, Appendix
+ * E.1, and returns the payload size. */
+static size_t encode_device_instance(compared_format_t format,
+                                     char *buf,
+                                     size_t buf_size) {
+    avs_stream_outbuf_t outbuf = { &ANY_FORMAT_VTABLE, NULL, 0, 0, 0 };
+    avs_stream_outbuf_set_buffer(&outbuf, buf, buf_size);
+    avs_stream_abstract_t *stream = (avs_stream_abstract_t *) &outbuf;
+    anjay_msg_details_t details = {
+        .msg_type = AVS_COAP_MSG_NON_CONFIRMABLE,
+        .format = AVS_COAP_FORMAT_NONE
+    };
+    int outctx_errno = 0;
+    const anjay_uri_path_t uri = URI_IID(3, 0);
+    anjay_output_ctx_t *out = NULL;
+    switch (format) {
+    case COMPARED_FORMAT_TLV:
+        out = _anjay_output_tlv_create(stream, &outctx_errno, &details);
+        break;
+#ifdef WITH_JSON
+    case COMPARED_FORMAT_JSON:
+        out = _anjay_output_json_create(stream, &outctx_errno, &details,
+                                        &uri);
+        break;
+#endif // WITH_JSON
+    default:
+        out = _anjay_output_senml_cbor_create(stream, &outctx_errno,
+                                              &details, &uri);
+        break;
+    }
+    AVS_UNIT_ASSERT_NOT_NULL(out);
+
+    static const struct {
+        anjay_rid_t rid;
+        const char *value;
+    } STRINGS[] = {
+        { 0, "Open Mobile Alliance" },
+        { 1, "Lightweight M2M Client" },
+        { 2, "345000123" },
+        { 3, "1.0" },
+        { 14, "+02:00" },
+        { 15, "Europe/Belgrade" },
+        { 16, "U" }
+    };
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(STRINGS); ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(
+                _anjay_output_set_id(out, ANJAY_ID_RID, STRINGS[i].rid));
+        AVS_UNIT_ASSERT_SUCCESS(anjay_ret_string(out, STRINGS[i].value));
+    }
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 9));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(out, 100));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 10));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i32(out, 15));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_set_id(out, ANJAY_ID_RID, 13));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_i64(out, 1367491215));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_output_ctx_destroy(&out));
+    return avs_stream_outbuf_offset(&outbuf);
+}
+
+#define COMPARISON_ROUNDS 10000
+
+AVS_UNIT_TEST(senml_cbor_out, compare_with_other_formats) {
+    char buf[512];
+    size_t sizes[COMPARED_FORMAT_COUNT];
+    int64_t times_us[COMPARED_FORMAT_COUNT];
+    for (int format = 0; format < COMPARED_FORMAT_COUNT; ++format) {
+        avs_time_monotonic_t start = avs_time_monotonic_now();
+        for (int round = 0; round < COMPARISON_ROUNDS; ++round) {
+            sizes[format] = encode_device_instance(
+                    (compared_format_t) format, buf, sizeof(buf));
+        }
+        AVS_UNIT_ASSERT_SUCCESS(avs_time_duration_to_scalar(
+                &times_us[format], AVS_TIME_US,
+                avs_time_monotonic_diff(avs_time_monotonic_now(), start)));
+        cbor_log(INFO, "encoding /3/0 %d times as %s: %lu bytes, %" PRId64
+                 " us", COMPARISON_ROUNDS, COMPARED_FORMAT_NAMES[format],
+                 (unsigned long) sizes[format], times_us[format]);
+    }
+
+    // SenML CBOR carries a name per record, so it cannot beat the 2-3 byte
+    // TLV headers, but it is meant to be considerably more compact than JSON
+    AVS_UNIT_ASSERT_TRUE(sizes[COMPARED_FORMAT_TLV]
+                         < sizes[COMPARED_FORMAT_SENML_CBOR]);
+#ifdef WITH_JSON
+    AVS_UNIT_ASSERT_TRUE(sizes[COMPARED_FORMAT_SENML_CBOR]
+                         < sizes[COMPARED_FORMAT_JSON]);
+#endif // WITH_JSON
+}
+
+#undef COMPARISON_ROUNDS
@@ -16,6 +16,7 @@
 
 #include <config.h>
 
+#include <avsystem/commons/base64.h>
 #include <avsystem/commons/stream.h>
 #include <avsystem/commons/unit/memstream.h>
 #include <avsystem/commons/unit/test.h>
@@ -181,6 +182,56 @@ AVS_UNIT_TEST(text_out, unimplemented) {
     AVS_UNIT_ASSERT_FAILED(anjay_ret_array_finish((anjay_output_ctx_t *) &out));
 }
 
+#define BYTES_TEST_DATA_SIZE 1000
+
+static void fill_bytes_test_data(uint8_t *data) {
+    for (size_t i = 0; i < BYTES_TEST_DATA_SIZE; ++i) {
+        data[i] = (uint8_t) (i * 37 + 11);
+    }
+}
+
+static void test_bytes_encoding(size_t size, size_t chunk_size) {
+    TEST_ENV(2048);
+    uint8_t data[BYTES_TEST_DATA_SIZE];
+    fill_bytes_test_data(data);
+    char expected[2048];
+    AVS_UNIT_ASSERT_SUCCESS(avs_base64_encode(expected, sizeof(expected),
+                                              data, size));
+
+    anjay_ret_bytes_ctx_t *bytes =
+            anjay_ret_bytes_begin((anjay_output_ctx_t *) &out, size);
+    AVS_UNIT_ASSERT_NOT_NULL(bytes);
+    for (size_t offset = 0; offset < size; offset += chunk_size) {
+        AVS_UNIT_ASSERT_SUCCESS(anjay_ret_bytes_append(
+                bytes, &data[offset], AVS_MIN(chunk_size, size - offset)));
+    }
+    AVS_UNIT_ASSERT_FAILED(anjay_ret_bytes_append(bytes, data, 1));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_base64_ret_bytes_ctx_close(bytes));
+    stringify_buf(&outbuf);
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, expected);
+}
+
+AVS_UNIT_TEST(text_out, bytes) {
+    static const size_t SIZES[] = { 0, 1, 2, 3, 4, 5, 192, 193,
+                                    BYTES_TEST_DATA_SIZE };
+    static const size_t CHUNK_SIZES[] = { 1, 2, 3, 4, 7, 191,
+                                          BYTES_TEST_DATA_SIZE };
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(SIZES); ++i) {
+        for (size_t j = 0; j < AVS_ARRAY_SIZE(CHUNK_SIZES); ++j) {
+            test_bytes_encoding(SIZES[i], CHUNK_SIZES[j]);
+        }
+    }
+}
+
+AVS_UNIT_TEST(text_out, bytes_too_short) {
+    TEST_ENV(64);
+    anjay_ret_bytes_ctx_t *bytes =
+            anjay_ret_bytes_begin((anjay_output_ctx_t *) &out, 4);
+    AVS_UNIT_ASSERT_NOT_NULL(bytes);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_ret_bytes_append(bytes, "abc", 3));
+    AVS_UNIT_ASSERT_FAILED(_anjay_base64_ret_bytes_ctx_close(bytes));
+}
+
 #undef TEST_ENV
 
 /////////////////////////////////////////////////////////////////////// DECODING
@@ -380,5 +431,77 @@ AVS_UNIT_TEST(text_in, objlnk) {
 #undef TEST_OBJLNK_FAIL
 #undef TEST_OBJLNK
 #undef TEST_OBJLNK_COMMON
+
+static void test_bytes_decoding(size_t size, size_t buf_size) {
+    uint8_t data[BYTES_TEST_DATA_SIZE];
+    fill_bytes_test_data(data);
+    char encoded[2048];
+    AVS_UNIT_ASSERT_SUCCESS(avs_base64_encode(encoded, sizeof(encoded),
+                                              data, size));
+    TEST_ENV(sizeof(encoded));
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, encoded,
+                                             strlen(encoded)));
+
+    /* a little extra space, so that buf_size never drops to zero */
+    uint8_t decoded[BYTES_TEST_DATA_SIZE + 16];
+    size_t decoded_size = 0;
+    bool message_finished = false;
+    while (!message_finished) {
+        size_t bytes_read;
+        AVS_UNIT_ASSERT_TRUE(decoded_size <= size);
+        AVS_UNIT_ASSERT_SUCCESS(anjay_get_bytes(
+                in, &bytes_read, &message_finished, &decoded[decoded_size],
+                AVS_MIN(buf_size, sizeof(decoded) - decoded_size)));
+        decoded_size += bytes_read;
+    }
+    AVS_UNIT_ASSERT_EQUAL(decoded_size, size);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(decoded, data, size);
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(text_in, bytes) {
+    static const size_t SIZES[] = { 0, 1, 2, 3, 4, 5, 192, 193,
+                                    BYTES_TEST_DATA_SIZE };
+    static const size_t BUF_SIZES[] = { 1, 2, 3, 4, 7, 191,
+                                        BYTES_TEST_DATA_SIZE };
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(SIZES); ++i) {
+        for (size_t j = 0; j < AVS_ARRAY_SIZE(BUF_SIZES); ++j) {
+            test_bytes_decoding(SIZES[i], BUF_SIZES[j]);
+        }
+    }
+}
+
+#define TEST_BYTES_FAIL(Str) do { \
+    TEST_ENV(64); \
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_write(stream, Str, sizeof(Str) - 1)); \
+    uint8_t buf[64]; \
+    size_t bytes_read; \
+    bool message_finished; \
+    AVS_UNIT_ASSERT_FAILED(anjay_get_bytes(in, &bytes_read, \
+                                           &message_finished, \
+                                           buf, sizeof(buf))); \
+    TEST_TEARDOWN; \
+} while (false)
+
+AVS_UNIT_TEST(text_in, bytes_invalid) {
+    TEST_BYTES_FAIL("AAA");
+    TEST_BYTES_FAIL("AAAAA");
+    TEST_BYTES_FAIL("AA==AAAA");
+    TEST_BYTES_FAIL("AAA=AAAA");
+    TEST_BYTES_FAIL("A===");
+    TEST_BYTES_FAIL("====");
+    TEST_BYTES_FAIL("AA=A");
+    TEST_BYTES_FAIL("AA A");
+    TEST_BYTES_FAIL("AA*A");
+    /* non-zero bits replaced by padding */
+    TEST_BYTES_FAIL("QUJ=");
+    TEST_BYTES_FAIL("QR==");
+    TEST_BYTES_FAIL("AAAAQR==");
+    /* invalid character within a group decoded in bulk */
+    TEST_BYTES_FAIL("AAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA"
+                    "AAAAAAAAAAAAAAAAAAAAAA*AAAAAAAAAAAAAAAAA");
+}
+
+#undef TEST_BYTES_FAIL
 #undef TEST_TEARDOWN
 #undef TEST_ENV
@@ -423,3 +423,139 @@ AVS_UNIT_TEST(tlv_in_types, invalid_read) {
 
     TEST_TEARDOWN;
 }
+
+#undef TEST_TEARDOWN
+#undef TEST_ENV
+
+#define TEST_ENV(Data) \
+    anjay_input_ctx_t *in; \
+    AVS_UNIT_ASSERT_SUCCESS(tlv_buf_in_create(&in, (const uint8_t *) Data, \
+                                              sizeof(Data) - 1));
+
+#define TEST_TEARDOWN _anjay_input_ctx_destroy(&in)
+
+#define TEST_ID(Ctx, IdType, Id) do { \
+    anjay_id_type_t type; \
+    uint16_t id; \
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_get_id((Ctx), &type, &id)); \
+    AVS_UNIT_ASSERT_EQUAL(type, IdType); \
+    AVS_UNIT_ASSERT_EQUAL(id, Id); \
+} while (0)
+
+AVS_UNIT_TEST(tlv_in_buffered, resources) {
+    TEST_ENV("\xC1\x01\x2A" "\xC5\x02" "Hello" "\xC0\x03");
+
+    int32_t i32;
+    TEST_ID(in, ANJAY_ID_RID, 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_i32(in, &i32));
+    AVS_UNIT_ASSERT_EQUAL(i32, 42);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    char buf[3];
+    TEST_ID(in, ANJAY_ID_RID, 2);
+    AVS_UNIT_ASSERT_EQUAL(anjay_get_string(in, buf, sizeof(buf)),
+                          ANJAY_BUFFER_TOO_SHORT);
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, "He");
+    // skip the rest of the string
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    TEST_ID(in, ANJAY_ID_RID, 3);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_string(in, buf, sizeof(buf)));
+    AVS_UNIT_ASSERT_EQUAL_STRING(buf, "");
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    AVS_UNIT_ASSERT_EQUAL(_anjay_input_get_id(in, NULL, NULL),
+                          ANJAY_GET_INDEX_END);
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(tlv_in_buffered, nested) {
+    TEST_ENV("\x08\x05\x0B" // IID 5
+                 "\xC1\x00\x07" // RID 0
+                 "\x86\x01" // RID 1, multiple
+                     "\x41\x03\x0A" // RIID 3
+                     "\x41\x04\x0B" // RIID 4
+             "\x00\x06" // IID 6, empty
+             );
+
+    TEST_ID(in, ANJAY_ID_IID, 5);
+    anjay_input_ctx_t *instance = _anjay_input_nested_ctx(in);
+    AVS_UNIT_ASSERT_NOT_NULL(instance);
+
+    int32_t value;
+    TEST_ID(instance, ANJAY_ID_RID, 0);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_i32(instance, &value));
+    AVS_UNIT_ASSERT_EQUAL(value, 7);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(instance));
+
+    TEST_ID(instance, ANJAY_ID_RID, 1);
+    anjay_input_ctx_t *array = anjay_get_array(instance);
+    AVS_UNIT_ASSERT_NOT_NULL(array);
+    anjay_riid_t riid;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_array_index(array, &riid));
+    AVS_UNIT_ASSERT_EQUAL(riid, 3);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_i32(array, &value));
+    AVS_UNIT_ASSERT_EQUAL(value, 10);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_array_index(array, &riid));
+    AVS_UNIT_ASSERT_EQUAL(riid, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_i32(array, &value));
+    AVS_UNIT_ASSERT_EQUAL(value, 11);
+    AVS_UNIT_ASSERT_EQUAL(anjay_get_array_index(array, &riid),
+                          ANJAY_GET_INDEX_END);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(instance));
+
+    AVS_UNIT_ASSERT_EQUAL(_anjay_input_get_id(instance, NULL, NULL),
+                          ANJAY_GET_INDEX_END);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    TEST_ID(in, ANJAY_ID_IID, 6);
+    instance = _anjay_input_nested_ctx(in);
+    AVS_UNIT_ASSERT_NOT_NULL(instance);
+    AVS_UNIT_ASSERT_EQUAL(_anjay_input_get_id(instance, NULL, NULL),
+                          ANJAY_GET_INDEX_END);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_input_next_entry(in));
+
+    AVS_UNIT_ASSERT_EQUAL(_anjay_input_get_id(in, NULL, NULL),
+                          ANJAY_GET_INDEX_END);
+    TEST_TEARDOWN;
+}
+
+AVS_UNIT_TEST(tlv_in_buffered, value_parsed_as_tlv) {
+    // single Resource whose value is itself a TLV payload
+    TEST_ENV("\xC3\x01" "\x41\x00\x2A");
+
+    TEST_ID(in, ANJAY_ID_RID, 1);
+    anjay_input_ctx_t *array = anjay_get_array(in);
+    AVS_UNIT_ASSERT_NOT_NULL(array);
+    anjay_riid_t riid;
+    int32_t value;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_array_index(array, &riid));
+    AVS_UNIT_ASSERT_EQUAL(riid, 0);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_i32(array, &value));
+    AVS_UNIT_ASSERT_EQUAL(value, 42);
+    AVS_UNIT_ASSERT_EQUAL(anjay_get_array_index(array, &riid),
+                          ANJAY_GET_INDEX_END);
+
+    TEST_TEARDOWN;
+}
+
+#define TEST_MALFORMED(Name, Data) \
+AVS_UNIT_TEST(tlv_in_buffered, Name) { \
+    static const char DATA[] = Data; \
+    anjay_input_ctx_t *in = NULL; \
+    AVS_UNIT_ASSERT_EQUAL(tlv_buf_in_create(&in, (const uint8_t *) DATA, \
+                                            sizeof(DATA) - 1), \
+                          ANJAY_ERR_BAD_REQUEST); \
+    AVS_UNIT_ASSERT_NULL(in); \
+}
+
+TEST_MALFORMED(truncated_header, "\xC1")
+TEST_MALFORMED(truncated_length, "\xC8\x01")
+TEST_MALFORMED(truncated_value, "\xC7\x2A" "012")
+TEST_MALFORMED(truncated_nested, "\x04\x01" "\xC1\x00\x2A" "\xC7")
+TEST_MALFORMED(riid_in_instance, "\x03\x01" "\x41\x00\x2A")
+TEST_MALFORMED(instance_in_array, "\x82\x01" "\x00\x00")
+TEST_MALFORMED(trailing_garbage, "\xC1\x01\x2A" "\xE8")
+
+#undef TEST_MALFORMED
+#undef TEST_ID
@@ -23,13 +23,13 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include <avsystem/commons/base64.h>
 #include <avsystem/commons/stream.h>
 
 #include <anjay/core.h>
 
 #include "../coap/content_format.h"
 #include "../utils_core.h"
+#include "base64_codec.h"
 #include "base64_out.h"
 #include "vtable.h"
 
@@ -198,20 +198,15 @@ typedef struct {
     // if bytes_mode == true, then only raw bytes can be read from the context
     // and any other reading operation will fail
     bool bytes_mode;
+    // decoded bytes that did not fit in the caller's buffer
     uint8_t bytes_cached[3];
     size_t num_bytes_cached;
-    char msg_finished;
+    // trailing characters of an incomplete base64 group
+    char encoded_cached[3];
+    size_t num_encoded_cached;
+    bool msg_finished;
 } text_in_t;
 
-static int has_valid_padding(const char *buffer,
-                             size_t size,
-                             bool msg_finished) {
-    const char *last = buffer + size;
-    /* Note: buffer is size+1 in length. Last byte is a NULL terminator though. */
-    assert(!*last);
-    return last - 1 >= buffer && *(last - 1) == '=' && !msg_finished ? -1 : 0;
-}
-
 static void text_get_some_bytes_cache_flush(text_in_t *ctx,
                                             uint8_t **out_buf,
                                             size_t *buf_size) {
@@ -224,6 +219,9 @@ static void text_get_some_bytes_cache_flush(text_in_t *ctx,
     *out_buf += bytes_to_copy;
 }
 
+/* Number of base64 groups read from the stream at once */
+#define TEXT_DECODE_GROUPS_PER_READ 64u
+
 static int text_get_some_bytes(anjay_input_ctx_t *ctx_,
                                size_t *out_bytes_read,
                                bool *out_msg_finished,
@@ -236,38 +234,65 @@ static int text_get_some_bytes(anjay_input_ctx_t *ctx_,
     *out_bytes_read = 0;
 
     text_get_some_bytes_cache_flush(ctx, &current, &buf_size);
-    // 4bytes + null terminator
-    char encoded[5];
-    size_t stream_bytes_read;
-    char stream_msg_finished = 0;
-
-    while (buf_size > 0) {
-        if (avs_stream_read(ctx->stream, &stream_bytes_read, &stream_msg_finished,
-                            encoded, sizeof(encoded) - 1)) {
+
+    while (buf_size > 0 && !ctx->msg_finished) {
+        char encoded[4 * TEXT_DECODE_GROUPS_PER_READ];
+        size_t encoded_size = ctx->num_encoded_cached;
+        memcpy(encoded, ctx->encoded_cached, encoded_size);
+
+        // do not read more groups than needed to fill out_buf
+        const size_t max_encoded_size =
+                AVS_MIN(sizeof(encoded), 4 * ((buf_size + 2) / 3));
+        size_t stream_bytes_read;
+        char stream_msg_finished = 0;
+        if (avs_stream_read(ctx->stream, &stream_bytes_read,
+                            &stream_msg_finished, &encoded[encoded_size],
+                            max_encoded_size - encoded_size)) {
             return -1;
         }
-        encoded[stream_bytes_read] = '\0';
-        if (stream_bytes_read % 4) {
+        encoded_size += stream_bytes_read;
+        ctx->msg_finished = !!stream_msg_finished;
+        if (ctx->msg_finished && encoded_size % 4) {
             return -1;
         }
-        if (has_valid_padding(encoded, stream_bytes_read,
-                              !!stream_msg_finished)) {
-            return -1;
+
+        const size_t num_groups = encoded_size / 4;
+        // groups that fit in the caller's buffer are decoded in bulk; the
+        // last group of the message may contain padding, so it is not
+        size_t bulk_groups = num_groups;
+        if (ctx->msg_finished && bulk_groups) {
+            --bulk_groups;
         }
-        assert(ctx->num_bytes_cached == 0);
-        ssize_t num_decoded =
-                avs_base64_decode_strict((uint8_t *) ctx->bytes_cached,
-                                         sizeof(ctx->bytes_cached), encoded);
-        if (num_decoded < 0) {
-            return (int) num_decoded;
+        size_t i = AVS_MIN(bulk_groups, buf_size / 3);
+        if (_anjay_base64_decode_groups(current, encoded, i)) {
+            return -1;
         }
-        ctx->num_bytes_cached = (size_t) num_decoded;
-        text_get_some_bytes_cache_flush(ctx, &current, &buf_size);
-        if (stream_msg_finished) {
-            break;
+        current += 3 * i;
+        buf_size -= 3 * i;
+        for (; i < num_groups; ++i) {
+            const bool is_last_group = ctx->msg_finished
+                                       && i == num_groups - 1;
+            // decode directly into the caller's buffer whenever possible
+            const bool use_cache = (buf_size < 3);
+            assert(!use_cache || !ctx->num_bytes_cached);
+            int num_decoded = _anjay_base64_decode_group(
+                    use_cache ? ctx->bytes_cached : current, &encoded[4 * i],
+                    is_last_group);
+            if (num_decoded < 0) {
+                return -1;
+            }
+            if (use_cache) {
+                ctx->num_bytes_cached = (size_t) num_decoded;
+                text_get_some_bytes_cache_flush(ctx, &current, &buf_size);
+            } else {
+                current += num_decoded;
+                buf_size -= (size_t) num_decoded;
+            }
         }
+        ctx->num_encoded_cached = encoded_size % 4;
+        memcpy(ctx->encoded_cached, &encoded[4 * num_groups],
+               ctx->num_encoded_cached);
     }
-    ctx->msg_finished = !!stream_msg_finished;
     *out_msg_finished = ctx->msg_finished && !ctx->num_bytes_cached;
     *out_bytes_read = (size_t) (current - (uint8_t *) out_buf);
     return 0;
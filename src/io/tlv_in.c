@@ -16,6 +16,8 @@
 
 #include <config.h>
 
+#include <avsystem/commons/coap/block_utils.h>
+#include <avsystem/commons/coap/msg_opt.h>
 #include <avsystem/commons/stream_v_table.h>
 #include <avsystem/commons/utils.h>
 
@@ -31,6 +33,28 @@ typedef struct {
     char finished;
 } tlv_single_msg_stream_wrapper_t;
 
+/**
+ * Entry of the index built for payloads that are available in memory as a
+ * whole. Entries are stored in the order in which they appear in the payload,
+ * so descendants of an entry immediately follow it.
+ */
+typedef struct {
+    anjay_id_type_t id_type;
+    uint16_t id;
+    /* true for Object Instances and Multiple Resources */
+    bool has_children;
+    const uint8_t *data;
+    size_t length;
+    /* index of the first entry that is not a descendant of this one */
+    size_t next_sibling;
+} tlv_index_entry_t;
+
+typedef struct {
+    tlv_index_entry_t *entries;
+    size_t num_entries;
+    size_t capacity;
+} tlv_index_t;
+
 typedef struct {
     const anjay_input_ctx_vtable_t *vtable;
     tlv_single_msg_stream_wrapper_t stream;
@@ -40,6 +64,13 @@ typedef struct {
     int32_t id;
     size_t length;
     size_t bytes_read;
+
+    /* Fields below are only used by contexts with TLV_BUF_IN_VTABLE */
+    /* index shared with the parent context, or owned_index.entries */
+    const tlv_index_entry_t *entries;
+    tlv_index_t owned_index;
+    size_t current_entry;
+    size_t end_entry;
 } tlv_in_t;
 
 static int tlv_get_some_bytes(anjay_input_ctx_t *ctx_,
@@ -78,13 +109,16 @@ static int tlv_read_to_end(anjay_input_ctx_t *ctx,
                            size_t *out_bytes_read,
                            void *out_buf,
                            size_t buf_size) {
+    /* some_bytes differs between the streamed and the buffered variant */
+    const anjay_input_ctx_bytes_t get_some_bytes =
+            ((tlv_in_t *) ctx)->vtable->some_bytes;
     bool message_finished;
     char *ptr = (char *) out_buf;
     char *endptr = ptr + buf_size;
     do {
         size_t bytes_read = 0;
-        int retval = tlv_get_some_bytes(ctx, &bytes_read, &message_finished,
-                                        ptr, (size_t) (endptr - ptr));
+        int retval = get_some_bytes(ctx, &bytes_read, &message_finished,
+                                    ptr, (size_t) (endptr - ptr));
         if (retval) {
             return retval;
         }
@@ -349,9 +383,294 @@ static const avs_stream_v_table_t TLV_SINGLE_MSG_STREAM_WRAPPER_VTABLE = {
     .read = tlv_safe_read
 };
 
+//////////////////////////////////////////////////////////// BUFFERED VARIANT
+
+/*
+ * If the whole payload is already in memory, its structure is validated and
+ * indexed upfront, and all reads are served directly from the buffer instead
+ * of going through the stream for every header field.
+ */
+
+static size_t read_be_field(const uint8_t **ptr, size_t length) {
+    size_t result = 0;
+    for (size_t i = 0; i < length; ++i) {
+        result = (result << 8) + *(*ptr)++;
+    }
+    return result;
+}
+
+static bool is_valid_child(tlv_id_type_t parent, tlv_id_type_t child) {
+    switch (parent) {
+    case TLV_ID_IID:
+        return child == TLV_ID_RID || child == TLV_ID_RID_ARRAY;
+    case TLV_ID_RID_ARRAY:
+        return child == TLV_ID_RIID;
+    default:
+        return false;
+    }
+}
+
+static tlv_index_entry_t *index_new_entry(tlv_index_t *index) {
+    if (index->num_entries == index->capacity) {
+        size_t new_capacity = index->capacity ? 2 * index->capacity : 16;
+        tlv_index_entry_t *new_entries = (tlv_index_entry_t *) realloc(
+                index->entries, new_capacity * sizeof(*new_entries));
+        if (!new_entries) {
+            return NULL;
+        }
+        index->entries = new_entries;
+        index->capacity = new_capacity;
+    }
+    return &index->entries[index->num_entries++];
+}
+
+/**
+ * Appends entries found in @p data to @p index, recursing into Object
+ * Instances and Multiple Resources.
+ *
+ * @param parent Type of the entry that contains @p data, or NULL if it is
+ *               a top-level payload, in which case any entry type is allowed.
+ */
+static int index_entries(tlv_index_t *index,
+                         const uint8_t *data,
+                         size_t size,
+                         const tlv_id_type_t *parent) {
+    const uint8_t *ptr = data;
+    const uint8_t *const end = data + size;
+    while (ptr < end) {
+        const uint8_t typefield = *ptr++;
+        const tlv_id_type_t tlv_type = (tlv_id_type_t) ((typefield >> 6) & 3);
+        const size_t id_length = (typefield & 0x20) ? 2 : 1;
+        const size_t length_length = ((typefield >> 3) & 3);
+        if ((size_t) (end - ptr) < id_length + length_length
+                || (parent && !is_valid_child(*parent, tlv_type))) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+        const size_t id = read_be_field(&ptr, id_length);
+        const size_t length = length_length
+                ? read_be_field(&ptr, length_length)
+                : (size_t) (typefield & 7);
+        if (length > (size_t) (end - ptr)) {
+            return ANJAY_ERR_BAD_REQUEST;
+        }
+
+        const size_t entry_index = index->num_entries;
+        tlv_index_entry_t *entry = index_new_entry(index);
+        if (!entry) {
+            anjay_log(ERROR, "out of memory");
+            return -1;
+        }
+        entry->id_type = convert_id_type(typefield);
+        entry->id = (uint16_t) id;
+        entry->has_children = (tlv_type == TLV_ID_IID
+                               || tlv_type == TLV_ID_RID_ARRAY);
+        entry->data = ptr;
+        entry->length = length;
+        ptr += length;
+
+        if (entry->has_children) {
+            int retval = index_entries(index, entry->data, entry->length,
+                                       &tlv_type);
+            if (retval) {
+                return retval;
+            }
+        }
+        /* entry might have been invalidated by realloc() */
+        index->entries[entry_index].next_sibling = index->num_entries;
+    }
+    return 0;
+}
+
+static int build_index(tlv_index_t *out_index,
+                       const uint8_t *data,
+                       size_t size) {
+    memset(out_index, 0, sizeof(*out_index));
+    int retval = index_entries(out_index, data, size, NULL);
+    if (retval) {
+        free(out_index->entries);
+        memset(out_index, 0, sizeof(*out_index));
+    }
+    return retval;
+}
+
+static const tlv_index_entry_t *current_entry(tlv_in_t *ctx) {
+    assert(ctx->current_entry < ctx->end_entry);
+    return &ctx->entries[ctx->current_entry];
+}
+
+static int tlv_buf_get_id(anjay_input_ctx_t *ctx_,
+                          anjay_id_type_t *out_type, uint16_t *out_id) {
+    tlv_in_t *ctx = (tlv_in_t *) ctx_;
+    if (ctx->id < 0) {
+        if (ctx->current_entry >= ctx->end_entry) {
+            return ANJAY_GET_INDEX_END;
+        }
+        const tlv_index_entry_t *entry = current_entry(ctx);
+        ctx->id_type = entry->id_type;
+        ctx->id = entry->id;
+        ctx->length = entry->length;
+        ctx->bytes_read = 0;
+    }
+    *out_type = ctx->id_type;
+    *out_id = (uint16_t) ctx->id;
+    return 0;
+}
+
+static int tlv_buf_get_some_bytes(anjay_input_ctx_t *ctx_,
+                                  size_t *out_bytes_read,
+                                  bool *out_message_finished,
+                                  void *out_buf,
+                                  size_t buf_size) {
+    tlv_in_t *ctx = (tlv_in_t *) ctx_;
+    anjay_id_type_t type;
+    uint16_t id;
+    int retval = tlv_buf_get_id(ctx_, &type, &id);
+    if (retval) {
+        return retval;
+    }
+    *out_bytes_read = AVS_MIN(buf_size, ctx->length - ctx->bytes_read);
+    memcpy(out_buf, current_entry(ctx)->data + ctx->bytes_read,
+           *out_bytes_read);
+    ctx->bytes_read += *out_bytes_read;
+    *out_message_finished = (ctx->bytes_read == ctx->length);
+    return 0;
+}
+
+static int tlv_buf_next_entry(anjay_input_ctx_t *ctx_) {
+    tlv_in_t *ctx = (tlv_in_t *) ctx_;
+    if (ctx->id >= 0) {
+        ctx->current_entry = current_entry(ctx)->next_sibling;
+        ctx->id = -1;
+    }
+    return 0;
+}
+
+static int tlv_buf_in_close(anjay_input_ctx_t *ctx_) {
+    tlv_in_t *ctx = (tlv_in_t *) ctx_;
+    _anjay_input_ctx_destroy(&ctx->child);
+    free(ctx->owned_index.entries);
+    if (ctx->autoclose) {
+        avs_stream_cleanup(&ctx->stream.backend);
+    }
+    return 0;
+}
+
+static anjay_input_ctx_t *tlv_buf_nested_ctx(anjay_input_ctx_t *ctx_);
+
+static const anjay_input_ctx_vtable_t TLV_BUF_IN_VTABLE = {
+    .some_bytes = tlv_buf_get_some_bytes,
+    .string = tlv_get_string,
+    .i32 = tlv_get_i32,
+    .i64 = tlv_get_i64,
+    .f32 = tlv_get_float,
+    .f64 = tlv_get_double,
+    .boolean = tlv_get_bool,
+    .objlnk = tlv_get_objlnk,
+    .attach_child = tlv_in_attach_child,
+    .get_id = tlv_buf_get_id,
+    .next_entry = tlv_buf_next_entry,
+    .close = tlv_buf_in_close,
+    .nested_ctx = tlv_buf_nested_ctx
+};
+
+static tlv_in_t *tlv_buf_in_new(void) {
+    tlv_in_t *ctx = (tlv_in_t *) calloc(1, sizeof(tlv_in_t));
+    if (ctx) {
+        ctx->vtable = &TLV_BUF_IN_VTABLE;
+        ctx->id = -1;
+    }
+    return ctx;
+}
+
+static anjay_input_ctx_t *tlv_buf_nested_ctx(anjay_input_ctx_t *ctx_) {
+    tlv_in_t *ctx = (tlv_in_t *) ctx_;
+    anjay_id_type_t type;
+    uint16_t id;
+    if (tlv_buf_get_id(ctx_, &type, &id) || ctx->bytes_read) {
+        return NULL;
+    }
+    tlv_in_t *child = tlv_buf_in_new();
+    if (!child) {
+        return NULL;
+    }
+    const tlv_index_entry_t *entry = current_entry(ctx);
+    if (entry->has_children) {
+        child->entries = ctx->entries;
+        child->current_entry = ctx->current_entry + 1;
+        child->end_entry = entry->next_sibling;
+    } else if (!build_index(&child->owned_index, entry->data,
+                            entry->length)) {
+        /* a plain Resource whose value is itself parsed as TLV */
+        child->entries = child->owned_index.entries;
+        child->end_entry = child->owned_index.num_entries;
+    } else {
+        free(child);
+        return NULL;
+    }
+    ctx->bytes_read = ctx->length;
+
+    anjay_input_ctx_t *result = (anjay_input_ctx_t *) child;
+    if (tlv_in_attach_child(ctx_, result)) {
+        _anjay_input_ctx_destroy(&result);
+    }
+    return result;
+}
+
+static int tlv_buf_in_create(anjay_input_ctx_t **out,
+                             const uint8_t *data,
+                             size_t size) {
+    tlv_in_t *ctx = tlv_buf_in_new();
+    *out = (anjay_input_ctx_t *) ctx;
+    if (!ctx) {
+        return -1;
+    }
+    int retval = build_index(&ctx->owned_index, data, size);
+    if (retval) {
+        anjay_log(DEBUG, "malformed TLV payload");
+        free(ctx);
+        *out = NULL;
+        return retval;
+    }
+    ctx->entries = ctx->owned_index.entries;
+    ctx->end_entry = ctx->owned_index.num_entries;
+    return 0;
+}
+
+/**
+ * Returns the incoming CoAP message if the whole payload is available in it,
+ * i.e. the stream is a CoAP stream and the request is not a BLOCK1 transfer.
+ */
+static const avs_coap_msg_t *get_whole_payload_msg(
+        avs_stream_abstract_t *stream) {
+    const avs_coap_msg_t *msg;
+    avs_coap_block_info_t block1;
+    if (!_anjay_is_coap_stream(stream)
+            || _anjay_coap_stream_get_incoming_msg(stream, &msg)
+            || avs_coap_get_block_info(msg, AVS_COAP_BLOCK1, &block1)
+            || block1.valid) {
+        return NULL;
+    }
+    return msg;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 int _anjay_input_tlv_create(anjay_input_ctx_t **out,
                             avs_stream_abstract_t **stream_ptr,
                             bool autoclose) {
+    const avs_coap_msg_t *msg = get_whole_payload_msg(*stream_ptr);
+    if (msg) {
+        int retval = tlv_buf_in_create(
+                out, (const uint8_t *) avs_coap_msg_payload(msg),
+                avs_coap_msg_payload_length(msg));
+        if (!retval && autoclose) {
+            ((tlv_in_t *) *out)->stream.backend = *stream_ptr;
+            ((tlv_in_t *) *out)->autoclose = true;
+            *stream_ptr = NULL;
+        }
+        return retval;
+    }
+
     tlv_in_t *ctx = (tlv_in_t *) calloc(1, sizeof(tlv_in_t));
     *out = (anjay_input_ctx_t *) ctx;
     if (!ctx) {
@@ -227,6 +227,10 @@ int anjay_ret_array_index(anjay_output_ctx_t *array_ctx, anjay_riid_t index) {
     return _anjay_output_set_id(array_ctx, ANJAY_ID_RIID, index);
 }
 
+int anjay_ret_resource_id(anjay_output_ctx_t *ctx, anjay_rid_t rid) {
+    return _anjay_output_set_id(ctx, ANJAY_ID_RID, rid);
+}
+
 int anjay_ret_array_finish(anjay_output_ctx_t *array_ctx) {
     if (!array_ctx->vtable->array_finish) {
         set_errno_not_implemented(array_ctx);
@@ -427,6 +431,9 @@ int _anjay_input_attach_child(anjay_input_ctx_t *ctx,
 }
 
 anjay_input_ctx_t *_anjay_input_nested_ctx(anjay_input_ctx_t *ctx) {
+    if (ctx->vtable->nested_ctx) {
+        return ctx->vtable->nested_ctx(ctx);
+    }
     anjay_input_ctx_t *retval = NULL;
     avs_stream_abstract_t *stream = _anjay_input_bytes_stream(ctx);
     if (stream && _anjay_input_tlv_create(&retval, &stream, true)) {
@@ -41,6 +41,13 @@ typedef enum {
 anjay_input_ctx_constructor_t _anjay_input_dynamic_create;
 anjay_input_ctx_constructor_t _anjay_input_opaque_create;
 anjay_input_ctx_constructor_t _anjay_input_text_create;
+#ifdef WITH_JSON
+anjay_input_ctx_constructor_t _anjay_input_json_create;
+anjay_input_ctx_constructor_t _anjay_input_senml_json_create;
+#endif
+#ifdef WITH_SENML_CBOR
+anjay_input_ctx_constructor_t _anjay_input_senml_cbor_create;
+#endif
 
 #ifdef WITH_LEGACY_CONTENT_FORMAT_SUPPORT
 uint16_t _anjay_translate_legacy_content_format(uint16_t format);
@@ -89,6 +96,14 @@ _anjay_output_json_create(avs_stream_abstract_t *stream,
                           const anjay_uri_path_t *uri);
 #endif
 
+#ifdef WITH_SENML_CBOR
+anjay_output_ctx_t *
+_anjay_output_senml_cbor_create(avs_stream_abstract_t *stream,
+                                int *errno_ptr,
+                                anjay_msg_details_t *inout_details,
+                                const anjay_uri_path_t *uri);
+#endif
+
 int *_anjay_output_ctx_errno_ptr(anjay_output_ctx_t *ctx);
 anjay_output_ctx_t * _anjay_output_object_start(anjay_output_ctx_t *ctx);
 int _anjay_output_object_finish(anjay_output_ctx_t *ctx);
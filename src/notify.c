@@ -62,6 +62,41 @@ static int observe_notify(anjay_t *anjay,
 #define observe_notify(anjay, origin_ssid, queue) ((void) (origin_ssid), 0)
 #endif // WITH_OBSERVE
 
+#ifdef WITH_DISCOVER
+static void discover_cache_notify(anjay_t *anjay,
+                                  anjay_notify_queue_t queue) {
+    AVS_LIST(anjay_notify_queue_object_entry_t) it;
+    AVS_LIST_FOREACH(it, queue) {
+        if (it->oid == ANJAY_DM_OID_SERVER
+                && it->instance_set_changes.instance_set_changed) {
+            // attributes of removed servers are dropped along with them
+            _anjay_discover_cache_invalidate(anjay, ANJAY_SSID_ANY,
+                                             &(const anjay_uri_path_t) {
+                                                 .has_oid = false
+                                             });
+            return;
+        }
+        if (it->instance_set_changes.instance_set_changed) {
+            _anjay_discover_cache_invalidate(anjay, ANJAY_SSID_ANY,
+                                             &(const anjay_uri_path_t) {
+                                                 .oid = it->oid,
+                                                 .has_oid = true
+                                             });
+        } else {
+            // resource presence or dim may have changed
+            AVS_LIST(anjay_notify_queue_resource_entry_t) it2;
+            AVS_LIST_FOREACH(it2, it->resources_changed) {
+                _anjay_discover_cache_invalidate(
+                        anjay, ANJAY_SSID_ANY,
+                        &MAKE_RESOURCE_PATH(it->oid, it2->iid, it2->rid));
+            }
+        }
+    }
+}
+#else // WITH_DISCOVER
+#define discover_cache_notify(anjay, queue) ((void) 0)
+#endif // WITH_DISCOVER
+
 static int security_modified_notify(
         anjay_t *anjay, anjay_notify_queue_object_entry_t *security) {
     if (anjay_is_offline(anjay)) {
@@ -125,6 +160,7 @@ int _anjay_notify_perform(anjay_t *anjay,
             _anjay_update_ret(&ret, server_modified_notify(anjay, it));
         }
     }
+    discover_cache_notify(anjay, queue);
     _anjay_update_ret(&ret, observe_notify(anjay, queue));
     AVS_LIST(anjay_dm_installed_module_t) module;
     AVS_LIST_FOREACH(module, anjay->dm.modules) {
@@ -262,6 +298,20 @@ int _anjay_notify_queue_instance_set_unknown_change(
     return 0;
 }
 
+int _anjay_notify_queue_all_instances_removed(anjay_notify_queue_t *out_queue,
+                                              anjay_oid_t oid) {
+    AVS_LIST(anjay_notify_queue_object_entry_t) *entry_ptr =
+            find_or_create_object_entry(out_queue, oid);
+    if (!entry_ptr) {
+        anjay_log(ERROR, "Out of memory");
+        return -1;
+    }
+    AVS_LIST_CLEAR(&(*entry_ptr)->instance_set_changes.known_added_iids);
+    AVS_LIST_CLEAR(&(*entry_ptr)->resources_changed);
+    (*entry_ptr)->instance_set_changes.instance_set_changed = true;
+    return 0;
+}
+
 static int compare_resource_entries(
         const anjay_notify_queue_resource_entry_t *left,
         const anjay_notify_queue_resource_entry_t *right) {
@@ -342,6 +392,10 @@ int anjay_notify_changed(anjay_t *anjay,
                          anjay_oid_t oid,
                          anjay_iid_t iid,
                          anjay_rid_t rid) {
+    // the queue is flushed asynchronously; don't serve stale Discover
+    // responses in the meantime
+    _anjay_discover_cache_invalidate(anjay, ANJAY_SSID_ANY,
+                                     &MAKE_RESOURCE_PATH(oid, iid, rid));
     int retval;
     (void) ((retval = _anjay_notify_queue_resource_change(
                     &anjay->scheduled_notify.queue, oid, iid, rid))
@@ -350,6 +404,11 @@ int anjay_notify_changed(anjay_t *anjay,
 }
 
 int anjay_notify_instances_changed(anjay_t *anjay, anjay_oid_t oid) {
+    _anjay_discover_cache_invalidate(anjay, ANJAY_SSID_ANY,
+                                     &(const anjay_uri_path_t) {
+                                         .oid = oid,
+                                         .has_oid = true
+                                     });
     int retval;
     (void) ((retval = _anjay_notify_queue_instance_set_unknown_change(
                     &anjay->scheduled_notify.queue, oid))
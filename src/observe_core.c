@@ -129,7 +129,9 @@ static void cleanup_connection(anjay_t *anjay,
         AVS_LIST_CLEAR(&(*conn->entries)->last_sent);
     }
     _anjay_sched_del(anjay->sched, &conn->flush_task);
-    AVS_LIST_CLEAR(&conn->unsent);
+    AVS_LIST_CLEAR(&conn->unsent) {
+        _anjay_exchange_cancel(anjay, &conn->unsent->exchange);
+    }
 }
 
 void _anjay_observe_cleanup(anjay_t *anjay) {
@@ -187,6 +189,7 @@ static void clear_entry(anjay_t *anjay,
             if ((*unsent_ptr)->ref != entry) {
                 server_last_unsent = *unsent_ptr;
             } else {
+                _anjay_exchange_cancel(anjay, &(*unsent_ptr)->exchange);
                 AVS_LIST_DELETE(unsent_ptr);
             }
         }
@@ -233,7 +236,7 @@ static int schedule_trigger(anjay_t *anjay,
 
     avs_time_duration_t delay =
             avs_time_real_diff(newest_value(entry)->timestamp,
-                               avs_time_real_now());
+                               _anjay_time_real_now(anjay));
     delay = avs_time_duration_add(
             delay, avs_time_duration_from_scalar(period, AVS_TIME_S));
     if (avs_time_duration_less(delay, AVS_TIME_DURATION_ZERO)) {
@@ -246,7 +249,8 @@ static int schedule_trigger(anjay_t *anjay,
 }
 
 static AVS_LIST(anjay_observe_resource_value_t)
-create_resource_value(const anjay_msg_details_t *details,
+create_resource_value(anjay_t *anjay,
+                      const anjay_msg_details_t *details,
                       anjay_observe_entry_t *ref,
                       const avs_coap_msg_identity_t *identity,
                       double numeric,
@@ -261,6 +265,8 @@ create_resource_value(const anjay_msg_details_t *details,
     result->details = *details;
     result->ref = ref;
     result->identity = *identity;
+    result->exchange = ANJAY_EXCHANGE_ID_INVALID;
+    result->delivered = false;
     result->numeric = numeric;
     AVS_STATIC_ASSERT(sizeof(result->value_length) == sizeof(size),
                       length_size);
@@ -269,11 +275,12 @@ create_resource_value(const anjay_msg_details_t *details,
     if (data) {
         memcpy(result->value, data, size);
     }
-    result->timestamp = avs_time_real_now();
+    result->timestamp = _anjay_time_real_now(anjay);
     return result;
 }
 
-static int insert_new_value(anjay_observe_connection_entry_t *conn_state,
+static int insert_new_value(anjay_t *anjay,
+                            anjay_observe_connection_entry_t *conn_state,
                             anjay_observe_entry_t *entry,
                             const anjay_msg_details_t *details,
                             const avs_coap_msg_identity_t *identity,
@@ -281,7 +288,7 @@ static int insert_new_value(anjay_observe_connection_entry_t *conn_state,
                             const void *data,
                             size_t size) {
     AVS_LIST(anjay_observe_resource_value_t) res_value =
-            create_resource_value(details, entry, identity,
+            create_resource_value(anjay, details, entry, identity,
                                   numeric, data, size);
     if (!res_value) {
         return -1;
@@ -307,7 +314,7 @@ static int insert_error(anjay_t *anjay,
         .msg_code = _anjay_make_error_response_code(outer_result),
         .format = AVS_COAP_FORMAT_NONE
     };
-    return insert_new_value(conn_state, entry, &details, identity,
+    return insert_new_value(anjay, conn_state, entry, &details, identity,
                             NAN, NULL, 0);
 }
 
@@ -374,7 +381,7 @@ static int insert_initial_value(
     assert(!entry->last_sent);
     assert(!entry->last_unsent);
 
-    avs_time_real_t now = avs_time_real_now();
+    avs_time_real_t now = _anjay_time_real_now(anjay);
 
     int result;
     anjay_dm_internal_res_attrs_t attrs;
@@ -382,7 +389,7 @@ static int insert_initial_value(
     // even though we haven't actually sent it ourselves
     if (!(result = get_attrs(anjay, &attrs, &entry->key))
             && (entry->last_sent =
-                    create_resource_value(details, entry, identity,
+                    create_resource_value(anjay, details, entry, identity,
                                           numeric, data, size))
             && !(result = schedule_trigger(anjay, entry,
                                            attrs.standard.common.max_period))) {
@@ -552,10 +559,12 @@ void _anjay_observe_gc(anjay_t *anjay) {
     }
 }
 
-static bool has_pmax_expired(const anjay_observe_resource_value_t *value,
+static bool has_pmax_expired(anjay_t *anjay,
+                             const anjay_observe_resource_value_t *value,
                              const anjay_dm_attributes_t *attrs) {
     return attrs->max_period >= 0
-            && avs_time_real_diff(avs_time_real_now(), value->timestamp).seconds
+            && avs_time_real_diff(_anjay_time_real_now(anjay),
+                                  value->timestamp).seconds
                     >= attrs->max_period;
 }
 
@@ -639,7 +648,8 @@ static int ensure_conn_online(anjay_t *anjay, anjay_connection_ref_t ref) {
     if (_anjay_connection_current_mode(ref) == ANJAY_CONNECTION_QUEUE
             && !_anjay_connection_is_online(ref)) {
         bool session_resumed;
-        if (_anjay_connection_bring_online(_anjay_get_server_connection(ref),
+        if (_anjay_connection_bring_online(anjay,
+                                           _anjay_get_server_connection(ref),
                                            &session_resumed)) {
             anjay_log(ERROR, "broken socket for server %" PRIu16,
                       ref.server->ssid);
@@ -700,8 +710,21 @@ static void value_sent(anjay_observe_connection_entry_t *conn_state) {
 static int sched_flush_send_queue(anjay_t *anjay,
                                   anjay_observe_connection_entry_t *conn);
 
+static void con_notify_finished(anjay_t *anjay,
+                                anjay_exchange_id_t exchange_id,
+                                anjay_exchange_result_t result,
+                                const avs_coap_msg_t *response,
+                                void *conn_);
+
+static bool is_confirmable(avs_time_real_t now,
+                           const anjay_observe_resource_value_t *value) {
+    return value->details.msg_type == AVS_COAP_MSG_CONFIRMABLE
+            || confirmable_required(now, value->ref);
+}
+
 static int send_entry(anjay_t *anjay,
-                      anjay_observe_connection_entry_t *conn_state) {
+                      anjay_observe_connection_entry_t *conn_state,
+                      anjay_observe_resource_value_t *value) {
     int result;
     anjay_connection_ref_t ref;
     if ((result = get_conn_ref(anjay, &ref,
@@ -711,35 +734,48 @@ static int send_entry(anjay_t *anjay,
         return result;
     }
     anjay_active_server_info_t *server = anjay->current_connection.server;
-    assert(conn_state->unsent);
-    anjay_observe_entry_t *entry = conn_state->unsent->ref;
-    const avs_coap_msg_identity_t *id = &conn_state->unsent->identity;
-    anjay_msg_details_t details = conn_state->unsent->details;
+    assert(!value->exchange);
+    assert(!value->delivered);
+    anjay_msg_details_t details = value->details;
     avs_coap_msg_identity_t notify_id;
 
-    avs_time_real_t now = avs_time_real_now();
-    if (details.msg_type != AVS_COAP_MSG_CONFIRMABLE
-            && confirmable_required(now, entry)) {
+    if (is_confirmable(_anjay_time_real_now(anjay), value)) {
         details.msg_type = AVS_COAP_MSG_CONFIRMABLE;
     }
 
     (void) ((result = _anjay_coap_stream_setup_request(
-                    anjay->comm_stream, &details, &id->token))
+                    anjay->comm_stream, &details, &value->identity.token))
             || (result = avs_stream_write(anjay->comm_stream,
-                                          conn_state->unsent->value,
-                                          conn_state->unsent->value_length))
+                                          value->value, value->value_length))
             || (result = _anjay_coap_stream_get_request_identity(
-                    anjay->comm_stream, &notify_id))
-            || (result = avs_stream_finish_message(anjay->comm_stream)));
+                    anjay->comm_stream, &notify_id)));
+
+    if (!result && details.msg_type == AVS_COAP_MSG_CONFIRMABLE) {
+        // Confirmable notifications are finished in con_notify_finished(),
+        // so that waiting for the ACK does not block the whole client
+        avs_coap_msg_t *msg;
+        result = _anjay_coap_stream_detach_request(anjay->comm_stream, &msg);
+        if (!result) {
+            result = _anjay_exchange_send_confirmable(
+                    anjay, conn_state->key.ssid, conn_state->key.type, msg,
+                    ANJAY_SERVER_STATS_NOTIFY, con_notify_finished, conn_state,
+                    &value->exchange);
+        } else if (result > 0) {
+            // block-wise notifications can only be sent synchronously
+            if (!(result = _anjay_comm_stream_finish_message(anjay))) {
+                value->ref->last_confirmable = _anjay_time_real_now(anjay);
+                value->delivered = true;
+            }
+        }
+    } else if (!result
+                   && !(result = _anjay_comm_stream_finish_message(anjay))) {
+        value->delivered = true;
+    }
 
     _anjay_release_server_stream(anjay);
 
     if (!result) {
-        if (details.msg_type == AVS_COAP_MSG_CONFIRMABLE) {
-            entry->last_confirmable = now;
-        }
-        value_sent(conn_state);
-        entry->last_sent->identity.msg_id = notify_id.msg_id;
+        value->identity.msg_id = notify_id.msg_id;
     } else if (result == AVS_COAP_CTX_ERR_NETWORK) {
         anjay_log(ERROR, "network communication error while sending Observe");
         _anjay_schedule_server_reconnect(anjay, server);
@@ -783,30 +819,121 @@ static inline bool is_error_value(const anjay_observe_resource_value_t *value) {
     return avs_coap_msg_code_get_class(value->details.msg_code) >= 4;
 }
 
-static void remove_all_unsent_values(anjay_observe_connection_entry_t *conn) {
+static void remove_all_unsent_values(anjay_t *anjay,
+                                     anjay_observe_connection_entry_t *conn) {
     while (conn->unsent) {
         AVS_LIST(anjay_observe_resource_value_t) value =
                 detach_first_unsent_value(conn);
+        _anjay_exchange_cancel(anjay, &value->exchange);
         AVS_LIST_DELETE(&value);
     }
 }
 
+/**
+ * Returns the oldest value that has been neither delivered nor is awaiting
+ * acknowledgement, or NULL if there is none.
+ */
+static anjay_observe_resource_value_t *
+first_unsent_value(anjay_observe_connection_entry_t *conn) {
+    AVS_LIST(anjay_observe_resource_value_t) value;
+    AVS_LIST_FOREACH(value, conn->unsent) {
+        if (!value->exchange && !value->delivered) {
+            return value;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Moves delivered values from the head of the send queue to their entries'
+ * last_sent. Values delivered out of order are retired as soon as all older
+ * ones are, so that last_sent always reflects the most recent notification.
+ *
+ * @returns @p conn, or NULL if it has been deleted in the meantime.
+ */
+static anjay_observe_connection_entry_t *
+retire_delivered_values(anjay_t *anjay,
+                        anjay_observe_connection_entry_t *conn) {
+    while (conn && conn->unsent && conn->unsent->delivered) {
+        const anjay_observe_key_t key = conn->unsent->ref->key;
+        const bool is_error = is_error_value(conn->unsent);
+        value_sent(conn);
+        if (is_error) {
+            _anjay_observe_remove_entry(anjay, &key);
+            // the above might've deleted the connection entry
+            conn = AVS_RBTREE_FIND(anjay->observe.connection_entries,
+                                   connection_query(&key.connection));
+        }
+    }
+    return conn;
+}
+
+static void con_notify_finished(anjay_t *anjay,
+                                anjay_exchange_id_t exchange_id,
+                                anjay_exchange_result_t result,
+                                const avs_coap_msg_t *response,
+                                void *conn_) {
+    (void) response;
+    anjay_observe_connection_entry_t *conn =
+            (anjay_observe_connection_entry_t *) conn_;
+    const anjay_connection_key_t conn_key = conn->key;
+
+    // exchanges of removed values are cancelled, so the value must be there
+    AVS_LIST(anjay_observe_resource_value_t) sent;
+    AVS_LIST_FOREACH(sent, conn->unsent) {
+        if (sent->exchange == exchange_id) {
+            break;
+        }
+    }
+    assert(sent);
+    sent->exchange = ANJAY_EXCHANGE_ID_INVALID;
+
+    const anjay_observe_key_t key = sent->ref->key;
+    const bool is_error = is_error_value(sent);
+    switch (result) {
+    case ANJAY_EXCHANGE_RESPONSE:
+        sent->ref->last_confirmable = _anjay_time_real_now(anjay);
+        sent->delivered = true;
+        break;
+    case ANJAY_EXCHANGE_RESET:
+        anjay_log(INFO, "Reset received as reply to notification");
+        _anjay_observe_remove_entry(anjay, &key);
+        // the above might've deleted the connection entry
+        conn = AVS_RBTREE_FIND(anjay->observe.connection_entries,
+                               connection_query(&conn_key));
+        break;
+    case ANJAY_EXCHANGE_TIMEOUT:
+        anjay_log(ERROR, "Confirmable notification not acknowledged");
+        if (server_state(anjay, conn_key.ssid).notification_storing_enabled) {
+            // keep the value for later; it will be sent on next flush
+            return;
+        }
+        remove_all_unsent_values(anjay, conn);
+        if (is_error) {
+            _anjay_observe_remove_entry(anjay, &key);
+        }
+        return;
+    }
+
+    sched_flush_send_queue(anjay, retire_delivered_values(anjay, conn));
+}
+
 static int handle_send_queue_entry(anjay_t *anjay,
                                    anjay_observe_connection_entry_t *conn_state,
+                                   anjay_observe_resource_value_t *value,
                                    observe_server_state_t observe_state) {
-    assert(conn_state->unsent);
     assert(observe_state.server_active);
-    bool is_error = is_error_value(conn_state->unsent);
-    int result = send_entry(anjay, conn_state);
-    if (result > 0) {
-        anjay_log(INFO, "Reset received as reply to notification, result == %d",
-                  result);
+    bool is_error = is_error_value(value);
+    int result = send_entry(anjay, conn_state, value);
+    if (!result && value->exchange) {
+        // the outcome will be handled by con_notify_finished()
+        return 0;
     } else if (result < 0) {
         anjay_log(ERROR, "Could not send Observe notification, result == %d",
                   result);
         if (result != AVS_COAP_CTX_ERR_NETWORK
                 && !observe_state.notification_storing_enabled) {
-            remove_all_unsent_values(conn_state);
+            remove_all_unsent_values(anjay, conn_state);
         }
     }
     if (is_error
@@ -842,9 +969,10 @@ static int flush_send_queue(anjay_t *anjay,
                             const observe_server_state_t *observe_state) {
     int result = 0;
     observe_server_state_t observe_state_buf;
+    anjay_observe_resource_value_t *value;
 
-    while (result >= 0 && conn && conn->unsent) {
-        anjay_observe_key_t key = conn->unsent->ref->key;
+    while (result >= 0 && conn && (value = first_unsent_value(conn))) {
+        anjay_observe_key_t key = value->ref->key;
         if (!observe_state) {
             observe_state_buf = server_state(anjay, key.connection.ssid);
             observe_state = &observe_state_buf;
@@ -852,7 +980,14 @@ static int flush_send_queue(anjay_t *anjay,
                 break;
             }
         }
-        if ((result = handle_send_queue_entry(anjay, conn,
+        if (is_confirmable(_anjay_time_real_now(anjay), value)
+                && _anjay_exchange_count_pending(anjay, conn->key.ssid,
+                                                 conn->key.type)
+                        >= anjay->nstart) {
+            // NSTART limit reached; con_notify_finished() will flush again
+            break;
+        }
+        if ((result = handle_send_queue_entry(anjay, conn, value,
                                               *observe_state)) > 0) {
             _anjay_observe_remove_entry(anjay, &key);
             // the above might've deleted the connection entry,
@@ -860,6 +995,7 @@ static int flush_send_queue(anjay_t *anjay,
             conn = AVS_RBTREE_FIND(anjay->observe.connection_entries,
                                    connection_query(&key.connection));
         }
+        conn = retire_delivered_values(anjay, conn);
     }
     if (result >= 0 && conn && !conn->unsent) {
         schedule_all_triggers(anjay, conn);
@@ -926,7 +1062,7 @@ update_notification_value(anjay_t *anjay,
         return result;
     }
 
-    bool pmax_expired = has_pmax_expired(newest_value(entry),
+    bool pmax_expired = has_pmax_expired(anjay, newest_value(entry),
                                          &attrs.standard.common);
     char buf[ANJAY_MAX_OBSERVABLE_RESOURCE_SIZE];
     anjay_msg_details_t observe_details;
@@ -950,7 +1086,7 @@ update_notification_value(anjay_t *anjay,
     if (pmax_expired || should_update(newest_value(entry), &attrs.standard,
                                       &observe_details, numeric,
                                       buf, (size_t) size)) {
-        result = insert_new_value(conn_state, entry, &observe_details,
+        result = insert_new_value(anjay, conn_state, entry, &observe_details,
                                   &newest_value(entry)->identity, numeric,
                                   buf, (size_t) size);
     }
@@ -974,6 +1110,9 @@ static int trigger_observe(anjay_t *anjay, void *entry_) {
         return 0;
     }
 
+    // the entry might be removed while flushing the notifications
+    const anjay_oid_t oid = entry->key.oid;
+    _anjay_trace_begin(anjay, "observe", "trigger", oid);
     int result = update_notification_value(anjay, conn, entry);
     if (result) {
         result = insert_error(anjay, conn, entry,
@@ -987,6 +1126,7 @@ static int trigger_observe(anjay_t *anjay, void *entry_) {
             result = flush_result;
         }
     }
+    _anjay_trace_end(anjay, "observe", "trigger", oid);
     return result;
 }
 
@@ -24,6 +24,7 @@
 #include <anjay_modules/observe.h>
 
 #include "coap/coap_stream.h"
+#include "coap_exchange.h"
 #include "servers.h"
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
@@ -59,6 +60,11 @@ typedef struct {
     avs_coap_msg_identity_t identity;
     avs_time_real_t timestamp;
     double numeric;
+    // set while the value is being sent in a Confirmable exchange
+    anjay_exchange_id_t exchange;
+    // the value has been delivered, but is kept in the queue until all the
+    // values queued before it are delivered as well
+    bool delivered;
     const size_t value_length;
     char value[1]; // actually a FAM
 } anjay_observe_resource_value_t;
@@ -106,6 +112,7 @@ anjay_output_ctx_t *_anjay_observe_decorate_ctx(anjay_output_ctx_t *backend,
 #define _anjay_observe_init(...) ((int) 0)
 #define _anjay_observe_cleanup(...) ((void) 0)
 #define _anjay_observe_sched_flush_current_connection(...) ((void) 0)
+#define _anjay_observe_sched_flush(...) ((void) 0)
 
 #endif // WITH_OBSERVE
 
@@ -0,0 +1,310 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include <avsystem/commons/utils.h>
+
+#include "anjay_core.h"
+#include "resolver.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+struct anjay_resolver_entry {
+    char host[ANJAY_MAX_URL_HOSTNAME_SIZE];
+    char port[ANJAY_MAX_URL_PORT_SIZE];
+    avs_net_af_t family;
+    char address[ANJAY_MAX_URL_HOSTNAME_SIZE];
+    avs_time_monotonic_t expire_time;
+    anjay_sched_handle_t refresh_job;
+    // the entry has been looked up since it was last refreshed; entries that
+    // are not used any more are dropped instead of being refreshed again
+    bool used;
+};
+
+static int system_resolve(void *arg,
+                          const char *host,
+                          const char *port,
+                          avs_net_af_t family,
+                          char *out_address,
+                          size_t address_size,
+                          avs_time_duration_t *inout_ttl) {
+    (void) arg;
+    (void) inout_ttl;
+
+    avs_net_addrinfo_t *info = avs_net_addrinfo_resolve(
+            AVS_NET_UDP_SOCKET, family, host, port, NULL);
+    avs_net_resolved_endpoint_t endpoint;
+    int result = -1;
+    if (info && !avs_net_addrinfo_next(info, &endpoint)) {
+        result = avs_net_resolved_endpoint_get_host(&endpoint, out_address,
+                                                    address_size);
+    }
+    avs_net_addrinfo_delete(&info);
+    return result;
+}
+
+void _anjay_resolver_init(anjay_resolver_t *resolver,
+                          anjay_resolve_handler_t *handler,
+                          void *handler_arg,
+                          bool background_refresh) {
+    *resolver = (anjay_resolver_t) {
+        .handler = handler ? handler : system_resolve,
+        .handler_arg = handler_arg,
+        .background_refresh = background_refresh,
+        .entries = NULL
+    };
+}
+
+static void delete_entry(anjay_t *anjay,
+                         AVS_LIST(anjay_resolver_entry_t) *entry_ptr) {
+    _anjay_sched_del(anjay->sched, &(*entry_ptr)->refresh_job);
+    AVS_LIST_DELETE(entry_ptr);
+}
+
+void _anjay_resolver_cleanup(anjay_t *anjay) {
+    while (anjay->resolver.entries) {
+        delete_entry(anjay, &anjay->resolver.entries);
+    }
+}
+
+bool _anjay_resolver_applicable(avs_net_socket_type_t type,
+                                const void *config) {
+    switch (type) {
+    case AVS_NET_UDP_SOCKET:
+    case AVS_NET_TCP_SOCKET:
+        return true;
+    case AVS_NET_DTLS_SOCKET:
+    case AVS_NET_SSL_SOCKET:
+        return config
+                && ((const avs_net_ssl_configuration_t *) config)
+                                   ->security.mode
+                        == AVS_NET_SECURITY_PSK;
+    default:
+        return false;
+    }
+}
+
+avs_net_af_t _anjay_resolver_address_family(avs_net_socket_type_t type,
+                                            const void *config) {
+    if (!config) {
+        return AVS_NET_AF_UNSPEC;
+    }
+    switch (type) {
+    case AVS_NET_UDP_SOCKET:
+    case AVS_NET_TCP_SOCKET:
+        return ((const avs_net_socket_configuration_t *) config)
+                ->address_family;
+    case AVS_NET_DTLS_SOCKET:
+    case AVS_NET_SSL_SOCKET:
+        return ((const avs_net_ssl_configuration_t *) config)
+                ->backend_configuration.address_family;
+    default:
+        return AVS_NET_AF_UNSPEC;
+    }
+}
+
+static int call_handler(anjay_t *anjay,
+                        const char *host,
+                        const char *port,
+                        avs_net_af_t family,
+                        char *out_address,
+                        size_t address_size,
+                        avs_time_duration_t *out_ttl) {
+    *out_ttl = avs_time_duration_from_scalar(ANJAY_DNS_CACHE_DEFAULT_TTL_S,
+                                             AVS_TIME_S);
+    int result = anjay->resolver.handler(anjay->resolver.handler_arg, host,
+                                         port, family, out_address,
+                                         address_size, out_ttl);
+    if (!result && !memchr(out_address, '\0', address_size)) {
+        anjay_log(ERROR, "address of %s does not fit in the buffer", host);
+        result = -1;
+    }
+    if (result) {
+        anjay_log(ERROR, "could not resolve %s:%s", host, port);
+    } else {
+        anjay_log(DEBUG, "resolved %s:%s to %s", host, port, out_address);
+    }
+    return result;
+}
+
+static AVS_LIST(anjay_resolver_entry_t) *find_entry_ptr(anjay_t *anjay,
+                                                        const char *host,
+                                                        const char *port,
+                                                        avs_net_af_t family) {
+    AVS_LIST(anjay_resolver_entry_t) *entry_ptr;
+    AVS_LIST_FOREACH_PTR(entry_ptr, &anjay->resolver.entries) {
+        if (!strcmp((*entry_ptr)->host, host)
+                && !strcmp((*entry_ptr)->port, port)
+                && (*entry_ptr)->family == family) {
+            return entry_ptr;
+        }
+    }
+    return NULL;
+}
+
+static int copy_address(char *out_address,
+                        size_t address_size,
+                        const char *address) {
+    if (avs_simple_snprintf(out_address, address_size, "%s", address) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static int refresh_job(anjay_t *anjay, void *entry_);
+
+static void sched_refresh(anjay_t *anjay,
+                          anjay_resolver_entry_t *entry,
+                          avs_time_duration_t delay) {
+    _anjay_sched_del(anjay->sched, &entry->refresh_job);
+    if (_anjay_sched(anjay->sched, &entry->refresh_job, delay, refresh_job,
+                     entry)) {
+        anjay_log(WARNING, "could not schedule refresh of %s", entry->host);
+    }
+}
+
+static int update_entry(anjay_t *anjay,
+                        anjay_resolver_entry_t *entry,
+                        const char *address,
+                        avs_time_duration_t ttl) {
+    if (copy_address(entry->address, sizeof(entry->address), address)) {
+        anjay_log(WARNING, "address of %s too long, not caching", entry->host);
+        return -1;
+    }
+    entry->expire_time =
+            avs_time_monotonic_add(_anjay_time_monotonic_now(anjay), ttl);
+    sched_refresh(anjay, entry, ttl);
+    return 0;
+}
+
+/**
+ * Fires when the entry expires. Entries not used since the previous expiry are
+ * dropped. The others are kept, so that the last known address may be used as
+ * a fallback, and - only if background refresh is enabled, as the resolver
+ * may block - resolved again.
+ */
+static int refresh_job(anjay_t *anjay, void *entry_) {
+    anjay_resolver_entry_t *entry = (anjay_resolver_entry_t *) entry_;
+    AVS_LIST(anjay_resolver_entry_t) *entry_ptr =
+            find_entry_ptr(anjay, entry->host, entry->port, entry->family);
+    assert(entry_ptr && *entry_ptr == entry);
+
+    if (!entry->used) {
+        anjay_log(TRACE, "dropping unused cache entry for %s", entry->host);
+        delete_entry(anjay, entry_ptr);
+        return 0;
+    }
+
+    entry->used = false;
+    const avs_time_duration_t default_ttl =
+            avs_time_duration_from_scalar(ANJAY_DNS_CACHE_DEFAULT_TTL_S,
+                                          AVS_TIME_S);
+    if (!anjay->resolver.background_refresh) {
+        sched_refresh(anjay, entry, default_ttl);
+        return 0;
+    }
+
+    char address[sizeof(entry->address)];
+    avs_time_duration_t ttl;
+    if (call_handler(anjay, entry->host, entry->port, entry->family, address,
+                     sizeof(address), &ttl)) {
+        // keep the last known address as a fallback; the entry is dropped
+        // when this job fires again, unless it is used in the meantime
+        sched_refresh(anjay, entry, default_ttl);
+    } else if (!avs_time_duration_less(AVS_TIME_DURATION_ZERO, ttl)
+                   || update_entry(anjay, entry, address, ttl)) {
+        delete_entry(anjay, entry_ptr);
+    }
+    return 0;
+}
+
+int _anjay_resolver_resolve(anjay_t *anjay,
+                            const char *host,
+                            const char *port,
+                            avs_net_af_t family,
+                            char *out_address,
+                            size_t address_size) {
+    AVS_LIST(anjay_resolver_entry_t) *entry_ptr =
+            find_entry_ptr(anjay, host, port, family);
+    if (entry_ptr) {
+        (*entry_ptr)->used = true;
+        if (avs_time_monotonic_before(_anjay_time_monotonic_now(anjay),
+                                      (*entry_ptr)->expire_time)) {
+            return copy_address(out_address, address_size,
+                                (*entry_ptr)->address);
+        }
+    }
+
+    char address[ANJAY_MAX_URL_HOSTNAME_SIZE];
+    avs_time_duration_t ttl;
+    if (call_handler(anjay, host, port, family, address, sizeof(address),
+                     &ttl)) {
+        if (!entry_ptr) {
+            return -1;
+        }
+        anjay_log(WARNING, "using last known address of %s: %s", host,
+                  (*entry_ptr)->address);
+        return copy_address(out_address, address_size, (*entry_ptr)->address);
+    }
+
+    if (!avs_time_duration_less(AVS_TIME_DURATION_ZERO, ttl)) {
+        if (entry_ptr) {
+            delete_entry(anjay, entry_ptr);
+        }
+    } else if (!entry_ptr) {
+        if (strlen(host) < ANJAY_MAX_URL_HOSTNAME_SIZE
+                && strlen(port) < ANJAY_MAX_URL_PORT_SIZE) {
+            AVS_LIST(anjay_resolver_entry_t) entry =
+                    AVS_LIST_NEW_ELEMENT(anjay_resolver_entry_t);
+            if (!entry) {
+                anjay_log(WARNING, "out of memory, not caching %s", host);
+            } else {
+                strcpy(entry->host, host);
+                strcpy(entry->port, port);
+                entry->family = family;
+                entry->used = true;
+                if (update_entry(anjay, entry, address, ttl)) {
+                    AVS_LIST_DELETE(&entry);
+                } else {
+                    AVS_LIST_INSERT(&anjay->resolver.entries, entry);
+                }
+            }
+        }
+    } else if (update_entry(anjay, *entry_ptr, address, ttl)) {
+        delete_entry(anjay, entry_ptr);
+    }
+    return copy_address(out_address, address_size, address);
+}
+
+int _anjay_resolver_connect(anjay_t *anjay,
+                            avs_net_abstract_socket_t *socket,
+                            avs_net_af_t family,
+                            const char *host,
+                            const char *port) {
+    char address[ANJAY_MAX_URL_HOSTNAME_SIZE];
+    if (_anjay_resolver_resolve(anjay, host, port, family, address,
+                                sizeof(address))) {
+        return -1;
+    }
+    return avs_net_socket_connect(socket, address, port);
+}
+
+#ifdef ANJAY_TEST
+#include "test/resolver.c"
+#endif // ANJAY_TEST
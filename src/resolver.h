@@ -0,0 +1,91 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_RESOLVER_H
+#define ANJAY_RESOLVER_H
+
+#include <avsystem/commons/list.h>
+#include <avsystem/commons/net.h>
+
+#include <anjay/core.h>
+
+#include "utils_core.h"
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+typedef struct anjay_resolver_entry anjay_resolver_entry_t;
+
+typedef struct {
+    anjay_resolve_handler_t *handler;
+    void *handler_arg;
+    bool background_refresh;
+    AVS_LIST(anjay_resolver_entry_t) entries;
+} anjay_resolver_t;
+
+void _anjay_resolver_init(anjay_resolver_t *resolver,
+                          anjay_resolve_handler_t *handler,
+                          void *handler_arg,
+                          bool background_refresh);
+
+void _anjay_resolver_cleanup(anjay_t *anjay);
+
+/**
+ * Checks whether a socket of given @p type and @p config (as passed to
+ * avs_net_socket_create()) may be connected to a numeric address resolved by
+ * @ref _anjay_resolver_connect, instead of the original hostname.
+ *
+ * This is not the case for certificate-based (D)TLS, as the hostname is needed
+ * to verify the peer certificate.
+ */
+bool _anjay_resolver_applicable(avs_net_socket_type_t type,
+                                const void *config);
+
+/**
+ * Returns the address family set in socket @p config of given @p type (as
+ * passed to avs_net_socket_create()).
+ */
+avs_net_af_t _anjay_resolver_address_family(avs_net_socket_type_t type,
+                                            const void *config);
+
+/**
+ * Translates @p host into a numeric address of given @p family , using the
+ * cache if possible.
+ *
+ * Expired entries are resolved again when looked up, or by a scheduler job as
+ * soon as they expire if background refresh is enabled. Entries not used
+ * during their TTL are dropped. If resolving fails, the last known address is
+ * returned, if any.
+ */
+int _anjay_resolver_resolve(anjay_t *anjay,
+                            const char *host,
+                            const char *port,
+                            avs_net_af_t family,
+                            char *out_address,
+                            size_t address_size);
+
+/**
+ * Connects @p socket to @p host, resolved using
+ * @ref _anjay_resolver_resolve .
+ */
+int _anjay_resolver_connect(anjay_t *anjay,
+                            avs_net_abstract_socket_t *socket,
+                            avs_net_af_t family,
+                            const char *host,
+                            const char *port);
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_RESOLVER_H */
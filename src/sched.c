@@ -78,6 +78,56 @@ sched_delayed(anjay_sched_t *sched,
               avs_time_duration_t delay,
               AVS_LIST(anjay_sched_entry_t) entry);
 
+static anjay_sched_job_stats_t *get_job_stats(anjay_sched_t *sched,
+                                              anjay_sched_clb_t clb) {
+    const uintptr_t callback = (uintptr_t) (intptr_t) clb;
+    AVS_LIST(anjay_sched_job_stats_t) *stats_ptr;
+    AVS_LIST_FOREACH_PTR(stats_ptr, &sched->job_stats) {
+        if ((*stats_ptr)->callback == callback) {
+            return *stats_ptr;
+        }
+    }
+    AVS_LIST(anjay_sched_job_stats_t) stats =
+            AVS_LIST_NEW_ELEMENT(anjay_sched_job_stats_t);
+    if (!stats) {
+        sched_log(WARNING, "out of memory, job statistics not updated");
+        return NULL;
+    }
+    stats->callback = callback;
+    stats->total_run_time = AVS_TIME_DURATION_ZERO;
+    stats->max_run_time = AVS_TIME_DURATION_ZERO;
+    stats->max_lateness = AVS_TIME_DURATION_ZERO;
+    AVS_LIST_INSERT(stats_ptr, stats);
+    return stats;
+}
+
+static void update_job_stats(anjay_sched_t *sched,
+                             anjay_sched_clb_t clb,
+                             avs_time_duration_t lateness,
+                             avs_time_duration_t run_time) {
+    anjay_sched_job_stats_t *stats = get_job_stats(sched, clb);
+    if (!stats) {
+        return;
+    }
+    ++stats->count;
+    stats->total_run_time = avs_time_duration_add(stats->total_run_time,
+                                                  run_time);
+    if (avs_time_duration_less(stats->max_run_time, run_time)) {
+        stats->max_run_time = run_time;
+    }
+    if (avs_time_duration_less(stats->max_lateness, lateness)) {
+        stats->max_lateness = lateness;
+    }
+
+    if (sched->watchdog_handler
+            && avs_time_duration_less(sched->watchdog_budget, run_time)) {
+        sched_log(WARNING, "job %p ran for %" PRId64 ".%09" PRId32 " s",
+                  (void *) (intptr_t) clb, run_time.seconds,
+                  run_time.nanoseconds);
+        sched->watchdog_handler(sched->watchdog_handler_arg, stats, run_time);
+    }
+}
+
 static void execute_task(anjay_sched_t *sched,
                          AVS_LIST(anjay_sched_entry_t) entry) {
     /* make sure the task is detached */
@@ -91,7 +141,16 @@ static void execute_task(anjay_sched_t *sched,
         handle = *entry->handle_ptr;
         *entry->handle_ptr = NULL;
     }
+    const avs_time_monotonic_t start_time =
+            _anjay_time_monotonic_now(sched->anjay);
+    _anjay_trace_begin(sched->anjay, "sched", "job", (intptr_t) entry->clb);
     int clb_result = entry->clb(sched->anjay, entry->clb_data);
+    _anjay_trace_end(sched->anjay, "sched", "job", (intptr_t) entry->clb);
+    update_job_stats(sched, entry->clb,
+                     avs_time_monotonic_diff(start_time, entry->when),
+                     avs_time_monotonic_diff(
+                             _anjay_time_monotonic_now(sched->anjay),
+                             start_time));
     if (clb_result) {
         sched_log(DEBUG, "non-zero (%d) job exit status (clb=%p)",
                   clb_result, (void *) (intptr_t) entry->clb);
@@ -127,20 +186,35 @@ static void execute_task(anjay_sched_t *sched,
     }
 }
 
-ssize_t _anjay_sched_run(anjay_sched_t *sched) {
-    int running = 1;
+static bool budget_exhausted(anjay_sched_t *sched,
+                             ssize_t tasks_executed,
+                             size_t max_tasks,
+                             avs_time_monotonic_t deadline) {
+    // at least one task is always executed, to guarantee progress
+    if (tasks_executed == 0) {
+        return false;
+    }
+    return (max_tasks && (size_t) tasks_executed >= max_tasks)
+            || (avs_time_monotonic_valid(deadline)
+                    && !avs_time_monotonic_before(
+                               _anjay_time_monotonic_now(sched->anjay),
+                               deadline));
+}
+
+ssize_t _anjay_sched_run_bounded(anjay_sched_t *sched,
+                                 size_t max_tasks,
+                                 avs_time_monotonic_t deadline) {
     ssize_t tasks_executed = 0;
 
-    avs_time_monotonic_t now = avs_time_monotonic_now();
+    avs_time_monotonic_t now = _anjay_time_monotonic_now(sched->anjay);
 
-    while (running) {
+    while (!budget_exhausted(sched, tasks_executed, max_tasks, deadline)) {
         anjay_sched_entry_t *task = fetch_task(sched, &now);
         if (!task) {
-            running = 0;
-        } else {
-            execute_task(sched, task);
-            ++tasks_executed;
+            break;
         }
+        execute_task(sched, task);
+        ++tasks_executed;
     }
 
     avs_time_duration_t delay = AVS_TIME_DURATION_ZERO;
@@ -152,6 +226,17 @@ ssize_t _anjay_sched_run(anjay_sched_t *sched) {
     return tasks_executed;
 }
 
+ssize_t _anjay_sched_run(anjay_sched_t *sched) {
+    return _anjay_sched_run_bounded(sched, 0, AVS_TIME_MONOTONIC_INVALID);
+}
+
+bool _anjay_sched_has_due_tasks(anjay_sched_t *sched) {
+    return sched->entries
+            && !avs_time_monotonic_before(
+                       _anjay_time_monotonic_now(sched->anjay),
+                       sched->entries->when);
+}
+
 void _anjay_sched_delete(anjay_sched_t **sched_ptr) {
     if (!sched_ptr || !*sched_ptr) {
         return;
@@ -166,6 +251,7 @@ void _anjay_sched_delete(anjay_sched_t **sched_ptr) {
             *(*sched_ptr)->entries->handle_ptr = NULL;
         }
     }
+    AVS_LIST_CLEAR(&(*sched_ptr)->job_stats);
     free(*sched_ptr);
     *sched_ptr = NULL;
 }
@@ -228,7 +314,7 @@ static anjay_sched_handle_t
 sched_delayed(anjay_sched_t *sched,
               avs_time_duration_t delay,
               AVS_LIST(anjay_sched_entry_t) entry) {
-    avs_time_monotonic_t sched_time = avs_time_monotonic_now();
+    avs_time_monotonic_t sched_time = _anjay_time_monotonic_now(sched->anjay);
     sched_log(TRACE, "current time %" PRId64 ".%09" PRId32,
               sched_time.since_monotonic_epoch.seconds,
               sched_time.since_monotonic_epoch.nanoseconds);
@@ -327,7 +413,7 @@ int _anjay_sched_del(anjay_sched_t *sched, anjay_sched_handle_t *handle) {
 int _anjay_sched_time_to_next(anjay_sched_t *sched,
                               avs_time_duration_t *delay) {
     anjay_sched_entry_t *elem;
-    avs_time_monotonic_t now = avs_time_monotonic_now();
+    avs_time_monotonic_t now = _anjay_time_monotonic_now(sched->anjay);
 
     AVS_LIST_FOREACH(elem, sched->entries) {
         if (delay) {
@@ -342,6 +428,27 @@ int _anjay_sched_time_to_next(anjay_sched_t *sched,
     return -1;
 }
 
+AVS_LIST(const anjay_sched_job_stats_t) anjay_sched_job_stats(anjay_t *anjay) {
+    return anjay->sched->job_stats;
+}
+
+int anjay_sched_set_watchdog(anjay_t *anjay,
+                             avs_time_duration_t budget,
+                             anjay_sched_overrun_handler_t *handler,
+                             void *arg) {
+    if (handler
+            && (!avs_time_duration_valid(budget)
+                    || avs_time_duration_less(budget,
+                                              AVS_TIME_DURATION_ZERO))) {
+        sched_log(ERROR, "invalid watchdog budget");
+        return -1;
+    }
+    anjay->sched->watchdog_budget = budget;
+    anjay->sched->watchdog_handler = handler;
+    anjay->sched->watchdog_handler_arg = arg;
+    return 0;
+}
+
 #ifdef ANJAY_TEST
 #include "test/sched.c"
 #endif // ANJAY_TEST
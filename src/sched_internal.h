@@ -47,6 +47,11 @@ struct anjay_sched_struct {
     anjay_t *anjay;
     AVS_LIST(anjay_sched_entry_t) entries;
     bool shut_down;
+
+    AVS_LIST(anjay_sched_job_stats_t) job_stats;
+    avs_time_duration_t watchdog_budget;
+    anjay_sched_overrun_handler_t *watchdog_handler;
+    void *watchdog_handler_arg;
 };
 
 VISIBILITY_PRIVATE_HEADER_END
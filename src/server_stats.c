@@ -0,0 +1,185 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <assert.h>
+#include <string.h>
+
+#include <avsystem/commons/coap/ctx.h>
+
+#include "anjay_core.h"
+#include "server_stats.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+#ifdef WITH_NET_STATS
+
+struct anjay_server_stats_entry {
+    anjay_ssid_t ssid;
+    anjay_server_stats_t stats;
+};
+
+static anjay_server_stats_t *find_or_create_stats(anjay_t *anjay,
+                                                  anjay_ssid_t ssid) {
+    AVS_LIST(anjay_server_stats_entry_t) *entry_ptr;
+    AVS_LIST_FOREACH_PTR(entry_ptr, &anjay->server_stats.entries) {
+        if ((*entry_ptr)->ssid >= ssid) {
+            break;
+        }
+    }
+    if (!*entry_ptr || (*entry_ptr)->ssid != ssid) {
+        AVS_LIST(anjay_server_stats_entry_t) entry =
+                AVS_LIST_NEW_ELEMENT(anjay_server_stats_entry_t);
+        if (!entry) {
+            anjay_log(ERROR, "out of memory");
+            return NULL;
+        }
+        entry->ssid = ssid;
+        AVS_LIST_INSERT(entry_ptr, entry);
+    }
+    return &(*entry_ptr)->stats;
+}
+
+void _anjay_server_stats_init(anjay_t *anjay) {
+    anjay_server_stats_registry_t *registry = &anjay->server_stats;
+    registry->entries = NULL;
+    registry->charged_ssid = ANJAY_SSID_ANY;
+    registry->last_tx_bytes = avs_coap_ctx_get_tx_bytes(anjay->coap_ctx);
+    registry->last_rx_bytes = avs_coap_ctx_get_rx_bytes(anjay->coap_ctx);
+    registry->last_num_incoming_retransmissions =
+            avs_coap_ctx_get_num_incoming_retransmissions(anjay->coap_ctx);
+    registry->last_num_outgoing_retransmissions =
+            anjay_get_num_outgoing_retransmissions(anjay);
+}
+
+void _anjay_server_stats_cleanup(anjay_t *anjay) {
+    AVS_LIST_CLEAR(&anjay->server_stats.entries);
+}
+
+void _anjay_server_stats_charge_to(anjay_t *anjay, anjay_ssid_t ssid) {
+    anjay_server_stats_registry_t *registry = &anjay->server_stats;
+    const uint64_t tx_bytes = avs_coap_ctx_get_tx_bytes(anjay->coap_ctx);
+    const uint64_t rx_bytes = avs_coap_ctx_get_rx_bytes(anjay->coap_ctx);
+    const uint64_t num_incoming_retransmissions =
+            avs_coap_ctx_get_num_incoming_retransmissions(anjay->coap_ctx);
+    const uint64_t num_outgoing_retransmissions =
+            anjay_get_num_outgoing_retransmissions(anjay);
+
+    if (registry->charged_ssid != ANJAY_SSID_ANY
+            && (tx_bytes != registry->last_tx_bytes
+                    || rx_bytes != registry->last_rx_bytes)) {
+        anjay_server_stats_t *stats =
+                find_or_create_stats(anjay, registry->charged_ssid);
+        if (stats) {
+            stats->tx_bytes += tx_bytes - registry->last_tx_bytes;
+            stats->rx_bytes += rx_bytes - registry->last_rx_bytes;
+            stats->num_incoming_retransmissions +=
+                    num_incoming_retransmissions
+                    - registry->last_num_incoming_retransmissions;
+            stats->num_outgoing_retransmissions +=
+                    num_outgoing_retransmissions
+                    - registry->last_num_outgoing_retransmissions;
+        }
+    }
+
+    registry->charged_ssid = ssid;
+    registry->last_tx_bytes = tx_bytes;
+    registry->last_rx_bytes = rx_bytes;
+    registry->last_num_incoming_retransmissions = num_incoming_retransmissions;
+    registry->last_num_outgoing_retransmissions = num_outgoing_retransmissions;
+}
+
+anjay_ssid_t _anjay_server_stats_charged_ssid(anjay_t *anjay) {
+    return anjay->server_stats.charged_ssid;
+}
+
+void _anjay_server_stats_record_incoming(anjay_t *anjay, anjay_ssid_t ssid) {
+    anjay_server_stats_t *stats = find_or_create_stats(anjay, ssid);
+    if (stats) {
+        ++stats->num_incoming_messages;
+    }
+}
+
+static size_t latency_bucket(avs_time_duration_t latency) {
+    int64_t latency_ms;
+    if (avs_time_duration_to_scalar(&latency_ms, AVS_TIME_MS, latency)) {
+        return ANJAY_LATENCY_HISTOGRAM_BUCKETS - 1;
+    }
+    size_t bucket = 0;
+    int64_t upper_bound_ms = ANJAY_LATENCY_HISTOGRAM_FIRST_BUCKET_MS;
+    while (bucket < ANJAY_LATENCY_HISTOGRAM_BUCKETS - 1
+            && latency_ms >= upper_bound_ms) {
+        ++bucket;
+        upper_bound_ms *= 2;
+    }
+    return bucket;
+}
+
+void _anjay_server_stats_record_latency(anjay_t *anjay,
+                                        anjay_ssid_t ssid,
+                                        anjay_server_stats_exchange_t exchange,
+                                        avs_time_monotonic_t request_time) {
+    anjay_server_stats_t *stats = find_or_create_stats(anjay, ssid);
+    if (!stats) {
+        return;
+    }
+    anjay_latency_histogram_t *histogram;
+    switch (exchange) {
+    case ANJAY_SERVER_STATS_REGISTER:
+        histogram = &stats->register_latency;
+        break;
+    case ANJAY_SERVER_STATS_UPDATE:
+        histogram = &stats->update_latency;
+        break;
+    case ANJAY_SERVER_STATS_NOTIFY:
+        histogram = &stats->notify_latency;
+        break;
+    default:
+        assert(0 && "Should never happen");
+        return;
+    }
+    ++histogram->buckets[latency_bucket(avs_time_monotonic_diff(
+            _anjay_time_monotonic_now(anjay), request_time))];
+}
+
+#endif // WITH_NET_STATS
+
+int anjay_get_server_stats(anjay_t *anjay,
+                           anjay_ssid_t ssid,
+                           anjay_server_stats_t *out_stats) {
+#ifdef WITH_NET_STATS
+    // bring the statistics of the currently charged server up to date
+    _anjay_server_stats_charge_to(anjay, anjay->server_stats.charged_ssid);
+
+    AVS_LIST(anjay_server_stats_entry_t) entry;
+    AVS_LIST_FOREACH(entry, anjay->server_stats.entries) {
+        if (entry->ssid == ssid) {
+            *out_stats = entry->stats;
+            return 0;
+        }
+    }
+#else
+    (void) anjay;
+    (void) ssid;
+    (void) out_stats;
+#endif
+    return -1;
+}
+
+#ifdef ANJAY_TEST
+#include "test/server_stats.c"
+#endif // ANJAY_TEST
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_SERVER_STATS_H
+#define ANJAY_SERVER_STATS_H
+
+#include <avsystem/commons/list.h>
+#include <avsystem/commons/time.h>
+
+#include <anjay/stats.h>
+
+#include "utils_core.h"
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+typedef enum {
+    ANJAY_SERVER_STATS_REGISTER,
+    ANJAY_SERVER_STATS_UPDATE,
+    ANJAY_SERVER_STATS_NOTIFY
+} anjay_server_stats_exchange_t;
+
+#ifdef WITH_NET_STATS
+
+typedef struct anjay_server_stats_entry anjay_server_stats_entry_t;
+
+typedef struct {
+    AVS_LIST(anjay_server_stats_entry_t) entries;
+    /**
+     * Server to which the CoAP traffic is currently attributed, or
+     * ANJAY_SSID_ANY if it is not attributed to any server (e.g. downloads).
+     */
+    anjay_ssid_t charged_ssid;
+    /** Values of CoAP context counters when charged_ssid was last set. */
+    uint64_t last_tx_bytes;
+    uint64_t last_rx_bytes;
+    uint64_t last_num_incoming_retransmissions;
+    uint64_t last_num_outgoing_retransmissions;
+} anjay_server_stats_registry_t;
+
+void _anjay_server_stats_init(anjay_t *anjay);
+
+void _anjay_server_stats_cleanup(anjay_t *anjay);
+
+/**
+ * Per-server traffic is derived from the global CoAP context counters, which
+ * is why it needs to be explicitly attributed: all traffic since the previous
+ * call is added to the statistics of the server charged so far, and all
+ * subsequent traffic will be attributed to @p ssid.
+ */
+void _anjay_server_stats_charge_to(anjay_t *anjay, anjay_ssid_t ssid);
+
+/**
+ * @returns SSID of the server currently charged for the CoAP traffic, so that
+ *          it can be restored after sending a message to another one.
+ */
+anjay_ssid_t _anjay_server_stats_charged_ssid(anjay_t *anjay);
+
+void _anjay_server_stats_record_incoming(anjay_t *anjay, anjay_ssid_t ssid);
+
+/**
+ * Records the round-trip time of an exchange with server @p ssid, started at
+ * @p request_time and finished just now.
+ */
+void _anjay_server_stats_record_latency(anjay_t *anjay,
+                                        anjay_ssid_t ssid,
+                                        anjay_server_stats_exchange_t exchange,
+                                        avs_time_monotonic_t request_time);
+
+#else // WITH_NET_STATS
+
+#define _anjay_server_stats_init(...) ((void) 0)
+#define _anjay_server_stats_cleanup(...) ((void) 0)
+#define _anjay_server_stats_charge_to(Anjay, Ssid) ((void) (Ssid))
+#define _anjay_server_stats_charged_ssid(...) ANJAY_SSID_ANY
+#define _anjay_server_stats_record_incoming(...) ((void) 0)
+#define _anjay_server_stats_record_latency(...) ((void) 0)
+
+#endif // WITH_NET_STATS
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_SERVER_STATS_H */
@@ -24,6 +24,7 @@
 
 #include "utils_core.h"
 #include "coap/coap_stream.h"
+#include "coap_exchange.h"
 
 VISIBILITY_PRIVATE_HEADER_BEGIN
 
@@ -69,6 +70,24 @@ typedef struct {
     avs_net_abstract_socket_t *socket;
     avs_net_resolved_endpoint_t preferred_endpoint;
     char last_local_port[ANJAY_MAX_URL_PORT_SIZE];
+    /**
+     * Hostname of the server, if the socket has been connected to an address
+     * resolved by the resolver cache - in that case, the remote hostname of the
+     * socket itself is numeric. Empty string otherwise.
+     */
+    char hostname[ANJAY_MAX_URL_HOSTNAME_SIZE];
+    /**
+     * Address family from the socket configuration, used when resolving
+     * @ref hostname again.
+     */
+    avs_net_af_t address_family;
+    /**
+     * Set if the connection has been suspended by
+     * @ref _anjay_connection_park . The socket is still connected, but it is
+     * treated as offline until the next call to
+     * @ref _anjay_connection_bring_online .
+     */
+    bool parked;
 } anjay_server_connection_private_data_t;
 
 typedef struct {
@@ -93,6 +112,27 @@ typedef struct {
 
     anjay_registration_info_t registration_info;
     anjay_sched_handle_t sched_update_handle;
+
+    /**
+     * Register request sent during server activation, still awaiting the
+     * response; ANJAY_EXCHANGE_ID_INVALID if there is none. The parameters
+     * it was sent with become registration_info.last_update_params once the
+     * registration succeeds.
+     */
+    anjay_exchange_id_t registration_exchange;
+    anjay_update_parameters_t registration_params;
+
+    /**
+     * Update request awaiting the response, and the parameters it was sent
+     * with; analogous to registration_exchange and registration_params.
+     */
+    anjay_exchange_id_t update_exchange;
+    anjay_update_parameters_t update_params;
+    /**
+     * Delay before retrying an Update that failed; doubled after each
+     * consecutive failure, and reset to zero once an Update succeeds.
+     */
+    avs_time_duration_t update_retry_delay;
 } anjay_active_server_info_t;
 
 // inactive servers include administratively disabled ones
@@ -186,11 +226,20 @@ int _anjay_server_setup_registration_connection(
 avs_net_abstract_socket_t *
 _anjay_connection_get_online_socket(anjay_server_connection_t *connection);
 
-int _anjay_connection_bring_online(anjay_server_connection_t *connection,
+int _anjay_connection_bring_online(anjay_t *anjay,
+                                   anjay_server_connection_t *connection,
                                    bool *out_session_resumed);
 
 void _anjay_connection_suspend(anjay_connection_ref_t conn_ref);
 
+/**
+ * Suspends the connection like @ref _anjay_connection_suspend, but without
+ * closing the socket. The local port, remote address and (D)TLS context are
+ * kept, so that @ref _anjay_connection_bring_online does not need to
+ * communicate with the network at all.
+ */
+void _anjay_connection_park(anjay_connection_ref_t conn_ref);
+
 VISIBILITY_PRIVATE_HEADER_END
 
 #endif // ANJAY_SERVERS_H
@@ -66,7 +66,9 @@ initialize_active_server(anjay_t *anjay,
     }
 
     if (server->ssid != ANJAY_SSID_BOOTSTRAP) {
-        if ((result = _anjay_server_register(anjay, server))) {
+        // the response is handled asynchronously, so that activation of other
+        // servers does not need to wait for it
+        if ((result = _anjay_server_register_async(anjay, server))) {
             anjay_log(ERROR, "could not register to server SSID %u",
                       server->ssid);
             return result;
@@ -145,6 +147,58 @@ bool anjay_all_connections_failed(anjay_t *anjay) {
     return true;
 }
 
+/**
+ * Updates the failure counters of @p server and decides whether activation
+ * shall be retried.
+ *
+ * @returns -1 if another activation attempt shall be made, 0 otherwise.
+ */
+static int handle_activation_failure(anjay_t *anjay,
+                                     anjay_inactive_server_info_t *server,
+                                     int socket_error) {
+    const anjay_ssid_t ssid = server->ssid;
+    server->reactivate_failed = true;
+    uint32_t *num_icmp_failures = &server->num_icmp_failures;
+
+    if (socket_error == ECONNREFUSED) {
+        ++*num_icmp_failures;
+    } else if (socket_error == ANJAY_ERR_FORBIDDEN
+                    || socket_error == ETIMEDOUT
+                    || socket_error == EPROTO) {
+        *num_icmp_failures = anjay->max_icmp_failures;
+    }
+
+    if (*num_icmp_failures >= anjay->max_icmp_failures) {
+        if (ssid == ANJAY_SSID_BOOTSTRAP) {
+            anjay_log(DEBUG, "Bootstrap Server could not be reached. "
+                             "Disabling all communication.");
+            // Abort any further bootstrap retries.
+            _anjay_bootstrap_cleanup(anjay);
+        } else {
+            if (_anjay_dm_ssid_exists(anjay, ANJAY_SSID_BOOTSTRAP)) {
+                if (should_retry_bootstrap(anjay)) {
+                    _anjay_bootstrap_account_prepare(anjay);
+                }
+            } else {
+                anjay_log(DEBUG,
+                          "Non-Bootstrap Server %" PRIu16
+                          " could not be reached.",
+                          ssid);
+            }
+        }
+        // Return 0, to kill this job.
+        return 0;
+    }
+    // We had a failure with either a bootstrap or a non-bootstrap server,
+    // retry till it's possible.
+    return -1;
+}
+
+/**
+ * Connects to the server and sends Register without waiting for the response.
+ * Note that connecting (see _anjay_connection_bring_online()) still blocks
+ * for the duration of the (D)TLS handshake.
+ */
 static int activate_server_job(anjay_t *anjay, void *ssid_) {
     anjay_ssid_t ssid = (anjay_ssid_t) (uintptr_t) ssid_;
 
@@ -172,42 +226,8 @@ static int activate_server_job(anjay_t *anjay, void *ssid_) {
         _anjay_servers_add_active(&anjay->servers, new_server);
         return 0;
     } else {
-        (*inactive_server_ptr)->reactivate_failed = true;
-        uint32_t *num_icmp_failures =
-                &(*inactive_server_ptr)->num_icmp_failures;
-
-        if (socket_error == ECONNREFUSED) {
-            ++*num_icmp_failures;
-        } else if (socket_error == ANJAY_ERR_FORBIDDEN
-                        || socket_error == ETIMEDOUT
-                        || socket_error == EPROTO) {
-            *num_icmp_failures = anjay->max_icmp_failures;
-        }
-
-        if (*num_icmp_failures >= anjay->max_icmp_failures) {
-            if (ssid == ANJAY_SSID_BOOTSTRAP) {
-                anjay_log(DEBUG, "Bootstrap Server could not be reached. "
-                                 "Disabling all communication.");
-                // Abort any further bootstrap retries.
-                _anjay_bootstrap_cleanup(anjay);
-            } else {
-                if (_anjay_dm_ssid_exists(anjay, ANJAY_SSID_BOOTSTRAP)) {
-                    if (should_retry_bootstrap(anjay)) {
-                        _anjay_bootstrap_account_prepare(anjay);
-                    }
-                } else {
-                    anjay_log(DEBUG,
-                              "Non-Bootstrap Server %" PRIu16
-                              " could not be reached.",
-                              ssid);
-                }
-            }
-            // Return 0, to kill this job.
-            return 0;
-        }
-        // We had a failure with either a bootstrap or a non-bootstrap server,
-        // retry till it's possible.
-        return -1;
+        return handle_activation_failure(anjay, *inactive_server_ptr,
+                                         socket_error);
     }
 }
 
@@ -310,6 +330,73 @@ deactivate_active_server(anjay_t *anjay,
     return new_server;
 }
 
+typedef struct {
+    anjay_ssid_t ssid;
+    int error;
+} registration_failed_data_t;
+
+static int registration_failed_job(anjay_t *anjay, void *data_) {
+    registration_failed_data_t *data = (registration_failed_data_t *) data_;
+    const anjay_ssid_t ssid = data->ssid;
+    const int error = data->error;
+    free(data);
+
+    AVS_LIST(anjay_active_server_info_t) *active_server_ptr =
+            _anjay_servers_find_active_ptr(&anjay->servers, ssid);
+    if (!active_server_ptr) {
+        anjay_log(TRACE, "not an active server: SSID = %u", ssid);
+        return 0;
+    }
+    // mark that the registration connection is not valid;
+    // prevents superfluous Deregister
+    (*active_server_ptr)->registration_info.conn_type = ANJAY_CONNECTION_UNSET;
+
+    anjay_inactive_server_info_t *server =
+            deactivate_active_server(anjay, &anjay->servers, active_server_ptr,
+                                     ssid, AVS_TIME_DURATION_INVALID);
+    if (!server) {
+        anjay_log(ERROR, "could not deactivate server SSID %u", ssid);
+        return -1;
+    }
+    if (handle_activation_failure(anjay, server, error)) {
+        // retry just like activate_server_job would, had it failed itself
+        const anjay_sched_retryable_backoff_t backoff =
+                ANJAY_SERVER_RETRYABLE_BACKOFF;
+        if (_anjay_sched_retryable(anjay->sched,
+                                   &server->sched_reactivate_handle,
+                                   backoff.delay, backoff, activate_server_job,
+                                   (void *) (uintptr_t) ssid)) {
+            anjay_log(ERROR, "could not schedule reactivate job for server "
+                      "SSID %u", ssid);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int _anjay_server_registration_failed(anjay_t *anjay,
+                                      anjay_ssid_t ssid,
+                                      int error) {
+    registration_failed_data_t *data = (registration_failed_data_t *)
+            malloc(sizeof(*data));
+    if (!data) {
+        anjay_log(ERROR, "out of memory");
+        return -1;
+    }
+
+    data->ssid = ssid;
+    data->error = error;
+
+    // the server cannot be deactivated right away, as its connection may be
+    // currently in use by the caller
+    if (_anjay_sched_now(anjay->sched, NULL, registration_failed_job, data)) {
+        free(data);
+        anjay_log(ERROR, "could not schedule registration_failed_job");
+        return -1;
+    }
+    return 0;
+}
+
 static anjay_inactive_server_info_t *deactivate_inactive_server(
         anjay_t *anjay,
         AVS_LIST(anjay_inactive_server_info_t) inactive_server,
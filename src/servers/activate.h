@@ -71,6 +71,16 @@ _anjay_server_deactivate(anjay_t *anjay,
                          anjay_ssid_t ssid,
                          avs_time_duration_t reactivate_delay);
 
+/**
+ * Schedules deactivation of the server @p ssid after its Register request sent
+ * during activation has failed with @p error. The failure is then handled just
+ * like a failed activation attempt, i.e. another one is scheduled if
+ * appropriate.
+ */
+int _anjay_server_registration_failed(anjay_t *anjay,
+                                      anjay_ssid_t ssid,
+                                      int error);
+
 /**
  * Creates a new detached inactive server entry for given @p ssid .
  *
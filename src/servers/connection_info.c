@@ -18,9 +18,13 @@
 
 #include <inttypes.h>
 
+#include <avsystem/commons/errno.h>
 #include <avsystem/commons/stream/stream_net.h>
 #include <avsystem/commons/utils.h>
 
+#include "../dtls_session.h"
+#include "../coap/coap_stream.h"
+#include "../resolver.h"
 #include "../utils_core.h"
 #include "../dm/query.h"
 
@@ -35,10 +39,12 @@ typedef struct {
     anjay_server_connection_mode_t mode;
     char local_port[ANJAY_MAX_URL_PORT_SIZE];
     anjay_udp_security_mode_t security_mode;
+    uint32_t credentials_digest;
 } udp_connection_info_t;
 
 
 typedef struct {
+    anjay_ssid_t ssid;
     anjay_iid_t security_iid;
     const anjay_url_t *uri;
     udp_connection_info_t udp;
@@ -54,9 +60,16 @@ avs_net_abstract_socket_t *_anjay_connection_internal_get_socket(
     return connection->conn_priv_data_.socket;
 }
 
-void
-_anjay_connection_internal_clean_socket(anjay_server_connection_t *connection) {
+void _anjay_connection_internal_clean_socket(
+        anjay_t *anjay, anjay_server_connection_t *connection) {
+    if (connection->conn_priv_data_.socket && anjay->comm_stream) {
+        // another socket may be allocated at the same address later
+        _anjay_coap_stream_forget_socket(anjay->comm_stream,
+                                         connection->conn_priv_data_.socket);
+    }
     avs_net_socket_cleanup(&connection->conn_priv_data_.socket);
+    // this also clears the parked flag - a socket created in place of the
+    // cleaned up one must not inherit it
     memset(&connection->conn_priv_data_, 0,
            sizeof(connection->conn_priv_data_));
 }
@@ -158,7 +171,8 @@ _anjay_connection_internal_is_online(anjay_server_connection_t *connection) {
         anjay_log(ERROR, "Could not get socket state");
         return false;
     }
-    return opt.state == AVS_NET_SOCKET_STATE_CONNECTED;
+    return opt.state == AVS_NET_SOCKET_STATE_CONNECTED
+            && !connection->conn_priv_data_.parked;
 }
 
 bool _anjay_connection_is_online(anjay_connection_ref_t ref) {
@@ -223,6 +237,25 @@ typedef struct {
     create_connected_socket_t *create_connected_socket;
 } connection_type_definition_t;
 
+static void update_handshake_stats(anjay_t *anjay,
+                                   avs_net_abstract_socket_t *socket) {
+#ifdef WITH_NET_STATS
+    avs_net_socket_opt_value_t session_resumed;
+    // fails for non-DTLS sockets, which are not accounted for
+    if (!avs_net_socket_get_opt(socket, AVS_NET_SOCKET_OPT_SESSION_RESUMED,
+                                &session_resumed)) {
+        if (session_resumed.flag) {
+            ++anjay->num_dtls_resumed_handshakes;
+        } else {
+            ++anjay->num_dtls_full_handshakes;
+        }
+    }
+#else
+    (void) anjay;
+    (void) socket;
+#endif // WITH_NET_STATS
+}
+
 static int recreate_socket(anjay_t *anjay,
                            const connection_type_definition_t *def,
                            anjay_server_connection_t *connection,
@@ -239,7 +272,7 @@ static int recreate_socket(anjay_t *anjay,
                   def->name, ANJAY_DM_OID_SECURITY, inout_info->security_iid);
         return -1;
     }
-    _anjay_connection_internal_clean_socket(connection);
+    _anjay_connection_internal_clean_socket(anjay, connection);
 
     // Socket configuration is slightly different between UDP and SMS
     // connections. That's why we do the common configuration here...
@@ -266,6 +299,8 @@ static int recreate_socket(anjay_t *anjay,
         if (sock) {
             avs_net_socket_close(sock);
         }
+    } else {
+        update_handshake_stats(anjay, connection->conn_priv_data_.socket);
     }
     return result;
 }
@@ -303,7 +338,7 @@ ensure_socket_connected(anjay_t *anjay,
         if (_anjay_connection_internal_is_online(connection)) {
             session_resume = true;
         } else {
-            int result = _anjay_connection_bring_online(connection,
+            int result = _anjay_connection_bring_online(anjay, connection,
                                                         &session_resume);
             if (result) {
                 *out_socket_errno = -result;
@@ -332,7 +367,7 @@ refresh_connection(anjay_t *anjay,
     *out_socket_errno = 0;
 
     if (def->get_connection_mode(inout_info) == ANJAY_CONNECTION_DISABLED) {
-        _anjay_connection_internal_clean_socket(out_connection);
+        _anjay_connection_internal_clean_socket(anjay, out_connection);
     } else {
         result = ensure_socket_connected(
                 anjay, def, out_connection, inout_info,
@@ -537,6 +572,8 @@ static int get_udp_connection_info(anjay_t *anjay,
                                  inout_info->udp.security_mode, dtls_keys)) {
         return -1;
     }
+    inout_info->udp.credentials_digest = _anjay_dtls_credentials_digest(
+            inout_info->udp.security_mode, dtls_keys);
 
     get_requested_local_port(inout_info->udp.local_port, anjay, old_socket);
 
@@ -560,6 +597,21 @@ create_connected_udp_socket(anjay_t *anjay,
     inout_socket_config->backend_configuration.preferred_endpoint =
             &out_conn->conn_priv_data_.preferred_endpoint;
 
+#ifdef HAVE_AVS_NET_SESSION_RESUMPTION_BUFFER
+    if (type == AVS_NET_DTLS_SOCKET) {
+        // session state is kept outside the socket, so that it survives
+        // recreating the socket and may be persisted across restarts
+        if (!(inout_socket_config->session_resumption_buffer =
+                      _anjay_dtls_session_buffer(
+                              anjay, info->ssid,
+                              info->udp.credentials_digest))) {
+            return -ENOMEM;
+        }
+        inout_socket_config->session_resumption_buffer_size =
+                ANJAY_DTLS_SESSION_BUFFER_SIZE;
+    }
+#endif // HAVE_AVS_NET_SESSION_RESUMPTION_BUFFER
+
     const void *config_ptr = (type == AVS_NET_DTLS_SOCKET)
             ? (const void *) inout_socket_config
             : (const void *) &inout_socket_config->backend_configuration;
@@ -575,6 +627,14 @@ create_connected_udp_socket(anjay_t *anjay,
 
     anjay_log(INFO, "connected to %s:%s", info->uri->host, info->uri->port);
     out_conn->conn_priv_data_.socket = socket;
+    out_conn->conn_priv_data_.parked = false;
+    if (_anjay_resolver_applicable(type, config_ptr)) {
+        strcpy(out_conn->conn_priv_data_.hostname, info->uri->host);
+        out_conn->conn_priv_data_.address_family =
+                _anjay_resolver_address_family(type, config_ptr);
+    } else {
+        out_conn->conn_priv_data_.hostname[0] = '\0';
+    }
     return 0;
 }
 
@@ -597,6 +657,7 @@ static int get_common_connection_info(anjay_t *anjay,
         return -1;
     }
 
+    out_info->ssid = server->ssid;
     out_info->uri = &server->uri;
 
     if (read_connection_modes(anjay, server, &out_info->udp.mode,
@@ -671,7 +732,7 @@ int _anjay_server_setup_registration_connection(
 }
 
 static void connection_suspend(anjay_connection_ref_t conn_ref) {
-    const anjay_server_connection_t *connection =
+    anjay_server_connection_t *connection =
             _anjay_get_server_connection(conn_ref);
     if (connection) {
         avs_net_abstract_socket_t *socket =
@@ -679,6 +740,16 @@ static void connection_suspend(anjay_connection_ref_t conn_ref) {
         if (socket) {
             avs_net_socket_close(socket);
         }
+        // the socket is closed now, there is nothing to resume
+        connection->conn_priv_data_.parked = false;
+    }
+}
+
+void _anjay_connection_park(anjay_connection_ref_t conn_ref) {
+    anjay_server_connection_t *connection =
+            _anjay_get_server_connection(conn_ref);
+    if (connection && _anjay_connection_internal_is_online(connection)) {
+        connection->conn_priv_data_.parked = true;
     }
 }
 
@@ -695,12 +766,23 @@ void _anjay_connection_suspend(anjay_connection_ref_t conn_ref) {
     }
 }
 
-int _anjay_connection_bring_online(anjay_server_connection_t *connection,
+int _anjay_connection_bring_online(anjay_t *anjay,
+                                   anjay_server_connection_t *connection,
                                    bool *out_session_resumed) {
     assert(connection);
     assert(connection->conn_priv_data_.socket);
     assert(!_anjay_connection_internal_is_online(connection));
 
+    if (connection->conn_priv_data_.parked) {
+        connection->conn_priv_data_.parked = false;
+        if (_anjay_connection_internal_is_online(connection)) {
+            // the socket is still connected, so is the (D)TLS session
+            *out_session_resumed = true;
+            anjay_log(DEBUG, "resumed parked connection");
+            return 0;
+        }
+    }
+
     char remote_host[ANJAY_MAX_URL_HOSTNAME_SIZE];
     char remote_port[ANJAY_MAX_URL_PORT_SIZE];
     if (avs_net_socket_get_remote_hostname(connection->conn_priv_data_.socket,
@@ -712,6 +794,17 @@ int _anjay_connection_bring_online(anjay_server_connection_t *connection,
                          "of a suspended connection");
         return -1;
     }
+    // the socket has been connected to a numeric address; the hostname might
+    // resolve to a different one by now
+    const char *hostname = connection->conn_priv_data_.hostname;
+    if (*hostname
+            && _anjay_resolver_resolve(
+                    anjay, hostname, remote_port,
+                    connection->conn_priv_data_.address_family, remote_host,
+                    sizeof(remote_host))) {
+        anjay_log(WARNING, "could not resolve %s, reconnecting to %s",
+                  hostname, remote_host);
+    }
 
     /*
      * avs_net_socket_bind() is usually called, EXCEPT when:
@@ -757,6 +850,10 @@ int _anjay_connection_bring_online(anjay_server_connection_t *connection,
         }
     }
 
+    // TODO: this performs DNS resolution, connect() and the whole (D)TLS
+    // handshake synchronously, from within the scheduler job, so servers
+    // are still connected one after another. Making it a non-blocking state
+    // machine requires an asynchronous connect/handshake API in avs_net.
     if (avs_net_socket_connect(connection->conn_priv_data_.socket,
                                remote_host, remote_port)) {
         anjay_log(ERROR, "could not connect to %s:%s",
@@ -775,6 +872,7 @@ int _anjay_connection_bring_online(anjay_server_connection_t *connection,
         *out_session_resumed = !*remote_port;
     } else {
         *out_session_resumed = session_resumed.flag;
+        update_handshake_stats(anjay, connection->conn_priv_data_.socket);
     }
     anjay_log(INFO, "%s to %s:%s",
               *out_session_resumed ? "resumed connection" : "reconnected",
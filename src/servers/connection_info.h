@@ -29,8 +29,8 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
 avs_net_abstract_socket_t *_anjay_connection_internal_get_socket(
         const anjay_server_connection_t *connection);
 
-void
-_anjay_connection_internal_clean_socket(anjay_server_connection_t *connection);
+void _anjay_connection_internal_clean_socket(
+        anjay_t *anjay, anjay_server_connection_t *connection);
 
 bool
 _anjay_connection_internal_is_online(anjay_server_connection_t *connection);
@@ -73,6 +73,131 @@ static void send_update_args_decode(anjay_ssid_t *out_ssid,
     assert(*out_socket_needs >= 0 && *out_socket_needs < _SOCKET_NEEDS_LIMIT);
 }
 
+static int schedule_update(anjay_t *anjay,
+                           anjay_sched_handle_t *out_handle,
+                           const anjay_active_server_info_t *server,
+                           avs_time_duration_t delay,
+                           anjay_socket_needs_t socket_needs);
+
+static void reregister_or_deactivate(anjay_t *anjay,
+                                     anjay_active_server_info_t *server) {
+    if (_anjay_server_register(anjay, server)) {
+        anjay_log(DEBUG, "re-registration failed");
+        // mark that the registration connection is no longer valid;
+        // prevents superfluous Deregister
+        server->registration_info.conn_type = ANJAY_CONNECTION_UNSET;
+        _anjay_server_deactivate(anjay, &anjay->servers, server->ssid,
+                                 AVS_TIME_DURATION_ZERO);
+    }
+}
+
+static int reregister_sched_job(anjay_t *anjay, void *ssid_) {
+    anjay_ssid_t ssid = (anjay_ssid_t) (uintptr_t) ssid_;
+    anjay_active_server_info_t *server =
+            _anjay_servers_find_active(&anjay->servers, ssid);
+    if (server) {
+        reregister_or_deactivate(anjay, server);
+    }
+    return 0;
+}
+
+static void on_updated(anjay_t *anjay, anjay_active_server_info_t *server) {
+    server->update_retry_delay = AVS_TIME_DURATION_ZERO;
+
+    // Ignore errors, failure to flush notifications is not fatal.
+    _anjay_observe_sched_flush(anjay, (anjay_connection_key_t) {
+                                          .ssid = server->ssid,
+                                          .type = server->registration_info
+                                                          .conn_type
+                                      });
+    _anjay_server_reschedule_update_job(anjay, server);
+}
+
+/**
+ * Retries a failed Update with an exponential backoff, just like the
+ * scheduler would do for send_update_sched_job had it failed itself.
+ */
+static void schedule_update_retry(anjay_t *anjay,
+                                  anjay_active_server_info_t *server) {
+    const anjay_sched_retryable_backoff_t backoff =
+            ANJAY_SERVER_RETRYABLE_BACKOFF;
+    if (avs_time_duration_equal(server->update_retry_delay,
+                                AVS_TIME_DURATION_ZERO)) {
+        server->update_retry_delay = backoff.delay;
+    } else {
+        server->update_retry_delay =
+                avs_time_duration_mul(server->update_retry_delay, 2);
+        if (avs_time_duration_less(backoff.max_delay,
+                                   server->update_retry_delay)) {
+            server->update_retry_delay = backoff.max_delay;
+        }
+    }
+
+    _anjay_sched_del(anjay->sched, &server->sched_update_handle);
+    if (schedule_update(anjay, &server->sched_update_handle, server,
+                        server->update_retry_delay, SOCKET_NEEDS_NOTHING)) {
+        anjay_log(ERROR, "could not schedule Update retry for server %u",
+                  server->ssid);
+    }
+}
+
+static void update_finished(anjay_t *anjay,
+                            anjay_exchange_id_t id,
+                            anjay_exchange_result_t result,
+                            const avs_coap_msg_t *response,
+                            void *ssid_) {
+    (void) id;
+    anjay_ssid_t ssid = (anjay_ssid_t) (uintptr_t) ssid_;
+    anjay_active_server_info_t *server =
+            _anjay_servers_find_active(&anjay->servers, ssid);
+    assert(server);
+    assert(server->update_exchange == id);
+    server->update_exchange = ANJAY_EXCHANGE_ID_INVALID;
+
+    int error;
+    switch (result) {
+    case ANJAY_EXCHANGE_RESPONSE:
+        error = _anjay_update_registration_finish(anjay, server, response);
+        break;
+    case ANJAY_EXCHANGE_RESET:
+        anjay_log(ERROR, "Update to server %u rejected with Reset", ssid);
+        error = -1;
+        break;
+    default:
+        anjay_log(ERROR, "Update to server %u timed out", ssid);
+        error = AVS_COAP_CTX_ERR_TIMEOUT;
+        break;
+    }
+    _anjay_update_registration_abort(anjay, server);
+
+    if (!error) {
+        on_updated(anjay, server);
+    } else if (error == ANJAY_REGISTRATION_UPDATE_REJECTED) {
+        anjay_log(DEBUG, "update rejected for SSID = %u; needs re-registering",
+                  ssid);
+        // the connection may be currently in use by the caller, so Register
+        // cannot be performed right away
+        _anjay_sched_del(anjay->sched, &server->sched_update_handle);
+        if (_anjay_sched_now(anjay->sched, &server->sched_update_handle,
+                             reregister_sched_job, ssid_)) {
+            anjay_log(ERROR, "could not schedule re-registration");
+        }
+    } else {
+        if (error == AVS_COAP_CTX_ERR_TIMEOUT) {
+            // We cannot use _anjay_schedule_server_reconnect(), because it
+            // would mean an endless loop without backoff if the server is
+            // down. Instead, we disconnect the socket and retry with backoff.
+            // The retried job will reconnect the socket during
+            // _anjay_server_refresh().
+            _anjay_connection_suspend((anjay_connection_ref_t) {
+                .server = server,
+                .conn_type = server->registration_info.conn_type
+            });
+        }
+        schedule_update_retry(anjay, server);
+    }
+}
+
 static int send_update(anjay_t *anjay, anjay_active_server_info_t *server) {
     anjay_connection_ref_t connection = {
         .server = server,
@@ -83,7 +208,8 @@ static int send_update(anjay_t *anjay, anjay_active_server_info_t *server) {
         return -1;
     }
 
-    int result = _anjay_update_registration(anjay);
+    int result = _anjay_update_registration_async(
+            anjay, update_finished, (void *) (uintptr_t) server->ssid);
     _anjay_release_server_stream(anjay);
 
     if (result == ANJAY_REGISTRATION_UPDATE_REJECTED) {
@@ -110,7 +236,7 @@ static int send_update_sched_job(anjay_t *anjay, void *args) {
     }
 
     if (_anjay_server_refresh(anjay, server, socket_needs)) {
-        if (_anjay_server_registration_expired(server)) {
+        if (_anjay_server_registration_expired(anjay, server)) {
             // note that this invariably causes re-Register,
             // so we cannot do it if we want to retry Update
             goto connection_failure;
@@ -125,12 +251,16 @@ static int send_update_sched_job(anjay_t *anjay, void *args) {
         return _anjay_bootstrap_update_reconnected(anjay);
     }
 
-    bool needs_reregister = true;
     if (_anjay_server_registration_connection_valid(server)) {
-        if (!_anjay_server_registration_expired(server)) {
+        if (!_anjay_server_registration_expired(anjay, server)) {
             int result = send_update(anjay, server);
             if (!result) {
-                needs_reregister = false;
+                if (!server->update_exchange) {
+                    // block-wise Update has been performed synchronously
+                    on_updated(anjay, server);
+                }
+                // otherwise, update_finished() takes it from here
+                return 0;
             } else if (result != ANJAY_REGISTRATION_UPDATE_REJECTED) {
                 if (result == AVS_COAP_CTX_ERR_NETWORK) {
                     anjay_log(ERROR, "network communication error while "
@@ -156,16 +286,9 @@ static int send_update_sched_job(anjay_t *anjay, void *args) {
             goto connection_failure;
         }
     }
-    if (needs_reregister && _anjay_server_register(anjay, server)) {
-        anjay_log(DEBUG, "re-registration failed");
-        goto connection_failure;
-    }
-
-    // Ignore errors, failure to flush notifications is not fatal.
-    _anjay_observe_sched_flush_current_connection(anjay);
-
-    // Updates are retryable, we only need to reschedule after success
-    return _anjay_server_reschedule_update_job(anjay, server);
+    // _anjay_server_register() reschedules the Update job on success
+    reregister_or_deactivate(anjay, server);
+    return 0;
 connection_failure:
     // mark that the registration connection is no longer valid;
     // prevents superfluous Deregister
@@ -197,12 +320,11 @@ get_server_update_interval_margin(anjay_t *anjay,
     }
 }
 
-static int
-schedule_update(anjay_t *anjay,
-                anjay_sched_handle_t *out_handle,
-                const anjay_active_server_info_t *server,
-                avs_time_duration_t delay,
-                anjay_socket_needs_t socket_needs) {
+static int schedule_update(anjay_t *anjay,
+                           anjay_sched_handle_t *out_handle,
+                           const anjay_active_server_info_t *server,
+                           avs_time_duration_t delay,
+                           anjay_socket_needs_t socket_needs) {
     anjay_log(DEBUG, "scheduling update for SSID %u after "
                      "%" PRId64 ".%09" PRId32,
               server->ssid, delay.seconds, delay.nanoseconds);
@@ -219,7 +341,7 @@ schedule_next_update(anjay_t *anjay,
                      anjay_sched_handle_t *out_handle,
                      const anjay_active_server_info_t *server) {
     avs_time_duration_t remaining =
-            _anjay_register_time_remaining(&server->registration_info);
+            _anjay_register_time_remaining(anjay, &server->registration_info);
     avs_time_duration_t interval_margin = get_server_update_interval_margin(
             anjay, &server->registration_info);
     remaining = avs_time_duration_diff(remaining, interval_margin);
@@ -243,9 +365,10 @@ bool _anjay_server_registration_connection_valid(
                        });
 }
 
-bool _anjay_server_registration_expired(anjay_active_server_info_t *server) {
+bool _anjay_server_registration_expired(anjay_t *anjay,
+                                        anjay_active_server_info_t *server) {
     avs_time_duration_t remaining =
-            _anjay_register_time_remaining(&server->registration_info);
+            _anjay_register_time_remaining(anjay, &server->registration_info);
     if (avs_time_duration_less(remaining, AVS_TIME_DURATION_ZERO)) {
         anjay_log(DEBUG, "Registration Lifetime expired for SSID = %u, "
                   "forcing re-register", server->ssid);
@@ -337,8 +460,31 @@ int _anjay_schedule_server_reconnect(anjay_t *anjay,
     return reschedule_update_for_server(anjay, server, SOCKET_NEEDS_RECONNECT);
 }
 
+static void on_registered(anjay_t *anjay,
+                          anjay_active_server_info_t *server) {
+    server->update_retry_delay = AVS_TIME_DURATION_ZERO;
+    _anjay_sched_del(anjay->sched, &server->sched_update_handle);
+    if (schedule_next_update(anjay, &server->sched_update_handle, server)) {
+        anjay_log(WARNING, "could not schedule Update for server %u",
+                  server->ssid);
+    }
+
+    // Ignore errors, failure to flush notifications is not fatal.
+    _anjay_observe_sched_flush(anjay, (anjay_connection_key_t) {
+                                          .ssid = server->ssid,
+                                          .type = server->registration_info
+                                                          .conn_type
+                                      });
+    _anjay_bootstrap_notify_regular_connection_available(anjay);
+}
+
 int _anjay_server_register(anjay_t *anjay,
                            anjay_active_server_info_t *server) {
+    // a synchronous Register supersedes any one still in progress, as well
+    // as any Update sent within the previous registration
+    _anjay_register_abort(anjay, server);
+    _anjay_update_registration_abort(anjay, server);
+
     if (_anjay_server_setup_registration_connection(server)) {
         return -1;
     }
@@ -352,14 +498,69 @@ int _anjay_server_register(anjay_t *anjay,
 
     int result = _anjay_register(anjay);
     if (!result) {
-        _anjay_sched_del(anjay->sched, &server->sched_update_handle);
-        if (schedule_next_update(anjay, &server->sched_update_handle, server)) {
-            anjay_log(WARNING, "could not schedule Update for server %u",
-                      server->ssid);
-        }
+        on_registered(anjay, server);
+    }
+    _anjay_release_server_stream(anjay);
+    return result;
+}
+
+static void registration_finished(anjay_t *anjay,
+                                  anjay_exchange_id_t id,
+                                  anjay_exchange_result_t result,
+                                  const avs_coap_msg_t *response,
+                                  void *ssid_) {
+    (void) id;
+    anjay_ssid_t ssid = (anjay_ssid_t) (uintptr_t) ssid_;
+    anjay_active_server_info_t *server =
+            _anjay_servers_find_active(&anjay->servers, ssid);
+    assert(server);
+    assert(server->registration_exchange == id);
+    server->registration_exchange = ANJAY_EXCHANGE_ID_INVALID;
+
+    int error;
+    switch (result) {
+    case ANJAY_EXCHANGE_RESPONSE:
+        error = _anjay_register_finish(anjay, server, response);
+        break;
+    case ANJAY_EXCHANGE_RESET:
+        anjay_log(ERROR, "Register to server %u rejected with Reset", ssid);
+        error = -1;
+        break;
+    default:
+        anjay_log(ERROR, "Register to server %u timed out", ssid);
+        error = AVS_COAP_CTX_ERR_TIMEOUT;
+        break;
+    }
 
-        _anjay_observe_sched_flush_current_connection(anjay);
-        _anjay_bootstrap_notify_regular_connection_available(anjay);
+    if (!error) {
+        on_registered(anjay, server);
+    } else {
+        _anjay_register_abort(anjay, server);
+        _anjay_server_registration_failed(anjay, ssid, error);
+    }
+}
+
+int _anjay_server_register_async(anjay_t *anjay,
+                                 anjay_active_server_info_t *server) {
+    _anjay_register_abort(anjay, server);
+    _anjay_update_registration_abort(anjay, server);
+
+    if (_anjay_server_setup_registration_connection(server)) {
+        return -1;
+    }
+    anjay_connection_ref_t connection = {
+        .server = server,
+        .conn_type = server->registration_info.conn_type
+    };
+    if (_anjay_bind_server_stream(anjay, connection)) {
+        return -1;
+    }
+
+    int result = _anjay_register_async(anjay, registration_finished,
+                                       (void *) (uintptr_t) server->ssid);
+    if (!result && !server->registration_exchange) {
+        // block-wise Register has been performed synchronously
+        on_registered(anjay, server);
     }
     _anjay_release_server_stream(anjay);
     return result;
@@ -367,6 +568,15 @@ int _anjay_server_register(anjay_t *anjay,
 
 int _anjay_server_deregister(anjay_t *anjay,
                              anjay_active_server_info_t *server) {
+    if (server->registration_exchange) {
+        anjay_log(DEBUG, "Register to server %u still in progress, skipping "
+                  "De-Register", server->ssid);
+        _anjay_register_abort(anjay, server);
+        return 0;
+    }
+    // De-Register obsoletes any response to the Update, if one is pending
+    _anjay_update_registration_abort(anjay, server);
+
     anjay_connection_ref_t connection = {
         .server = server,
         .conn_type = server->registration_info.conn_type
@@ -28,11 +28,20 @@ VISIBILITY_PRIVATE_HEADER_BEGIN
 bool
 _anjay_server_registration_connection_valid(anjay_active_server_info_t *server);
 
-bool _anjay_server_registration_expired(anjay_active_server_info_t *server);
+bool _anjay_server_registration_expired(anjay_t *anjay,
+                                        anjay_active_server_info_t *server);
 
 int _anjay_server_register(anjay_t *anjay,
                            anjay_active_server_info_t *server);
 
+/**
+ * Like @ref _anjay_server_register, but does not wait for the response. The
+ * outcome is handled when the exchange finishes: on failure, the server is
+ * deactivated and reactivation is scheduled as after a failed activation.
+ */
+int _anjay_server_register_async(anjay_t *anjay,
+                                 anjay_active_server_info_t *server);
+
 int _anjay_server_reschedule_update_job(anjay_t *anjay,
                                         anjay_active_server_info_t *server);
 
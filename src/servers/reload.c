@@ -64,7 +64,7 @@ static int reload_active_server(anjay_t *anjay,
                     || _anjay_server_register(anjay, server)) {
                 goto connection_failure;
             }
-        } else if (_anjay_server_registration_expired(server)
+        } else if (_anjay_server_registration_expired(anjay, server)
                 && _anjay_server_register(anjay, server)) {
             goto connection_failure;
         }
@@ -37,7 +37,7 @@ VISIBILITY_SOURCE_BEGIN
 
 static void connection_cleanup(anjay_t *anjay,
                                anjay_server_connection_t *connection) {
-    _anjay_connection_internal_clean_socket(connection);
+    _anjay_connection_internal_clean_socket(anjay, connection);
     _anjay_sched_del(anjay->sched,
                      &connection->queue_mode_close_socket_clb_handle);
 }
@@ -46,6 +46,8 @@ void _anjay_server_cleanup(anjay_t *anjay, anjay_active_server_info_t *server) {
     anjay_log(TRACE, "clear_server SSID %u", server->ssid);
 
     _anjay_sched_del(anjay->sched, &server->sched_update_handle);
+    _anjay_register_abort(anjay, server);
+    _anjay_update_registration_abort(anjay, server);
     _anjay_registration_info_cleanup(&server->registration_info);
     connection_cleanup(anjay, &server->udp_connection);
     _anjay_url_cleanup(&server->uri);
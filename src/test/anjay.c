@@ -21,10 +21,12 @@
 #include <errno.h>
 #include <stdio.h>
 
+#include <anjay_test/coap/socket.h>
 #include <anjay_test/dm.h>
 #include <anjay_test/utils.h>
 
 #include "../coap/test/utils.h"
+#include "../servers/connection_info.h"
 
 AVS_UNIT_GLOBAL_INIT(verbose) {
 #ifdef WITH_AVS_LOG
@@ -704,10 +706,17 @@ AVS_UNIT_TEST(queue_mode, change) {
             "\x04" "b=UQ"
             "\xFF" "</1>,</42>";
     avs_unit_mocksock_expect_output(mocksocks[0], UPDATE, sizeof(UPDATE) - 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    AVS_UNIT_ASSERT_TRUE(anjay->servers.active->update_exchange);
+
+    // the response is handled asynchronously
     static const char UPDATE_RESPONSE[] = "\x60\x44\x69\xED";
     avs_unit_mocksock_input(mocksocks[0],
                             UPDATE_RESPONSE, sizeof(UPDATE_RESPONSE) - 1);
-    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    AVS_UNIT_ASSERT_FALSE(anjay->servers.active->update_exchange);
+    AVS_UNIT_ASSERT_EQUAL(anjay->servers.active->registration_info
+                                  .last_update_params.lifetime_s, 9001);
 
     AVS_UNIT_ASSERT_NOT_NULL(
             anjay->servers.active->udp_connection.queue_mode_close_socket_clb_handle);
@@ -722,6 +731,92 @@ AVS_UNIT_TEST(queue_mode, change) {
     DM_TEST_FINISH;
 }
 
+static void park_after_request(anjay_t *anjay,
+                               avs_net_abstract_socket_t *mocksock) {
+    static const char REQUEST[] =
+            "\x40\x01\xFA\x3E" // CoAP header
+            "\xB2" "42" // OID
+            "\x01" "3" // IID
+            "\x01" "1"; // RID
+    avs_unit_mocksock_input(mocksock, REQUEST, sizeof(REQUEST) - 1);
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ, 3, 1);
+    _anjay_mock_dm_expect_resource_present(anjay, &OBJ, 3, 1, 1);
+    _anjay_mock_dm_expect_resource_read(anjay, &OBJ, 3, 1, 0,
+                                        ANJAY_MOCK_DM_STRING(0, "Hi!"));
+    static const char RESPONSE[] =
+            "\x60\x45\xFA\x3E" // CoAP header
+            "\xC0" // Content-Format
+            "\xFF" "Hi!";
+    DM_TEST_EXPECT_RESPONSE(mocksock, RESPONSE);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksock));
+    avs_unit_mocksock_assert_expects_met(mocksock);
+
+    AVS_UNIT_ASSERT_NOT_NULL(
+            anjay->servers.active->udp_connection.queue_mode_close_socket_clb_handle);
+    AVS_UNIT_ASSERT_EQUAL(sched_time_to_next_s(anjay->sched), 93);
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(93, AVS_TIME_S));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    // the socket is still connected, but not reported as online
+    AVS_UNIT_ASSERT_TRUE(
+            anjay->servers.active->udp_connection.conn_priv_data_.parked);
+    avs_net_socket_opt_value_t state;
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_get_opt(
+            mocksock, AVS_NET_SOCKET_OPT_STATE, &state));
+    AVS_UNIT_ASSERT_EQUAL(state.state, AVS_NET_SOCKET_STATE_CONNECTED);
+    AVS_UNIT_ASSERT_NULL(anjay_get_sockets(anjay));
+}
+
+AVS_UNIT_TEST(queue_mode, park_and_resume) {
+    DM_TEST_INIT_WITH_SSIDS(42);
+    anjay->queue_mode_park_sockets = true;
+    anjay->servers.active->udp_connection.queue_mode = true;
+    park_after_request(anjay, mocksocks[0]);
+
+    // no connect(), handshake or Register is expected on the mocksock
+    bool session_resumed = false;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_connection_bring_online(
+            anjay, &anjay->servers.active->udp_connection, &session_resumed));
+    AVS_UNIT_ASSERT_TRUE(session_resumed);
+    AVS_UNIT_ASSERT_FALSE(
+            anjay->servers.active->udp_connection.conn_priv_data_.parked);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(anjay_get_sockets(anjay)), 1);
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(queue_mode, park_disable_enable) {
+    DM_TEST_INIT_WITH_SSIDS(42);
+    anjay->queue_mode_park_sockets = true;
+    anjay->servers.active->udp_connection.queue_mode = true;
+    park_after_request(anjay, mocksocks[0]);
+
+    // disabling the server closes the parked connection...
+    anjay_connection_ref_t ref = {
+        .server = anjay->servers.active,
+        .conn_type = ANJAY_CONNECTION_UDP
+    };
+    _anjay_connection_suspend(ref);
+    AVS_UNIT_ASSERT_FALSE(
+            anjay->servers.active->udp_connection.conn_priv_data_.parked);
+    _anjay_connection_internal_clean_socket(
+            anjay, &anjay->servers.active->udp_connection);
+
+    // ...and re-enabling it connects a fresh socket, which must be treated
+    // as online right away
+    avs_net_abstract_socket_t *socket = NULL;
+    _anjay_mocksock_create(&socket, 1252, 1252);
+    avs_unit_mocksock_enable_state_getopt(socket);
+    avs_unit_mocksock_expect_connect(socket, "", "");
+    AVS_UNIT_ASSERT_SUCCESS(avs_net_socket_connect(socket, "", ""));
+    anjay->servers.active->udp_connection.conn_priv_data_.socket = socket;
+    AVS_UNIT_ASSERT_TRUE(_anjay_connection_is_online(ref));
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(anjay_get_sockets(anjay)), 1);
+
+    DM_TEST_FINISH;
+}
+
 AVS_UNIT_TEST(anjay_new, no_endpoint_name) {
     const anjay_configuration_t configuration = {
         .endpoint_name = NULL,
@@ -730,3 +825,99 @@ AVS_UNIT_TEST(anjay_new, no_endpoint_name) {
     };
     AVS_UNIT_ASSERT_NULL(anjay_new(&configuration));
 }
+
+typedef struct {
+    avs_time_monotonic_t monotonic;
+    avs_time_real_t real;
+} virtual_clock_t;
+
+static avs_time_monotonic_t virtual_monotonic_clock(void *clock) {
+    return ((virtual_clock_t *) clock)->monotonic;
+}
+
+static avs_time_real_t virtual_real_clock(void *clock) {
+    return ((virtual_clock_t *) clock)->real;
+}
+
+static int count_calls(anjay_t *anjay, void *counter) {
+    (void) anjay;
+    ++*(int *) counter;
+    return 0;
+}
+
+AVS_UNIT_TEST(anjay_new, virtual_clock) {
+    virtual_clock_t clock = {
+        .monotonic = avs_time_monotonic_from_scalar(1000, AVS_TIME_S),
+        .real = avs_time_real_from_scalar(1000, AVS_TIME_S)
+    };
+    anjay_t *anjay = anjay_new(&(const anjay_configuration_t) {
+        .endpoint_name = "urn:dev:os:anjay-test",
+        .in_buffer_size = 4096,
+        .out_buffer_size = 4096,
+        .monotonic_clock = virtual_monotonic_clock,
+        .real_clock = virtual_real_clock,
+        .clock_arg = &clock
+    });
+    AVS_UNIT_ASSERT_NOT_NULL(anjay);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    AVS_UNIT_ASSERT_TRUE(avs_time_monotonic_equal(
+            _anjay_time_monotonic_now(anjay), clock.monotonic));
+    AVS_UNIT_ASSERT_TRUE(avs_time_real_equal(_anjay_time_real_now(anjay),
+                                             clock.real));
+
+    int calls = 0;
+    anjay_sched_handle_t handle = NULL;
+    const avs_time_duration_t day =
+            avs_time_duration_from_scalar(1, AVS_TIME_DAY);
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_sched(anjay->sched, &handle, day, count_calls, &calls));
+
+    // no time passes unless the virtual clock is advanced
+    avs_time_duration_t delay;
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_time_to_next(anjay, &delay));
+    AVS_UNIT_ASSERT_TRUE(avs_time_duration_equal(delay, day));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    AVS_UNIT_ASSERT_EQUAL(calls, 0);
+
+    clock.monotonic = avs_time_monotonic_add(clock.monotonic, day);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    AVS_UNIT_ASSERT_EQUAL(calls, 1);
+    AVS_UNIT_ASSERT_NULL(handle);
+
+    anjay_delete(anjay);
+}
+
+static void count_exchange_results(anjay_t *anjay,
+                                   anjay_exchange_id_t id,
+                                   anjay_exchange_result_t result,
+                                   const avs_coap_msg_t *response,
+                                   void *counter) {
+    (void) anjay;
+    (void) id;
+    (void) result;
+    (void) response;
+    ++*(int *) counter;
+}
+
+AVS_UNIT_TEST(anjay_delete, pending_exchange_cancelled) {
+    DM_TEST_INIT_WITH_SSIDS(1);
+
+    static const char CON_REQUEST[] = "\x40\x02\x12\x34";
+    avs_coap_msg_t *msg = (avs_coap_msg_t *) malloc(
+            offsetof(avs_coap_msg_t, content) + sizeof(CON_REQUEST) - 1);
+    AVS_UNIT_ASSERT_NOT_NULL(msg);
+    msg->length = (uint32_t) (sizeof(CON_REQUEST) - 1);
+    memcpy(&msg->content, CON_REQUEST, sizeof(CON_REQUEST) - 1);
+    int calls = 0;
+    anjay_exchange_id_t exchange_id;
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], CON_REQUEST);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_exchange_send_confirmable(
+            anjay, 1, ANJAY_CONNECTION_UDP, msg, ANJAY_SERVER_STATS_UPDATE,
+            count_exchange_results, &calls, &exchange_id));
+
+    // the retransmission is due, but shall not be attempted while deleting
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(3, AVS_TIME_S));
+    DM_TEST_FINISH;
+    AVS_UNIT_ASSERT_EQUAL(calls, 0);
+}
@@ -221,6 +221,103 @@ AVS_UNIT_TEST(dm_read, instance_resource_doesnt_support_read) {
     DM_TEST_FINISH;
 }
 
+static int fake_instance_resources(anjay_t *anjay,
+                                   const anjay_dm_object_def_t *const *obj_ptr,
+                                   anjay_iid_t iid,
+                                   anjay_dm_resource_op_mask_t *out) {
+    (void) anjay;
+    (void) iid;
+    AVS_UNIT_ASSERT_EQUAL((*obj_ptr)->supported_rids.count, 7);
+    out[0] = ANJAY_DM_RESOURCE_PRESENT | ANJAY_DM_RESOURCE_OP_BIT_R;
+    out[5] = ANJAY_DM_RESOURCE_PRESENT | ANJAY_DM_RESOURCE_OP_BIT_W;
+    out[6] = ANJAY_DM_RESOURCE_PRESENT | ANJAY_DM_RESOURCE_OP_BIT_R;
+    return 0;
+}
+
+static const anjay_dm_object_def_t *const OBJ_WITH_INSTANCE_RESOURCES =
+        &(const anjay_dm_object_def_t) {
+            .oid = 42,
+            .supported_rids = ANJAY_DM_SUPPORTED_RIDS(0, 1, 2, 3, 4, 5, 6),
+            .handlers = {
+                ANJAY_MOCK_DM_HANDLERS,
+                .resource_operations = _anjay_mock_dm_resource_operations,
+                .instance_resources = fake_instance_resources
+            }
+        };
+
+AVS_UNIT_TEST(dm_read, instance_resources_bulk) {
+    DM_TEST_INIT_WITH_OBJECTS(&OBJ_WITH_INSTANCE_RESOURCES, &FAKE_SECURITY,
+                              &FAKE_SERVER);
+    static const char REQUEST[] =
+            "\x40\x01\xFA\x3E" // CoAP header
+            "\xB2" "42" // OID
+            "\x02" "13"; // IID
+    avs_unit_mocksock_input(mocksocks[0], REQUEST, sizeof(REQUEST) - 1);
+    _anjay_mock_dm_expect_instance_present(
+            anjay, &OBJ_WITH_INSTANCE_RESOURCES, 13, 1);
+    // no resource_present nor resource_operations calls expected; Resource 5
+    // is present, but not readable
+    _anjay_mock_dm_expect_resource_read(anjay, &OBJ_WITH_INSTANCE_RESOURCES,
+                                        13, 0, 0, ANJAY_MOCK_DM_INT(0, 69));
+    _anjay_mock_dm_expect_resource_read(anjay, &OBJ_WITH_INSTANCE_RESOURCES,
+                                        13, 6, 0,
+                                        ANJAY_MOCK_DM_STRING(0, "Hello"));
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0],
+            "\x60\x45\xFA\x3E" // CoAP header
+            "\xc2\x2d\x16" // Content-Format
+            "\xff"
+            "\xc1\x00\x45"
+            "\xc5\x06" "Hello");
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    DM_TEST_FINISH;
+}
+
+static int fake_instance_read(anjay_t *anjay,
+                              const anjay_dm_object_def_t *const *obj_ptr,
+                              anjay_iid_t iid,
+                              anjay_output_ctx_t *ctx) {
+    (void) anjay;
+    (void) obj_ptr;
+    AVS_UNIT_ASSERT_EQUAL(iid, 13);
+    int result;
+    (void) ((result = anjay_ret_resource_id(ctx, 0))
+            || (result = anjay_ret_i32(ctx, 69))
+            || (result = anjay_ret_resource_id(ctx, 6))
+            || (result = anjay_ret_string(ctx, "Hello")));
+    return result;
+}
+
+static const anjay_dm_object_def_t *const OBJ_WITH_INSTANCE_READ =
+        &(const anjay_dm_object_def_t) {
+            .oid = 42,
+            .supported_rids = ANJAY_DM_SUPPORTED_RIDS(0, 1, 2, 3, 4, 5, 6),
+            .handlers = {
+                ANJAY_MOCK_DM_HANDLERS,
+                .instance_read = fake_instance_read
+            }
+        };
+
+AVS_UNIT_TEST(dm_read, instance_read_handler) {
+    DM_TEST_INIT_WITH_OBJECTS(&OBJ_WITH_INSTANCE_READ, &FAKE_SECURITY,
+                              &FAKE_SERVER);
+    static const char REQUEST[] =
+            "\x40\x01\xFA\x3E" // CoAP header
+            "\xB2" "42" // OID
+            "\x02" "13"; // IID
+    avs_unit_mocksock_input(mocksocks[0], REQUEST, sizeof(REQUEST) - 1);
+    // no per-Resource handler calls expected
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ_WITH_INSTANCE_READ, 13,
+                                           1);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0],
+            "\x60\x45\xFA\x3E" // CoAP header
+            "\xc2\x2d\x16" // Content-Format
+            "\xff"
+            "\xc1\x00\x45"
+            "\xc5\x06" "Hello");
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    DM_TEST_FINISH;
+}
+
 AVS_UNIT_TEST(dm_read, instance_not_found) {
     DM_TEST_INIT;
     static const char REQUEST[] =
@@ -1629,6 +1726,56 @@ AVS_UNIT_TEST(dm_discover, multiple_servers_empty) {
     DM_TEST_FINISH;
 }
 
+static void expect_discover_resource_without_attrs(anjay_t *anjay,
+                                                   anjay_ssid_t ssid) {
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ, 69, 1);
+    _anjay_mock_dm_expect_resource_present(anjay, &OBJ, 69, 4, 1);
+    _anjay_mock_dm_expect_resource_dim(anjay, &OBJ, 69, 4, 3);
+    _anjay_mock_dm_expect_resource_read_attrs(
+            anjay, &OBJ, 69, 4, ssid, 0, &ANJAY_DM_INTERNAL_RES_ATTRS_EMPTY);
+    _anjay_mock_dm_expect_instance_read_default_attrs(
+            anjay, &OBJ, 69, ssid, 0, &ANJAY_DM_INTERNAL_ATTRS_EMPTY);
+    _anjay_mock_dm_expect_object_read_default_attrs(
+            anjay, &OBJ, ssid, 0, &ANJAY_DM_INTERNAL_ATTRS_EMPTY);
+}
+
+AVS_UNIT_TEST(dm_discover, cached) {
+    DM_TEST_INIT_GENERIC((DM_TEST_DEFAULT_OBJECTS), (7),
+                         (.discover_cache_size = 1024));
+    static const char REQUEST[] =
+            "\x40\x01\xFA\x3E" // CoAP header
+            "\xB2" "42" // OID
+            "\x02" "69" // IID
+            "\x01" "4" // RID
+            "\x61\x28"; // Accept: application/link-format
+    static const char RESPONSE[] =
+            "\x60\x45\xfa\x3e" // CoAP header
+            "\xc1\x28" // Content-Format: application/link-format
+            "\xff" "</42/69/4>;dim=3";
+    avs_unit_mocksock_input(mocksocks[0], REQUEST, sizeof(REQUEST) - 1);
+    expect_discover_resource_without_attrs(anjay, 7);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], RESPONSE);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+
+    // served from cache, data model not queried
+    avs_unit_mocksock_input(mocksocks[0], REQUEST, sizeof(REQUEST) - 1);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], RESPONSE);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+
+    // change in an unrelated Instance does not invalidate the cache
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 70, 4));
+    avs_unit_mocksock_input(mocksocks[0], REQUEST, sizeof(REQUEST) - 1);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], RESPONSE);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    avs_unit_mocksock_input(mocksocks[0], REQUEST, sizeof(REQUEST) - 1);
+    expect_discover_resource_without_attrs(anjay, 7);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], RESPONSE);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    DM_TEST_FINISH;
+}
+
 AVS_UNIT_TEST(dm_create, only_iid) {
     DM_TEST_INIT;
     static const char REQUEST[] =
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <avsystem/commons/unit/test.h>
+
+static anjay_t *dtls_session_test_anjay_new(void) {
+    anjay_t *anjay = anjay_new(&(const anjay_configuration_t) {
+        .endpoint_name = "urn:dev:os:anjay-test",
+        .in_buffer_size = 4096,
+        .out_buffer_size = 4096
+    });
+    AVS_UNIT_ASSERT_NOT_NULL(anjay);
+    return anjay;
+}
+
+AVS_UNIT_TEST(dtls_session, credentials_change_drops_session) {
+    uint8_t session[ANJAY_DTLS_SESSION_BUFFER_SIZE];
+    memset(session, 0x11, sizeof(session));
+    const uint8_t empty[ANJAY_DTLS_SESSION_BUFFER_SIZE] = { 0 };
+
+    anjay_t *anjay = dtls_session_test_anjay_new();
+    uint8_t *buffer = _anjay_dtls_session_buffer(anjay, 1, 0x1234);
+    AVS_UNIT_ASSERT_NOT_NULL(buffer);
+    memcpy(buffer, session, sizeof(session));
+    AVS_UNIT_ASSERT_TRUE(_anjay_dtls_session_buffer(anjay, 1, 0x1234)
+                         == buffer);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buffer, session, sizeof(session));
+
+    // sockets may still refer to the buffer, so it shall be reused
+    AVS_UNIT_ASSERT_TRUE(_anjay_dtls_session_buffer(anjay, 1, 0x4321)
+                         == buffer);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buffer, empty, sizeof(empty));
+    AVS_UNIT_ASSERT_EQUAL(anjay->dtls_sessions->credentials_digest, 0x4321);
+    anjay_delete(anjay);
+}
+
+AVS_UNIT_TEST(dtls_session, restore_in_place) {
+    uint8_t session1[ANJAY_DTLS_SESSION_BUFFER_SIZE];
+    memset(session1, 0x11, sizeof(session1));
+    uint8_t session2[ANJAY_DTLS_SESSION_BUFFER_SIZE];
+    memset(session2, 0x22, sizeof(session2));
+
+    anjay_t *anjay = dtls_session_test_anjay_new();
+    uint8_t *buffer = _anjay_dtls_session_buffer(anjay, 2, 0x1234);
+    AVS_UNIT_ASSERT_NOT_NULL(buffer);
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_dtls_session_restore(anjay, 2, 0x1234, session2));
+    AVS_UNIT_ASSERT_SUCCESS(
+            _anjay_dtls_session_restore(anjay, 1, 0x5678, session1));
+
+    AVS_LIST(const anjay_dtls_session_t) sessions =
+            _anjay_dtls_sessions(anjay);
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(sessions), 2);
+    AVS_UNIT_ASSERT_EQUAL(sessions->ssid, 1);
+    AVS_UNIT_ASSERT_EQUAL(sessions->credentials_digest, 0x5678);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(sessions->buffer, session1,
+                                      sizeof(session1));
+    AVS_UNIT_ASSERT_TRUE(AVS_LIST_NEXT(sessions)->buffer == buffer);
+    AVS_UNIT_ASSERT_TRUE(_anjay_dtls_session_buffer(anjay, 2, 0x1234)
+                         == buffer);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buffer, session2, sizeof(session2));
+    anjay_delete(anjay);
+}
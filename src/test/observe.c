@@ -338,15 +338,17 @@ AVS_UNIT_TEST(observe, cancel_deregister) {
 }
 
 static inline void
-remove_server(AVS_LIST(anjay_active_server_info_t) *server_ptr) {
-    _anjay_connection_internal_clean_socket(&(*server_ptr)->udp_connection);
+remove_server(anjay_t *anjay,
+              AVS_LIST(anjay_active_server_info_t) *server_ptr) {
+    _anjay_connection_internal_clean_socket(anjay,
+                                            &(*server_ptr)->udp_connection);
     AVS_LIST_DELETE(server_ptr);
 }
 
 AVS_UNIT_TEST(observe, gc) {
     SUCCESS_TEST(14, 69, 514, 666, 777);
 
-    remove_server(&anjay->servers.active);
+    remove_server(anjay, &anjay->servers.active);
 
     _anjay_observe_gc(anjay);
     assert_observe_size(anjay, 4);
@@ -355,7 +357,7 @@ AVS_UNIT_TEST(observe, gc) {
     ASSERT_SUCCESS_TEST_RESULT(666);
     ASSERT_SUCCESS_TEST_RESULT(777);
 
-    remove_server(AVS_LIST_NTH_PTR(&anjay->servers.active, 3));
+    remove_server(anjay, AVS_LIST_NTH_PTR(&anjay->servers.active, 3));
 
     _anjay_observe_gc(anjay);
     assert_observe_size(anjay, 3);
@@ -363,7 +365,7 @@ AVS_UNIT_TEST(observe, gc) {
     ASSERT_SUCCESS_TEST_RESULT(514);
     ASSERT_SUCCESS_TEST_RESULT(666);
 
-    remove_server(AVS_LIST_NTH_PTR(&anjay->servers.active, 1));
+    remove_server(anjay, AVS_LIST_NTH_PTR(&anjay->servers.active, 1));
 
     _anjay_observe_gc(anjay);
     assert_observe_size(anjay, 2);
@@ -480,7 +482,13 @@ static void notify_max_period_test(const char *con_notify_ack,
             "\xFF" "Hi!";
     avs_unit_mocksock_expect_output(mocksocks[0], CON_NOTIFY_RESPONSE,
                                     sizeof(CON_NOTIFY_RESPONSE) - 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    assert_observe_size(anjay, 1);
+    // the notification is not considered sent until acknowledged
+    AVS_UNIT_ASSERT_EQUAL(AVS_RBTREE_FIRST(AVS_RBTREE_FIRST(anjay->observe.connection_entries)->entries)->last_confirmable.since_real_epoch.seconds,
+                          1000);
     avs_unit_mocksock_input(mocksocks[0], con_notify_ack, con_notify_ack_size);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
     AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
     assert_observe_size(anjay, observe_size_after_ack);
     if (observe_size_after_ack) {
@@ -493,10 +501,61 @@ static void notify_max_period_test(const char *con_notify_ack,
 }
 
 AVS_UNIT_TEST(notify, max_period) {
-    notify_max_period_test("\x60\x00\x69\xEE", 4, 1); // CON
+    notify_max_period_test("\x60\x00\x69\xEE", 4, 1); // ACK
     notify_max_period_test("\x70\x00\x69\xEE", 4, 0); // Reset
 }
 
+AVS_UNIT_TEST(notify, non_confirmable_cancel_reset) {
+    static const anjay_dm_internal_res_attrs_t ATTRS = {
+        .standard = {
+            .common = {
+                .min_period = 1,
+                .max_period = 10
+            },
+            .greater_than = ANJAY_ATTRIB_VALUE_NONE,
+            .less_than = ANJAY_ATTRIB_VALUE_NONE,
+            .step = ANJAY_ATTRIB_VALUE_NONE
+        }
+    };
+
+    ////// INITIALIZATION //////
+    DM_TEST_INIT_WITH_SSIDS(14);
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_observe_put_entry(
+            anjay, &(const anjay_observe_key_t) {
+                { 14, ANJAY_CONNECTION_UDP }, 42, 69, 4, AVS_COAP_FORMAT_NONE
+            }, &(const anjay_msg_details_t) {
+                .msg_type = AVS_COAP_MSG_ACKNOWLEDGEMENT,
+                .msg_code = AVS_COAP_CODE_CONTENT,
+                .format = ANJAY_COAP_FORMAT_PLAINTEXT,
+                .observe_serial = true
+            }, &NULL_IDENTITY, 514.0, "514", 3));
+    assert_observe_size(anjay, 1);
+
+    ////// NON-CONFIRMABLE NOTIFICATION //////
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(10, AVS_TIME_S));
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    expect_read_res_attrs(anjay, &OBJ, 14, 69, 4, &ATTRS);
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_STRING(0, "Hello"));
+    static const char NOTIFY_RESPONSE[] =
+            "\x50\x45\x69\xED" // CoAP header
+            "\x63\xF9\x00\x00" // Observe option
+            "\x60" // Content-Format
+            "\xFF" "Hello";
+    avs_unit_mocksock_expect_output(mocksocks[0], NOTIFY_RESPONSE,
+                                    sizeof(NOTIFY_RESPONSE) - 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    assert_observe_size(anjay, 1);
+
+    ////// RESET - NOT MATCHED BY ANY EXCHANGE, CANCELS OBSERVATION //////
+    static const char RESET[] = "\x70\x00\x69\xED";
+    avs_unit_mocksock_input(mocksocks[0], RESET, sizeof(RESET) - 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    assert_observe_size(anjay, 0);
+
+    DM_TEST_FINISH;
+}
+
 AVS_UNIT_TEST(notify, min_period) {
     static const anjay_dm_internal_res_attrs_t ATTRS = {
         .standard = {
@@ -598,15 +657,169 @@ AVS_UNIT_TEST(notify, confirmable) {
             "\xFF" "42";
     avs_unit_mocksock_expect_output(mocksocks[0], NOTIFY_RESPONSE,
                                     sizeof(NOTIFY_RESPONSE) - 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    static const char NOTIFY_ACK[] =
+            "\x60\x00\x69\xED";
+    avs_unit_mocksock_input(mocksocks[0], NOTIFY_ACK, sizeof(NOTIFY_ACK) - 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    DM_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(notify, confirmable_retransmission) {
+    ////// INITIALIZATION //////
+    DM_TEST_INIT_GENERIC((DM_TEST_DEFAULT_OBJECTS), (14),
+                         (.confirmable_notifications = true));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_observe_put_entry(
+            anjay, &(const anjay_observe_key_t) {
+                { 14, ANJAY_CONNECTION_UDP }, 42, 69, 4, AVS_COAP_FORMAT_NONE
+            }, &(const anjay_msg_details_t) {
+                .msg_type = AVS_COAP_MSG_ACKNOWLEDGEMENT,
+                .msg_code = AVS_COAP_CODE_CONTENT,
+                .format = ANJAY_COAP_FORMAT_PLAINTEXT,
+                .observe_serial = true
+            }, &(avs_coap_msg_identity_t) {}, 514.0, "514", 3));
+    assert_observe_size(anjay, 1);
+
+    ////// CONFIRMABLE NOTIFICATION //////
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(10, AVS_TIME_S));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, 4));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    expect_read_res(anjay, &OBJ, 69, 4, ANJAY_MOCK_DM_INT(0, 42));
+    static const char NOTIFY_RESPONSE[] =
+            "\x40\x45\x69\xED" // CoAP header
+            "\x63\xF9\x00\x00" // Observe option
+            "\x60" // Content-Format
+            "\xFF" "42";
+    avs_unit_mocksock_expect_output(mocksocks[0], NOTIFY_RESPONSE,
+                                    sizeof(NOTIFY_RESPONSE) - 1);
+    // sending does not wait for the ACK
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    ////// RETRANSMISSION //////
+    // ACK_TIMEOUT * ACK_RANDOM_FACTOR is at most 3 seconds
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(3, AVS_TIME_S));
+    avs_unit_mocksock_expect_output(mocksocks[0], NOTIFY_RESPONSE,
+                                    sizeof(NOTIFY_RESPONSE) - 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    ////// ACKNOWLEDGEMENT //////
     static const char NOTIFY_ACK[] =
             "\x60\x00\x69\xED";
     avs_unit_mocksock_input(mocksocks[0], NOTIFY_ACK, sizeof(NOTIFY_ACK) - 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    assert_observe_size(anjay, 1);
+
+    ////// NO MORE RETRANSMISSIONS //////
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(90, AVS_TIME_S));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    DM_TEST_FINISH;
+}
+
+#define NOTIFY_PIPELINED_STEP(Rid, Value) do { \
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, Rid); \
+    AVS_UNIT_ASSERT_SUCCESS(anjay_notify_changed(anjay, 42, 69, Rid)); \
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay)); \
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true); \
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, Rid); \
+    expect_read_res(anjay, &OBJ, 69, Rid, ANJAY_MOCK_DM_INT(0, Value)); \
+} while (0)
+
+static void put_pipelined_entry(anjay_t *anjay, anjay_rid_t rid) {
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_observe_put_entry(
+            anjay, &(const anjay_observe_key_t) {
+                { 14, ANJAY_CONNECTION_UDP }, 42, 69, rid, AVS_COAP_FORMAT_NONE
+            }, &(const anjay_msg_details_t) {
+                .msg_type = AVS_COAP_MSG_ACKNOWLEDGEMENT,
+                .msg_code = AVS_COAP_CODE_CONTENT,
+                .format = ANJAY_COAP_FORMAT_PLAINTEXT,
+                .observe_serial = true
+            }, &(avs_coap_msg_identity_t) {}, 514.0, "514", 3));
+}
+
+AVS_UNIT_TEST(notify, confirmable_pipelining) {
+    ////// INITIALIZATION //////
+    DM_TEST_INIT_GENERIC((DM_TEST_DEFAULT_OBJECTS), (14),
+                         (.confirmable_notifications = true, .nstart = 2));
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    put_pipelined_entry(anjay, 4);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 5);
+    put_pipelined_entry(anjay, 5);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 6);
+    put_pipelined_entry(anjay, 6);
+    assert_observe_size(anjay, 3);
+
+    ////// TWO NOTIFICATIONS IN FLIGHT //////
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(10, AVS_TIME_S));
+    static const char NOTIFY4[] =
+            "\x40\x45\x69\xED" // CoAP header
+            "\x63\xF9\x00\x00" // Observe option
+            "\x60" // Content-Format
+            "\xFF" "42";
+    static const char NOTIFY5[] =
+            "\x40\x45\x69\xEE" // CoAP header
+            "\x63\xF9\x00\x00" // Observe option
+            "\x60" // Content-Format
+            "\xFF" "43";
+    static const char NOTIFY6[] =
+            "\x40\x45\x69\xEF" // CoAP header
+            "\x63\xF9\x00\x00" // Observe option
+            "\x60" // Content-Format
+            "\xFF" "44";
+    NOTIFY_PIPELINED_STEP(4, 42);
+    avs_unit_mocksock_expect_output(mocksocks[0], NOTIFY4,
+                                    sizeof(NOTIFY4) - 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    // the second one is sent before the first one is acknowledged
+    NOTIFY_PIPELINED_STEP(5, 43);
+    avs_unit_mocksock_expect_output(mocksocks[0], NOTIFY5,
+                                    sizeof(NOTIFY5) - 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    // NSTART reached - the third one has to wait
+    NOTIFY_PIPELINED_STEP(6, 44);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    ////// OUT-OF-ORDER ACKNOWLEDGEMENTS //////
+    static const char ACK5[] = "\x60\x00\x69\xEE";
+    avs_unit_mocksock_input(mocksocks[0], ACK5, sizeof(ACK5) - 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    expect_read_notif_storing(anjay, &FAKE_SERVER, 14, true);
+    avs_unit_mocksock_expect_output(mocksocks[0], NOTIFY6,
+                                    sizeof(NOTIFY6) - 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    static const char ACK4[] = "\x60\x00\x69\xED";
+    avs_unit_mocksock_input(mocksocks[0], ACK4, sizeof(ACK4) - 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    static const char ACK6[] = "\x60\x00\x69\xEF";
+    avs_unit_mocksock_input(mocksocks[0], ACK6, sizeof(ACK6) - 1);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
     DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 4);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 5);
+    DM_TEST_EXPECT_READ_NULL_ATTRS(14, 69, 6);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    assert_observe_size(anjay, 3);
+
+    ////// NO MORE RETRANSMISSIONS //////
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(90, AVS_TIME_S));
     AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
 
     DM_TEST_FINISH;
 }
 
+#undef NOTIFY_PIPELINED_STEP
+
 AVS_UNIT_TEST(notify, extremes) {
     static const anjay_dm_internal_res_attrs_t ATTRS = {
         .standard = {
@@ -0,0 +1,252 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <avsystem/commons/unit/test.h>
+
+#include <anjay_test/mock_clock.h>
+
+typedef struct {
+    unsigned calls;
+    int result;
+    const char *address;
+    avs_time_duration_t ttl;
+    avs_net_af_t family;
+    // fill the whole buffer, without the terminating nullbyte
+    bool overflow;
+} fake_resolver_t;
+
+static int fake_resolve(void *resolver_,
+                        const char *host,
+                        const char *port,
+                        avs_net_af_t family,
+                        char *out_address,
+                        size_t address_size,
+                        avs_time_duration_t *inout_ttl) {
+    fake_resolver_t *resolver = (fake_resolver_t *) resolver_;
+    AVS_UNIT_ASSERT_EQUAL_STRING(host, "lwm2m.example.com");
+    AVS_UNIT_ASSERT_EQUAL_STRING(port, "5683");
+    ++resolver->calls;
+    resolver->family = family;
+    if (resolver->overflow) {
+        memset(out_address, '1', address_size);
+    } else if (!resolver->result) {
+        AVS_UNIT_ASSERT_TRUE(strlen(resolver->address) < address_size);
+        strcpy(out_address, resolver->address);
+        if (avs_time_duration_valid(resolver->ttl)) {
+            *inout_ttl = resolver->ttl;
+        }
+    }
+    return resolver->result;
+}
+
+#define RESOLVER_TEST_INIT_WITH_REFRESH(Resolver, BackgroundRefresh) \
+    _anjay_mock_clock_start(avs_time_monotonic_from_scalar(1000, AVS_TIME_S)); \
+    anjay_t *anjay = anjay_new(&(anjay_configuration_t) { \
+        .endpoint_name = "urn:dev:os:anjay-test", \
+        .in_buffer_size = 4096, \
+        .out_buffer_size = 4096, \
+        .resolve_handler = fake_resolve, \
+        .resolve_handler_arg = (Resolver), \
+        .refresh_dns_cache_in_background = (BackgroundRefresh) \
+    }); \
+    AVS_UNIT_ASSERT_NOT_NULL(anjay); \
+    char address[ANJAY_MAX_URL_HOSTNAME_SIZE]
+
+#define RESOLVER_TEST_INIT(Resolver) \
+    RESOLVER_TEST_INIT_WITH_REFRESH((Resolver), false)
+
+#define RESOLVER_TEST_FINISH \
+    do { \
+        anjay_delete(anjay); \
+        _anjay_mock_clock_finish(); \
+    } while (0)
+
+#define RESOLVE_FAMILY(Family) \
+    _anjay_resolver_resolve(anjay, "lwm2m.example.com", "5683", (Family), \
+                            address, sizeof(address))
+
+#define RESOLVE() RESOLVE_FAMILY(AVS_NET_AF_UNSPEC)
+
+AVS_UNIT_TEST(resolver, cached_until_ttl_expires) {
+    fake_resolver_t resolver = {
+        .address = "192.0.2.1",
+        .ttl = avs_time_duration_from_scalar(60, AVS_TIME_S)
+    };
+    RESOLVER_TEST_INIT(&resolver);
+
+    AVS_UNIT_ASSERT_SUCCESS(RESOLVE());
+    AVS_UNIT_ASSERT_EQUAL_STRING(address, "192.0.2.1");
+    AVS_UNIT_ASSERT_EQUAL(resolver.calls, 1);
+
+    resolver.address = "192.0.2.2";
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(30, AVS_TIME_S));
+    AVS_UNIT_ASSERT_SUCCESS(RESOLVE());
+    AVS_UNIT_ASSERT_EQUAL_STRING(address, "192.0.2.1");
+    AVS_UNIT_ASSERT_EQUAL(resolver.calls, 1);
+
+    // background refresh is disabled - the scheduler never calls the resolver
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(31, AVS_TIME_S));
+    anjay_sched_run(anjay);
+    AVS_UNIT_ASSERT_EQUAL(resolver.calls, 1);
+    AVS_UNIT_ASSERT_SUCCESS(RESOLVE());
+    AVS_UNIT_ASSERT_EQUAL_STRING(address, "192.0.2.2");
+    AVS_UNIT_ASSERT_EQUAL(resolver.calls, 2);
+
+    RESOLVER_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(resolver, background_refresh) {
+    fake_resolver_t resolver = {
+        .address = "192.0.2.1",
+        .ttl = avs_time_duration_from_scalar(60, AVS_TIME_S)
+    };
+    RESOLVER_TEST_INIT_WITH_REFRESH(&resolver, true);
+
+    AVS_UNIT_ASSERT_SUCCESS(RESOLVE());
+    AVS_UNIT_ASSERT_EQUAL(resolver.calls, 1);
+
+    // entry used since the last refresh - refreshed in the background
+    resolver.address = "192.0.2.2";
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(61, AVS_TIME_S));
+    anjay_sched_run(anjay);
+    AVS_UNIT_ASSERT_EQUAL(resolver.calls, 2);
+    AVS_UNIT_ASSERT_SUCCESS(RESOLVE());
+    AVS_UNIT_ASSERT_EQUAL_STRING(address, "192.0.2.2");
+    AVS_UNIT_ASSERT_EQUAL(resolver.calls, 2);
+
+    // used right before the refresh, so refreshed once more
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(61, AVS_TIME_S));
+    anjay_sched_run(anjay);
+    AVS_UNIT_ASSERT_EQUAL(resolver.calls, 3);
+
+    // not used since then
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(61, AVS_TIME_S));
+    anjay_sched_run(anjay);
+    AVS_UNIT_ASSERT_EQUAL(resolver.calls, 3);
+    AVS_UNIT_ASSERT_NULL(anjay->resolver.entries);
+
+    RESOLVER_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(resolver, unused_entry_dropped) {
+    fake_resolver_t resolver = {
+        .address = "192.0.2.1",
+        .ttl = avs_time_duration_from_scalar(60, AVS_TIME_S)
+    };
+    RESOLVER_TEST_INIT(&resolver);
+
+    AVS_UNIT_ASSERT_SUCCESS(RESOLVE());
+    AVS_UNIT_ASSERT_EQUAL(resolver.calls, 1);
+
+    // kept as a fallback, as it has been used right before being cached
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(61, AVS_TIME_S));
+    anjay_sched_run(anjay);
+    AVS_UNIT_ASSERT_NOT_NULL(anjay->resolver.entries);
+
+    // not used since then
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(
+            ANJAY_DNS_CACHE_DEFAULT_TTL_S + 1, AVS_TIME_S));
+    anjay_sched_run(anjay);
+    AVS_UNIT_ASSERT_NULL(anjay->resolver.entries);
+    AVS_UNIT_ASSERT_EQUAL(resolver.calls, 1);
+
+    RESOLVER_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(resolver, last_known_address_on_failure) {
+    fake_resolver_t resolver = {
+        .address = "192.0.2.1",
+        .ttl = avs_time_duration_from_scalar(60, AVS_TIME_S)
+    };
+    RESOLVER_TEST_INIT(&resolver);
+
+    AVS_UNIT_ASSERT_SUCCESS(RESOLVE());
+    AVS_UNIT_ASSERT_EQUAL(resolver.calls, 1);
+
+    resolver.result = -1;
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(61, AVS_TIME_S));
+    anjay_sched_run(anjay);
+
+    AVS_UNIT_ASSERT_SUCCESS(RESOLVE());
+    AVS_UNIT_ASSERT_EQUAL_STRING(address, "192.0.2.1");
+    AVS_UNIT_ASSERT_EQUAL(resolver.calls, 2);
+
+    RESOLVER_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(resolver, zero_ttl_not_cached) {
+    fake_resolver_t resolver = {
+        .address = "192.0.2.1",
+        .ttl = AVS_TIME_DURATION_ZERO
+    };
+    RESOLVER_TEST_INIT(&resolver);
+
+    AVS_UNIT_ASSERT_SUCCESS(RESOLVE());
+    AVS_UNIT_ASSERT_SUCCESS(RESOLVE());
+    AVS_UNIT_ASSERT_EQUAL_STRING(address, "192.0.2.1");
+    AVS_UNIT_ASSERT_EQUAL(resolver.calls, 2);
+    AVS_UNIT_ASSERT_NULL(anjay->resolver.entries);
+
+    resolver.result = -1;
+    AVS_UNIT_ASSERT_FAILED(RESOLVE());
+
+    RESOLVER_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(resolver, cached_per_family) {
+    fake_resolver_t resolver = {
+        .address = "192.0.2.1",
+        .ttl = avs_time_duration_from_scalar(60, AVS_TIME_S)
+    };
+    RESOLVER_TEST_INIT(&resolver);
+
+    AVS_UNIT_ASSERT_SUCCESS(RESOLVE_FAMILY(AVS_NET_AF_INET4));
+    AVS_UNIT_ASSERT_EQUAL(resolver.family, AVS_NET_AF_INET4);
+    AVS_UNIT_ASSERT_EQUAL(resolver.calls, 1);
+
+    resolver.address = "2001:db8::1";
+    AVS_UNIT_ASSERT_SUCCESS(RESOLVE_FAMILY(AVS_NET_AF_INET6));
+    AVS_UNIT_ASSERT_EQUAL(resolver.family, AVS_NET_AF_INET6);
+    AVS_UNIT_ASSERT_EQUAL_STRING(address, "2001:db8::1");
+    AVS_UNIT_ASSERT_EQUAL(resolver.calls, 2);
+
+    AVS_UNIT_ASSERT_SUCCESS(RESOLVE_FAMILY(AVS_NET_AF_INET4));
+    AVS_UNIT_ASSERT_EQUAL_STRING(address, "192.0.2.1");
+    AVS_UNIT_ASSERT_EQUAL(resolver.calls, 2);
+
+    RESOLVER_TEST_FINISH;
+}
+
+AVS_UNIT_TEST(resolver, address_too_long) {
+    fake_resolver_t resolver = {
+        .overflow = true
+    };
+    RESOLVER_TEST_INIT(&resolver);
+
+    AVS_UNIT_ASSERT_FAILED(RESOLVE());
+    AVS_UNIT_ASSERT_EQUAL(resolver.calls, 1);
+    AVS_UNIT_ASSERT_NULL(anjay->resolver.entries);
+
+    RESOLVER_TEST_FINISH;
+}
+
+#undef RESOLVE
+#undef RESOLVE_FAMILY
+#undef RESOLVER_TEST_FINISH
+#undef RESOLVER_TEST_INIT
+#undef RESOLVER_TEST_INIT_WITH_REFRESH
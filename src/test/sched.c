@@ -299,3 +299,95 @@ AVS_UNIT_TEST(sched, retryable_job_handle_nullification) {
     AVS_UNIT_ASSERT_NULL(global.task);
     teardown_test(&env);
 }
+
+static int slow_task(anjay_t *anjay, void *duration_ms_) {
+    (void) anjay;
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(
+            *(int *) duration_ms_, AVS_TIME_MS));
+    return 0;
+}
+
+static void count_overrun(void *counter_,
+                          const anjay_sched_job_stats_t *job,
+                          avs_time_duration_t run_time) {
+    AVS_UNIT_ASSERT_TRUE(job->callback == (uintptr_t) (intptr_t) slow_task);
+    AVS_UNIT_ASSERT_TRUE(avs_time_duration_equal(
+            run_time, avs_time_duration_from_scalar(300, AVS_TIME_MS)));
+    ++*(int *) counter_;
+}
+
+AVS_UNIT_TEST(sched, job_stats) {
+    sched_test_env_t env = setup_test();
+    int overruns = 0;
+    env.sched->watchdog_budget =
+            avs_time_duration_from_scalar(200, AVS_TIME_MS);
+    env.sched->watchdog_handler = count_overrun;
+    env.sched->watchdog_handler_arg = &overruns;
+
+    int fast = 100;
+    int slow = 300;
+    int counter = 0;
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_sched_now(env.sched, NULL, slow_task,
+                                             &fast));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_sched_now(env.sched, NULL, slow_task,
+                                             &slow));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_sched_now(env.sched, NULL, increment_task,
+                                             &counter));
+    AVS_UNIT_ASSERT_EQUAL(3, _anjay_sched_run(env.sched));
+    AVS_UNIT_ASSERT_EQUAL(1, overruns);
+
+    AVS_UNIT_ASSERT_EQUAL(AVS_LIST_SIZE(env.sched->job_stats), 2);
+    const anjay_sched_job_stats_t *stats = env.sched->job_stats;
+    AVS_UNIT_ASSERT_TRUE(stats->callback == (uintptr_t) (intptr_t) slow_task);
+    AVS_UNIT_ASSERT_EQUAL(stats->count, 2);
+    AVS_UNIT_ASSERT_TRUE(avs_time_duration_equal(
+            stats->total_run_time,
+            avs_time_duration_from_scalar(400, AVS_TIME_MS)));
+    AVS_UNIT_ASSERT_TRUE(avs_time_duration_equal(
+            stats->max_run_time,
+            avs_time_duration_from_scalar(300, AVS_TIME_MS)));
+    // the second job started after the first one has finished
+    AVS_UNIT_ASSERT_TRUE(avs_time_duration_equal(
+            stats->max_lateness,
+            avs_time_duration_from_scalar(100, AVS_TIME_MS)));
+
+    stats = AVS_LIST_NEXT(stats);
+    AVS_UNIT_ASSERT_TRUE(stats->callback
+                         == (uintptr_t) (intptr_t) increment_task);
+    AVS_UNIT_ASSERT_EQUAL(stats->count, 1);
+    AVS_UNIT_ASSERT_TRUE(avs_time_duration_equal(
+            stats->max_lateness,
+            avs_time_duration_from_scalar(400, AVS_TIME_MS)));
+    teardown_test(&env);
+}
+
+AVS_UNIT_TEST(sched, run_bounded) {
+    sched_test_env_t env = setup_test();
+
+    int duration_ms = 100;
+    for (int i = 0; i < 6; ++i) {
+        AVS_UNIT_ASSERT_SUCCESS(_anjay_sched_now(env.sched, NULL, slow_task,
+                                                 &duration_ms));
+    }
+
+    AVS_UNIT_ASSERT_EQUAL(2, _anjay_sched_run_bounded(
+                                     env.sched, 2,
+                                     AVS_TIME_MONOTONIC_INVALID));
+    AVS_UNIT_ASSERT_TRUE(_anjay_sched_has_due_tasks(env.sched));
+
+    // deadline checked only after each job
+    AVS_UNIT_ASSERT_EQUAL(1, _anjay_sched_run_bounded(
+                                     env.sched, 0, avs_time_monotonic_now()));
+    AVS_UNIT_ASSERT_EQUAL(
+            2, _anjay_sched_run_bounded(
+                       env.sched, 0,
+                       avs_time_monotonic_add(
+                               avs_time_monotonic_now(),
+                               avs_time_duration_from_scalar(150,
+                                                             AVS_TIME_MS))));
+    AVS_UNIT_ASSERT_TRUE(_anjay_sched_has_due_tasks(env.sched));
+
+    AVS_UNIT_ASSERT_EQUAL(1, _anjay_sched_run(env.sched));
+    AVS_UNIT_ASSERT_FALSE(_anjay_sched_has_due_tasks(env.sched));
+    teardown_test(&env);
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <stddef.h>
+
+#include <avsystem/commons/unit/mocksock.h>
+#include <avsystem/commons/unit/test.h>
+
+#include <anjay_test/dm.h>
+#include <anjay_test/mock_clock.h>
+
+#include "../coap_exchange.h"
+
+#ifdef WITH_NET_STATS
+
+#define SERVER_STATS_TEST_INIT() \
+    _anjay_mock_clock_start(avs_time_monotonic_from_scalar(1000, AVS_TIME_S)); \
+    anjay_t *anjay = anjay_new(&(const anjay_configuration_t) { \
+        .endpoint_name = "urn:dev:os:anjay-test", \
+        .in_buffer_size = 4096, \
+        .out_buffer_size = 4096 \
+    }); \
+    AVS_UNIT_ASSERT_NOT_NULL(anjay); \
+    anjay_server_stats_t stats
+
+#define SERVER_STATS_TEST_FINISH \
+    do { \
+        anjay_delete(anjay); \
+        _anjay_mock_clock_finish(); \
+    } while (0)
+
+AVS_UNIT_TEST(server_stats, latency_buckets) {
+    AVS_UNIT_ASSERT_EQUAL(latency_bucket(AVS_TIME_DURATION_ZERO), 0);
+    AVS_UNIT_ASSERT_EQUAL(
+            latency_bucket(avs_time_duration_from_scalar(15, AVS_TIME_MS)), 0);
+    AVS_UNIT_ASSERT_EQUAL(
+            latency_bucket(avs_time_duration_from_scalar(16, AVS_TIME_MS)), 1);
+    AVS_UNIT_ASSERT_EQUAL(
+            latency_bucket(avs_time_duration_from_scalar(100, AVS_TIME_MS)),
+            3);
+    AVS_UNIT_ASSERT_EQUAL(
+            latency_bucket(avs_time_duration_from_scalar(1, AVS_TIME_HOUR)),
+            ANJAY_LATENCY_HISTOGRAM_BUCKETS - 1);
+    AVS_UNIT_ASSERT_EQUAL(latency_bucket(AVS_TIME_DURATION_INVALID),
+                          ANJAY_LATENCY_HISTOGRAM_BUCKETS - 1);
+}
+
+AVS_UNIT_TEST(server_stats, per_server) {
+    SERVER_STATS_TEST_INIT();
+
+    AVS_UNIT_ASSERT_FAILED(anjay_get_server_stats(anjay, 1, &stats));
+
+    _anjay_server_stats_record_incoming(anjay, 2);
+    _anjay_server_stats_record_incoming(anjay, 1);
+    _anjay_server_stats_record_incoming(anjay, 2);
+
+    avs_time_monotonic_t request_time = avs_time_monotonic_now();
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(20, AVS_TIME_MS));
+    _anjay_server_stats_record_latency(anjay, 1, ANJAY_SERVER_STATS_UPDATE,
+                                       request_time);
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(3, AVS_TIME_S));
+    _anjay_server_stats_record_latency(anjay, 1, ANJAY_SERVER_STATS_NOTIFY,
+                                       request_time);
+
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_server_stats(anjay, 1, &stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.num_incoming_messages, 1);
+    AVS_UNIT_ASSERT_EQUAL(stats.update_latency.buckets[1], 1);
+    // 3020 ms
+    AVS_UNIT_ASSERT_EQUAL(stats.notify_latency.buckets[8], 1);
+    for (size_t i = 0; i < ANJAY_LATENCY_HISTOGRAM_BUCKETS; ++i) {
+        AVS_UNIT_ASSERT_EQUAL(stats.register_latency.buckets[i], 0);
+    }
+
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_server_stats(anjay, 2, &stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.num_incoming_messages, 2);
+    AVS_UNIT_ASSERT_EQUAL(stats.update_latency.buckets[1], 0);
+
+    SERVER_STATS_TEST_FINISH;
+}
+
+static void charged_exchange_finished(anjay_t *anjay,
+                                      anjay_exchange_id_t id,
+                                      anjay_exchange_result_t result,
+                                      const avs_coap_msg_t *response,
+                                      void *result_ptr) {
+    (void) anjay;
+    (void) id;
+    (void) response;
+    *(anjay_exchange_result_t *) result_ptr = result;
+}
+
+AVS_UNIT_TEST(server_stats, charged_per_server) {
+    DM_TEST_INIT_WITH_SSIDS(1, 2);
+    anjay_server_stats_t stats;
+
+    ////// REQUEST FROM SERVER 1 //////
+    static const char REQUEST[] =
+            "\x40\x01\xFA\x3E" // CoAP header
+            "\xB2" "42" // OID
+            "\x02" "69" // IID
+            "\x01" "7"; // RID
+    avs_unit_mocksock_input(mocksocks[0], REQUEST, sizeof(REQUEST) - 1);
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ, 69, 1);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], "\x60\x84\xFA\x3E");
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+
+    ////// CONFIRMABLE TO SERVER 2 //////
+    // sent and retransmitted outside of any server stream
+    static const char CON_REQUEST[] = "\x40\x02\x12\x34";
+    const size_t msg_size =
+            offsetof(avs_coap_msg_t, content) + sizeof(CON_REQUEST) - 1;
+    avs_coap_msg_t *msg = (avs_coap_msg_t *) malloc(msg_size);
+    AVS_UNIT_ASSERT_NOT_NULL(msg);
+    msg->length = (uint32_t) (sizeof(CON_REQUEST) - 1);
+    memcpy(&msg->content, CON_REQUEST, sizeof(CON_REQUEST) - 1);
+    anjay_exchange_result_t exchange_result = ANJAY_EXCHANGE_TIMEOUT;
+    anjay_exchange_id_t exchange_id;
+    DM_TEST_EXPECT_RESPONSE(mocksocks[1], CON_REQUEST);
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_exchange_send_confirmable(
+            anjay, 2, ANJAY_CONNECTION_UDP, msg, ANJAY_SERVER_STATS_UPDATE,
+            charged_exchange_finished, &exchange_result, &exchange_id));
+
+    ////// RETRANSMISSION //////
+    // ACK_TIMEOUT * ACK_RANDOM_FACTOR is at most 3 seconds
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(3, AVS_TIME_S));
+    DM_TEST_EXPECT_RESPONSE(mocksocks[1], CON_REQUEST);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    ////// ACKNOWLEDGEMENT //////
+    avs_unit_mocksock_input(mocksocks[1], "\x60\x44\x12\x34", 4);
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[1]));
+    AVS_UNIT_ASSERT_EQUAL(exchange_result, ANJAY_EXCHANGE_RESPONSE);
+
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_server_stats(anjay, 1, &stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.tx_bytes, 4);
+    AVS_UNIT_ASSERT_EQUAL(stats.rx_bytes, sizeof(REQUEST) - 1);
+    AVS_UNIT_ASSERT_EQUAL(stats.num_incoming_messages, 1);
+    AVS_UNIT_ASSERT_EQUAL(stats.num_outgoing_retransmissions, 0);
+
+    AVS_UNIT_ASSERT_SUCCESS(anjay_get_server_stats(anjay, 2, &stats));
+    AVS_UNIT_ASSERT_EQUAL(stats.tx_bytes, 2 * (sizeof(CON_REQUEST) - 1));
+    AVS_UNIT_ASSERT_EQUAL(stats.rx_bytes, 4);
+    AVS_UNIT_ASSERT_EQUAL(stats.num_incoming_messages, 1);
+    AVS_UNIT_ASSERT_EQUAL(stats.num_outgoing_retransmissions, 1);
+    // 3000 ms
+    AVS_UNIT_ASSERT_EQUAL(stats.update_latency.buckets[8], 1);
+
+    AVS_UNIT_ASSERT_EQUAL(anjay_get_num_outgoing_retransmissions(anjay), 1);
+    AVS_UNIT_ASSERT_EQUAL(anjay_get_tx_bytes(anjay),
+                          4 + 2 * (sizeof(CON_REQUEST) - 1));
+
+    DM_TEST_FINISH;
+}
+
+#undef SERVER_STATS_TEST_FINISH
+#undef SERVER_STATS_TEST_INIT
+
+#endif // WITH_NET_STATS
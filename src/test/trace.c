@@ -0,0 +1,168 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <string.h>
+
+#include <avsystem/commons/defs.h>
+#include <avsystem/commons/stream/stream_membuf.h>
+#include <avsystem/commons/unit/mocksock.h>
+#include <avsystem/commons/unit/test.h>
+
+#include <anjay_test/dm.h>
+#include <anjay_test/mock_clock.h>
+
+#ifdef WITH_TRACE
+
+typedef struct {
+    size_t num_events;
+    anjay_trace_event_t events[4];
+} trace_recorder_t;
+
+static void record_event(void *recorder_, const anjay_trace_event_t *event) {
+    trace_recorder_t *recorder = (trace_recorder_t *) recorder_;
+    AVS_UNIT_ASSERT_TRUE(recorder->num_events
+                         < AVS_ARRAY_SIZE(recorder->events));
+    recorder->events[recorder->num_events++] = *event;
+}
+
+static int noop_job(anjay_t *anjay, void *arg) {
+    (void) anjay;
+    (void) arg;
+    _anjay_mock_clock_advance(avs_time_duration_from_scalar(5, AVS_TIME_MS));
+    return 0;
+}
+
+AVS_UNIT_TEST(trace, sched_job) {
+    _anjay_mock_clock_start(avs_time_monotonic_from_scalar(1000, AVS_TIME_S));
+    anjay_t *anjay = anjay_new(&(const anjay_configuration_t) {
+        .endpoint_name = "urn:dev:os:anjay-test",
+        .in_buffer_size = 4096,
+        .out_buffer_size = 4096
+    });
+    AVS_UNIT_ASSERT_NOT_NULL(anjay);
+
+    trace_recorder_t recorder = { 0 };
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_set_trace_handler(anjay, record_event, &recorder));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_sched_now(anjay->sched, NULL, noop_job,
+                                             NULL));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+
+    AVS_UNIT_ASSERT_EQUAL(recorder.num_events, 2);
+    AVS_UNIT_ASSERT_EQUAL(recorder.events[0].phase, ANJAY_TRACE_BEGIN);
+    AVS_UNIT_ASSERT_EQUAL(recorder.events[1].phase, ANJAY_TRACE_END);
+    for (size_t i = 0; i < 2; ++i) {
+        AVS_UNIT_ASSERT_EQUAL_STRING(recorder.events[i].category, "sched");
+        AVS_UNIT_ASSERT_TRUE(recorder.events[i].detail
+                             == (uintptr_t) (intptr_t) noop_job);
+    }
+    AVS_UNIT_ASSERT_TRUE(avs_time_duration_equal(
+            avs_time_monotonic_diff(recorder.events[1].timestamp,
+                                    recorder.events[0].timestamp),
+            avs_time_duration_from_scalar(5, AVS_TIME_MS)));
+
+    // no events after the handler is removed
+    AVS_UNIT_ASSERT_SUCCESS(anjay_set_trace_handler(anjay, NULL, NULL));
+    AVS_UNIT_ASSERT_SUCCESS(_anjay_sched_now(anjay->sched, NULL, noop_job,
+                                             NULL));
+    AVS_UNIT_ASSERT_SUCCESS(anjay_sched_run(anjay));
+    AVS_UNIT_ASSERT_EQUAL(recorder.num_events, 2);
+
+    anjay_delete(anjay);
+    _anjay_mock_clock_finish();
+}
+
+static void record_net_event(void *recorder,
+                             const anjay_trace_event_t *event) {
+    if (!strcmp(event->category, "net")) {
+        record_event(recorder, event);
+    }
+}
+
+AVS_UNIT_TEST(trace, net_request_and_response) {
+    DM_TEST_INIT;
+    trace_recorder_t recorder = { 0 };
+    AVS_UNIT_ASSERT_SUCCESS(
+            anjay_set_trace_handler(anjay, record_net_event, &recorder));
+
+    static const char REQUEST[] =
+            "\x40\x01\xFA\x3E" // CoAP header
+            "\xB2" "42" // OID
+            "\x02" "69" // IID
+            "\x01" "7"; // RID
+    avs_unit_mocksock_input(mocksocks[0], REQUEST, sizeof(REQUEST) - 1);
+    _anjay_mock_dm_expect_instance_present(anjay, &OBJ, 69, 1);
+    DM_TEST_EXPECT_RESPONSE(mocksocks[0], "\x60\x84\xFA\x3E");
+    AVS_UNIT_ASSERT_SUCCESS(anjay_serve(anjay, mocksocks[0]));
+
+    // the response is sent through the comm_stream, not the exchange engine
+    static const struct {
+        anjay_trace_phase_t phase;
+        const char *name;
+    } EXPECTED[] = {
+        { ANJAY_TRACE_BEGIN, "recv" },
+        { ANJAY_TRACE_END, "recv" },
+        { ANJAY_TRACE_BEGIN, "send" },
+        { ANJAY_TRACE_END, "send" }
+    };
+    AVS_UNIT_ASSERT_EQUAL(recorder.num_events, AVS_ARRAY_SIZE(EXPECTED));
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(EXPECTED); ++i) {
+        AVS_UNIT_ASSERT_EQUAL(recorder.events[i].phase, EXPECTED[i].phase);
+        AVS_UNIT_ASSERT_EQUAL_STRING(recorder.events[i].name,
+                                     EXPECTED[i].name);
+    }
+
+    AVS_UNIT_ASSERT_SUCCESS(anjay_set_trace_handler(anjay, NULL, NULL));
+    DM_TEST_FINISH;
+}
+
+#endif // WITH_TRACE
+
+AVS_UNIT_TEST(trace, chrome_json) {
+    avs_stream_abstract_t *stream = avs_stream_membuf_create();
+    AVS_UNIT_ASSERT_NOT_NULL(stream);
+    anjay_trace_chrome_json(stream, &(const anjay_trace_event_t) {
+        .phase = ANJAY_TRACE_BEGIN,
+        .category = "dm",
+        .name = "resource_read",
+        .detail = 3,
+        .timestamp = avs_time_monotonic_from_scalar(1500, AVS_TIME_US)
+    });
+    anjay_trace_chrome_json(stream, &(const anjay_trace_event_t) {
+        .phase = ANJAY_TRACE_END,
+        .category = "dm",
+        .name = "resource_read",
+        .detail = 3,
+        .timestamp = avs_time_monotonic_from_scalar(2, AVS_TIME_MS)
+    });
+
+    static const char EXPECTED[] =
+            "{\"name\":\"resource_read\",\"cat\":\"dm\",\"ph\":\"B\","
+            "\"ts\":1500,\"pid\":1,\"tid\":1,\"args\":{\"detail\":3}},\n"
+            "{\"name\":\"resource_read\",\"cat\":\"dm\",\"ph\":\"E\","
+            "\"ts\":2000,\"pid\":1,\"tid\":1,\"args\":{\"detail\":3}},\n";
+    char buffer[sizeof(EXPECTED)];
+    size_t bytes_read;
+    char message_finished;
+    AVS_UNIT_ASSERT_SUCCESS(avs_stream_read(stream, &bytes_read,
+                                            &message_finished, buffer,
+                                            sizeof(buffer)));
+    AVS_UNIT_ASSERT_EQUAL(bytes_read, sizeof(EXPECTED) - 1);
+    AVS_UNIT_ASSERT_EQUAL_BYTES_SIZED(buffer, EXPECTED, bytes_read);
+    avs_stream_cleanup(&stream);
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <inttypes.h>
+
+#include <anjay/trace.h>
+
+#include "anjay_core.h"
+#include "trace.h"
+
+VISIBILITY_SOURCE_BEGIN
+
+#ifdef WITH_TRACE
+
+void _anjay_trace_emit(anjay_t *anjay,
+                       anjay_trace_phase_t phase,
+                       const char *category,
+                       const char *name,
+                       uintptr_t detail) {
+    // the scheduler is used without an Anjay instance in unit tests
+    if (anjay && anjay->trace.handler) {
+        const anjay_trace_event_t event = {
+            .phase = phase,
+            .category = category,
+            .name = name,
+            .detail = detail,
+            .timestamp = _anjay_time_monotonic_now(anjay)
+        };
+        anjay->trace.handler(anjay->trace.handler_arg, &event);
+    }
+}
+
+#endif // WITH_TRACE
+
+int anjay_set_trace_handler(anjay_t *anjay,
+                            anjay_trace_handler_t *handler,
+                            void *arg) {
+#ifdef WITH_TRACE
+    anjay->trace.handler = handler;
+    anjay->trace.handler_arg = arg;
+    return 0;
+#else
+    (void) anjay;
+    (void) handler;
+    (void) arg;
+    anjay_log(ERROR, "tracing support not compiled in");
+    return -1;
+#endif
+}
+
+void anjay_trace_chrome_json(void *stream, const anjay_trace_event_t *event) {
+    int64_t timestamp_us;
+    if (avs_time_duration_to_scalar(&timestamp_us, AVS_TIME_US,
+                                    event->timestamp.since_monotonic_epoch)) {
+        return;
+    }
+    // all events are emitted from the thread that runs Anjay
+    (void) avs_stream_write_f(
+            (avs_stream_abstract_t *) stream,
+            "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%s\",\"ts\":%" PRId64
+            ",\"pid\":1,\"tid\":1,\"args\":{\"detail\":%" PRIuPTR "}},\n",
+            event->name, event->category,
+            event->phase == ANJAY_TRACE_BEGIN ? "B" : "E", timestamp_us,
+            event->detail);
+}
+
+#ifdef ANJAY_TEST
+#include "test/trace.c"
+#endif // ANJAY_TEST
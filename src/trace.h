@@ -0,0 +1,59 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANJAY_TRACE_H
+#define ANJAY_TRACE_H
+
+#include <anjay/trace.h>
+
+#include "utils_core.h"
+
+VISIBILITY_PRIVATE_HEADER_BEGIN
+
+#ifdef WITH_TRACE
+
+typedef struct {
+    anjay_trace_handler_t *handler;
+    void *handler_arg;
+} anjay_trace_t;
+
+void _anjay_trace_emit(anjay_t *anjay,
+                       anjay_trace_phase_t phase,
+                       const char *category,
+                       const char *name,
+                       uintptr_t detail);
+
+/**
+ * Emits a trace event, if a trace handler is set. @p Category and @p Name
+ * shall be string literals.
+ */
+#define _anjay_trace_begin(Anjay, Category, Name, Detail) \
+    _anjay_trace_emit((Anjay), ANJAY_TRACE_BEGIN, (Category), (Name), \
+                      (uintptr_t) (Detail))
+#define _anjay_trace_end(Anjay, Category, Name, Detail) \
+    _anjay_trace_emit((Anjay), ANJAY_TRACE_END, (Category), (Name), \
+                      (uintptr_t) (Detail))
+
+#else // WITH_TRACE
+
+#define _anjay_trace_begin(...) ((void) 0)
+#define _anjay_trace_end(...) ((void) 0)
+
+#endif // WITH_TRACE
+
+VISIBILITY_PRIVATE_HEADER_END
+
+#endif /* ANJAY_TRACE_H */
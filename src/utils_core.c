@@ -24,6 +24,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "resolver.h"
 #include "utils_core.h"
 
 #include <avsystem/commons/errno.h>
@@ -325,8 +326,6 @@ int _anjay_create_connected_udp_socket(anjay_t *anjay,
                                        const char *bind_port,
                                        const void *config,
                                        const anjay_url_t *uri) {
-    (void) anjay;
-
     int result = 0;
     assert(!*out);
 
@@ -345,7 +344,12 @@ int _anjay_create_connected_udp_socket(anjay_t *anjay,
             goto fail;
         }
 
-        if (avs_net_socket_connect(*out, uri->host, uri->port)) {
+        if (_anjay_resolver_applicable(type, config)
+                ? _anjay_resolver_connect(
+                          anjay, *out,
+                          _anjay_resolver_address_family(type, config),
+                          uri->host, uri->port)
+                : avs_net_socket_connect(*out, uri->host, uri->port)) {
             anjay_log(ERROR, "could not connect to %s:%s",
                       uri->host, uri->port);
             goto fail;
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Benchmark of objects generated by anjay_codegen.py, linked against the code
+ * generated from input/multiple-object.xml in either storage mode.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <anjay/anjay.h>
+#include <avsystem/commons/time.h>
+
+const anjay_dm_object_def_t **test_object_object_create(void);
+void test_object_object_release(const anjay_dm_object_def_t **def);
+
+#define BENCH_INSTANCES 1000
+#define BENCH_ROUNDS 100
+
+static int64_t elapsed_us(avs_time_monotonic_t start) {
+    int64_t result = 0;
+    avs_time_duration_to_scalar(
+            &result, AVS_TIME_US,
+            avs_time_monotonic_diff(avs_time_monotonic_now(), start));
+    return result;
+}
+
+int main(void) {
+    const anjay_dm_object_def_t **obj = test_object_object_create();
+    if (!obj) {
+        return 1;
+    }
+    for (int i = 0; i < BENCH_INSTANCES; ++i) {
+        anjay_iid_t iid = ANJAY_IID_INVALID;
+        if ((*obj)->handlers.instance_create(NULL, obj, &iid, 1)) {
+            fprintf(stderr, "could not create instance %d\n", i);
+            test_object_object_release(obj);
+            return 1;
+        }
+    }
+
+    // full iteration, with presence checks as performed by the library
+    size_t found = 0;
+    avs_time_monotonic_t start = avs_time_monotonic_now();
+    for (int round = 0; round < BENCH_ROUNDS; ++round) {
+        void *cookie = NULL;
+        anjay_iid_t iid;
+        while (!(*obj)->handlers.instance_it(NULL, obj, &iid, &cookie)
+                && iid != ANJAY_IID_INVALID) {
+            found += (size_t) (*obj)->handlers.instance_present(NULL, obj,
+                                                                iid);
+        }
+    }
+    const int64_t iterate_us = elapsed_us(start);
+
+    printf("%d instances, %d rounds: iteration with presence checks %" PRId64
+           " us\n", BENCH_INSTANCES, BENCH_ROUNDS, iterate_us);
+    test_object_object_release(obj);
+    return found == (size_t) BENCH_INSTANCES * BENCH_ROUNDS ? 0 : 1;
+}
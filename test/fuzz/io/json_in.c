@@ -0,0 +1,84 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <avsystem/commons/stream/stream_inbuf.h>
+
+#include "../../../src/io_core.h"
+
+#ifdef WITH_JSON
+static int read_entries(anjay_input_ctx_t *in) {
+    anjay_id_type_t type;
+    uint16_t id;
+    int retval;
+    while (!(retval = _anjay_input_get_id(in, &type, &id))) {
+        if (type != ANJAY_ID_RIID) {
+            anjay_input_ctx_t *nested = _anjay_input_nested_ctx(in);
+            if (nested && (retval = read_entries(nested))) {
+                return retval;
+            }
+        }
+        /* try all value types, each of them is rejected or accepted */
+        char buf[16];
+        size_t bytes_read;
+        bool message_finished;
+        double value;
+        (void) anjay_get_string(in, buf, sizeof(buf));
+        (void) anjay_get_bytes(in, &bytes_read, &message_finished,
+                               buf, sizeof(buf));
+        (void) anjay_get_double(in, &value);
+        if ((retval = _anjay_input_next_entry(in))) {
+            return retval;
+        }
+    }
+    return retval == ANJAY_GET_INDEX_END ? 0 : retval;
+}
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    static char input[65536];
+    size_t input_size = fread(input, 1, sizeof(input), stdin);
+    if (!input_size) {
+        return -1;
+    }
+
+    /* the first byte selects the format: LwM2M JSON or SenML JSON */
+    avs_stream_inbuf_t inbuf = AVS_STREAM_INBUF_STATIC_INITIALIZER;
+    avs_stream_inbuf_set_buffer(&inbuf, input + 1, input_size - 1);
+    avs_stream_abstract_t *stream = (avs_stream_abstract_t *) &inbuf;
+
+    anjay_input_ctx_t *in = NULL;
+    int retval = (input[0] & 1)
+            ? _anjay_input_senml_json_create(&in, &stream, false)
+            : _anjay_input_json_create(&in, &stream, false);
+    if (!retval) {
+        retval = read_entries(in);
+    }
+
+    _anjay_input_ctx_destroy(&in);
+    return retval;
+}
+#else // WITH_JSON
+int main(void) {
+    return 0;
+}
+#endif // WITH_JSON
@@ -0,0 +1,54 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <avsystem/commons/stream/stream_inbuf.h>
+
+#include "../../../src/io_core.h"
+
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    static char input[65536];
+    size_t input_size = fread(input, 1, sizeof(input), stdin);
+
+    avs_stream_inbuf_t inbuf = AVS_STREAM_INBUF_STATIC_INITIALIZER;
+    avs_stream_inbuf_set_buffer(&inbuf, input, input_size);
+    avs_stream_abstract_t *stream = (avs_stream_abstract_t *) &inbuf;
+
+    anjay_input_ctx_t *in = NULL;
+    if (_anjay_input_text_create(&in, &stream, false)) {
+        return -1;
+    }
+
+    /* odd-sized reads exercise the partial group caching paths */
+    uint8_t buffer[7];
+    bool message_finished = false;
+    int retval = 0;
+    while (!message_finished && !retval) {
+        size_t bytes_read;
+        retval = anjay_get_bytes(in, &bytes_read, &message_finished,
+                                 buffer, sizeof(buffer));
+    }
+
+    _anjay_input_ctx_destroy(&in);
+    return retval;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2017-2018 AVSystem <avsystem@avsystem.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <config.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <avsystem/commons/base64.h>
+#include <avsystem/commons/stream/stream_inbuf.h>
+#include <avsystem/commons/stream/stream_outbuf.h>
+
+#include "../../../src/io/base64_out.h"
+#include "../../../src/io_core.h"
+
+/* round-trips the input through the base64 encoder and decoder, aborting if
+ * the result differs from avs_base64_encode() or from the original data */
+int main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+
+    static char input[16384];
+    size_t input_size = fread(input, 1, sizeof(input), stdin);
+    if (!input_size) {
+        return -1;
+    }
+
+    /* the first byte selects the size of appended and read chunks */
+    const size_t chunk_size = (size_t) (uint8_t) input[0] + 1;
+    const uint8_t *data = (const uint8_t *) input + 1;
+    const size_t data_size = input_size - 1;
+
+    static char encoded[4 * sizeof(input) / 3 + 4];
+    avs_stream_outbuf_t outbuf = AVS_STREAM_OUTBUF_STATIC_INITIALIZER;
+    avs_stream_outbuf_set_buffer(&outbuf, encoded, sizeof(encoded));
+    anjay_ret_bytes_ctx_t *bytes = _anjay_base64_ret_bytes_ctx_new(
+            (avs_stream_abstract_t *) &outbuf, data_size);
+    if (!bytes) {
+        return -1;
+    }
+    int retval = 0;
+    for (size_t offset = 0; !retval && offset < data_size;
+            offset += chunk_size) {
+        size_t size = data_size - offset;
+        retval = anjay_ret_bytes_append(
+                bytes, &data[offset], size < chunk_size ? size : chunk_size);
+    }
+    if (!retval) {
+        retval = _anjay_base64_ret_bytes_ctx_close(bytes);
+    }
+    _anjay_base64_ret_bytes_ctx_delete(&bytes);
+    if (retval) {
+        abort();
+    }
+
+    static char expected[sizeof(encoded) + 1];
+    const size_t encoded_size = avs_stream_outbuf_offset(&outbuf);
+    if (avs_base64_encode(expected, sizeof(expected), data, data_size)
+            || encoded_size != strlen(expected)
+            || memcmp(encoded, expected, encoded_size)) {
+        abort();
+    }
+
+    avs_stream_inbuf_t inbuf = AVS_STREAM_INBUF_STATIC_INITIALIZER;
+    avs_stream_inbuf_set_buffer(&inbuf, encoded, encoded_size);
+    avs_stream_abstract_t *stream = (avs_stream_abstract_t *) &inbuf;
+    anjay_input_ctx_t *in = NULL;
+    if (_anjay_input_text_create(&in, &stream, false)) {
+        return -1;
+    }
+    static uint8_t decoded[sizeof(input)];
+    size_t decoded_size = 0;
+    bool message_finished = false;
+    while (!message_finished && !retval) {
+        size_t bytes_read;
+        size_t size = sizeof(decoded) - decoded_size;
+        retval = anjay_get_bytes(in, &bytes_read, &message_finished,
+                                 &decoded[decoded_size],
+                                 size < chunk_size ? size : chunk_size);
+        decoded_size += bytes_read;
+    }
+    _anjay_input_ctx_destroy(&in);
+    if (retval || decoded_size != data_size
+            || memcmp(decoded, data, data_size)) {
+        abort();
+    }
+    return 0;
+}
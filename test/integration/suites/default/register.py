@@ -14,7 +14,9 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 
+import binascii
 import socket
+import time
 import unittest
 
 from framework.lwm2m_test import *
@@ -144,6 +146,73 @@ class ConcurrentRequestWhileWaitingForResponse(Register.TestCase):
         self.serv.send(Lwm2mCreated.matching(pkt)(location='/rd/demo'))
 
 
+class ConcurrentRegisterToMultipleServers(test_suite.Lwm2mTest):
+    def setUp(self):
+        self.setup_demo_with_servers(servers=2, auto_register=False)
+
+    def runTest(self):
+        # Register shall be sent to both servers before any of them responds
+        pkts = [serv.recv() for serv in self.servers]
+        for pkt in pkts:
+            self.assertMsgEqual(
+                Lwm2mRegister('/rd?lwm2m=%s&ep=%s&lt=86400' % (DEMO_LWM2M_VERSION, DEMO_ENDPOINT_NAME),
+                              content=expected_content),
+                pkt)
+
+        # respond in reverse order
+        self.servers[1].send(Lwm2mCreated.matching(pkts[1])(location='/rd/demo'))
+        self.servers[0].send(Lwm2mCreated.matching(pkts[0])(location='/rd/demo'))
+
+        # no retransmissions expected
+        for serv in self.servers:
+            with self.assertRaises(socket.timeout, msg='unexpected message'):
+                print(serv.recv(timeout_s=3))
+
+
+class TimeToAllRegisteredWithStalledServer(test_suite.Lwm2mTest):
+    # One of the servers never responds to Register. Connections (including
+    # DTLS handshakes) are still established one after another, but the
+    # remaining servers shall not wait for the stalled Register to time out.
+    NUM_SERVERS = 8
+    PSK_IDENTITY = b'test-identity'
+    PSK_KEY = b'test-key'
+    MAX_TIME_TO_ALL_REGISTERED_S = 10
+
+    def setUp(self):
+        self.start_time = time.time()
+        servers = [Lwm2mServer(coap.DtlsServer(psk_identity=self.PSK_IDENTITY, psk_key=self.PSK_KEY))
+                   for _ in range(self.NUM_SERVERS)]
+        self.setup_demo_with_servers(servers=servers,
+                                     extra_cmdline_args=['--identity', str(binascii.hexlify(self.PSK_IDENTITY), 'ascii'),
+                                                         '--key', str(binascii.hexlify(self.PSK_KEY), 'ascii')],
+                                     auto_register=False)
+
+    def tearDown(self):
+        # De-Register is not sent to the server that has not completed Register
+        self.teardown_demo_with_servers(deregister_servers=self.servers[1:])
+
+    def runTest(self):
+        expected_register = Lwm2mRegister('/rd?lwm2m=%s&ep=%s&lt=86400' % (DEMO_LWM2M_VERSION, DEMO_ENDPOINT_NAME),
+                                          content=expected_content)
+
+        # ignored on purpose
+        self.assertMsgEqual(expected_register, self.servers[0].recv())
+
+        for serv in self.servers[1:]:
+            pkt = serv.recv()
+            self.assertMsgEqual(expected_register, pkt)
+            serv.send(Lwm2mCreated.matching(pkt)(location='/rd/demo'))
+
+        time_to_all_registered = time.time() - self.start_time
+        print('time to all registered: %.3f s' % (time_to_all_registered,))
+        self.assertLess(time_to_all_registered, self.MAX_TIME_TO_ALL_REGISTERED_S)
+
+        # no retransmissions to the servers that responded
+        for serv in self.servers[1:]:
+            with self.assertRaises(socket.timeout, msg='unexpected message'):
+                print(serv.recv(timeout_s=1))
+
+
 class RegisterUri(Register.TestCase):
     def make_demo_args(self, *args, **kwargs):
         args = super().make_demo_args(*args, **kwargs)
@@ -90,7 +90,7 @@ TEMPLATE = """\
 
 #include <anjay/anjay.h>
 #include <avsystem/commons/defs.h>
-{% if obj.multiple %}
+{% if obj.multiple and not indexed %}
 #include <avsystem/commons/list.h>
 {% endif %}
 
@@ -103,6 +103,28 @@ TEMPLATE = """\
 #define {{ res.name_upper }} {{ res.rid }}
 
 {% endfor %}
+{% if indexed %}
+typedef struct {
+    anjay_rid_t rid;
+    anjay_dm_resource_op_mask_t operations;
+} resource_def_t;
+
+/**
+ * Resources sorted by Resource ID, in the same order as supported_rids in the
+ * object definition, so that the index may be used for both
+ */
+static const resource_def_t RESOURCES[] = {
+{% for res in obj.resources %}
+    { {{ res.name_upper }}, {{ res.operations_mask }} }{{ "" if loop.last else "," }}
+{% endfor %}
+};
+
+{% if obj.multiple %}
+// TODO: maximum number of instances; Instance IDs are indices into an array
+#define MAX_INSTANCES 1024
+
+{% endif %}
+{% endif %}
 {% if obj.multiple %}
 typedef struct {{ obj_inst_tag }} {
     anjay_iid_t iid;
@@ -113,7 +135,9 @@ typedef struct {{ obj_inst_tag }} {
 {% endif %}
 typedef struct {{ obj_repr_tag }} {
     const anjay_dm_object_def_t *def;
-{% if obj.multiple %}
+{% if obj.multiple and indexed %}
+    {{ obj_inst_type }} *instances[MAX_INSTANCES];
+{% elif obj.multiple %}
     AVS_LIST({{ obj_name_snake }}_instance_t) instances;
 {% endif %}
 
@@ -126,7 +150,113 @@ get_obj(const anjay_dm_object_def_t *const *obj_ptr) {
     return AVS_CONTAINER_OF(obj_ptr, {{ obj_repr_type }}, def);
 }
 
-{% if obj.multiple %}
+{% if obj.multiple and indexed %}
+static {{ obj_inst_type }} *
+find_instance(const {{ obj_repr_type }} *obj,
+              anjay_iid_t iid) {
+    return iid < MAX_INSTANCES ? obj->instances[iid] : NULL;
+}
+
+static int instance_present(anjay_t *anjay,
+                            const anjay_dm_object_def_t *const *obj_ptr,
+                            anjay_iid_t iid) {
+    (void)anjay;
+    return find_instance(get_obj(obj_ptr), iid) != NULL;
+}
+
+static int instance_it(anjay_t *anjay,
+                       const anjay_dm_object_def_t *const *obj_ptr,
+                       anjay_iid_t *out,
+                       void **cookie) {
+    (void)anjay;
+
+    {{ obj_repr_type }} *obj = get_obj(obj_ptr);
+    uintptr_t iid = (uintptr_t) *cookie;
+    while (iid < MAX_INSTANCES && !obj->instances[iid]) {
+        ++iid;
+    }
+
+    *out = iid < MAX_INSTANCES ? (anjay_iid_t) iid : ANJAY_IID_INVALID;
+    *cookie = (void *) (iid + 1);
+    return 0;
+}
+
+static anjay_iid_t get_new_iid(const {{ obj_repr_type }} *obj) {
+    for (anjay_iid_t iid = 0; iid < MAX_INSTANCES; ++iid) {
+        if (!obj->instances[iid]) {
+            return iid;
+        }
+    }
+    return ANJAY_IID_INVALID;
+}
+
+static int init_instance({{ obj_inst_type }} *inst,
+                         anjay_iid_t iid) {
+    assert(iid != ANJAY_IID_INVALID);
+
+    inst->iid = iid;
+    // TODO: instance init
+
+    // TODO: return 0 on success, negative value on failure
+    return 0;
+}
+
+static void release_instance({{ obj_inst_type }} *inst) {
+    // TODO: instance cleanup
+    (void) inst;
+}
+
+static int instance_create(anjay_t *anjay,
+                           const anjay_dm_object_def_t *const *obj_ptr,
+                           anjay_iid_t *inout_iid,
+                           anjay_ssid_t ssid) {
+    (void) anjay; (void) ssid;
+    {{ obj_repr_type }} *obj = get_obj(obj_ptr);
+    assert(obj);
+
+    if (*inout_iid == ANJAY_IID_INVALID) {
+        *inout_iid = get_new_iid(obj);
+    }
+    if (*inout_iid >= MAX_INSTANCES || obj->instances[*inout_iid]) {
+        return ANJAY_ERR_INTERNAL;
+    }
+
+    {{ obj_inst_type }} *created = ({{ obj_inst_type }} *)
+            calloc(1, sizeof({{ obj_inst_type }}));
+    if (!created) {
+        return ANJAY_ERR_INTERNAL;
+    }
+
+    int result = init_instance(created, *inout_iid);
+    if (result) {
+        free(created);
+        return result;
+    }
+
+    obj->instances[*inout_iid] = created;
+    return 0;
+}
+
+static int instance_remove(anjay_t *anjay,
+                           const anjay_dm_object_def_t *const *obj_ptr,
+                           anjay_iid_t iid) {
+    (void)anjay;
+    {{ obj_repr_type }} *obj = get_obj(obj_ptr);
+    assert(obj);
+
+    {{ obj_inst_type }} *inst = find_instance(obj, iid);
+    if (!inst) {
+        assert(0);
+        return ANJAY_ERR_NOT_FOUND;
+    }
+
+    release_instance(inst);
+    free(inst);
+    obj->instances[iid] = NULL;
+    return 0;
+}
+
+{% elif obj.multiple %}
 static {{ obj_inst_type }} *
 find_instance(const {{ obj_repr_type }} *obj,
               anjay_iid_t iid) {
@@ -253,6 +383,55 @@ static int instance_remove(anjay_t *anjay,
     return ANJAY_ERR_NOT_FOUND;
 }
 
+{% endif %}
+{% if indexed %}
+static const resource_def_t *find_resource(anjay_rid_t rid) {
+    size_t left = 0;
+    size_t right = AVS_ARRAY_SIZE(RESOURCES);
+    while (left < right) {
+        size_t mid = (left + right) / 2;
+        if (RESOURCES[mid].rid == rid) {
+            return &RESOURCES[mid];
+        } else if (RESOURCES[mid].rid < rid) {
+            left = mid + 1;
+        } else {
+            right = mid;
+        }
+    }
+    return NULL;
+}
+
+static int resource_operations(anjay_t *anjay,
+                               const anjay_dm_object_def_t *const *obj_ptr,
+                               anjay_rid_t rid,
+                               anjay_dm_resource_op_mask_t *out) {
+    (void)anjay;
+    (void)obj_ptr;
+
+    const resource_def_t *res = find_resource(rid);
+    if (!res) {
+        return ANJAY_ERR_NOT_FOUND;
+    }
+    *out = res->operations;
+    return 0;
+}
+
+static int instance_resources(anjay_t *anjay,
+                              const anjay_dm_object_def_t *const *obj_ptr,
+                              anjay_iid_t iid,
+                              anjay_dm_resource_op_mask_t *out) {
+    (void)anjay;
+    (void)obj_ptr;
+    (void)iid;
+
+    // TODO: leave out Resources that are not present in this instance
+    for (size_t i = 0; i < AVS_ARRAY_SIZE(RESOURCES); ++i) {
+        out[i] = (anjay_dm_resource_op_mask_t) (ANJAY_DM_RESOURCE_PRESENT
+                                                | RESOURCES[i].operations);
+    }
+    return 0;
+}
+
 {% endif %}
 {% if obj.needs_instance_reset_handler %}
 static int instance_reset(anjay_t *anjay,
@@ -415,7 +594,14 @@ const anjay_dm_object_def_t **{{ obj_name_snake }}_object_create(void) {
 void {{ obj_name_snake }}_object_release(const anjay_dm_object_def_t **def) {
     if (def) {
         {{ obj_repr_type }} *obj = get_obj(def);
-{% if obj.multiple %}
+{% if obj.multiple and indexed %}
+        for (size_t i = 0; i < MAX_INSTANCES; ++i) {
+            if (obj->instances[i]) {
+                release_instance(obj->instances[i]);
+                free(obj->instances[i]);
+            }
+        }
+{% elif obj.multiple %}
         AVS_LIST_CLEAR(&obj->instances) {
             release_instance(obj->instances);
         }
@@ -451,6 +637,11 @@ class ResourceDef(collections.namedtuple('ResourceDef', ['rid', 'name', 'operati
     def name_upper(self) -> str:
         return _sanitize_macro_name('RID_' + self.name.upper())
 
+    @property
+    def operations_mask(self) -> str:
+        bits = ['ANJAY_DM_RESOURCE_OP_BIT_' + op for op in 'RWE' if op in self.operations]
+        return ' | '.join(bits) if bits else 'ANJAY_DM_RESOURCE_OP_NONE'
+
     @property
     def read_handler(self) -> Optional[str]:
         if 'R' not in self.operations:
@@ -608,7 +799,7 @@ class ObjectDef(collections.namedtuple('ObjectDef',
                                     key=operator.attrgetter('rid')))
 
 
-def generate_object_boilerplate(obj_ddf_xml: str, cxx: bool):
+def generate_object_boilerplate(obj_ddf_xml: str, cxx: bool, indexed: bool = False):
     tree = ElementTree.fromstring(obj_ddf_xml)
     obj = ObjectDef.from_etree(tree.find('Object'))
 
@@ -629,6 +820,9 @@ def generate_object_boilerplate(obj_ddf_xml: str, cxx: bool):
 
     handlers.append('')
     handlers.append(('resource_present', 'anjay_dm_resource_present_TRUE'))
+    if indexed:
+        handlers.append(('resource_operations', 'resource_operations'))
+        handlers.append(('instance_resources', 'instance_resources'))
     if obj.has_any_readable_resources:
         handlers.append(('resource_read', 'resource_read'))
     if obj.has_any_writable_resources:
@@ -651,6 +845,7 @@ def generate_object_boilerplate(obj_ddf_xml: str, cxx: bool):
 
     return (jinja_env.from_string(TEMPLATE)
                 .render(obj=obj,
+                        indexed=indexed,
                         date_time=datetime.datetime.now().strftime('%Y-%m-%d %H:%M:%S'),
                         obj_name_snake=obj.name_snake,
                         obj_repr_tag=obj.name_snake + '_struct',
@@ -665,6 +860,9 @@ if __name__ == '__main__':
     parser.add_argument('-i', '--input', help='Input filename or - to read from stdin')
     parser.add_argument('-o', '--output', default='/dev/stdout', help='Output filename (default: stdout)')
     parser.add_argument('-x', '--c++', dest='cxx', action='store_true', help='Generate C++ code (default: C)')
+    parser.add_argument('-a', '--indexed', action='store_true',
+                        help='Store instances in an array indexed by Instance ID and generate constant Resource '
+                             'tables (default: sorted list of instances)')
 
     args = parser.parse_args()
     if args.input == '-':
@@ -677,7 +875,7 @@ if __name__ == '__main__':
         sys.exit(1)
 
     with open(args.input) as f:
-        boilerplate = generate_object_boilerplate(f.read(), args.cxx)
+        boilerplate = generate_object_boilerplate(f.read(), args.cxx, args.indexed)
 
     with open(args.output, 'w') as f:
         print(boilerplate, file=f)